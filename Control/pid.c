@@ -0,0 +1,67 @@
+/*
+ * pid.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Fixed point PID without any driver dependency so it
+ * can be run against a simulated plant on the host
+ */
+
+#include "pid.h"
+
+static int64_t clamp64(int64_t value, int64_t min, int64_t max)
+{
+    if(value < min){return min;}
+    if(value > max){return max;}
+    return value;
+}
+
+/*
+ * Clears the integrator and derivative history
+ */
+void PID_reset(PID_State *state)
+{
+    state->integral = 0;
+    state->lastMeasurement = 0;
+    state->primed = false;
+}
+
+/*
+ * Runs one controller period
+ *      Derivative acts on the measurement so setpoint steps do not kick
+ *      Integrator is clamped to the output range and frozen while the
+ *      output is saturated in the direction of the error (anti-windup)
+ *
+ * Returns the clamped output
+ */
+int32_t PID_step(PID_State *state, const PID_Gains *gains, int32_t setpoint, int32_t measurement)
+{
+    int64_t min = (int64_t)gains->outMin << PID_Q;
+    int64_t max = (int64_t)gains->outMax << PID_Q;
+    int32_t error = setpoint - measurement;
+    int32_t change = state->primed ? measurement - state->lastMeasurement : 0;
+    if(gains->reverse){
+        error = -error;
+        change = -change;
+    }
+    state->lastMeasurement = measurement;
+    state->primed = true;
+
+    int64_t proportional = (int64_t)gains->kp * error;
+    int64_t derivative = -(int64_t)gains->kd * change;
+    int64_t integral = clamp64(state->integral + (int64_t)gains->ki * error, min, max);
+
+    int64_t output = proportional + integral + derivative;
+    bool saturatedHigh = output > max && error > 0;
+    bool saturatedLow = output < min && error < 0;
+    if(!saturatedHigh && !saturatedLow){
+        state->integral = integral;
+        output = proportional + integral + derivative;
+    }
+    else{
+        output = proportional + state->integral + derivative;
+    }
+
+    return (int32_t)(clamp64(output, min, max) >> PID_Q);
+}
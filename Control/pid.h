@@ -0,0 +1,36 @@
+/*
+ * pid.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#ifndef PID_H_
+#define PID_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Gains are Q16.16 fixed point, 1.0 == PID_ONE */
+#define PID_Q           16
+#define PID_ONE         ((int32_t)1 << PID_Q)
+
+typedef struct PID_Gains {
+    int32_t kp;         // Output units per error unit, Q16.16
+    int32_t ki;         // Output units per error unit per period, Q16.16
+    int32_t kd;         // Output units per error unit change per period, Q16.16
+    int32_t outMin;     // Output clamp
+    int32_t outMax;
+    bool reverse;       // True for cooling (output rises when measurement is above setpoint)
+} PID_Gains;
+
+typedef struct PID_State {
+    int64_t integral;   // Integrator in Q16.16, clamped to the output range
+    int32_t lastMeasurement;
+    bool primed;        // False until the first step, suppresses derivative kick
+} PID_State;
+
+void PID_reset(PID_State *state);
+int32_t PID_step(PID_State *state, const PID_Gains *gains, int32_t setpoint, int32_t measurement);
+
+#endif /* PID_H_ */
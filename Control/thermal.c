@@ -0,0 +1,241 @@
+/*
+ * thermal.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+#include "thermal.h"
+#include "utilities.h"
+#include "log.h"
+
+void Thermal_dispatch(void *thermal_handle, const Active_Msg *msg);
+void SetPoint_request(Thermal_Handle *handle, float setpoint);
+void Run_request(Thermal_Handle *handle);
+void Run_process(Thermal_Handle *handle);
+void Claim_step(Thermal_Handle *handle);
+void Run_step(Thermal_Handle *handle);
+void Thermal_Stop_request(Thermal_Handle *handle);
+static void Thermal_release_internal(Thermal_Handle *handle);
+
+/* Shared by every controller */
+static const Active_Config Thermal_config = {
+    .priority = THERMAL_PRIORITY,
+    .stackSize = THERMAL_STACK_SIZE,
+    .start = NULL,
+    .dispatch = Thermal_dispatch,
+    .interleave = NULL
+};
+
+
+/*
+ * Initializes a closed loop thermal controller thread
+ * The sensor is read, the PID run and the PWM written once per period
+ *
+ * Input handle storage owned by the caller (static or global), the
+ * thread keeps using it so it must outlive the controller
+ * Input TMP handle opened with Open_TMP
+ * Input myPWM handle driving the heater or fan
+ * Input control period in ms
+ * Input PID gains in Q16.16, error in TMP117 counts (1/128 degC),
+ *       output in PWM levels (outMax is limited to the PWM resolution)
+ * Input Controller Name (i.e. Heater) up to 10 characters
+ *
+ * While running the controller claims the sensor and the output, their
+ * own requests wait until Stop
+ *      Returns false if the thread could not be started
+ */
+bool Open_Thermal(Thermal_Handle *thm_handle, TMP_Handle *tmp_handle, myPWM_Handle *pwm_handle, uint16_t period_ms, PID_Gains gains, const char Thermal_Name[10])
+{
+    strcpy(thm_handle->thm_name,Thermal_Name);
+    thm_handle->tmp_handle = tmp_handle;
+    thm_handle->pwm_handle = pwm_handle;
+    thm_handle->period_us = (uint32_t)period_ms*1000;
+
+    if(gains.outMax > pwm_handle->resolution){
+        gains.outMax = pwm_handle->resolution;
+    }
+    if(gains.outMin < 0){
+        gains.outMin = 0;
+    }
+    thm_handle->gains = gains;
+    PID_reset(&thm_handle->pid);
+
+    thm_handle->SetPoint = SetPoint_request;
+    thm_handle->Run = Run_request;
+    thm_handle->Stop = Thermal_Stop_request;
+
+    memset(&thm_handle->fxn_details, 0, sizeof(Thermal_Misc));
+    memset(&thm_handle->stats, 0, sizeof(Thermal_Stats));
+    Periodic_register(&thm_handle->timer, thm_handle->thm_name);
+
+    return Active_start(&thm_handle->active, &Thermal_config, thm_handle, thm_handle->thm_name);
+}
+
+
+/*
+ * Runs one controller request step in the controller thread
+ */
+void Thermal_dispatch(void *thermal_handle, const Active_Msg *msg)
+{
+    Thermal_Handle *handle = (Thermal_Handle*)thermal_handle;
+
+    switch(msg->sig) {
+        case THM_Run:
+            Run_process(handle);
+            break;
+        case THM_ClaimNext:
+            Claim_step(handle);
+            break;
+        case THM_RunNext:
+            Periodic_record(&handle->timer);
+            Run_step(handle);
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * Change setpoint, takes effect at the next period
+ * Input setpoint in degC
+ */
+void SetPoint_request(Thermal_Handle *handle, float setpoint)
+{
+    __atomic_store_n(&handle->fxn_details.setpoint, (int32_t)(setpoint*128), __ATOMIC_RELAXED);
+}
+
+/*
+ * Start closed loop control request
+ * A Run made while the controller runs waits for Stop
+ */
+void Run_request(Thermal_Handle *handle)
+{
+    Active_Msg msg = {.sig = THM_Run};
+    Active_post(&handle->active, &msg);
+}
+
+/*
+ * Run process
+ *      Claims the sensor and the output, a busy one has its request
+ *      stopped and the claim is retried every 1ms as a continuation, so
+ *      on the FW_COOPERATIVE event loop the stopped request can finish
+ */
+void Run_process(Thermal_Handle *handle)
+{
+    PID_reset(&handle->pid);
+    handle->fxn_details.output = 0;
+    handle->fxn_details.claimed = 0;
+    handle->fxn_details.claimDeadline_us = clock_us() + THERMAL_CLAIM_MS*1000;
+    memset(&handle->stats, 0, sizeof(Thermal_Stats));
+    Periodic_reset_stats(&handle->timer);
+
+    if(Active_try_take(&handle->tmp_handle->active)){
+        handle->fxn_details.claimed |= THM_CLAIMED_SENSOR;
+    }
+    else{
+        Active_cancel(&handle->tmp_handle->active);
+    }
+    if(Active_try_take(&handle->pwm_handle->active)){
+        handle->fxn_details.claimed |= THM_CLAIMED_OUTPUT;
+    }
+    else{
+        Active_cancel(&handle->pwm_handle->active);
+    }
+    Claim_step(handle);
+}
+
+/*
+ * Claims the sensor and the output, starts the loop once both are held
+ */
+void Claim_step(Thermal_Handle *handle)
+{
+    Thermal_Misc *details = &handle->fxn_details;
+    if(Active_cancelled(&handle->active)){
+        Thermal_release_internal(handle);
+        return;
+    }
+    if(!(details->claimed & THM_CLAIMED_SENSOR) && Active_try_take(&handle->tmp_handle->active)){
+        details->claimed |= THM_CLAIMED_SENSOR;
+    }
+    if(!(details->claimed & THM_CLAIMED_OUTPUT) && Active_try_take(&handle->pwm_handle->active)){
+        details->claimed |= THM_CLAIMED_OUTPUT;
+    }
+
+    if(details->claimed == (THM_CLAIMED_SENSOR | THM_CLAIMED_OUTPUT)){
+        // A new sample every period, not the 1s power on cycle
+        if(!Conversion_internal(handle->tmp_handle, handle->period_us)){
+            handle->stats.sampleErrors++;
+        }
+        Periodic_start(&handle->timer, handle->period_us, PERIODIC_SKIP);
+        Run_step(handle);
+        return;
+    }
+    if(clock_us() >= details->claimDeadline_us){
+        LOG1(LOG_CTRL_BUSY, (details->claimed & THM_CLAIMED_SENSOR) ? handle->pwm_handle->pwm_sysconfig
+                                                                     : handle->tmp_handle->address);
+        handle->stats.claimFailures++;
+        Thermal_release_internal(handle);
+        return;
+    }
+    Active_Msg next = {.sig = THM_ClaimNext};
+    Active_schedule(&handle->active, &next, clock_us() + 1000); // Retry in 1ms
+}
+
+/*
+ * One control period
+ *      Each period starts on an absolute deadline so execution time
+ *      does not add to the period. The output computed in the previous
+ *      period is written first so the actuator update has no jitter from
+ *      the I2C read or the PID, then the sensor is sampled for the next one.
+ *      The sensor and the output stay claimed for the whole run, so their
+ *      own threads do not touch them in between.
+ */
+void Run_step(Thermal_Handle *handle)
+{
+    TMP_Sample sample;
+    if(Active_cancelled(&handle->active)){
+        Set_internal(handle->pwm_handle, 0);
+        Thermal_release_internal(handle);
+        return;
+    }
+    Set_internal(handle->pwm_handle, (uint16_t)handle->fxn_details.output);
+
+    if(ReadTemp_internal(handle->tmp_handle, &sample)){
+        int32_t setpoint = __atomic_load_n(&handle->fxn_details.setpoint, __ATOMIC_RELAXED);
+        handle->fxn_details.measurement = sample.raw;
+        handle->fxn_details.output = PID_step(&handle->pid, &handle->gains, setpoint, sample.raw);
+        LOG2(LOG_CTRL_OUTPUT, sample.raw, handle->fxn_details.output);
+    }
+    else{
+        handle->stats.sampleErrors++;
+    }
+
+    // Missed deadlines are skipped so the loop does not burst
+    Active_Msg next = {.sig = THM_RunNext};
+    Periodic_next(&handle->timer);
+    Active_schedule(&handle->active, &next, handle->timer.deadline_us);
+}
+
+/*
+ * Stop closed loop control request, output is switched off
+ * A Run still queued is discarded as well
+ */
+void Thermal_Stop_request(Thermal_Handle *handle)
+{
+    Active_cancel(&handle->active);
+}
+
+
+/*
+ * Gives back the sensor and the output held by the request
+ */
+static void Thermal_release_internal(Thermal_Handle *handle)
+{
+    if(handle->fxn_details.claimed & THM_CLAIMED_OUTPUT){
+        Active_release(&handle->pwm_handle->active);
+    }
+    if(handle->fxn_details.claimed & THM_CLAIMED_SENSOR){
+        Active_release(&handle->tmp_handle->active);
+    }
+    handle->fxn_details.claimed = 0;
+}
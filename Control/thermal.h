@@ -0,0 +1,72 @@
+/*
+ * thermal.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#ifndef THERMAL_H_
+#define THERMAL_H_
+
+#include <string.h>
+
+#include "pid.h"
+#include "periodic.h"
+#include "TMP117.h"
+#include "myPWM.h"
+
+/* Stack of each controller thread */
+#define THERMAL_STACK_SIZE      2048
+#define THERMAL_PRIORITY        3
+
+/* Time given to the sensor and output to finish a stopped request on Run */
+#define THERMAL_CLAIM_MS        50
+
+/* Thermal_Misc claimed bits */
+#define THM_CLAIMED_SENSOR      0x01
+#define THM_CLAIMED_OUTPUT      0x02
+
+typedef enum Thermal_Request {
+    THM_None,
+    THM_Run,
+    THM_ClaimNext,          // Continuations, scheduled by the controller itself
+    THM_RunNext
+} Thermal_Request;
+
+typedef struct Thermal_Stats {
+    uint32_t sampleErrors;      // Periods where the sensor read failed, output held
+    uint32_t claimFailures;     // Runs refused, sensor or output not free in THERMAL_CLAIM_MS
+} Thermal_Stats;
+
+typedef struct Thermal_Misc {
+    uint8_t claimed;            // THM_CLAIMED_* held by the running request
+    uint64_t claimDeadline_us;  // Run is refused if both are not claimed by then
+    int32_t setpoint;           // Setpoint in TMP117 counts (1/128 degC)
+    int32_t output;             // Output written at the next deadline, 0 to PWM resolution
+    int32_t measurement;        // Last measurement in TMP117 counts
+} Thermal_Misc;
+
+/*
+ * Run and Stop only queue a request and return, like the TMP_Handle
+ * methods, SetPoint is read by the loop at the next period. All three
+ * may be called from a Hwi or Swi
+ */
+typedef struct Thermal_Handle {
+    const char          thm_name[10];
+    TMP_Handle          *tmp_handle;    // Sensor claimed by the controller while running
+    myPWM_Handle        *pwm_handle;    // Heater or fan claimed by the controller while running
+    uint32_t            period_us;      // Control period
+    Active_Object       active;         // Thread and request queue started by Open_Thermal
+    PID_Gains           gains;
+    PID_State           pid;
+    void (*SetPoint)(struct Thermal_Handle*,float); // Method to change the setpoint in degC
+    void (*Run)(struct Thermal_Handle*);            // Method to start closed loop control
+    void (*Stop)(struct Thermal_Handle*);           // Method to stop control, output is switched off
+    Thermal_Misc        fxn_details;    // Internal register to manage tasks
+    Thermal_Stats       stats;          // Loop statistics
+    Periodic_Timer      timer;          // Control period, jitter and overrun statistics
+} Thermal_Handle;
+
+bool Open_Thermal(Thermal_Handle *thm_handle, TMP_Handle *tmp_handle, myPWM_Handle *pwm_handle, uint16_t period_ms, PID_Gains gains, const char Thermal_Name[10]);
+
+#endif /* THERMAL_H_ */
@@ -0,0 +1,242 @@
+/*
+ * adapt_replay.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Replays a recorded temperature trace through the adaptive sampling period
+ *      adapt_replay [trace.csv|--synthetic] [sensor] [min ms] [max ms] [max step degC] [transient degC]
+ *
+ * The trace is a hist_get CSV (index,boot,time_ms,sensor,raw,degC) sampled
+ * at least as fast as the minimum period; only the given sensor and the
+ * first boot in the file are used. --synthetic makes a two hour trace at
+ * 125 ms with flat, ramping, stepping and cycling parts and sensor noise.
+ *
+ * The sampler reads the trace at the times Adaptive_update asks for, linear
+ * between trace points. It reports samples, effective rate and modeled I2C
+ * time against fixed periods of min ms and 1 s, and how far a line through
+ * the samples strays from the full trace.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "adaptive.h"
+
+/* I2C at 100 kHz, result read: address, pointer, repeated start, address, 2 bytes */
+#define BUS_READ_US             480
+/* Configuration write: address, pointer, 2 bytes */
+#define BUS_CONFIG_US           380
+
+#define SYNTH_PERIOD_MS         125
+#define SYNTH_HOURS             2
+
+typedef struct Trace {
+    uint32_t *time_ms;
+    float *temp;
+    uint32_t count;
+} Trace;
+
+typedef struct Replay_Result {
+    uint32_t samples;
+    uint32_t configWrites;
+    float maxError;             // degC, line through the samples against the trace
+    float rmsError;
+} Replay_Result;
+
+static bool trace_add(Trace *trace, uint32_t time_ms, float temp, uint32_t *capacity)
+{
+    if (trace->count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 4096;
+        trace->time_ms = realloc(trace->time_ms, *capacity * sizeof(uint32_t));
+        trace->temp = realloc(trace->temp, *capacity * sizeof(float));
+        if (trace->time_ms == NULL || trace->temp == NULL) {
+            return false;
+        }
+    }
+    trace->time_ms[trace->count] = time_ms;
+    trace->temp[trace->count] = temp;
+    trace->count++;
+    return true;
+}
+
+static bool load_csv(Trace *trace, const char *path, unsigned sensorId)
+{
+    char line[160];
+    uint32_t capacity = 0;
+    unsigned index, boot, time_ms, sensor, firstBoot = 0;
+    int raw;
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return false;
+    }
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (sscanf(line, "%u,%u,%u,%u,%d", &index, &boot, &time_ms, &sensor, &raw) != 5 || sensor != sensorId) {
+            continue;
+        }
+        if (!firstBoot) {
+            firstBoot = boot;
+        }
+        if (boot != firstBoot) {
+            break;
+        }
+        if (trace->count && time_ms <= trace->time_ms[trace->count - 1]) {
+            continue;
+        }
+        if (!trace_add(trace, time_ms, raw / 128.0f, &capacity)) {
+            break;
+        }
+    }
+    fclose(file);
+    return trace->count > 1;
+}
+
+/*
+ * Flat, a heating ramp, a hold, a sudden drop, a thermostat cycle, flat
+ */
+static void make_synthetic(Trace *trace)
+{
+    uint32_t capacity = 0;
+    uint32_t seed = 7;
+    uint32_t end = SYNTH_HOURS * 3600000;
+
+    for (uint32_t t = 0; t < end; t += SYNTH_PERIOD_MS) {
+        double s = t / 1000.0;
+        double temp = 22.0;
+        if (s >= 1200 && s < 1800) {
+            temp += 2.0 * (s - 1200) / 600;                 // 2 degC in 10 min
+        }
+        else if (s >= 1800 && s < 3000) {
+            temp += 2.0;
+        }
+        else if (s >= 3000 && s < 3600) {
+            temp += 0.5 + 1.5 * exp(-(s - 3000) / 8);        // Probe moved, 8 s time constant
+        }
+        else if (s >= 3600 && s < 4500) {
+            temp += 0.5 + 0.3 * sin(2 * M_PI * (s - 3600) / 60);  // 60 s cycle
+        }
+        else if (s >= 4500) {
+            temp += 0.5;
+        }
+        seed = seed * 1103515245 + 12345;
+        temp += (((seed >> 16) & 0xFF) - 127.5) / 127.5 * 0.012;  // About 1.5 LSB of noise
+        trace_add(trace, t, roundf((float)temp * 128) / 128, &capacity);
+    }
+}
+
+static float trace_at(const Trace *trace, double time_ms, uint32_t *hint)
+{
+    uint32_t n = *hint;
+    while (n + 1 < trace->count && trace->time_ms[n + 1] <= time_ms) {
+        n++;
+    }
+    *hint = n;
+    if (n + 1 >= trace->count) {
+        return trace->temp[trace->count - 1];
+    }
+    double f = (time_ms - trace->time_ms[n]) / (double)(trace->time_ms[n + 1] - trace->time_ms[n]);
+    return (float)(trace->temp[n] + f * (trace->temp[n + 1] - trace->temp[n]));
+}
+
+/*
+ * Samples the trace, at a fixed period if rate is NULL
+ */
+static Replay_Result replay(const Trace *trace, Adaptive_Rate *rate, uint32_t period_us)
+{
+    Replay_Result result = {0};
+    uint32_t capacity = 0, hint = 0;
+    Trace taken = {0};
+    double t = trace->time_ms[0];
+    double end = trace->time_ms[trace->count - 1];
+
+    if (rate != NULL) {
+        Adaptive_start(rate);
+    }
+    while (t <= end) {
+        float temp = trace_at(trace, t, &hint);
+        trace_add(&taken, (uint32_t)t, temp, &capacity);
+        result.samples++;
+        if (rate != NULL) {
+            uint32_t last = rate->period_us;
+            period_us = Adaptive_update(rate, temp, (uint64_t)(t * 1000));
+            rate->stats.busTime_us += BUS_READ_US;
+            if (period_us != last) {
+                result.configWrites++;
+            }
+        }
+        t += period_us / 1000.0;
+    }
+
+    double sum = 0;
+    hint = 0;
+    for (uint32_t n = 0; n < trace->count; n++) {
+        float error = fabsf(trace_at(&taken, trace->time_ms[n], &hint) - trace->temp[n]);
+        sum += (double)error * error;
+        if (error > result.maxError) {
+            result.maxError = error;
+        }
+    }
+    result.rmsError = (float)sqrt(sum / trace->count);
+    free(taken.time_ms);
+    free(taken.temp);
+    return result;
+}
+
+static void report(const char *name, const Replay_Result *result, double hours, const Replay_Result *base)
+{
+    double bus_ms = (result->samples * (double)BUS_READ_US + result->configWrites * (double)BUS_CONFIG_US) / 1000;
+    double base_ms = base->samples * (double)BUS_READ_US / 1000;
+    printf("%-22s %7u samples %6.3f Hz  bus %8.0f ms (%5.1f %%)  error max %.3f rms %.4f degC\n", name,
+           result->samples, result->samples / (hours * 3600), bus_ms, 100 * bus_ms / base_ms,
+           result->maxError, result->rmsError);
+}
+
+int main(int argc, char **argv)
+{
+    Trace trace = {0};
+    Adaptive_Rate rate;
+    char name[32];
+    const char *source = (argc > 1) ? argv[1] : "--synthetic";
+    unsigned sensor = (argc > 2) ? (unsigned)strtoul(argv[2], NULL, 0) : 0;
+
+    memset(&rate, 0, sizeof(Adaptive_Rate));
+    rate.config.minPeriod_us = ((argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 0) : 125) * 1000;
+    rate.config.maxPeriod_us = ((argc > 4) ? (uint32_t)strtoul(argv[4], NULL, 0) : 16000) * 1000;
+    rate.config.maxStep = (argc > 5) ? strtof(argv[5], NULL) : 0.1f;
+    rate.config.transient = (argc > 6) ? strtof(argv[6], NULL) : 0.25f;
+
+    if (strcmp(source, "--synthetic") == 0) {
+        make_synthetic(&trace);
+    }
+    else if (!load_csv(&trace, source, sensor)) {
+        fprintf(stderr, "no samples of sensor %u in %s\n", sensor, source);
+        return 1;
+    }
+    double hours = (trace.time_ms[trace.count - 1] - trace.time_ms[0]) / 3600000.0;
+    printf("%u trace points over %.2f h, min %u ms, max %u ms, step %.3f, transient %.3f degC\n",
+           trace.count, hours, rate.config.minPeriod_us / 1000, rate.config.maxPeriod_us / 1000,
+           rate.config.maxStep, rate.config.transient);
+
+    Replay_Result fast = replay(&trace, NULL, rate.config.minPeriod_us);
+    Replay_Result second = replay(&trace, NULL, 1000000);
+    Replay_Result adaptive = replay(&trace, &rate, 0);
+
+    snprintf(name, sizeof(name), "fixed %u ms", rate.config.minPeriod_us / 1000);
+    report(name, &fast, hours, &fast);
+    report("fixed 1000 ms", &second, hours, &fast);
+    report("adaptive", &adaptive, hours, &fast);
+    printf("adaptive: %u transients, %u period changes, %u samples a fixed %u ms period takes (Adaptive_fixedSamples)\n",
+           rate.stats.transients, rate.stats.changes, Adaptive_fixedSamples(&rate), rate.config.minPeriod_us / 1000);
+    printf("bus time saved: %.0f ms against %u ms, %.0f ms against 1000 ms\n",
+           (fast.samples - adaptive.samples) * (double)BUS_READ_US / 1000 - adaptive.configWrites * (double)BUS_CONFIG_US / 1000,
+           rate.config.minPeriod_us / 1000,
+           ((double)second.samples - adaptive.samples) * BUS_READ_US / 1000 - adaptive.configWrites * (double)BUS_CONFIG_US / 1000);
+
+    free(trace.time_ms);
+    free(trace.temp);
+    return 0;
+}
@@ -0,0 +1,281 @@
+/*
+ * completion_check.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Checks the Completion tokens of the TMP117 requests
+ *      completion_check [latency requests]
+ *
+ * Opens a sensor with Open_TMP on the host stand-in, I2C_transfer is
+ * replaced so a test can make the bus fail. Every way a request can end
+ * is checked against the token: done with the result, failed on a bus
+ * error, dropped by a full queue, cancelled by Stop while running or still
+ * queued, a wait that times out, and the callback running once per
+ * request. For the full queue the sensor is held with Active_claim so the
+ * number of drops does not depend on the scheduler. Last, the time from
+ * ReadID to the caller seeing the result with Completion_wait, polling
+ * and a callback. Exits 1 on a failure.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "sim.h"
+#include "TMP117.h"
+#include "utilities.h"
+
+/* Requests posted at the held sensor, more than the queue takes */
+#define BURST                   (ACTIVE_QUEUE_SIZE * 3)
+
+void Detect_request(TMP_Handle *tmp_handle, Completion *done);
+void ReadTemp_request(TMP_Handle *tmp_handle, uint8_t count, Completion *done);
+void ReadID_request(TMP_Handle *tmp_handle, Completion *done);
+void ReadCal_request(TMP_Handle *tmp_handle, Completion *done);
+void Monitor_request(TMP_Handle *tmp_handle, uint16_t period_ms, Completion *done);
+void TMP_Stop_request(TMP_Handle *tmp_handle);
+
+static const char *status_name[] = {"idle", "pending", "done", "failed", "dropped", "cancelled"};
+
+static TMP_Handle tmp;
+static volatile bool busFails;
+static uint32_t failures;
+
+static pthread_t mainThread;
+static uint32_t callbacks;
+static uint32_t callbacksInPoster;
+static volatile uint64_t callback_us;
+
+/*
+ * Bus, every read returns SIM_I2C_RESULT unless busFails
+ */
+bool I2C_transfer(I2C_Handle handle, I2C_Transaction *transaction)
+{
+    (void)handle;
+    if (busFails) {
+        transaction->status = I2C_STATUS_ADDR_NACK;
+        return false;
+    }
+    if (transaction->readCount >= 2) {
+        ((uint8_t *)transaction->readBuf)[0] = (uint8_t)(SIM_I2C_RESULT >> 8);
+        ((uint8_t *)transaction->readBuf)[1] = (uint8_t)SIM_I2C_RESULT;
+    }
+    transaction->status = I2C_STATUS_SUCCESS;
+    return true;
+}
+
+static void count_callback(Completion *done, void *arg)
+{
+    (void)done;
+    (void)arg;
+    callback_us = clock_us();
+    if (pthread_equal(pthread_self(), mainThread)) {
+        callbacksInPoster++;
+    }
+    __atomic_add_fetch(&callbacks, 1, __ATOMIC_RELEASE);
+}
+
+static void expect(const char *what, Completion_Status status, Completion_Status want)
+{
+    if (status != want) {
+        printf("FAIL %s: %s, want %s\n", what, status_name[status], status_name[want]);
+        failures++;
+    }
+}
+
+static void expect_true(const char *what, bool ok)
+{
+    if (!ok) {
+        printf("FAIL %s\n", what);
+        failures++;
+    }
+}
+
+/* Finished tokens are stamped in order, dropped ones never started */
+static void expect_times(const char *what, const Completion *done)
+{
+    bool ok = done->posted_us && done->done_us >= done->posted_us;
+    if (done->status == COMPLETION_Dropped) {
+        ok &= done->started_us == 0;
+    }
+    else if (done->status == COMPLETION_Done || done->status == COMPLETION_Failed) {
+        ok &= done->started_us >= done->posted_us && done->done_us >= done->started_us;
+    }
+    expect_true(what, ok);
+}
+
+static void check_done(void)
+{
+    Completion detect, id, temp;
+    Completion_init(&detect, NULL, NULL);
+    Completion_init(&id, NULL, NULL);
+    Completion_init(&temp, NULL, NULL);
+
+    Detect_request(&tmp, &detect);
+    ReadID_request(&tmp, &id);
+    expect("Detect", Completion_wait(&detect, 100000), COMPLETION_Done);
+    expect_true("Detect result", detect.result.b);
+    expect_times("Detect times", &detect);
+    expect("ReadID", Completion_wait(&id, 100000), COMPLETION_Done);
+    expect_true("ReadID result", id.result.u16 == (SIM_I2C_RESULT & 0x0FFF));
+    expect_times("ReadID times", &id);
+
+    // Two samples 1s apart, a short wait times out and leaves it pending
+    ReadTemp_request(&tmp, 2, &temp);
+    expect("ReadTemp 2 after 100ms", Completion_wait(&temp, 100000), COMPLETION_Pending);
+    expect("ReadTemp 2", Completion_wait(&temp, COMPLETION_WAIT_FOREVER), COMPLETION_Done);
+    expect_true("ReadTemp result 25 degC", temp.result.f32 == SIM_I2C_RESULT / 128.0f);
+    expect_true("ReadTemp took 1s", temp.done_us - temp.posted_us >= 1000000);
+    expect_times("ReadTemp times", &temp);
+    printf("done       Detect %s, ReadID 0x%03X, ReadTemp 2 %.3f degC in %llu ms, waited 100 ms: pending\n",
+           detect.result.b ? "found" : "missing", id.result.u16, temp.result.f32,
+           (unsigned long long)(temp.done_us - temp.posted_us) / 1000);
+}
+
+static void check_failed(void)
+{
+    Completion id, temp;
+    Completion_init(&id, NULL, NULL);
+    Completion_init(&temp, NULL, NULL);
+
+    busFails = true;
+    ReadID_request(&tmp, &id);
+    ReadTemp_request(&tmp, 1, &temp);
+    Completion_Status idStatus = Completion_wait(&id, 100000);
+    Completion_Status tempStatus = Completion_wait(&temp, 100000);
+    busFails = false;
+    expect("ReadID on a failing bus", idStatus, COMPLETION_Failed);
+    expect("ReadTemp on a failing bus", tempStatus, COMPLETION_Failed);
+    expect_times("failed times", &id);
+    printf("failed     ReadID %s, ReadTemp %s\n", status_name[idStatus], status_name[tempStatus]);
+}
+
+static void check_dropped(void)
+{
+    Completion burst[BURST];
+    uint32_t dropped = 0, done = 0;
+    uint32_t before = tmp.active.stats.dropped;
+
+    while (!Active_claim(&tmp.active)) {
+        usleep(1000);
+    }
+    callbacks = 0;
+    callbacksInPoster = 0;
+    for (uint32_t n = 0; n < BURST; n++) {
+        Completion_init(&burst[n], count_callback, NULL);
+        ReadID_request(&tmp, &burst[n]);
+        if (Completion_poll(&burst[n]) == COMPLETION_Dropped) {
+            dropped++;
+        }
+    }
+    Active_release(&tmp.active);
+    for (uint32_t n = 0; n < BURST; n++) {
+        Completion_Status status = Completion_wait(&burst[n], 100000);
+        if (status == COMPLETION_Done) {
+            done++;
+        }
+        expect_times("burst times", &burst[n]);
+    }
+    usleep(10000);
+    expect_true("queue took ACTIVE_QUEUE_SIZE", done == ACTIVE_QUEUE_SIZE);
+    expect_true("rest dropped at post", dropped == BURST - ACTIVE_QUEUE_SIZE);
+    expect_true("stats.dropped counted", tmp.active.stats.dropped - before == dropped);
+    expect_true("one callback per request", callbacks == BURST);
+    expect_true("dropped callbacks ran in the poster", callbacksInPoster == dropped);
+    printf("dropped    %u ReadID at a held sensor: %u done, %u dropped at post, stats.dropped +%u, "
+           "callbacks %u (%u in the poster)\n", BURST, done, dropped, tmp.active.stats.dropped - before,
+           callbacks, callbacksInPoster);
+}
+
+static void check_cancelled(void)
+{
+    Completion monitor, queued, after;
+    Completion_init(&monitor, NULL, NULL);
+    Completion_init(&queued, NULL, NULL);
+    Completion_init(&after, NULL, NULL);
+
+    // ReadCal may not run between Monitor samples, it waits in the queue
+    Monitor_request(&tmp, 10, &monitor);
+    ReadCal_request(&tmp, &queued);
+    usleep(30000);
+    expect("Monitor before Stop", Completion_poll(&monitor), COMPLETION_Pending);
+    expect("ReadCal behind Monitor", Completion_poll(&queued), COMPLETION_Pending);
+    TMP_Stop_request(&tmp);
+    ReadID_request(&tmp, &after);
+    Completion_Status monitorStatus = Completion_wait(&monitor, 100000);
+    Completion_Status queuedStatus = Completion_wait(&queued, 100000);
+    Completion_Status afterStatus = Completion_wait(&after, 100000);
+    expect("Monitor after Stop", monitorStatus, COMPLETION_Cancelled);
+    expect("queued ReadCal after Stop", queuedStatus, COMPLETION_Cancelled);
+    expect("ReadID posted after Stop", afterStatus, COMPLETION_Done);
+    expect_true("Monitor ran", monitor.started_us != 0);
+    expect_true("queued ReadCal never ran", queued.started_us == 0);
+    printf("cancelled  running Monitor %s, queued ReadCal %s, ReadID posted after Stop %s\n",
+           status_name[monitorStatus], status_name[queuedStatus], status_name[afterStatus]);
+}
+
+/* ReadID to the caller seeing the result */
+static void latency(uint32_t requests)
+{
+    Completion done, called;
+    uint64_t waitSum = 0, pollSum = 0, callbackSum = 0;
+    uint32_t waitMax = 0;
+    Completion_init(&done, NULL, NULL);
+    Completion_init(&called, count_callback, NULL);
+
+    for (uint32_t n = 0; n < requests; n++) {
+        uint64_t start = clock_us();
+        ReadID_request(&tmp, &done);
+        Completion_wait(&done, COMPLETION_WAIT_FOREVER);
+        uint32_t took = (uint32_t)(clock_us() - start);
+        waitSum += took;
+        if (took > waitMax) {
+            waitMax = took;
+        }
+    }
+    for (uint32_t n = 0; n < requests; n++) {
+        uint64_t start = clock_us();
+        ReadID_request(&tmp, &done);
+        while (Completion_poll(&done) == COMPLETION_Pending) {
+            sched_yield();
+        }
+        pollSum += clock_us() - start;
+    }
+    for (uint32_t n = 0; n < requests; n++) {
+        uint32_t seen = __atomic_load_n(&callbacks, __ATOMIC_ACQUIRE);
+        uint64_t start = clock_us();
+        ReadID_request(&tmp, &called);
+        while (__atomic_load_n(&callbacks, __ATOMIC_ACQUIRE) == seen) {
+            sched_yield();
+        }
+        callbackSum += callback_us - start;
+    }
+    printf("latency    ReadID to result over %u requests: wait %.1f us avg %u us max, poll %.1f us, "
+           "callback %.1f us\n", requests, (double)waitSum / requests, waitMax,
+           (double)pollSum / requests, (double)callbackSum / requests);
+}
+
+int main(int argc, char **argv)
+{
+    static const char name[10] = "T0";
+    uint32_t requests = argc > 1 ? (uint32_t)atoi(argv[1]) : 2000;
+    mainThread = pthread_self();
+
+    Open_TMP(&tmp, (I2C_Handle)1, TMP117_ADDR, name);
+    while (!Active_ready(&tmp.active)) {
+        usleep(1000);
+    }
+    check_done();
+    check_failed();
+    check_dropped();
+    check_cancelled();
+    if (requests) {
+        latency(requests);
+    }
+
+    printf("%s\n", failures ? "FAILED" : "all passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,240 @@
+/*
+ * coop_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Compares the threaded and the FW_COOPERATIVE build of the active objects
+ *      coop_bench [sensors] [leds] [stop rounds]
+ *
+ * Build it twice, with and without -DFW_COOPERATIVE, and compare the two
+ * reports. Opens the sensors with Open_TMP and the LEDs with Open_myPWM on
+ * the host stand-in next to a plain object whose dispatch measures the
+ * time from post. Reports:
+ *      RAM for the objects and the stacks they need, host stacks are not
+ *      the firmware's so they are counted from the configured sizes
+ *      Post to dispatch latency and throughput, first with everything
+ *      idle, then with Monitor every 10ms on each sensor and Pulse on
+ *      each LED
+ *      Stop racing the continuations: Monitor and Pulse are started and
+ *      stopped after 0 to 15ms, with 0 Stop may find the request still
+ *      queued. After a Stop every LED must be off and no sensor may read
+ *      or LED change again
+ * Exits 1 if a Stop leaves anything running.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+
+#include "sim.h"
+#include "TMP117.h"
+#include "myPWM.h"
+#include "utilities.h"
+
+#define OBJECTS_MAX             4
+#define LATENCY_MESSAGES        2000
+#define THROUGHPUT_MESSAGES     200000
+
+void Monitor_request(TMP_Handle *tmp_handle, uint16_t period_ms, Completion *done);
+void TMP_Stop_request(TMP_Handle *tmp_handle);
+void Pulse_request(myPWM_Handle *handle, uint8_t count);
+void PWM_Stop_request(myPWM_Handle *handle);
+
+static TMP_Handle tmp[OBJECTS_MAX];
+static myPWM_Handle led[OBJECTS_MAX];
+static uint32_t sensors = 2;
+static uint32_t leds = 2;
+
+static Active_Object probe;
+static uint32_t probed;         // Messages dispatched by the probe
+static uint64_t latencySum;
+static uint32_t latencyMax;
+static uint32_t rng = 1;
+
+/* Post time is carried in arg (high) and value (low) */
+static void probe_dispatch(void *owner, const Active_Msg *msg)
+{
+    (void)owner;
+    uint64_t posted = (uint64_t)msg->arg << 32 | msg->value.u32;
+    uint32_t latency = (uint32_t)(clock_us() - posted);
+    latencySum += latency;
+    if (latency > latencyMax) {
+        latencyMax = latency;
+    }
+    __atomic_add_fetch(&probed, 1, __ATOMIC_RELEASE);
+}
+
+static const Active_Config probe_config = {
+    .priority = 2,
+    .stackSize = 1024,
+    .dispatch = probe_dispatch
+};
+
+static bool probe_post(void)
+{
+    uint64_t now = clock_us();
+    Active_Msg msg = {.arg = (uint16_t)(now >> 32), .value.u32 = (uint32_t)now};
+    return Active_post(&probe, &msg);
+}
+
+static void measure(const char *name)
+{
+    latencySum = 0;
+    latencyMax = 0;
+    uint32_t base = __atomic_load_n(&probed, __ATOMIC_ACQUIRE);
+
+    // One message at a time
+    for (uint32_t n = 1; n <= LATENCY_MESSAGES; n++) {
+        probe_post();
+        while (__atomic_load_n(&probed, __ATOMIC_ACQUIRE) < base + n) {
+            sched_yield();
+        }
+    }
+    double average = (double)latencySum / LATENCY_MESSAGES;
+    uint32_t worst = latencyMax;
+
+    // As fast as the queue takes them
+    base = __atomic_load_n(&probed, __ATOMIC_ACQUIRE);
+    uint64_t start = clock_us();
+    for (uint32_t n = 0; n < THROUGHPUT_MESSAGES; n++) {
+        while (!probe_post()) {
+            sched_yield();
+        }
+    }
+    while (__atomic_load_n(&probed, __ATOMIC_ACQUIRE) < base + THROUGHPUT_MESSAGES) {
+        sched_yield();
+    }
+    uint64_t took = clock_us() - start;
+    printf("%-8s post to dispatch %5.1f us avg %6u us max, %7.0f msgs/s\n", name, average, worst,
+           THROUGHPUT_MESSAGES * 1e6 / took);
+}
+
+static void start_all(void)
+{
+    for (uint32_t n = 0; n < sensors; n++) {
+        Monitor_request(&tmp[n], 10, NULL);
+    }
+    for (uint32_t n = 0; n < leds; n++) {
+        Pulse_request(&led[n], 100);
+    }
+}
+
+static void stop_all(void)
+{
+    for (uint32_t n = 0; n < sensors; n++) {
+        TMP_Stop_request(&tmp[n]);
+    }
+    for (uint32_t n = 0; n < leds; n++) {
+        PWM_Stop_request(&led[n]);
+    }
+}
+
+static bool any_led_on(void)
+{
+    for (uint32_t n = 0; n < leds; n++) {
+        if (sim_pwm_running[n]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Starts and stops everything rounds times
+ * Returns the rounds where something kept running
+ */
+static uint32_t stop_races(uint32_t rounds, uint32_t *slowest_us)
+{
+    uint32_t faults = 0;
+    uint32_t duty[OBJECTS_MAX];
+    *slowest_us = 0;
+
+    for (uint32_t r = 0; r < rounds; r++) {
+        start_all();
+        rng = rng * 1664525u + 1013904223u;
+        usleep((rng >> 8) % 16 * 1000);
+        uint64_t stopped = clock_us();
+        stop_all();
+        while (any_led_on() && clock_us() - stopped < 100000) {
+            sched_yield();
+        }
+        uint32_t off_us = (uint32_t)(clock_us() - stopped);
+        if (off_us > *slowest_us) {
+            *slowest_us = off_us;
+        }
+        // A step already running may finish, after that nothing moves
+        usleep(5000);
+        uint32_t transfers = __atomic_load_n(&sim_i2c_transfers, __ATOMIC_ACQUIRE);
+        memcpy(duty, sim_pwm_duty, sizeof(duty));
+        usleep(30000);
+        if (any_led_on() || transfers != __atomic_load_n(&sim_i2c_transfers, __ATOMIC_ACQUIRE) ||
+            memcmp(duty, sim_pwm_duty, sizeof(duty)) != 0) {
+            faults++;
+        }
+    }
+    return faults;
+}
+
+int main(int argc, char **argv)
+{
+    static const char names[OBJECTS_MAX][10] = {"0", "1", "2", "3"};
+    sensors = argc > 1 ? (uint32_t)atoi(argv[1]) : 2;
+    leds = argc > 2 ? (uint32_t)atoi(argv[2]) : 2;
+    uint32_t rounds = argc > 3 ? (uint32_t)atoi(argv[3]) : 100;
+    if (sensors > OBJECTS_MAX || leds > OBJECTS_MAX) {
+        fprintf(stderr, "0 to %u sensors and leds\n", OBJECTS_MAX);
+        return 1;
+    }
+
+    for (uint32_t n = 0; n < sensors; n++) {
+        Open_TMP(&tmp[n], (I2C_Handle)1, TMP117_ADDR, names[n]);
+    }
+    for (uint32_t n = 0; n < leds; n++) {
+        Open_myPWM(&led[n], (uint_least8_t)n, names[n], 0, 0);
+    }
+    Active_start(&probe, &probe_config, &probe, "probe");
+    for (uint32_t n = 0; n < sensors; n++) {
+        while (!Active_ready(&tmp[n].active)) {
+            usleep(1000);
+        }
+    }
+    for (uint32_t n = 0; n < leds; n++) {
+        while (!Active_ready(&led[n].active)) {
+            usleep(1000);
+        }
+    }
+    while (!Active_ready(&probe)) {
+        usleep(1000);
+    }
+
+#ifdef FW_COOPERATIVE
+    const char *build = "cooperative";
+    uint32_t tasks = 1;
+    uint32_t stacks = ACTIVE_LOOP_STACK_SIZE;
+#else
+    const char *build = "threaded";
+    uint32_t tasks = sensors + leds;
+    uint32_t stacks = sensors * TMP_STACK_SIZE + leds * MYPWM_STACK_SIZE;
+#endif
+    uint32_t objects = sensors * sizeof(TMP_Handle) + leds * sizeof(myPWM_Handle);
+    printf("%s build, %u sensors, %u LEDs\n", build, sensors, leds);
+    printf("RAM      Active_Object %zu, TMP_Handle %zu, myPWM_Handle %zu bytes\n",
+           sizeof(Active_Object), sizeof(TMP_Handle), sizeof(myPWM_Handle));
+    printf("RAM      handles %u + %u task stacks %u = %u bytes\n", objects, tasks, stacks, objects + stacks);
+
+    measure("idle");
+    start_all();
+    usleep(100000);
+    measure("busy");
+    stop_all();
+    usleep(50000);
+
+    uint32_t slowest;
+    uint32_t faults = stop_races(rounds, &slowest);
+    printf("Stop     %u rounds, %u left something running, LEDs off within %u us\n", rounds, faults,
+           slowest);
+    return faults ? 1 : 0;
+}
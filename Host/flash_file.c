@@ -0,0 +1,117 @@
+/*
+ * flash_file.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "flash_file.h"
+
+static bool file_read(void *device, uint32_t offset, void *buffer, size_t length)
+{
+    Flash_File *file = (Flash_File*)device;
+    if (offset + length > file->size) {
+        return false;
+    }
+    memcpy(buffer, file->base + offset, length);
+    return true;
+}
+
+static bool file_write(void *device, uint32_t offset, const void *buffer, size_t length)
+{
+    Flash_File *file = (Flash_File*)device;
+    const uint8_t *bytes = (const uint8_t*)buffer;
+    bool torn = false;
+
+    if (offset + length > file->size) {
+        return false;
+    }
+    if (file->failAfter) {
+        // Power lost in the middle of this write
+        if (length > file->failAfter) {
+            length = file->failAfter;
+            file->failAfter = 0;
+            torn = true;
+        }
+        else {
+            file->failAfter -= length;
+        }
+    }
+    for (size_t n = 0; n < length; n++) {
+        file->base[offset + n] &= bytes[n];
+    }
+    file->programmed += length;
+    file->writes++;
+    return !torn;
+}
+
+static bool file_erase(void *device, uint32_t offset, size_t length)
+{
+    Flash_File *file = (Flash_File*)device;
+    if (offset % file->sectorSize || length % file->sectorSize || offset + length > file->size) {
+        return false;
+    }
+    memset(file->base + offset, 0xFF, length);
+    for (uint32_t sector = offset / file->sectorSize; sector < (offset + length) / file->sectorSize; sector++) {
+        file->erases[sector]++;
+        file->erased++;
+    }
+    return true;
+}
+
+/*
+ * Maps a flash image file, creating it erased if it does not exist
+ * Fills flash with the access functions and geometry for SampleLog_open
+ */
+bool FlashFile_open(Flash_File *file, SampleLog_Flash *flash, const char *path, uint32_t sectorSize, uint32_t sectors)
+{
+    struct stat st;
+    int fd;
+
+    memset(file, 0, sizeof(Flash_File));
+    file->size = sectorSize * sectors;
+    file->sectorSize = sectorSize;
+    if ((fd = open(path, O_RDWR | O_CREAT, 0644)) < 0) {
+        return false;
+    }
+    if (fstat(fd, &st) != 0 || (st.st_size != 0 && st.st_size != file->size)) {
+        close(fd);
+        return false;
+    }
+    bool created = (st.st_size == 0);
+    if (created && ftruncate(fd, file->size) != 0) {
+        close(fd);
+        return false;
+    }
+    file->base = mmap(NULL, file->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (file->base == MAP_FAILED) {
+        return false;
+    }
+    if (created) {
+        memset(file->base, 0xFF, file->size);
+    }
+    file->erases = calloc(sectors, sizeof(uint32_t));
+
+    flash->read = file_read;
+    flash->write = file_write;
+    flash->erase = file_erase;
+    flash->device = file;
+    flash->sectorSize = sectorSize;
+    flash->sectors = sectors;
+    return true;
+}
+
+void FlashFile_close(Flash_File *file)
+{
+    msync(file->base, file->size, MS_SYNC);
+    munmap(file->base, file->size);
+    free(file->erases);
+}
@@ -0,0 +1,35 @@
+/*
+ * flash_file.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Host stand-in for the NVS region of the sample log
+ *      A file mapped into memory behaves like NOR flash: a new file is
+ *      erased (0xFF), writes only clear bits and erase works on whole
+ *      sectors. Programmed bytes and erases are counted per sector.
+ */
+
+#ifndef FLASH_FILE_H_
+#define FLASH_FILE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "samplelog.h"
+
+typedef struct Flash_File {
+    uint8_t *base;
+    uint32_t size;
+    uint32_t sectorSize;
+    uint64_t programmed;        // Bytes written
+    uint64_t writes;            // Write calls
+    uint64_t erased;            // Sector erases
+    uint32_t *erases;           // Per sector
+    uint32_t failAfter;         // Bytes programmed before a simulated power loss, 0 never
+} Flash_File;
+
+bool FlashFile_open(Flash_File *file, SampleLog_Flash *flash, const char *path, uint32_t sectorSize, uint32_t sectors);
+void FlashFile_close(Flash_File *file);
+
+#endif /* FLASH_FILE_H_ */
@@ -0,0 +1,161 @@
+/*
+ * fmt_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Times the table driven formatters of Utilities/utilities.c against the
+ * ones they replaced, copied below: uint32ToStr with a division per digit
+ * and reverse(), ftoa scaling the fraction with pow(10, n)
+ *      fmt_bench [rounds]
+ *
+ * Cases are a TMP117 sample printed from its Q7 register value against
+ * the float temperature through the old ftoa, small counters, full range
+ * uint32 values and ftoa itself. The old copies are kept out of line and
+ * get the decimals at run time like the firmware, so pow() is not folded.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "utilities.h"
+
+static volatile int decimals = 3;
+static volatile int sink;
+
+static void old_reverse(char *str, int len)
+{
+    int i = 0, j = len - 1, temp;
+    while (i < j) {
+        temp = str[i];
+        str[i] = str[j];
+        str[j] = temp;
+        i++;
+        j--;
+    }
+}
+
+__attribute__((noinline)) static int old_uint32ToStr(uint32_t x, char str[], int d)
+{
+    int i = 0;
+    while (x) {
+        str[i++] = (x % 10) + '0';
+        x = x / 10;
+    }
+    while (i < d) {
+        str[i] = '0';
+        i++;
+    }
+    old_reverse(str, i);
+    str[i] = '\0';
+    return i;
+}
+
+__attribute__((noinline)) static int old_ftoa(float n, char *res, int afterpoint)
+{
+    int i = 0;
+    if (n < 0) {
+        res[i++] = '-';
+        n = -n;
+    }
+    if (n > 4294967040.0f) {
+        n = 4294967040.0f;
+    }
+    uint32_t ipart = (uint32_t)n;
+    float fpart = n - (float)ipart;
+    i += old_uint32ToStr(ipart, res + i, 1);
+    if (afterpoint != 0) {
+        res[i] = '.';
+        fpart = fpart * pow(10, afterpoint);
+        i += 1 + old_uint32ToStr((uint32_t)fpart, res + i + 1, afterpoint);
+    }
+    return i;
+}
+
+static double ns_per(uint64_t start, uint64_t count)
+{
+    return (clock_us() - start) * 1000.0 / count;
+}
+
+static void report(const char *name, double before, double after)
+{
+    printf("%-24s %6.1f ns %6.1f ns  %4.1fx\n", name, before, after, before / after);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t rounds = argc > 1 ? (uint32_t)atoi(argv[1]) : 30;
+    char buffer[FMT_BUFFER_SIZE];
+    uint64_t count = (uint64_t)rounds * 65536;
+    uint64_t start;
+    double before, after;
+
+    printf("%-24s %9s %9s  %5s\n", "", "before", "after", "gain");
+
+    // Every TMP117 result, as ReadTemp printed it before and prints it now
+    start = clock_us();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (int32_t raw = -32768; raw < 32768; raw++) {
+            sink += old_ftoa((float)raw * 0.0078125f, buffer, decimals);
+        }
+    }
+    before = ns_per(start, count);
+    start = clock_us();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (int32_t raw = -32768; raw < 32768; raw++) {
+            sink += fixedToStr(raw, 7, (uint8_t)decimals, buffer);
+        }
+    }
+    after = ns_per(start, count);
+    report("Q7 sample, 3 decimals", before, after);
+
+    start = clock_us();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (int32_t raw = -32768; raw < 32768; raw++) {
+            sink += old_ftoa((float)raw * 0.0078125f, buffer, decimals);
+        }
+    }
+    before = ns_per(start, count);
+    start = clock_us();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (int32_t raw = -32768; raw < 32768; raw++) {
+            sink += ftoa((float)raw * 0.0078125f, buffer, decimals);
+        }
+    }
+    after = ns_per(start, count);
+    report("ftoa, 3 decimals", before, after);
+
+    start = clock_us();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t n = 0; n < 65536; n++) {
+            sink += old_uint32ToStr(n % 10000, buffer, 1);
+        }
+    }
+    before = ns_per(start, count);
+    start = clock_us();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t n = 0; n < 65536; n++) {
+            sink += uint32ToStr(n % 10000, buffer, 1);
+        }
+    }
+    after = ns_per(start, count);
+    report("uint32 0-9999", before, after);
+
+    start = clock_us();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t n = 0; n < 65536; n++) {
+            sink += old_uint32ToStr((n | r << 16) * 2654435761u, buffer, 1);
+        }
+    }
+    before = ns_per(start, count);
+    start = clock_us();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t n = 0; n < 65536; n++) {
+            sink += uint32ToStr((n | r << 16) * 2654435761u, buffer, 1);
+        }
+    }
+    after = ns_per(start, count);
+    report("uint32 full range", before, after);
+    return 0;
+}
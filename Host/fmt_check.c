@@ -0,0 +1,238 @@
+/*
+ * fmt_check.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Checks the number formatting of Utilities/utilities.c
+ *      fmt_check [prints]
+ *
+ * Compares intToStr, uint32ToStr, ftoa and fixedToStr against expected
+ * strings, including negatives, zero, INT32_MIN and uint32 values past
+ * 2^24 that a float would round, and every Q7 value against the exact
+ * value. Then prints through uart_print_uint32, uart_print_float and
+ * uart_print_fixed with malloc, calloc and realloc wrapped, any heap
+ * call from the print path is a failure. Last the time per conversion.
+ * Exits 1 on a failure.
+ *
+ * Link with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <malloc.h>
+
+#include "sim.h"
+#include "uart_tx.h"
+#include "utilities.h"
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+
+static volatile bool counting;
+static uint32_t heap_calls;
+static uint32_t failures;
+static volatile int sink;
+
+void *__wrap_malloc(size_t size)
+{
+    if (counting) {
+        heap_calls++;
+    }
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+    if (counting) {
+        heap_calls++;
+    }
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size)
+{
+    if (counting) {
+        heap_calls++;
+    }
+    return __real_realloc(pointer, size);
+}
+
+static void expect(const char *what, const char *got, int length, const char *want)
+{
+    if (strcmp(got, want) != 0 || length != (int)strlen(want)) {
+        printf("FAIL %s: \"%s\" (%d), want \"%s\"\n", what, got, length, want);
+        failures++;
+    }
+}
+
+static void check_int(int value, int digits, const char *want)
+{
+    char buffer[FMT_BUFFER_SIZE];
+    char what[48];
+    int length = intToStr(value, buffer, digits);
+    buffer[length] = '\0';
+    snprintf(what, sizeof(what), "intToStr(%d, %d)", value, digits);
+    expect(what, buffer, length, want);
+}
+
+static void check_uint(uint32_t value, int digits, const char *want)
+{
+    char buffer[FMT_BUFFER_SIZE];
+    char what[48];
+    int length = uint32ToStr(value, buffer, digits);
+    snprintf(what, sizeof(what), "uint32ToStr(%u, %d)", value, digits);
+    expect(what, buffer, length, want);
+}
+
+static void check_float(float value, int decimals, const char *want)
+{
+    char buffer[FMT_BUFFER_SIZE];
+    char what[48];
+    int length = ftoa(value, buffer, decimals);
+    buffer[length] = '\0';
+    snprintf(what, sizeof(what), "ftoa(%g, %d)", value, decimals);
+    expect(what, buffer, length, want);
+}
+
+static void check_fixed(int32_t value, uint8_t fracBits, uint8_t decimals, const char *want)
+{
+    char buffer[FMT_BUFFER_SIZE];
+    char what[48];
+    int length = fixedToStr(value, fracBits, decimals, buffer);
+    buffer[length] = '\0';
+    snprintf(what, sizeof(what), "fixedToStr(%d, Q%u, %u)", value, fracBits, decimals);
+    expect(what, buffer, length, want);
+}
+
+/* Every Q7 value with 3 decimals against the exact value rounded half up */
+static void check_q7_sweep(void)
+{
+    char buffer[FMT_BUFFER_SIZE];
+    char want[FMT_BUFFER_SIZE];
+    uint32_t wrong = 0;
+    for (int32_t raw = -32768; raw < 32768; raw++) {
+        int length = fixedToStr(raw, 7, 3, buffer);
+        buffer[length] = '\0';
+        // Q7 with 3 decimals is exact in double, only the rounding needs care
+        double milli = floor(fabs(raw) * 1000.0 / 128.0 + 0.5);
+        snprintf(want, sizeof(want), "%s%.0f.%03.0f", raw < 0 ? "-" : "",
+                 floor(milli / 1000), fmod(milli, 1000));
+        if (strcmp(buffer, want) != 0) {
+            if (!wrong) {
+                printf("FAIL fixedToStr(%d, Q7, 3): \"%s\", want \"%s\"\n", raw, buffer, want);
+            }
+            wrong++;
+        }
+    }
+    failures += wrong;
+    printf("Q7 sweep: %u of 65536 values wrong\n", wrong);
+}
+
+static void check_heap(uint32_t prints)
+{
+    struct mallinfo2 before = mallinfo2();
+    heap_calls = 0;
+    counting = true;
+    for (uint32_t n = 0; n < prints; n++) {
+        uart_print_uint32(n * 2654435761u);
+        uart_print_float((float)(int32_t)n * -0.0078125f);
+        uart_print_fixed((int32_t)(n & 0xFFFF) - 32768, 7, 3);
+    }
+    counting = false;
+    struct mallinfo2 after = mallinfo2();
+    printf("heap: %u calls and %zd bytes in use change over %u prints of each kind\n",
+           heap_calls, (ssize_t)(after.uordblks - before.uordblks), prints);
+    if (heap_calls) {
+        failures++;
+    }
+}
+
+static double ns_per(uint64_t start, uint32_t count)
+{
+    return (clock_us() - start) * 1000.0 / count;
+}
+
+static void benchmark(void)
+{
+    char buffer[FMT_BUFFER_SIZE];
+    const uint32_t count = 2000000;
+    uint64_t start;
+
+    start = clock_us();
+    for (uint32_t n = 0; n < count; n++) {
+        sink += uint32ToStr(n * 2654435761u, buffer, 1);
+    }
+    printf("uint32ToStr      %6.1f ns\n", ns_per(start, count));
+
+    start = clock_us();
+    for (uint32_t n = 0; n < count; n++) {
+        sink += intToStr((int)(n * 2654435761u), buffer, 1);
+    }
+    printf("intToStr         %6.1f ns\n", ns_per(start, count));
+
+    start = clock_us();
+    for (uint32_t n = 0; n < count; n++) {
+        sink += fixedToStr((int32_t)(n & 0xFFFF) - 32768, 7, 3, buffer);
+    }
+    printf("fixedToStr Q7    %6.1f ns\n", ns_per(start, count));
+
+    start = clock_us();
+    for (uint32_t n = 0; n < count; n++) {
+        sink += ftoa((float)((int32_t)(n & 0xFFFF) - 32768) * 0.0078125f, buffer, 3);
+    }
+    printf("ftoa 3 decimals  %6.1f ns\n", ns_per(start, count));
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t prints = argc > 1 ? (uint32_t)atoi(argv[1]) : 100000;
+
+    check_int(0, 1, "0");
+    check_int(7, 3, "007");
+    check_int(-7, 3, "-007");
+    check_int(-123, 1, "-123");
+    check_int(INT_MAX, 1, "2147483647");
+    check_int(INT_MIN, 1, "-2147483648");
+
+    check_uint(0, 0, "0");
+    check_uint(0, 4, "0000");
+    check_uint(99, 1, "99");
+    check_uint(100, 1, "100");
+    check_uint(16777217, 1, "16777217");       // 2^24 + 1, not a float
+    check_uint(123456789, 1, "123456789");
+    check_uint(UINT32_MAX, 1, "4294967295");
+    check_uint(42, 12, "0000000042");          // Padding stops at 10 digits
+
+    check_float(0.0f, 3, "0.000");
+    check_float(-0.5f, 3, "-0.500");
+    check_float(23.125f, 3, "23.125");
+    check_float(-296.0f, 3, "-296.000");
+    check_float(0.0078125f, 3, "0.008");       // Rounded, not truncated
+    check_float(9.9996f, 3, "10.000");         // Carry into the integer part
+    check_float(1.5f, 0, "2");                 // Half up with no decimals
+    check_float(5e9f, 1, "4294967040.0");      // Saturated
+
+    check_fixed(2960, 7, 3, "23.125");
+    check_fixed(-37888, 7, 3, "-296.000");
+    check_fixed(0, 7, 3, "0.000");
+    check_fixed(1, 7, 3, "0.008");
+    check_fixed(-1, 7, 3, "-0.008");
+    check_fixed(8, 7, 3, "0.063");             // 0.0625, half up
+    check_fixed(127, 7, 2, "0.99");
+    check_fixed(INT32_MIN, 7, 3, "-16777216.000");
+    check_fixed(INT32_MAX, 16, 4, "32768.0000");
+    check_fixed(-5, 0, 3, "-5.000");
+    check_q7_sweep();
+
+    UART_TX_init(UART_TX_DROP);
+    check_heap(prints);
+    benchmark();
+
+    printf("%s\n", failures ? "FAILED" : "all passed");
+    return failures ? 1 : 0;
+}
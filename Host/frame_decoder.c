@@ -0,0 +1,174 @@
+/*
+ * frame_decoder.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#include <string.h>
+
+#include "frame_decoder.h"
+#include "framing.h"
+
+static uint16_t read16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * Resets the decoder
+ * Input sample callback for TLM_TYPE_SAMPLES frames (optional)
+ * Input log callback for LOG_TYPE_RECORDS frames (optional)
+ * Input frame callback for every other valid frame (optional)
+ */
+void Decoder_init(Frame_Decoder *decoder, Decoder_SampleFxn onSample, Decoder_LogFxn onLog,
+                  Decoder_FrameFxn onFrame, void *arg)
+{
+    memset(decoder, 0, sizeof(Frame_Decoder));
+    decoder->onSample = onSample;
+    decoder->onLog = onLog;
+    decoder->onFrame = onFrame;
+    decoder->arg = arg;
+}
+
+static void Decoder_samples(Frame_Decoder *decoder, const uint8_t *payload, size_t length)
+{
+    if (length < TLM_HEADER_SIZE) {
+        decoder->stats.framingErrors++;
+        return;
+    }
+    uint8_t sensorId = payload[1];
+    uint16_t sequence = read16(&payload[2]);
+    uint32_t first = read32(&payload[4]);
+    uint32_t last = read32(&payload[8]);
+    uint8_t count = payload[12];
+    if (count == 0 || count > TLM_MAX_SAMPLES || length != (size_t)TLM_HEADER_SIZE + 2*count) {
+        decoder->stats.framingErrors++;
+        return;
+    }
+
+    if (decoder->seen[sensorId] && sequence != decoder->nextSequence[sensorId]) {
+        decoder->stats.lostFrames += (uint16_t)(sequence - decoder->nextSequence[sensorId]);
+    }
+    decoder->seen[sensorId] = true;
+    decoder->nextSequence[sensorId] = (uint16_t)(sequence + 1);
+
+    uint32_t span = last - first;
+    uint8_t n = 0;
+    for (; n < count; n++) {
+        Decoder_Sample sample;
+        sample.sensorId = sensorId;
+        sample.timestamp_us = count > 1 ? first + (uint32_t)(((uint64_t)span * n) / (count - 1)) : first;
+        sample.raw = (int16_t)read16(&payload[TLM_HEADER_SIZE + 2*n]);
+        sample.temp = sample.raw / 128.0;
+        decoder->stats.samples++;
+        if (decoder->onSample != NULL) {
+            decoder->onSample(&sample, decoder->arg);
+        }
+    }
+}
+
+static void Decoder_logs(Frame_Decoder *decoder, const uint8_t *payload, size_t length)
+{
+    if (length < LOG_HEADER_SIZE) {
+        decoder->stats.framingErrors++;
+        return;
+    }
+    uint8_t thread = payload[1];
+    uint8_t count = payload[2];
+    uint16_t dropped = read16(&payload[3]);
+    decoder->stats.logDropped += (uint16_t)(dropped - decoder->logDropped[thread]);
+    decoder->logDropped[thread] = dropped;
+
+    size_t offset = LOG_HEADER_SIZE;
+    uint8_t n = 0;
+    for (; n < count; n++) {
+        Log_Record record;
+        if (offset + LOG_RECORD_MIN > length) {
+            decoder->stats.framingErrors++;
+            return;
+        }
+        memset(&record, 0, sizeof(record));
+        record.timestamp_us = read32(&payload[offset]);
+        record.id = read16(&payload[offset + 4]);
+        record.nargs = payload[offset + 6];
+        offset += LOG_RECORD_MIN;
+        if (record.nargs > LOG_MAX_ARGS || offset + 4*(size_t)record.nargs > length) {
+            decoder->stats.framingErrors++;
+            return;
+        }
+        uint8_t a = 0;
+        for (; a < record.nargs; a++) {
+            record.arg[a] = read32(&payload[offset]);
+            offset += 4;
+        }
+        decoder->stats.logRecords++;
+        if (decoder->onLog != NULL) {
+            decoder->onLog(&record, thread, decoder->arg);
+        }
+    }
+    if (offset != length) {
+        decoder->stats.framingErrors++;
+    }
+}
+
+static void Decoder_frame(Frame_Decoder *decoder)
+{
+    uint8_t payload[DECODER_MAX_FRAME];
+    size_t length = cobs_decode(decoder->encoded, decoder->fill, payload);
+    if (length < 1 + TLM_CRC_SIZE) {
+        decoder->stats.framingErrors++;
+        return;
+    }
+    length -= TLM_CRC_SIZE;
+    if (crc16(payload, length, 0xFFFF) != read16(&payload[length])) {
+        decoder->stats.crcErrors++;
+        return;
+    }
+    decoder->stats.frames++;
+
+    if (payload[0] == TLM_TYPE_SAMPLES) {
+        Decoder_samples(decoder, payload, length);
+    }
+    else if (payload[0] == LOG_TYPE_RECORDS) {
+        Decoder_logs(decoder, payload, length);
+    }
+    else if (decoder->onFrame != NULL) {
+        decoder->onFrame(payload, length, decoder->arg);
+    }
+    else {
+        decoder->stats.unknownTypes++;
+    }
+}
+
+/*
+ * Feeds raw bytes from the UART
+ */
+void Decoder_feed(Frame_Decoder *decoder, const uint8_t *data, size_t length)
+{
+    decoder->stats.bytes += length;
+    while (length--) {
+        uint8_t byte = *data++;
+        if (byte == FRAME_DELIMITER) {
+            if (decoder->overflow) {
+                decoder->stats.framingErrors++;
+            }
+            else if (decoder->fill) {
+                Decoder_frame(decoder);
+            }
+            decoder->fill = 0;
+            decoder->overflow = false;
+            continue;
+        }
+        if (decoder->fill >= sizeof(decoder->encoded)) {
+            decoder->overflow = true;
+            continue;
+        }
+        decoder->encoded[decoder->fill++] = byte;
+    }
+}
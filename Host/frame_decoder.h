@@ -0,0 +1,66 @@
+/*
+ * frame_decoder.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Host side decoder for the binary frames in protocol.h
+ * Feed raw UART bytes in any chunking, callbacks fire per decoded item
+ */
+
+#ifndef FRAME_DECODER_H_
+#define FRAME_DECODER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "protocol.h"
+#include "log.h"
+
+/* Largest decoded payload accepted */
+#define DECODER_MAX_FRAME       1024
+
+typedef struct Decoder_Sample {
+    uint8_t sensorId;
+    uint32_t timestamp_us;      // Device clock, low 32 bits
+    int16_t raw;                // TMP117 counts
+    double temp;                // degC
+} Decoder_Sample;
+
+typedef struct Decoder_Stats {
+    uint32_t frames;            // Frames with a valid CRC
+    uint32_t crcErrors;
+    uint32_t framingErrors;     // Bad COBS, oversize or truncated payloads
+    uint32_t lostFrames;        // Sequence gaps summed over all sensors
+    uint32_t unknownTypes;      // Valid frames of a type without a handler
+    uint32_t samples;
+    uint32_t logRecords;
+    uint32_t logDropped;        // Records the firmware reported as dropped
+    uint64_t bytes;             // Raw bytes fed in
+} Decoder_Stats;
+
+typedef struct Frame_Decoder Frame_Decoder;
+typedef void (*Decoder_SampleFxn)(const Decoder_Sample *sample, void *arg);
+typedef void (*Decoder_LogFxn)(const Log_Record *record, uint8_t thread, void *arg);
+typedef void (*Decoder_FrameFxn)(const uint8_t *payload, size_t length, void *arg);
+
+struct Frame_Decoder {
+    uint8_t encoded[DECODER_MAX_FRAME + DECODER_MAX_FRAME/254 + 2];
+    size_t fill;
+    bool overflow;              // Discard until the next delimiter
+    uint16_t nextSequence[256]; // Per sensor
+    bool seen[256];
+    uint16_t logDropped[256];   // Last drop count per thread slot
+    Decoder_SampleFxn onSample;
+    Decoder_LogFxn onLog;
+    Decoder_FrameFxn onFrame;   // Any other frame type with a valid CRC
+    void *arg;
+    Decoder_Stats stats;
+};
+
+void Decoder_init(Frame_Decoder *decoder, Decoder_SampleFxn onSample, Decoder_LogFxn onLog,
+                  Decoder_FrameFxn onFrame, void *arg);
+void Decoder_feed(Frame_Decoder *decoder, const uint8_t *data, size_t length);
+
+#endif /* FRAME_DECODER_H_ */
@@ -0,0 +1,164 @@
+/*
+ * hist_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Benchmarks the flash sample log on a memory mapped image
+ *      hist_bench [image] [samples] [sectors] [sector size]
+ *
+ * Appends synthetic samples one per write and in batches, then reports
+ * throughput, bytes programmed per sample, erase spread across sectors,
+ * recovery reads and time, and checks recovery from a torn write.
+ * Device throughput comes from a flash timing model (MODEL_*), the host
+ * figure only measures the log code.
+ * The image is recreated, defaults are 100000 samples in 32 x 4 KB sectors.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "flash_file.h"
+#include "samplelog.h"
+
+#define BENCH_SENSORS           4
+#define BENCH_OPENS             1000
+
+/* Device flash timing model, typical CC13x2/CC26x2 datasheet figures */
+#define MODEL_WRITE_US          20      // Driver and flash controller setup per NVS_write
+#define MODEL_WORD_US           8       // Program one 32 bit word
+#define MODEL_ERASE_US          8000    // Erase one sector
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Fills records like four probes sampled every 250 ms
+ */
+static void make_samples(SampleLog_Record *records, uint32_t count, uint32_t *n)
+{
+    for (uint32_t i = 0; i < count; i++, (*n)++) {
+        records[i].time_ms = *n * 250;
+        records[i].sensorId = (uint8_t)(*n % BENCH_SENSORS);
+        records[i].raw = (int16_t)(3000 + (*n / 64) % 400);
+    }
+}
+
+static int run(const char *path, uint32_t samples, uint32_t sectors, uint32_t sectorSize, uint32_t batch)
+{
+    Flash_File file;
+    SampleLog_Flash flash;
+    SampleLog log;
+    SampleLog_Record records[64];
+    SampleLog_Cursor cursor;
+    SampleLog_Record record;
+    uint32_t n = 0;
+    int failures = 0;
+
+    unlink(path);
+    if (!FlashFile_open(&file, &flash, path, sectorSize, sectors) || !SampleLog_open(&log, &flash)) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return 1;
+    }
+
+    double start = now_s();
+    while (n < samples) {
+        uint32_t count = (samples - n < batch) ? samples - n : batch;
+        make_samples(records, count, &n);
+        if (!SampleLog_append(&log, records, count)) {
+            failures++;
+        }
+    }
+    double elapsed = now_s() - start;
+
+    uint32_t minErases = UINT32_MAX, maxErases = 0;
+    for (uint32_t s = 0; s < sectors; s++) {
+        if (file.erases[s] < minErases) minErases = file.erases[s];
+        if (file.erases[s] > maxErases) maxErases = file.erases[s];
+    }
+    double device_s = (file.writes * MODEL_WRITE_US + file.programmed / 4 * MODEL_WORD_US +
+                       file.erased * MODEL_ERASE_US) * 1e-6;
+    printf("batch %2u: %.2f bytes programmed per sample (x%.3f of the record), %.2f erased, "
+           "%llu erases, %u-%u per sector\n",
+           batch, (double)file.programmed / samples,
+           (double)file.programmed / ((double)samples * SLOG_RECORD_SIZE),
+           (double)file.erased * sectorSize / samples,
+           (unsigned long long)file.erased, minErases, maxErases);
+    printf("          device model %.0f samples/s (%.0f us each), host %.1f M samples/s\n",
+           samples / device_s, device_s * 1e6 / samples, samples / elapsed * 1e-6);
+
+    // Recovery from the image as left, as at boot
+    start = now_s();
+    for (int i = 0; i < BENCH_OPENS; i++) {
+        SampleLog_open(&log, &flash);
+    }
+    elapsed = (now_s() - start) / BENCH_OPENS;
+    if (log.next != samples) {
+        failures++;
+    }
+
+    uint32_t kept = 0, expect = log.first;
+    SampleLog_rewind(&log, &cursor);
+    while (SampleLog_next(&log, &cursor, &record)) {
+        if (record.index != expect++ || record.boot != 1) {
+            failures++;
+        }
+        kept++;
+    }
+    uint32_t middle = log.first + kept / 2;
+    if (!SampleLog_seek(&log, &cursor, middle) || !SampleLog_next(&log, &cursor, &record) ||
+        record.index != middle) {
+        failures++;
+    }
+    printf("          recovery %u reads, %.1f us; %u samples kept of %u, boot %u, erase counts %u-%u\n",
+           log.stats.recoveryReads, elapsed * 1e6, kept, samples, log.boot,
+           log.stats.minErases, log.stats.maxErases);
+
+    // Power lost half way through a record, then resume after it
+    if (log.slot >= log.slots) {
+        make_samples(records, 1, &n);   // Start a sector so the loss hits a record
+        SampleLog_append(&log, records, 1);
+        samples++;
+    }
+    file.failAfter = SLOG_RECORD_SIZE / 2;
+    make_samples(records, 1, &n);
+    SampleLog_append(&log, records, 1);
+    SampleLog_open(&log, &flash);
+    make_samples(records, 1, &n);
+    SampleLog_append(&log, records, 1);
+    uint32_t resumed = log.next - 1;
+    if (!SampleLog_seek(&log, &cursor, samples) || !SampleLog_next(&log, &cursor, &record) ||
+        record.index != resumed || log.stats.torn != 1) {
+        failures++;
+    }
+    printf("          torn record skipped %u, next record %u in boot %u\n",
+           log.stats.torn, record.index, record.boot);
+
+    FlashFile_close(&file);
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = (argc > 1) ? argv[1] : "hist.img";
+    uint32_t samples = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 100000;
+    uint32_t sectors = (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 0) : 32;
+    uint32_t sectorSize = (argc > 4) ? (uint32_t)strtoul(argv[4], NULL, 0) : 4096;
+    static const uint32_t batches[] = {1, 8, 64};
+    int failures = 0;
+
+    printf("%u samples, %u sectors of %u bytes, %u records per sector\n", samples, sectors, sectorSize,
+           (sectorSize - SLOG_HEADER_SIZE) / SLOG_RECORD_SIZE);
+    for (size_t i = 0; i < sizeof(batches) / sizeof(batches[0]); i++) {
+        failures += run(path, samples, sectors, sectorSize, batches[i]);
+    }
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures != 0;
+}
@@ -0,0 +1,434 @@
+/*
+ * hist_get.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Downloads the sample history of a device as CSV
+ *      hist_get /dev/ttyACM0 [first index] [count] > history.csv
+ *      hist_get --bench [samples]
+ *
+ * Records arrive as HIST_TYPE_BLOCK frames (Utilities/histcodec.h). A block
+ * with a bad CRC, or no answer for HIST_TIMEOUT_S, ends the pass: the
+ * download is requested again from the last index written, which replaces
+ * the one running on the device, and blocks still arriving for the old
+ * request are ignored. The CSV has every record once and in order.
+ *
+ * --bench runs the same download against an emulated device holding
+ * synthetic samples of four probes, with one corrupted block, and reports
+ * the wire bytes and time at 115200 baud against ASCII output.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/time.h>
+
+#include "frame_decoder.h"
+#include "framing.h"
+#include "histcodec.h"
+
+#define HIST_TIMEOUT_S          2
+#define HIST_MAX_PASSES         20
+
+#define BENCH_SENSORS           4
+#define BENCH_PERIOD_MS         1000    // Per probe
+#define BENCH_BYTES_PER_S       11520   // 115200 baud, 8N1
+#define BENCH_IN_FLIGHT         1024    // Sent after a new request replaced the download, UART_TX_SIZE
+
+/* Emulated device, answers a request with all its frames at once */
+typedef struct Emu_Device {
+    SampleLog_Record *records;
+    uint32_t count;
+    uint8_t *out;               // Frames not read yet
+    size_t fill;
+    size_t taken;
+    size_t capacity;
+    uint32_t corruptBlock;      // Block of the first download to damage, 0 none
+    uint64_t wireBytes;         // Sent, passes and resends included
+} Emu_Device;
+
+typedef struct Hist_Link {
+    int fd;                     // Serial port, -1 for the emulated device
+    Emu_Device *emu;
+} Hist_Link;
+
+typedef struct Get_State {
+    Frame_Decoder decoder;
+    uint16_t requestId;
+    uint32_t next;              // Index after the last record written
+    bool started;               // A record was written
+    bool failed;                // Frame lost in this pass, blocks ignored until the end
+    bool done;                  // End frame of this pass received
+    uint8_t status;
+    uint32_t errors;            // Decoder errors when the pass started
+    uint32_t records;
+    uint32_t passes;
+    FILE *out;
+    SampleLog_Record *copy;     // Records kept by --bench to check against the device
+} Get_State;
+
+static void put32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static double now_s(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static int open_port(const char *path)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct termios tty;
+    if (tcgetattr(fd, &tty) == 0) {
+        cfmakeraw(&tty);
+        cfsetispeed(&tty, B115200);
+        cfsetospeed(&tty, B115200);
+        tty.c_cc[VMIN] = 0;
+        tty.c_cc[VTIME] = 1;    // Reads return after 100ms without input
+        tcsetattr(fd, TCSANOW, &tty);
+    }
+    return fd;
+}
+
+static void emu_send(Emu_Device *emu, const uint8_t *payload, size_t length)
+{
+    if (emu->fill + COBS_MAX_ENCODED(length) + 1 > emu->capacity) {
+        emu->capacity = (emu->capacity + COBS_MAX_ENCODED(length) + 1) * 2;
+        emu->out = realloc(emu->out, emu->capacity);
+    }
+    size_t encoded = cobs_encode(payload, length, &emu->out[emu->fill]);
+    emu->out[emu->fill + encoded++] = FRAME_DELIMITER;
+    emu->fill += encoded;
+}
+
+/*
+ * Same blocks as History_export_internal on the device
+ */
+static void emu_request(Emu_Device *emu, const uint8_t *payload)
+{
+    uint8_t block[HIST_BLOCK_MAX];
+    uint8_t end[HIST_END_SIZE];
+    HistCodec codec;
+    uint16_t requestId = (uint16_t)(payload[1] | (payload[2] << 8));
+    uint32_t first = get32(&payload[3]);
+    uint32_t remaining = get32(&payload[7]) ? get32(&payload[7]) : UINT32_MAX;
+    uint32_t n = 0, sent = 0, blocks = 0;
+    uint32_t next = (first > emu->records[0].index) ? first : emu->records[0].index;
+
+    while (n < emu->count && emu->records[n].index < first) {
+        n++;
+    }
+    while (n < emu->count && remaining) {
+        HistCodec_begin(&codec, block, sizeof(block), requestId);
+        while (n < emu->count && remaining && HistCodec_add(&codec, &emu->records[n])) {
+            n++;
+            remaining--;
+        }
+        size_t length = HistCodec_finish(&codec);
+        if (++blocks == emu->corruptBlock) {
+            block[length / 2] ^= 0x10;  // Line noise
+            emu->corruptBlock = 0;
+        }
+        emu_send(emu, block, length);
+        next = codec.last.index + 1;
+        sent += codec.count;
+    }
+
+    end[0] = HIST_TYPE_END;
+    end[1] = (uint8_t)requestId;
+    end[2] = (uint8_t)(requestId >> 8);
+    end[3] = HIST_OK;
+    put32(&end[4], next);
+    put32(&end[8], emu->records[0].index);
+    put32(&end[12], sent);
+    uint16_t crc = crc16(end, HIST_END_SIZE - TLM_CRC_SIZE, 0xFFFF);
+    end[16] = (uint8_t)crc;
+    end[17] = (uint8_t)(crc >> 8);
+    emu_send(emu, end, HIST_END_SIZE);
+}
+
+static bool link_write(Hist_Link *link, const uint8_t *frame, size_t length)
+{
+    if (link->emu != NULL) {
+        uint8_t payload[HIST_REQUEST_SIZE + 2];
+        Emu_Device *emu = link->emu;
+        if (length > 2 && cobs_decode(&frame[1], length - 2, payload) == HIST_REQUEST_SIZE) {
+            // The download running stops, the frames its UART ring held are still sent
+            size_t cut = emu->taken + BENCH_IN_FLIGHT;
+            while (cut < emu->fill && emu->out[cut - 1] != FRAME_DELIMITER) {
+                cut++;
+            }
+            if (cut < emu->fill) {
+                emu->fill = cut;
+            }
+            emu_request(emu, payload);
+        }
+        return true;
+    }
+    return write(link->fd, frame, length) == (ssize_t)length;
+}
+
+/*
+ * Returns the bytes read, 0 after 100 ms without input
+ */
+static size_t link_read(Hist_Link *link, uint8_t *buffer, size_t size)
+{
+    if (link->emu != NULL) {
+        Emu_Device *emu = link->emu;
+        size_t got = emu->fill - emu->taken;
+        if (got > size) {
+            got = size;
+        }
+        memcpy(buffer, &emu->out[emu->taken], got);
+        emu->taken += got;
+        emu->wireBytes += got;
+        if (emu->taken == emu->fill) {
+            emu->taken = emu->fill = 0;
+        }
+        return got;
+    }
+    ssize_t got = read(link->fd, buffer, size);
+    return got > 0 ? (size_t)got : 0;
+}
+
+static void write_record(const SampleLog_Record *record, void *arg)
+{
+    Get_State *state = (Get_State*)arg;
+    if (state->started && record->index < state->next) {
+        return;     // Already written by an earlier pass
+    }
+    if (state->out != NULL) {
+        fprintf(state->out, "%u,%u,%u,%u,%d,%.4f\n", record->index, record->boot, record->time_ms,
+                record->sensorId, record->raw, record->raw / 128.0);
+    }
+    if (state->copy != NULL) {
+        state->copy[state->records] = *record;
+    }
+    state->records++;
+    state->next = record->index + 1;
+    state->started = true;
+}
+
+static void on_frame(const uint8_t *payload, size_t length, void *arg)
+{
+    Get_State *state = (Get_State*)arg;
+    if (length < 3 || (uint16_t)(payload[1] | (payload[2] << 8)) != state->requestId) {
+        return;
+    }
+    if (state->decoder.stats.crcErrors + state->decoder.stats.framingErrors != state->errors) {
+        state->failed = true;   // A block before this one was lost
+    }
+    if (payload[0] == HIST_TYPE_BLOCK && !state->failed) {
+        if (HistCodec_decode(payload, length, write_record, state) < 0) {
+            state->failed = true;
+        }
+    }
+    else if (payload[0] == HIST_TYPE_END && length == HIST_END_SIZE - TLM_CRC_SIZE) {
+        state->status = payload[3];
+        state->done = true;
+        if (!state->started && !state->failed) {
+            state->next = get32(&payload[4]);
+        }
+    }
+}
+
+/*
+ * Requests records from state->next on, and reads until the end frame or a timeout
+ */
+static bool download_pass(Hist_Link *link, Get_State *state, uint32_t count)
+{
+    uint8_t request[HIST_REQUEST_SIZE];
+    uint8_t frame[COBS_MAX_ENCODED(HIST_REQUEST_SIZE) + 2];
+    uint8_t buffer[256];
+
+    state->requestId++;
+    state->passes++;
+    state->failed = false;
+    state->done = false;
+    state->errors = state->decoder.stats.crcErrors + state->decoder.stats.framingErrors;
+
+    request[0] = HIST_TYPE_REQUEST;
+    request[1] = (uint8_t)state->requestId;
+    request[2] = (uint8_t)(state->requestId >> 8);
+    put32(&request[3], state->next);
+    put32(&request[7], count);
+    uint16_t crc = crc16(request, HIST_REQUEST_SIZE - TLM_CRC_SIZE, 0xFFFF);
+    request[11] = (uint8_t)crc;
+    request[12] = (uint8_t)(crc >> 8);
+
+    // Leading delimiter opens the frame on the device, trailing one closes it
+    size_t encoded = 0;
+    frame[encoded++] = FRAME_DELIMITER;
+    encoded += cobs_encode(request, HIST_REQUEST_SIZE, &frame[encoded]);
+    frame[encoded++] = FRAME_DELIMITER;
+    if (!link_write(link, frame, encoded)) {
+        return false;
+    }
+
+    double last = now_s();
+    while (!state->done && !state->failed) {
+        size_t got = link_read(link, buffer, sizeof(buffer));
+        if (got) {
+            Decoder_feed(&state->decoder, buffer, got);
+            last = now_s();
+        }
+        else if (link->emu != NULL || now_s() - last > HIST_TIMEOUT_S) {
+            return false;
+        }
+    }
+    return !state->failed && state->status == HIST_OK;
+}
+
+static int download(Hist_Link *link, Get_State *state, uint32_t first, uint32_t count)
+{
+    Decoder_init(&state->decoder, NULL, NULL, on_frame, state);
+    state->requestId = (uint16_t)getpid();
+    state->next = first;
+    while (state->passes < HIST_MAX_PASSES) {
+        uint32_t wanted = count ? count - state->records : 0;
+        if (download_pass(link, state, wanted) || (count && state->records >= count)) {
+            return 0;
+        }
+        if (state->done && state->status != HIST_OK && state->status != HIST_ERR_BUSY) {
+            fprintf(stderr, "device refused the download: status %u\n", state->status);
+            return 1;
+        }
+        fprintf(stderr, "pass %u incomplete, resuming at %u\n", state->passes, state->next);
+    }
+    return 1;
+}
+
+/*
+ * Four probes every second with a slow drift and a little noise, a reset
+ * half way and a record lost to it
+ */
+static void make_samples(SampleLog_Record *records, uint32_t count)
+{
+    uint32_t seed = 1;
+    int16_t raw[BENCH_SENSORS] = {2900, 2950, 3010, 3100};
+    uint32_t time_ms = 5000;
+    uint16_t boot = 1;
+    uint32_t index = 0;
+
+    for (uint32_t n = 0; n < count; n++) {
+        uint8_t sensor = (uint8_t)(n % BENCH_SENSORS);
+        if (n == count / 2) {
+            boot++;
+            time_ms = 1200;
+            index++;
+        }
+        seed = seed * 1103515245 + 12345;
+        raw[sensor] += (int16_t)((int)((seed >> 16) % 5) - 2);
+        if (sensor == 0) {
+            time_ms += BENCH_PERIOD_MS - 2 + (seed >> 24) % 5;    // Loop jitter
+        }
+        records[n].index = index++;
+        records[n].time_ms = time_ms + sensor;
+        records[n].boot = boot;
+        records[n].raw = raw[sensor];
+        records[n].sensorId = sensor;
+    }
+}
+
+static int bench(uint32_t samples)
+{
+    static Get_State state;
+    Emu_Device emu;
+    Hist_Link link = { -1, &emu };
+    int failures = 0;
+
+    memset(&emu, 0, sizeof(Emu_Device));
+    emu.records = calloc(samples, sizeof(SampleLog_Record));
+    emu.count = samples;
+    emu.corruptBlock = 10;
+    make_samples(emu.records, samples);
+    state.copy = calloc(samples, sizeof(SampleLog_Record));
+
+    double start = now_s();
+    failures += download(&link, &state, 0, 0);
+    double elapsed = now_s() - start;
+
+    for (uint32_t n = 0; n < samples && n < state.records; n++) {
+        if (memcmp(&state.copy[n], &emu.records[n], offsetof(SampleLog_Record, reserved)) != 0) {
+            failures++;
+        }
+    }
+    if (state.records != samples || state.passes != (emu.corruptBlock ? 1 : 2)) {
+        failures++;
+    }
+
+    // ASCII alternatives, uart_print_float of the value alone, or the same CSV fields
+    uint64_t ascii = 0, csv = 0;
+    for (uint32_t n = 0; n < samples; n++) {
+        char line[80];
+        ascii += (uint64_t)snprintf(line, sizeof(line), "Value: %.3f\n", emu.records[n].raw / 128.0);
+        csv += (uint64_t)snprintf(line, sizeof(line), "%u,%u,%u,%u,%.4f\n", emu.records[n].index,
+                                  emu.records[n].boot, emu.records[n].time_ms, emu.records[n].sensorId,
+                                  emu.records[n].raw / 128.0);
+    }
+    uint64_t wire = emu.wireBytes;
+    printf("%u samples in %u passes, %u CRC errors, decoded in %.1f ms on the host\n", samples,
+           state.passes, state.decoder.stats.crcErrors, elapsed * 1000);
+    printf("binary: %llu bytes on the wire, %.2f per sample, %.1f s at 115200\n",
+           (unsigned long long)wire, (double)wire / samples, (double)wire / BENCH_BYTES_PER_S);
+    printf("ascii:  %llu bytes, %.2f per sample, %.1f s (value only)\n", (unsigned long long)ascii,
+           (double)ascii / samples, (double)ascii / BENCH_BYTES_PER_S);
+    printf("csv:    %llu bytes, %.2f per sample, %.1f s (index, boot, time, sensor, value)\n",
+           (unsigned long long)csv, (double)csv / samples, (double)csv / BENCH_BYTES_PER_S);
+    printf("%s\n", failures ? "FAILED" : "ok");
+
+    free(emu.records);
+    free(emu.out);
+    free(state.copy);
+    return failures != 0;
+}
+
+int main(int argc, char **argv)
+{
+    static Get_State state;
+
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        return bench((argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 100000);
+    }
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <serial port> [first index] [count]\n"
+                        "       %s --bench [samples]\n", argv[0], argv[0]);
+        return 1;
+    }
+    uint32_t first = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 0;
+    uint32_t count = (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 0) : 0;
+
+    Hist_Link link = { open_port(argv[1]), NULL };
+    if (link.fd < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    state.out = stdout;
+    printf("index,boot,time_ms,sensor,raw,degC\n");
+    double start = now_s();
+    int rc = download(&link, &state, first, count);
+    close(link.fd);
+    fprintf(stderr, "%u records in %.1f s, %llu bytes, %u passes, next index %u\n", state.records,
+            now_s() - start, (unsigned long long)state.decoder.stats.bytes, state.passes, state.next);
+    return rc;
+}
@@ -0,0 +1,268 @@
+/*
+ * isr_post.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Posts requests from interrupt context next to thread producers
+ *      isr_post [threads] [posts each] [latency events]
+ *
+ * Signal handlers stand in for Hwi: a timer thread keeps sending SIGUSR1
+ * to the producer threads, so each handler runs in the middle of whatever
+ * that thread was doing, often an Active_post of its own. Thread producers
+ * retry a refused post, handlers cannot wait and record it as a drop.
+ * Every message carries its producer and sequence number, the receiver
+ * checks that each one arrives exactly once and that the refused ones
+ * never arrive. The drops the producers saw must match stats.dropped.
+ *
+ * Then the time from an event to the LED turning on: Blink posted from
+ * the handler, against the handler waking a thread that posts it.
+ * Exits 1 if a message is lost or duplicated.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <pthread.h>
+
+#include "sim.h"
+#include "active.h"
+#include "myPWM.h"
+#include "utilities.h"
+
+#define THREADS_MAX             8
+/* Interval between interrupts */
+#define IRQ_INTERVAL_US         20
+
+/* Receive marks per message */
+#define SEEN_REFUSED            0xFF
+
+void Blink_request(myPWM_Handle *handle, uint8_t count);
+void PWM_Stop_request(myPWM_Handle *handle);
+
+static uint32_t threads = 3;
+static uint32_t posts = 300000;
+static uint8_t *seen[THREADS_MAX + 1];      // Per producer, the last one is the handlers
+static uint32_t seenSize;
+static uint32_t received, duplicated;
+
+static Active_Object ao;
+static pthread_t producer[THREADS_MAX];
+static volatile bool producing;
+static uint32_t isrPosts, isrRefused, threadRefused;
+
+static myPWM_Handle led;
+static volatile uint64_t event_us, on_us;
+static uint32_t ledStarts;
+static sem_t relay;
+
+/* Receiver, sig is the producer and value the sequence number */
+static void receive(void *owner, const Active_Msg *msg)
+{
+    (void)owner;
+    if (msg->sig > THREADS_MAX || msg->value.u32 >= seenSize) {
+        duplicated++;
+        return;
+    }
+    uint8_t *mark = &seen[msg->sig][msg->value.u32];
+    if (*mark) {
+        duplicated++;
+    }
+    *mark = 1;
+    received++;
+}
+
+static const Active_Config receiver_config = {
+    .priority = 1,
+    .stackSize = 1024,
+    .dispatch = receive
+};
+
+static void isr_post(int signal)
+{
+    (void)signal;
+    uint32_t seq = __atomic_fetch_add(&isrPosts, 1, __ATOMIC_RELAXED);
+    if (seq >= seenSize) {
+        return;
+    }
+    Active_Msg msg = {.sig = (uint8_t)THREADS_MAX, .value.u32 = seq};
+    if (!Active_post(&ao, &msg)) {
+        seen[THREADS_MAX][seq] = SEEN_REFUSED;
+        __atomic_fetch_add(&isrRefused, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void *producer_thread(void *arg)
+{
+    uint8_t id = (uint8_t)(uintptr_t)arg;
+    for (uint32_t n = 0; n < posts; n++) {
+        Active_Msg msg = {.sig = id, .value.u32 = n};
+        while (!Active_post(&ao, &msg)) {
+            __atomic_fetch_add(&threadRefused, 1, __ATOMIC_RELAXED);
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *irq_thread(void *arg)
+{
+    (void)arg;
+    uint32_t n = 0;
+    while (producing) {
+        pthread_kill(producer[n++ % threads], SIGUSR1);
+        usleep(IRQ_INTERVAL_US);
+    }
+    return NULL;
+}
+
+/*
+ * Thread and handler producers into one object
+ * Returns the messages lost or duplicated
+ */
+static uint32_t stress(void)
+{
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = isr_post;
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, NULL);
+
+    Active_start(&ao, &receiver_config, &ao, "receiver");
+    while (!Active_ready(&ao)) {
+        usleep(1000);
+    }
+    producing = true;
+    for (uint32_t n = 0; n < threads; n++) {
+        pthread_create(&producer[n], NULL, producer_thread, (void *)(uintptr_t)n);
+    }
+    pthread_t irq;
+    pthread_create(&irq, NULL, irq_thread, NULL);
+    for (uint32_t n = 0; n < threads; n++) {
+        pthread_join(producer[n], NULL);
+    }
+    producing = false;
+    pthread_join(irq, NULL);
+
+    uint32_t sent = threads * posts + (isrPosts < seenSize ? isrPosts : seenSize) - isrRefused;
+    uint64_t start = clock_us();
+    while (__atomic_load_n(&received, __ATOMIC_ACQUIRE) < sent && clock_us() - start < 1000000) {
+        usleep(1000);
+    }
+    usleep(10000);
+
+    uint32_t lost = 0, refusedArrived = 0;
+    for (uint32_t t = 0; t < threads; t++) {
+        for (uint32_t n = 0; n < posts; n++) {
+            lost += seen[t][n] != 1;
+        }
+    }
+    for (uint32_t n = 0; n < isrPosts && n < seenSize; n++) {
+        lost += seen[THREADS_MAX][n] == 0;
+        refusedArrived += seen[THREADS_MAX][n] != 1 && seen[THREADS_MAX][n] != SEEN_REFUSED;
+    }
+    bool counted = ao.stats.dropped == isrRefused + threadRefused;
+    printf("stress   %u threads x %u posts, %u from handlers, %u refused in handlers, %u thread retries\n",
+           threads, posts, isrPosts, isrRefused, threadRefused);
+    printf("stress   received %u, lost %u, duplicated %u, refused then received %u, stats.dropped %u %s, "
+           "max depth %u of %u\n", received, lost, duplicated, refusedArrived, ao.stats.dropped,
+           counted ? "matches" : "DIFFERS", ao.stats.maxDepth, ACTIVE_QUEUE_SIZE);
+    return lost + duplicated + refusedArrived + !counted;
+}
+
+/*
+ * LED driver, stamps the first start after an event
+ */
+void PWM_start(PWM_Handle handle)
+{
+    (void)handle;
+    on_us = clock_us();
+    __atomic_add_fetch(&ledStarts, 1, __ATOMIC_RELEASE);
+}
+
+static void button_direct(int signal)
+{
+    (void)signal;
+    event_us = clock_us();
+    Blink_request(&led, 1);
+}
+
+static void button_relay(int signal)
+{
+    (void)signal;
+    event_us = clock_us();
+    sem_post(&relay);
+}
+
+static void *relay_thread(void *arg)
+{
+    (void)arg;
+    while (1) {
+        while (sem_wait(&relay) != 0) {
+        }
+        Blink_request(&led, 1);
+    }
+    return NULL;
+}
+
+static void event_latency(const char *name, void (*handler)(int), uint32_t events)
+{
+    uint64_t sum = 0;
+    uint32_t worst = 0;
+    signal(SIGUSR2, handler);
+    for (uint32_t n = 0; n < events; n++) {
+        uint32_t starts = __atomic_load_n(&ledStarts, __ATOMIC_ACQUIRE);
+        raise(SIGUSR2);
+        while (__atomic_load_n(&ledStarts, __ATOMIC_ACQUIRE) == starts) {
+            sched_yield();
+        }
+        uint32_t took = (uint32_t)(on_us - event_us);
+        sum += took;
+        if (took > worst) {
+            worst = took;
+        }
+        PWM_Stop_request(&led);
+        usleep(2000);
+    }
+    printf("latency  event to LED on, %-22s %5.1f us avg %5u us max\n", name, (double)sum / events, worst);
+}
+
+int main(int argc, char **argv)
+{
+    static const char name[10] = "LED";
+    threads = argc > 1 ? (uint32_t)atoi(argv[1]) : 3;
+    posts = argc > 2 ? (uint32_t)atoi(argv[2]) : 300000;
+    uint32_t events = argc > 3 ? (uint32_t)atoi(argv[3]) : 500;
+    if (threads == 0 || threads > THREADS_MAX) {
+        fprintf(stderr, "1 to %u threads\n", THREADS_MAX);
+        return 1;
+    }
+    seenSize = posts;
+    for (uint32_t n = 0; n <= THREADS_MAX; n++) {
+        seen[n] = calloc(posts, 1);
+        if (seen[n] == NULL) {
+            return 2;
+        }
+    }
+
+    uint32_t faults = stress();
+
+    Open_myPWM(&led, 0, name, 0, 0);
+    while (!Active_ready(&led.active)) {
+        usleep(1000);
+    }
+    sem_init(&relay, 0, 0);
+    pthread_t relay_handle;
+    pthread_create(&relay_handle, NULL, relay_thread, NULL);
+    if (events) {
+        event_latency("Blink from the handler", button_direct, events);
+        event_latency("handler wakes a thread", button_relay, events);
+    }
+
+    printf("%s\n", faults ? "FAILED" : "none lost or duplicated");
+    return faults ? 1 : 0;
+}
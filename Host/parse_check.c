@@ -0,0 +1,314 @@
+/*
+ * parse_check.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Checks the decimal parsers of Utilities/utilities.c
+ *      parse_check [rounds]
+ *
+ * Compares parseUint32, parseInt32, parseFixed, stoi and stof against
+ * expected status, value and end position: signs, the int32 and uint32
+ * limits and one past them, trailing garbage such as "1a3", each
+ * delimiter, empty input, a bare fraction such as ".5" and Q7 rounding.
+ * Then times stoi and stof against the ctoi and pow() versions they
+ * replaced, copied below. Exits 1 on a failure.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "utilities.h"
+
+#define SAMPLES                 4096
+
+static uint32_t failures;
+static volatile int isink;
+static volatile float fsink;
+
+static const char *status_name(Parse_Status status)
+{
+    switch (status) {
+    case PARSE_OK:
+        return "ok";
+    case PARSE_INVALID:
+        return "invalid";
+    default:
+        return "overflow";
+    }
+}
+
+/* Status, value when ok and the characters left after end */
+static void expect(const char *what, const char *string, Parse_Status status, Parse_Status want,
+                   int64_t value, int64_t wantValue, const char *end, const char *wantEnd)
+{
+    bool wrong = status != want || (want == PARSE_OK && value != wantValue) ||
+                 (wantEnd != NULL && strcmp(end, wantEnd) != 0);
+    if (wrong) {
+        printf("FAIL %s(\"%s\"): %s %lld end \"%s\", want %s %lld end \"%s\"\n", what, string,
+               status_name(status), (long long)value, end, status_name(want),
+               (long long)wantValue, wantEnd != NULL ? wantEnd : end);
+        failures++;
+    }
+}
+
+static void check_uint(const char *string, Parse_Status want, uint32_t wantValue, const char *wantEnd)
+{
+    uint32_t value = 0;
+    const char *end = string;
+    Parse_Status status = parseUint32(string, &value, &end);
+    expect("parseUint32", string, status, want, value, wantValue, end, wantEnd);
+}
+
+static void check_int(const char *string, Parse_Status want, int32_t wantValue, const char *wantEnd)
+{
+    int32_t value = 0;
+    const char *end = string;
+    Parse_Status status = parseInt32(string, &value, &end);
+    expect("parseInt32", string, status, want, value, wantValue, end, wantEnd);
+}
+
+static void check_fixed(const char *string, uint8_t fracBits, Parse_Status want, int32_t wantValue,
+                        const char *wantEnd)
+{
+    int32_t value = 0;
+    const char *end = string;
+    char what[24];
+    Parse_Status status = parseFixed(string, fracBits, &value, &end);
+    snprintf(what, sizeof(what), "parseFixed Q%u", fracBits);
+    expect(what, string, status, want, value, wantValue, end, wantEnd);
+}
+
+static void check_stoi(const char *string, int want)
+{
+    int value = stoi((char *)string);
+    if (value != want) {
+        printf("FAIL stoi(\"%s\"): %d, want %d\n", string, value, want);
+        failures++;
+    }
+}
+
+static void check_stof(const char *string, float want)
+{
+    float value = stof((char *)string);
+    if (value != want) {
+        printf("FAIL stof(\"%s\"): %g, want %g\n", string, value, want);
+        failures++;
+    }
+}
+
+/* Every Q7 value printed with 4 decimals parses back to itself */
+static void check_q7_sweep(void)
+{
+    char buffer[FMT_BUFFER_SIZE];
+    uint32_t wrong = 0;
+    for (int32_t raw = -32768; raw < 32768; raw++) {
+        int32_t value = 0;
+        int length = fixedToStr(raw, 7, 4, buffer);
+        buffer[length] = '\0';
+        if (parseFixed(buffer, 7, &value, NULL) != PARSE_OK || value != raw) {
+            if (!wrong) {
+                printf("FAIL parseFixed Q7(\"%s\"): %d, want %d\n", buffer, value, raw);
+            }
+            wrong++;
+        }
+    }
+    failures += wrong;
+    printf("Q7 round trip: %u of 65536 values wrong\n", wrong);
+}
+
+static int old_ctoi(char character)
+{
+    if (character >= '1' && character <= '9') {
+        return character - '0';
+    }
+    return 0;
+}
+
+__attribute__((noinline)) static int old_stoi(char *string)
+{
+    int length = strlen(string);
+    int value = 0;
+    for (int index = 1; index < length + 1; index++) {
+        value += old_ctoi(*string) * pow(10, length - index);
+        string++;
+    }
+    return value;
+}
+
+__attribute__((noinline)) static float old_stof(char *string)
+{
+    int length = strlen(string);
+    float value = 0;
+    int decposition = 0;
+    int index = 0;
+    for (; index < length; index++) {
+        if (string[index] == '.') {
+            break;
+        }
+        decposition++;
+    }
+    for (index = 0; index < length; index++) {
+        if (index < decposition) {
+            value += old_ctoi(string[index]) * pow(10, decposition - (index + 1));
+        }
+        else if (index > decposition) {
+            value += old_ctoi(string[index]) * pow(10, decposition - index);
+        }
+    }
+    return value;
+}
+
+static double ns_per(uint64_t start, uint64_t count)
+{
+    return (clock_us() - start) * 1000.0 / count;
+}
+
+static void report(const char *name, double before, double after)
+{
+    printf("%-24s %6.1f ns %6.1f ns  %4.1fx\n", name, before, after, before / after);
+}
+
+/* Shell arguments: periods and setpoints like "250", offsets like "23.125" */
+static void benchmark(uint32_t rounds)
+{
+    static char integers[SAMPLES][12];
+    static char decimals[SAMPLES][12];
+    uint64_t count = (uint64_t)rounds * SAMPLES;
+    uint64_t start;
+    double before, after;
+    uint32_t rng = 1;
+
+    for (uint32_t n = 0; n < SAMPLES; n++) {
+        rng = rng * 1664525u + 1013904223u;
+        snprintf(integers[n], sizeof(integers[n]), "%u", (rng >> 8) % 100000);
+        snprintf(decimals[n], sizeof(decimals[n]), "%u.%03u", (rng >> 8) % 100, (rng >> 20) % 1000);
+    }
+
+    printf("%-24s %9s %9s  %5s\n", "", "before", "after", "gain");
+    start = clock_us();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t n = 0; n < SAMPLES; n++) {
+            isink += old_stoi(integers[n]);
+        }
+    }
+    before = ns_per(start, count);
+    start = clock_us();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t n = 0; n < SAMPLES; n++) {
+            isink += stoi(integers[n]);
+        }
+    }
+    after = ns_per(start, count);
+    report("stoi, up to 5 digits", before, after);
+
+    start = clock_us();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t n = 0; n < SAMPLES; n++) {
+            fsink += old_stof(decimals[n]);
+        }
+    }
+    before = ns_per(start, count);
+    start = clock_us();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t n = 0; n < SAMPLES; n++) {
+            fsink += stof(decimals[n]);
+        }
+    }
+    after = ns_per(start, count);
+    report("stof, \"dd.ddd\"", before, after);
+
+    start = clock_us();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t n = 0; n < SAMPLES; n++) {
+            int32_t value = 0;
+            parseFixed(decimals[n], 7, &value, NULL);
+            isink += value;
+        }
+    }
+    after = ns_per(start, count);
+    report("parseFixed Q7, \"dd.ddd\"", before, after);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t rounds = argc > 1 ? (uint32_t)atoi(argv[1]) : 500;
+
+    check_uint("0", PARSE_OK, 0, "");
+    check_uint("007", PARSE_OK, 7, "");
+    check_uint("+7", PARSE_OK, 7, "");
+    check_uint("4294967295", PARSE_OK, UINT32_MAX, "");
+    check_uint("4294967296", PARSE_OVERFLOW, 0, NULL);
+    check_uint("99999999999", PARSE_OVERFLOW, 0, NULL);
+    check_uint("-7", PARSE_INVALID, 0, NULL);
+    check_uint("", PARSE_INVALID, 0, NULL);
+    check_uint("+", PARSE_INVALID, 0, NULL);
+    check_uint("1a3", PARSE_INVALID, 0, "a3");
+    check_uint("12 34", PARSE_OK, 12, " 34");
+    check_uint("12,34", PARSE_OK, 12, ",34");
+    check_uint("12\t", PARSE_OK, 12, "\t");
+    check_uint("12\r\n", PARSE_OK, 12, "\r\n");
+    check_uint("12.5", PARSE_INVALID, 0, ".5");
+
+    check_int("-0", PARSE_OK, 0, "");
+    check_int("-5", PARSE_OK, -5, "");
+    check_int("+5", PARSE_OK, 5, "");
+    check_int("2147483647", PARSE_OK, INT32_MAX, "");
+    check_int("2147483648", PARSE_OVERFLOW, 0, NULL);
+    check_int("-2147483648", PARSE_OK, INT32_MIN, "");
+    check_int("-2147483649", PARSE_OVERFLOW, 0, NULL);
+    check_int("-", PARSE_INVALID, 0, NULL);
+    check_int("--5", PARSE_INVALID, 0, NULL);
+    check_int(" 5", PARSE_INVALID, 0, NULL);
+    check_int("-1a3", PARSE_INVALID, 0, "a3");
+    check_int("-12 x", PARSE_OK, -12, " x");
+
+    check_fixed("23.125", 7, PARSE_OK, 2960, "");
+    check_fixed("-296", 7, PARSE_OK, -37888, "");
+    check_fixed(".5", 7, PARSE_OK, 64, "");
+    check_fixed("-.5", 7, PARSE_OK, -64, "");
+    check_fixed("1.", 7, PARSE_OK, 128, "");
+    check_fixed("0.0039", 7, PARSE_OK, 0, "");          // 0.4992 steps
+    check_fixed("0.0040", 7, PARSE_OK, 1, "");          // 0.512 steps
+    check_fixed("-0.004", 7, PARSE_OK, -1, "");
+    check_fixed("0.00390625", 7, PARSE_OK, 1, "");      // Half a step, rounds up
+    check_fixed("0.123456789123", 7, PARSE_OK, 16, ""); // Digits past 9 ignored
+    check_fixed("2.5", 0, PARSE_OK, 3, "");
+    check_fixed("16777215.99", 7, PARSE_OK, INT32_MAX, "");
+    check_fixed("16777216", 7, PARSE_OVERFLOW, 0, NULL);
+    check_fixed("-16777216", 7, PARSE_OK, INT32_MIN, "");
+    check_fixed("-16777216.01", 7, PARSE_OVERFLOW, 0, NULL);
+    check_fixed("1", 32, PARSE_OVERFLOW, 0, NULL);
+    check_fixed(".", 7, PARSE_INVALID, 0, NULL);
+    check_fixed("", 7, PARSE_INVALID, 0, NULL);
+    check_fixed("-", 7, PARSE_INVALID, 0, NULL);
+    check_fixed("1.2.3", 7, PARSE_INVALID, 0, ".3");
+    check_fixed("1e3", 7, PARSE_INVALID, 0, "e3");
+    check_fixed("1.5 C", 7, PARSE_OK, 192, " C");
+    check_q7_sweep();
+
+    check_stoi("250", 250);
+    check_stoi("-5", -5);
+    check_stoi("+5", 5);
+    check_stoi("1a3", 0);
+    check_stoi("abc", 0);
+    check_stoi("", 0);
+    check_stoi("2147483648", 0);
+    check_stoi("-2147483648", INT32_MIN);
+
+    check_stof("23.125", 23.125f);
+    check_stof("-1.25", -1.25f);
+    check_stof(".5", 0.5f);
+    check_stof("3", 3.0f);
+    check_stof("3.", 3.0f);
+    check_stof("1a", 0);
+    check_stof("", 0);
+    check_stof("1.2.3", 0);
+
+    benchmark(rounds);
+
+    printf("%s\n", failures ? "FAILED" : "all passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * prov_tool.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Sends one provisioning batch to the device and prints the result
+ *      prov_tool /dev/ttyACM0 fixture.txt
+ *
+ * Every line of the fixture file provisions one sensor
+ *      <target> <serial number> <offset degC>
+ * and becomes WRITE_SN and WRITE_CAL operations, both verified by the device.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/time.h>
+
+#include "frame_decoder.h"
+#include "framing.h"
+
+#define PROV_TIMEOUT_S          5
+
+typedef struct Prov_Reply {
+    bool done;
+    uint16_t batchId;
+    const uint8_t *ops;         // Operations sent, for the report
+} Prov_Reply;
+
+static const char *status_name(uint8_t status)
+{
+    switch (status) {
+        case PROV_OK:           return "ok";
+        case PROV_ERR_TARGET:   return "no such target";
+        case PROV_ERR_OP:       return "bad operation";
+        case PROV_ERR_BUSY:     return "busy";
+        case PROV_ERR_I2C:      return "i2c error";
+        case PROV_ERR_EEPROM:   return "eeprom timeout";
+        case PROV_ERR_VERIFY:   return "verify failed";
+        case PROV_ERR_INVALID:  return "invalid batch";
+        default:                return "unknown";
+    }
+}
+
+static void put32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void print_result(const uint8_t *payload, size_t length, void *arg)
+{
+    Prov_Reply *reply = (Prov_Reply*)arg;
+    if (payload[0] != PROV_TYPE_RESULT || length < PROV_RESULT_HEADER_SIZE) {
+        return;
+    }
+    uint16_t batchId = (uint16_t)(payload[1] | (payload[2] << 8));
+    uint8_t count = payload[8];
+    if (batchId != reply->batchId || length != PROV_RESULT_HEADER_SIZE + (size_t)count*PROV_RESULT_SIZE) {
+        return;
+    }
+    reply->done = true;
+    if (payload[3] != PROV_OK) {
+        printf("batch %u refused: %s\n", batchId, status_name(payload[3]));
+        return;
+    }
+    uint8_t n = 0;
+    for (; n < count; n++) {
+        const uint8_t *op = &reply->ops[PROV_BATCH_HEADER_SIZE + n*PROV_OP_SIZE];
+        const uint8_t *result = &payload[PROV_RESULT_HEADER_SIZE + n*PROV_RESULT_SIZE];
+        int32_t value = (int32_t)get32(&result[1]);
+        if (op[1] == PROV_OP_WRITE_CAL || op[1] == PROV_OP_READ_CAL) {
+            printf("target %2u op %u: %-14s %.4f degC\n", op[0], op[1], status_name(result[0]), value / 128.0);
+        }
+        else {
+            printf("target %2u op %u: %-14s %u\n", op[0], op[1], status_name(result[0]), (uint32_t)value);
+        }
+    }
+    printf("device time %u us\n", get32(&payload[4]));
+}
+
+static int open_port(const char *path)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct termios tty;
+    if (tcgetattr(fd, &tty) == 0) {
+        cfmakeraw(&tty);
+        cfsetispeed(&tty, B115200);
+        cfsetospeed(&tty, B115200);
+        tty.c_cc[VMIN] = 0;
+        tty.c_cc[VTIME] = 1;    // Reads return after 100ms without input
+        tcsetattr(fd, TCSANOW, &tty);
+    }
+    return fd;
+}
+
+static double now_s(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t batch[PROV_BATCH_HEADER_SIZE + PROV_MAX_OPS*PROV_OP_SIZE + TLM_CRC_SIZE];
+    static uint8_t frame[COBS_MAX_ENCODED(sizeof(batch)) + 2];
+    static Frame_Decoder decoder;
+    Prov_Reply reply;
+    size_t length = PROV_BATCH_HEADER_SIZE;
+    uint8_t count = 0;
+    unsigned target;
+    unsigned long serial;
+    double offset;
+
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <serial port> <fixture file>\n", argv[0]);
+        return 1;
+    }
+    FILE *fixture = fopen(argv[2], "r");
+    if (fixture == NULL) {
+        perror(argv[2]);
+        return 1;
+    }
+    while (fscanf(fixture, "%u %lu %lf", &target, &serial, &offset) == 3) {
+        if (count + 2 > PROV_MAX_OPS) {
+            fprintf(stderr, "more than %d operations, split the fixture\n", PROV_MAX_OPS);
+            return 1;
+        }
+        batch[length] = (uint8_t)target;
+        batch[length + 1] = PROV_OP_WRITE_SN;
+        put32(&batch[length + 2], (uint32_t)serial);
+        length += PROV_OP_SIZE;
+        batch[length] = (uint8_t)target;
+        batch[length + 1] = PROV_OP_WRITE_CAL;
+        put32(&batch[length + 2], (uint32_t)(int32_t)lround(offset * 128));
+        length += PROV_OP_SIZE;
+        count += 2;
+    }
+    fclose(fixture);
+
+    reply.done = false;
+    reply.batchId = (uint16_t)getpid();
+    reply.ops = batch;
+    batch[0] = PROV_TYPE_BATCH;
+    batch[1] = (uint8_t)reply.batchId;
+    batch[2] = (uint8_t)(reply.batchId >> 8);
+    batch[3] = count;
+    uint16_t crc = crc16(batch, length, 0xFFFF);
+    batch[length] = (uint8_t)crc;
+    batch[length + 1] = (uint8_t)(crc >> 8);
+
+    // Leading delimiter opens the frame on the device, trailing one closes it
+    size_t encoded = 0;
+    frame[encoded++] = FRAME_DELIMITER;
+    encoded += cobs_encode(batch, length + TLM_CRC_SIZE, &frame[encoded]);
+    frame[encoded++] = FRAME_DELIMITER;
+
+    int fd = open_port(argv[1]);
+    if (fd < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    Decoder_init(&decoder, NULL, NULL, print_result, &reply);
+    double start = now_s();
+    if (write(fd, frame, encoded) != (ssize_t)encoded) {
+        perror("write");
+        return 1;
+    }
+    while (!reply.done && now_s() - start < PROV_TIMEOUT_S) {
+        uint8_t buffer[256];
+        ssize_t got = read(fd, buffer, sizeof(buffer));
+        if (got > 0) {
+            Decoder_feed(&decoder, buffer, (size_t)got);
+        }
+    }
+    close(fd);
+    if (!reply.done) {
+        fprintf(stderr, "no result within %d s\n", PROV_TIMEOUT_S);
+        return 1;
+    }
+    printf("round trip %.1f ms for %u operations\n", (now_s() - start) * 1000, count);
+    return 0;
+}
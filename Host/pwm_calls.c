@@ -0,0 +1,197 @@
+/*
+ * pwm_calls.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Counts the PWM driver calls of the LED requests
+ *      pwm_calls [pulses] [blinks] [leds]
+ *
+ * Opens the LEDs with Open_myPWM on the host stand-in and runs Pulse,
+ * Blink and a few Set requests on the first one, counting PWM_init,
+ * PWM_start, PWM_stop and PWM_setDuty as the driver sees them. The same
+ * requests then go through a copy of the Set_internal, Pulse and Blink
+ * loops from before the LED tracked its run state, which started the
+ * PWM on every non-zero step, stopped it on every zero and ran PWM_init
+ * in each LED thread. Exits 1 if the LED is left running or the counts
+ * disagree with the LED's own stats.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "myPWM.h"
+#include "utilities.h"
+
+#define LEDS_MAX                4
+
+typedef struct Calls {
+    uint32_t inits;
+    uint32_t starts;
+    uint32_t stops;
+    uint32_t dutyWrites;
+} Calls;
+
+static Calls calls;
+static bool running;
+
+void Blink_request(myPWM_Handle *handle, uint8_t count);
+void Pulse_request(myPWM_Handle *handle, uint8_t count);
+void Set_request(myPWM_Handle *handle, uint8_t brightness);
+
+/*
+ * Driver, counts the calls
+ */
+void PWM_init(void)
+{
+    calls.inits++;
+}
+
+void PWM_start(PWM_Handle handle)
+{
+    (void)handle;
+    calls.starts++;
+    running = true;
+}
+
+void PWM_stop(PWM_Handle handle)
+{
+    (void)handle;
+    calls.stops++;
+    running = false;
+}
+
+int_fast16_t PWM_setDuty(PWM_Handle handle, uint32_t duty)
+{
+    (void)handle;
+    (void)duty;
+    calls.dutyWrites++;
+    return 0;
+}
+
+/* Set_internal before run state tracking, brightness 0 to 100 */
+static void old_set(uint8_t brightness)
+{
+    if (!brightness) {
+        PWM_stop(NULL);
+        return;
+    }
+    if (brightness > 100) {
+        brightness = 100;
+    }
+    PWM_start(NULL);
+    PWM_setDuty(NULL, (uint32_t)(((uint64_t)PWM_DUTY_FRACTION_MAX * brightness) / 100));
+}
+
+static void old_pulse(uint8_t count)
+{
+    while (count--) {
+        for (int n = 0; n <= 100; n++) {
+            old_set((uint8_t)n);
+        }
+        for (int n = 100; n >= 0; n--) {
+            old_set((uint8_t)n);
+        }
+    }
+}
+
+static void old_blink(uint8_t count)
+{
+    while (count--) {
+        old_set(100);
+        old_set(0);
+    }
+}
+
+/* Waits until the LED has no request queued, running or scheduled */
+static void wait_idle(Active_Object *ao)
+{
+    while (1) {
+        if (Active_claim(ao)) {
+            bool busy = ao->armed || ao->readyCount ||
+                        __atomic_load_n(&ao->head, __ATOMIC_ACQUIRE) != ao->tail;
+            Active_release(ao);
+            if (!busy) {
+                return;
+            }
+        }
+        usleep(1000);
+    }
+}
+
+static void report(const char *name, const Calls *counted)
+{
+    printf("         %-6s start %4u, stop %4u, setDuty %4u\n", name,
+           counted->starts, counted->stops, counted->dutyWrites);
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t pulses = argc > 1 ? (uint8_t)atoi(argv[1]) : 2;
+    uint8_t blinks = argc > 2 ? (uint8_t)atoi(argv[2]) : 2;
+    uint32_t leds = argc > 3 ? (uint32_t)atoi(argv[3]) : 3;
+    static myPWM_Handle led[LEDS_MAX];
+    static const char names[LEDS_MAX][10] = {"LED 0", "LED 1", "LED 2", "LED 3"};
+    const uint8_t levels[5] = {50, 50, 100, 0, 0};
+    Calls pulse, blink, set;
+    bool ok = true;
+
+    if (leds == 0 || leds > LEDS_MAX) {
+        fprintf(stderr, "1 to %u leds\n", LEDS_MAX);
+        return 1;
+    }
+    printf("%u LEDs, Pulse %u, Blink %u, Set 50 50 100 0 0\n", leds, pulses, blinks);
+
+    for (uint32_t n = 0; n < leds; n++) {
+        Open_myPWM(&led[n], (uint_least8_t)n, names[n], 0, 0);
+    }
+    while (!Active_ready(&led[0].active)) {
+        usleep(1000);
+    }
+    uint32_t inits = calls.inits;
+
+    calls = (Calls){0};
+    Pulse_request(&led[0], pulses);
+    wait_idle(&led[0].active);
+    pulse = calls;
+    calls = (Calls){0};
+    Blink_request(&led[0], blinks);
+    wait_idle(&led[0].active);
+    blink = calls;
+    calls = (Calls){0};
+    for (int n = 0; n < 5; n++) {
+        Set_request(&led[0], levels[n]);
+    }
+    wait_idle(&led[0].active);
+    set = calls;
+    ok &= !running;
+    ok &= led[0].stats.starts == pulse.starts + blink.starts + set.starts;
+    ok &= led[0].stats.stops == pulse.stops + blink.stops + set.stops;
+    ok &= led[0].stats.dutyWrites == pulse.dutyWrites + blink.dutyWrites + set.dutyWrites;
+
+    printf("now      PWM_init %u for %u LEDs\n", inits, leds);
+    report("Pulse", &pulse);
+    report("Blink", &blink);
+    report("Set", &set);
+
+    calls = (Calls){0};
+    old_pulse(pulses);
+    pulse = calls;
+    calls = (Calls){0};
+    old_blink(blinks);
+    blink = calls;
+    calls = (Calls){0};
+    for (int n = 0; n < 5; n++) {
+        old_set(levels[n]);
+    }
+    set = calls;
+    printf("before   PWM_init %u for %u LEDs, one per LED thread\n", leds, leds);
+    report("Pulse", &pulse);
+    report("Blink", &blink);
+    report("Set", &set);
+
+    printf("%s\n", ok ? "LED off, counts match the LED stats" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,303 @@
+/*
+ * rx_framing.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Feeds text lines and frames through the UART receive path with lost and
+ * duplicated delimiters and checks that the reader resynchronizes
+ *      rx_framing [items] [fault %] [seed]
+ *
+ * The bytes go in through the read callback in chunks like the driver
+ * delivers them and are taken out with UART_RX_next. The host pauses
+ * after half of the text lines, as when waiting for a reply, and the
+ * reader gets UART_RX_idle there. First a fixed case for each kind of
+ * fault, then a random stream where every delimiter is dropped or doubled
+ * with the given probability. Items touched by a fault may be lost.
+ * Every item after the next intact frame or pause must come through and
+ * no frame may come out that was not sent. Stray lines, frame bytes read
+ * as text after a lost opening delimiter, are counted. Exits 1 on a
+ * failure.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "uart_rx.h"
+#include "framing.h"
+#include "protocol.h"
+
+void UART_RX_callback(UART2_Handle handle, void *buffer, size_t count, void *userArg, int_fast16_t status);
+
+#define ITEM_LINE_MAX           40
+#define ITEM_PAYLOAD_MAX        64
+#define STREAM_MAX              (1 << 24)
+/* Received items are matched this far ahead of the last match */
+#define MATCH_WINDOW            64
+
+typedef struct Item {
+    bool frame;
+    uint16_t length;
+    uint8_t data[ITEM_PAYLOAD_MAX];
+    bool faulted;               // One of its delimiters was dropped or doubled
+    bool pause;                 // Host goes quiet after this item
+    size_t end;                 // Stream offset after the item
+    bool required;              // Must be received
+    bool received;
+} Item;
+
+static uint8_t stream[STREAM_MAX];
+static size_t streamLength;
+static UART_RX_Reader reader;
+static uint32_t rng = 1;
+
+static uint32_t next_random(void)
+{
+    rng = rng * 1664525u + 1013904223u;
+    return rng >> 8;
+}
+
+static void put(const uint8_t *data, size_t length)
+{
+    if (streamLength + length > STREAM_MAX) {
+        fprintf(stderr, "stream full\n");
+        exit(2);
+    }
+    memcpy(&stream[streamLength], data, length);
+    streamLength += length;
+}
+
+/* Delimiter sent 0, 1 or 2 times */
+static void put_delimiter(int times)
+{
+    uint8_t delimiter = FRAME_DELIMITER;
+    for (int n = 0; n < times; n++) {
+        put(&delimiter, 1);
+    }
+}
+
+/* Times the next delimiter is sent, 1 unless a fault hits it */
+static int delimiter_times(uint32_t faultPercent, uint32_t *faults)
+{
+    if (next_random() % 100 < faultPercent) {
+        (*faults)++;
+        return (next_random() & 1) ? 2 : 0;
+    }
+    return 1;
+}
+
+/* Line with "\r\n", or frame with its delimiters sent the given times */
+static void put_item(Item *item, int opening, int closing)
+{
+    if (!item->frame) {
+        put(item->data, item->length);
+        put((const uint8_t *)"\r\n", 2);
+        item->end = streamLength;
+        return;
+    }
+    uint8_t raw[ITEM_PAYLOAD_MAX + TLM_CRC_SIZE];
+    uint8_t encoded[COBS_MAX_ENCODED(sizeof(raw))];
+    memcpy(raw, item->data, item->length);
+    uint16_t crc = crc16(item->data, item->length, 0xFFFF);
+    raw[item->length] = (uint8_t)crc;
+    raw[item->length + 1] = (uint8_t)(crc >> 8);
+    size_t length = cobs_encode(raw, item->length + TLM_CRC_SIZE, encoded);
+
+    item->faulted = (opening != 1 || closing != 1);
+    put_delimiter(opening);
+    put(encoded, length);
+    put_delimiter(closing);
+    item->end = streamLength;
+}
+
+static void random_item(Item *item)
+{
+    memset(item, 0, sizeof(Item));
+    item->frame = next_random() & 1;
+    if (item->frame) {
+        item->length = 1 + next_random() % ITEM_PAYLOAD_MAX;
+        for (uint16_t n = 0; n < item->length; n++) {
+            item->data[n] = (uint8_t)next_random();
+        }
+    }
+    else {
+        item->length = 1 + next_random() % ITEM_LINE_MAX;
+        for (uint16_t n = 0; n < item->length; n++) {
+            item->data[n] = (uint8_t)(' ' + 1 + next_random() % 94);
+        }
+        item->pause = next_random() & 1;
+    }
+}
+
+static void take(Item *items, uint32_t count, uint32_t *next, uint32_t *spurious)
+{
+    UART_RX_Item got;
+    while ((got = UART_RX_next(&reader)) != UART_RX_NONE) {
+        bool frame = (got == UART_RX_FRAME);
+        const uint8_t *data = frame ? reader.frame : (const uint8_t *)reader.line;
+        size_t length = frame ? reader.frameLength : strlen(reader.line);
+        uint32_t last = *next + MATCH_WINDOW < count ? *next + MATCH_WINDOW : count;
+        uint32_t n = *next;
+        for (; n < last; n++) {
+            if (items[n].frame == frame && items[n].length == length &&
+                memcmp(items[n].data, data, length) == 0) {
+                break;
+            }
+        }
+        if (n == last) {
+            spurious[frame]++;
+            continue;
+        }
+        items[n].received = true;
+        *next = n + 1;
+    }
+}
+
+/*
+ * Runs the stream through the callback and the reader and matches what
+ * comes out against the items in order
+ * Output spurious lines and frames
+ */
+static void run(Item *items, uint32_t count, uint32_t spurious[2])
+{
+    uint32_t next = 0, item = 0;
+    size_t offset = 0;
+
+    spurious[0] = spurious[1] = 0;
+    UART_RX_init();
+    UART_RX_readerInit(&reader, false);
+    while (offset < streamLength) {
+        // Next pause still ahead
+        while (item < count && (items[item].end <= offset || !items[item].pause)) {
+            item++;
+        }
+        size_t chunk = 1 + next_random() % UART_RX_CHUNK;
+        size_t limit = item < count ? items[item].end : streamLength;
+        if (chunk > limit - offset) {
+            chunk = limit - offset;
+        }
+        UART_RX_callback(NULL, &stream[offset], chunk, NULL, UART2_STATUS_SUCCESS);
+        offset += chunk;
+        take(items, count, &next, spurious);
+        if (offset == limit && limit != streamLength) {
+            UART_RX_idle(&reader);
+            take(items, count, &next, spurious);
+        }
+    }
+}
+
+/*
+ * Items after an intact frame or a pause that follows the last fault must
+ * be received
+ */
+static void mark_required(Item *items, uint32_t count)
+{
+    bool synced = true;
+    for (uint32_t n = 0; n < count; n++) {
+        if (items[n].faulted) {
+            synced = false;
+        }
+        items[n].required = synced && !items[n].faulted;
+        if ((items[n].frame && !items[n].faulted) || items[n].pause) {
+            synced = true;
+        }
+    }
+}
+
+static bool check(const char *name, Item *items, uint32_t count, const uint32_t spurious[2])
+{
+    uint32_t lost = 0, missed = 0;
+    for (uint32_t n = 0; n < count; n++) {
+        if (!items[n].received) {
+            lost++;
+            if (items[n].required) {
+                missed++;
+            }
+        }
+    }
+    bool ok = (missed == 0 && spurious[1] == 0);
+    printf("%-26s %s %u items, lost %u (after resync %u), stray lines %u, stray frames %u\n",
+           name, ok ? "ok  " : "FAIL", count, lost, missed, spurious[0], spurious[1]);
+    return ok;
+}
+
+/*
+ * Line, frame, line, frame, line, the host pausing after each line, with
+ * the delimiters of the first frame sent the given times
+ */
+static bool fixed_case(const char *name, int opening, int closing)
+{
+    Item items[5];
+    const char *lines[3] = {"help", "stats", "boot"};
+    const uint8_t payload[6] = {0x31, 0x00, 0x0A, 0x0D, 0x20, 0x7E};
+    uint32_t spurious[2];
+
+    memset(items, 0, sizeof(items));
+    streamLength = 0;
+    for (int n = 0; n < 5; n++) {
+        if (n & 1) {
+            items[n].frame = true;
+            items[n].length = sizeof(payload);
+            memcpy(items[n].data, payload, sizeof(payload));
+            items[n].data[5] += n;
+        }
+        else {
+            items[n].length = (uint16_t)strlen(lines[n / 2]);
+            memcpy(items[n].data, lines[n / 2], items[n].length);
+            items[n].pause = true;
+        }
+        put_item(&items[n], n == 1 ? opening : 1, n == 1 ? closing : 1);
+    }
+    // A lost closing delimiter takes the line after the frame with it
+    if (closing == 0) {
+        items[2].faulted = true;
+    }
+    mark_required(items, 5);
+    run(items, 5, spurious);
+    return check(name, items, 5, spurious);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t count = argc > 1 ? (uint32_t)atoi(argv[1]) : 100000;
+    uint32_t faultPercent = argc > 2 ? (uint32_t)atoi(argv[2]) : 2;
+    rng = argc > 3 ? (uint32_t)atoi(argv[3]) : 1;
+    bool ok = true;
+
+    ok &= fixed_case("clean", 1, 1);
+    ok &= fixed_case("lost opening delimiter", 0, 1);
+    ok &= fixed_case("lost closing delimiter", 1, 0);
+    ok &= fixed_case("doubled opening delimiter", 2, 1);
+    ok &= fixed_case("doubled closing delimiter", 1, 2);
+
+    Item *items = calloc(count, sizeof(Item));
+    if (items == NULL) {
+        return 2;
+    }
+    uint32_t faults = 0;
+    uint32_t spurious[2];
+    streamLength = 0;
+    bool closingLost = false;
+    for (uint32_t n = 0; n < count; n++) {
+        random_item(&items[n]);
+        int opening = delimiter_times(faultPercent, &faults);
+        int closing = delimiter_times(faultPercent, &faults);
+        put_item(&items[n], opening, closing);
+        // The next opening delimiter closes the frame instead
+        items[n].faulted |= closingLost;
+        closingLost = items[n].frame && closing == 0;
+    }
+    mark_required(items, count);
+    run(items, count, spurious);
+
+    char name[32];
+    snprintf(name, sizeof(name), "random, %u%% faults", faultPercent);
+    ok &= check(name, items, count, spurious);
+    printf("faults %u, %zu bytes, reader lines %u frames %u crc %u framing %u resyncs %u discarded %u\n",
+           faults, streamLength, reader.stats.lines, reader.stats.frames, reader.stats.crcErrors,
+           reader.stats.framingErrors, reader.stats.resyncs, reader.stats.discarded);
+    free(items);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,249 @@
+/*
+ * sim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/drivers/UART2.h>
+#include <ti/drivers/PWM.h>
+#include <ti/drivers/I2C.h>
+
+#include "sim.h"
+
+struct Semaphore_Struct {
+    sem_t sem;
+    Semaphore_Mode mode;
+};
+
+uint32_t Clock_tickPeriod = 1000;
+
+char sim_uart_out[SIM_UART_OUT_SIZE];
+size_t sim_uart_length = 0;
+uint64_t sim_uart_bytes = 0;
+uint32_t sim_uart_writes = 0;
+static pthread_mutex_t sim_uart_lock = PTHREAD_MUTEX_INITIALIZER;
+
+uint32_t sim_pwm_duty[SIM_PWM_MAX];
+bool sim_pwm_running[SIM_PWM_MAX];
+
+uint32_t sim_i2c_transfers = 0;
+
+
+/*
+ * Kernel
+ */
+uint32_t Clock_getTicks(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(((uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000) / Clock_tickPeriod);
+}
+
+Task_Handle Task_self(void)
+{
+    return NULL;
+}
+
+void Task_stat(Task_Handle handle, Task_Stat *stat)
+{
+    (void)handle;
+    memset(stat, 0, sizeof(Task_Stat));
+}
+
+void *Task_getHookContext(Task_Handle handle, int id)
+{
+    (void)handle;
+    (void)id;
+    return NULL;
+}
+
+void Task_setHookContext(Task_Handle handle, int id, void *context)
+{
+    (void)handle;
+    (void)id;
+    (void)context;
+}
+
+void Semaphore_Params_init(Semaphore_Params *params)
+{
+    params->mode = Semaphore_Mode_COUNTING;
+}
+
+Semaphore_Handle Semaphore_create(int count, Semaphore_Params *params, void *eb)
+{
+    (void)eb;
+    Semaphore_Handle handle = malloc(sizeof(struct Semaphore_Struct));
+    if (handle == NULL) {
+        return NULL;
+    }
+    handle->mode = (params != NULL) ? params->mode : Semaphore_Mode_COUNTING;
+    sem_init(&handle->sem, 0, (unsigned)count);
+    return handle;
+}
+
+bool Semaphore_pend(Semaphore_Handle handle, uint32_t timeout)
+{
+    if (timeout == BIOS_NO_WAIT) {
+        return sem_trywait(&handle->sem) == 0;
+    }
+    if (timeout == BIOS_WAIT_FOREVER) {
+        while (sem_wait(&handle->sem) != 0) {}
+        return true;
+    }
+    struct timespec due;
+    uint64_t ns = (uint64_t)timeout * Clock_tickPeriod * 1000;
+    clock_gettime(CLOCK_REALTIME, &due);
+    due.tv_sec += (time_t)(ns / 1000000000);
+    due.tv_nsec += (long)(ns % 1000000000);
+    if (due.tv_nsec >= 1000000000) {
+        due.tv_sec++;
+        due.tv_nsec -= 1000000000;
+    }
+    while (sem_timedwait(&handle->sem, &due) != 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Semaphore_post(Semaphore_Handle handle)
+{
+    int value = 0;
+    sem_getvalue(&handle->sem, &value);
+    if (handle->mode == Semaphore_Mode_BINARY && value > 0) {
+        return;
+    }
+    sem_post(&handle->sem);
+}
+
+/*
+ * The firmware asks for TI-RTOS priorities and 2 KB stacks, which a
+ * host scheduler refuses, threads run at the default policy and stack
+ */
+int pthread_attr_setschedparam(pthread_attr_t *attrs, const struct sched_param *param)
+{
+    (void)attrs;
+    (void)param;
+    return 0;
+}
+
+int pthread_attr_setstacksize(pthread_attr_t *attrs, size_t size)
+{
+    (void)attrs;
+    (void)size;
+    return 0;
+}
+
+
+/*
+ * UART, output is captured, input is fed by calling the read callback
+ */
+void sim_uart_clear(void)
+{
+    pthread_mutex_lock(&sim_uart_lock);
+    sim_uart_length = 0;
+    pthread_mutex_unlock(&sim_uart_lock);
+}
+
+__attribute__((weak)) int_fast16_t UART2_write(UART2_Handle handle, const void *buffer, size_t size, size_t *written)
+{
+    (void)handle;
+    pthread_mutex_lock(&sim_uart_lock);
+    size_t room = SIM_UART_OUT_SIZE - sim_uart_length;
+    size_t kept = (size < room) ? size : room;
+    memcpy(&sim_uart_out[sim_uart_length], buffer, kept);
+    sim_uart_length += kept;
+    sim_uart_bytes += size;
+    sim_uart_writes++;
+    pthread_mutex_unlock(&sim_uart_lock);
+    if (written != NULL) {
+        *written = size;
+    }
+    return UART2_STATUS_SUCCESS;
+}
+
+__attribute__((weak)) int_fast16_t UART2_read(UART2_Handle handle, void *buffer, size_t size, size_t *read)
+{
+    (void)handle;
+    (void)buffer;
+    (void)size;
+    if (read != NULL) {
+        *read = 0;
+    }
+    return UART2_STATUS_SUCCESS;
+}
+
+
+/*
+ * PWM, index i is handle i + 1
+ */
+static uint32_t sim_pwm_index(PWM_Handle handle)
+{
+    return (uint32_t)((uintptr_t)handle - 1) % SIM_PWM_MAX;
+}
+
+__attribute__((weak)) void PWM_init(void)
+{
+}
+
+__attribute__((weak)) void PWM_Params_init(PWM_Params *params)
+{
+    memset(params, 0, sizeof(PWM_Params));
+}
+
+__attribute__((weak)) PWM_Handle PWM_open(uint_least8_t index, PWM_Params *params)
+{
+    (void)params;
+    return (PWM_Handle)(uintptr_t)(index + 1);
+}
+
+__attribute__((weak)) void PWM_start(PWM_Handle handle)
+{
+    sim_pwm_running[sim_pwm_index(handle)] = true;
+}
+
+__attribute__((weak)) void PWM_stop(PWM_Handle handle)
+{
+    sim_pwm_running[sim_pwm_index(handle)] = false;
+}
+
+__attribute__((weak)) int_fast16_t PWM_setDuty(PWM_Handle handle, uint32_t duty)
+{
+    sim_pwm_duty[sim_pwm_index(handle)] = duty;
+    return 0;
+}
+
+
+/*
+ * I2C, every read returns SIM_I2C_RESULT
+ */
+__attribute__((weak)) bool I2C_transfer(I2C_Handle handle, I2C_Transaction *transaction)
+{
+    (void)handle;
+    __atomic_add_fetch(&sim_i2c_transfers, 1, __ATOMIC_RELAXED);
+    if (transaction->readCount >= 2) {
+        ((uint8_t*)transaction->readBuf)[0] = (uint8_t)(SIM_I2C_RESULT >> 8);
+        ((uint8_t*)transaction->readBuf)[1] = (uint8_t)SIM_I2C_RESULT;
+    }
+    transaction->status = I2C_STATUS_SUCCESS;
+    return true;
+}
+
+__attribute__((weak)) int_fast16_t I2C_transferTimeout(I2C_Handle handle, I2C_Transaction *transaction, uint32_t timeout)
+{
+    (void)timeout;
+    return I2C_transfer(handle, transaction) ? I2C_STATUS_SUCCESS : transaction->status;
+}
@@ -0,0 +1,46 @@
+/*
+ * sim.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Host stand-ins for the TI-RTOS kernel and drivers
+ *      Lets the firmware modules run unchanged on a POSIX host for tests
+ *      and measurements. Semaphores are POSIX semaphores, UART output is
+ *      captured in sim_uart_out, PWM outputs are recorded per index and
+ *      I2C answers every read with 25 degC. The driver functions are weak
+ *      so a test can replace them with a model of its own.
+ *
+ *      Build with -IHost/sim ahead of the module directories and link
+ *      sim.c, Clock_tickPeriod is 1000 so timeouts in ticks are ms.
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* UART output kept, later output is counted but dropped */
+#define SIM_UART_OUT_SIZE       (1 << 20)
+
+/* PWM indexes recorded */
+#define SIM_PWM_MAX             8
+
+/* TMP117 result register returned by the default I2C_transfer, 25 degC */
+#define SIM_I2C_RESULT          0x0C80
+
+extern char sim_uart_out[SIM_UART_OUT_SIZE];
+extern size_t sim_uart_length;          // Bytes kept in sim_uart_out
+extern uint64_t sim_uart_bytes;         // Bytes written in total
+extern uint32_t sim_uart_writes;        // UART2_write calls
+
+extern uint32_t sim_pwm_duty[SIM_PWM_MAX];
+extern bool sim_pwm_running[SIM_PWM_MAX];
+
+extern uint32_t sim_i2c_transfers;
+
+void sim_uart_clear(void);
+
+#endif /* SIM_H_ */
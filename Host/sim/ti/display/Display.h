@@ -0,0 +1,15 @@
+/*
+ * Display.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Host stand-in, only what the firmware uses (see Host/sim/sim.c)
+ */
+
+#ifndef TI_DISPLAY_DISPLAY_H_
+#define TI_DISPLAY_DISPLAY_H_
+
+typedef struct Display_Config *Display_Handle;
+
+#endif /* TI_DISPLAY_DISPLAY_H_ */
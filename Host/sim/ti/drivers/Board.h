@@ -0,0 +1,13 @@
+/*
+ * Board.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Host stand-in, only what the firmware uses (see Host/sim/sim.c)
+ */
+
+#ifndef TI_DRIVERS_BOARD_H_
+#define TI_DRIVERS_BOARD_H_
+
+#endif /* TI_DRIVERS_BOARD_H_ */
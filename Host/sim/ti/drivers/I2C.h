@@ -0,0 +1,47 @@
+/*
+ * I2C.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Host stand-in, only what the firmware uses (see Host/sim/sim.c)
+ */
+
+#ifndef TI_DRIVERS_I2C_H_
+#define TI_DRIVERS_I2C_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct I2C_Config *I2C_Handle;
+
+typedef struct I2C_Transaction {
+    void *writeBuf;
+    size_t writeCount;
+    void *readBuf;
+    size_t readCount;
+    uint_least8_t slaveAddress;
+    volatile int_fast16_t status;
+    void *arg;
+} I2C_Transaction;
+
+#define I2C_STATUS_SUCCESS          0
+#define I2C_STATUS_ERROR            (-1)
+#define I2C_STATUS_UNDEFINEDCMD     (-2)
+#define I2C_STATUS_TIMEOUT          (-3)
+#define I2C_STATUS_CLOCK_TIMEOUT    (-4)
+#define I2C_STATUS_ADDR_NACK        (-5)
+#define I2C_STATUS_DATA_NACK        (-6)
+#define I2C_STATUS_ARB_LOST         (-7)
+#define I2C_STATUS_INCOMPLETE       (-8)
+#define I2C_STATUS_BUS_BUSY         (-9)
+#define I2C_STATUS_CANCEL           (-10)
+#define I2C_STATUS_INVALID_TRANS    (-11)
+
+#define I2C_WAIT_FOREVER            (~(0U))
+
+bool I2C_transfer(I2C_Handle handle, I2C_Transaction *transaction);
+int_fast16_t I2C_transferTimeout(I2C_Handle handle, I2C_Transaction *transaction, uint32_t timeout);
+
+#endif /* TI_DRIVERS_I2C_H_ */
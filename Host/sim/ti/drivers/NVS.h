@@ -0,0 +1,43 @@
+/*
+ * NVS.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Host stand-in, only what the firmware uses (see Host/sim/sim.c)
+ */
+
+#ifndef TI_DRIVERS_NVS_H_
+#define TI_DRIVERS_NVS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct NVS_Config *NVS_Handle;
+
+typedef struct NVS_Attrs {
+    void *regionBase;
+    size_t regionSize;
+    size_t sectorSize;
+} NVS_Attrs;
+
+typedef struct NVS_Params {
+    void *custom;
+} NVS_Params;
+
+#define NVS_STATUS_SUCCESS      0
+#define NVS_STATUS_ERROR        (-1)
+
+#define NVS_WRITE_ERASE         0x1
+#define NVS_WRITE_PRE_VERIFY    0x2
+#define NVS_WRITE_POST_VERIFY   0x4
+
+void NVS_init(void);
+void NVS_Params_init(NVS_Params *params);
+NVS_Handle NVS_open(uint_least8_t index, NVS_Params *params);
+void NVS_getAttrs(NVS_Handle handle, NVS_Attrs *attrs);
+int_fast16_t NVS_read(NVS_Handle handle, size_t offset, void *buffer, size_t size);
+int_fast16_t NVS_write(NVS_Handle handle, size_t offset, void *buffer, size_t size, uint_fast16_t flags);
+int_fast16_t NVS_erase(NVS_Handle handle, size_t offset, size_t size);
+
+#endif /* TI_DRIVERS_NVS_H_ */
@@ -0,0 +1,51 @@
+/*
+ * PWM.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Host stand-in, only what the firmware uses (see Host/sim/sim.c)
+ */
+
+#ifndef TI_DRIVERS_PWM_H_
+#define TI_DRIVERS_PWM_H_
+
+#include <stdint.h>
+
+typedef struct PWM_Config *PWM_Handle;
+
+typedef enum PWM_IdleLevel {
+    PWM_IDLE_LOW,
+    PWM_IDLE_HIGH
+} PWM_IdleLevel;
+
+typedef enum PWM_Period_Units {
+    PWM_PERIOD_US,
+    PWM_PERIOD_HZ,
+    PWM_PERIOD_COUNTS
+} PWM_Period_Units;
+
+typedef enum PWM_Duty_Units {
+    PWM_DUTY_US,
+    PWM_DUTY_FRACTION,
+    PWM_DUTY_COUNTS
+} PWM_Duty_Units;
+
+typedef struct PWM_Params {
+    PWM_Period_Units periodUnits;
+    uint32_t periodValue;
+    PWM_Duty_Units dutyUnits;
+    uint32_t dutyValue;
+    PWM_IdleLevel idleLevel;
+} PWM_Params;
+
+#define PWM_DUTY_FRACTION_MAX   ((uint32_t)~0)
+
+void PWM_init(void);
+void PWM_Params_init(PWM_Params *params);
+PWM_Handle PWM_open(uint_least8_t index, PWM_Params *params);
+void PWM_start(PWM_Handle handle);
+void PWM_stop(PWM_Handle handle);
+int_fast16_t PWM_setDuty(PWM_Handle handle, uint32_t duty);
+
+#endif /* TI_DRIVERS_PWM_H_ */
@@ -0,0 +1,46 @@
+/*
+ * UART2.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Host stand-in, only what the firmware uses (see Host/sim/sim.c)
+ */
+
+#ifndef TI_DRIVERS_UART2_H_
+#define TI_DRIVERS_UART2_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct UART2_Config *UART2_Handle;
+typedef void (*UART2_Callback)(UART2_Handle handle, void *buffer, size_t count, void *userArg, int_fast16_t status);
+
+typedef enum UART2_Mode {
+    UART2_Mode_BLOCKING,
+    UART2_Mode_CALLBACK,
+    UART2_Mode_NONBLOCKING
+} UART2_Mode;
+
+typedef enum UART2_ReadReturnMode {
+    UART2_ReadReturnMode_FULL,
+    UART2_ReadReturnMode_PARTIAL
+} UART2_ReadReturnMode;
+
+typedef struct UART2_Params {
+    UART2_Mode readMode;
+    UART2_Mode writeMode;
+    UART2_Callback readCallback;
+    UART2_Callback writeCallback;
+    UART2_ReadReturnMode readReturnMode;
+    uint32_t baudRate;
+    void *userArg;
+} UART2_Params;
+
+#define UART2_STATUS_SUCCESS    0
+#define UART2_STATUS_EOVERRUN   (-6)
+
+int_fast16_t UART2_write(UART2_Handle handle, const void *buffer, size_t size, size_t *written);
+int_fast16_t UART2_read(UART2_Handle handle, void *buffer, size_t size, size_t *read);
+
+#endif /* TI_DRIVERS_UART2_H_ */
@@ -0,0 +1,18 @@
+/*
+ * BIOS.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Host stand-in, only what the firmware uses (see Host/sim/sim.c)
+ */
+
+#ifndef TI_SYSBIOS_BIOS_H_
+#define TI_SYSBIOS_BIOS_H_
+
+#include <stdint.h>
+
+#define BIOS_WAIT_FOREVER       (~(0u))
+#define BIOS_NO_WAIT            0
+
+#endif /* TI_SYSBIOS_BIOS_H_ */
@@ -0,0 +1,20 @@
+/*
+ * Clock.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Host stand-in, only what the firmware uses (see Host/sim/sim.c)
+ */
+
+#ifndef TI_SYSBIOS_KNL_CLOCK_H_
+#define TI_SYSBIOS_KNL_CLOCK_H_
+
+#include <stdint.h>
+
+/* Tick in us, 1000 on the host so Semaphore_pend timeouts are in ms */
+extern uint32_t Clock_tickPeriod;
+
+uint32_t Clock_getTicks(void);
+
+#endif /* TI_SYSBIOS_KNL_CLOCK_H_ */
@@ -0,0 +1,32 @@
+/*
+ * Semaphore.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Host stand-in, only what the firmware uses (see Host/sim/sim.c)
+ */
+
+#ifndef TI_SYSBIOS_KNL_SEMAPHORE_H_
+#define TI_SYSBIOS_KNL_SEMAPHORE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct Semaphore_Struct *Semaphore_Handle;
+
+typedef enum Semaphore_Mode {
+    Semaphore_Mode_COUNTING,
+    Semaphore_Mode_BINARY
+} Semaphore_Mode;
+
+typedef struct Semaphore_Params {
+    Semaphore_Mode mode;
+} Semaphore_Params;
+
+void Semaphore_Params_init(Semaphore_Params *params);
+Semaphore_Handle Semaphore_create(int count, Semaphore_Params *params, void *eb);
+bool Semaphore_pend(Semaphore_Handle handle, uint32_t timeout);
+void Semaphore_post(Semaphore_Handle handle);
+
+#endif /* TI_SYSBIOS_KNL_SEMAPHORE_H_ */
@@ -0,0 +1,35 @@
+/*
+ * Task.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Host stand-in, only what the firmware uses (see Host/sim/sim.c)
+ */
+
+#ifndef TI_SYSBIOS_KNL_TASK_H_
+#define TI_SYSBIOS_KNL_TASK_H_
+
+#include <stddef.h>
+
+typedef struct Task_Object *Task_Handle;
+
+typedef struct Task_Stat {
+    int priority;
+    void *stack;
+    size_t stackSize;
+    void *stackHeap;
+    void *env;
+    int mode;
+    void *sp;
+    size_t used;                // Always 0 on the host
+} Task_Stat;
+
+Task_Handle Task_self(void);
+void Task_stat(Task_Handle handle, Task_Stat *stat);
+
+/* Hook sets are never registered on the host, switch hooks do not run */
+void *Task_getHookContext(Task_Handle handle, int id);
+void Task_setHookContext(Task_Handle handle, int id, void *context);
+
+#endif /* TI_SYSBIOS_KNL_TASK_H_ */
@@ -0,0 +1,177 @@
+/*
+ * thermal_sim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Steps the thermal controller PID against a simulated heater plant
+ *      thermal_sim [setpoint degC] [period ms] [kp] [ki] [kd] [seconds]
+ *
+ * Gains are given as plain numbers and converted to Q16.16, output is in
+ * PWM levels 0 to 1000 like Control/README.md. The loop runs in the same
+ * order as Run_process: the output computed in the previous period is
+ * written first, then the sensor is sampled and the PID stepped.
+ *
+ * The plant is a lumped thermal mass heated by the PWM duty and losing
+ * heat to ambient, seen through the probe lag, TMP117 averaging and
+ * quantization (1/128 degC) and 1 LSB of noise. Prints the step response
+ * (rise, overshoot, settling, steady state error) and with --csv the trace.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "pid.h"
+
+#define OUTPUT_MAX              1000
+
+/* Plant: 10 W heater, 5 K/W to ambient, 20 J/K, tau 100 s */
+#define PLANT_POWER_W           10.0
+#define PLANT_R_KW              5.0
+#define PLANT_C_JK              20.0
+#define PLANT_AMBIENT           25.0
+/* Probe to mass thermal lag */
+#define PROBE_TAU_S             2.0
+/* TMP117 with 8 averages, result is the mean of the last 125 ms */
+#define SENSOR_AVG_S            0.125
+/* Plant integration step */
+#define SIM_DT_S                0.001
+
+/* Settled when within this band for the rest of the run */
+#define SETTLE_BAND             0.25
+
+typedef struct Plant {
+    double mass;                // degC
+    double probe;               // degC, lagging the mass
+    double average;             // degC, sensor averaging filter
+    uint32_t noise;             // LCG state
+} Plant;
+
+static void plant_step(Plant *plant, double duty, double dt)
+{
+    double power = PLANT_POWER_W * duty;
+    plant->mass += dt * (power - (plant->mass - PLANT_AMBIENT) / PLANT_R_KW) / PLANT_C_JK;
+    plant->probe += dt * (plant->mass - plant->probe) / PROBE_TAU_S;
+    plant->average += dt * (plant->probe - plant->average) / SENSOR_AVG_S;
+}
+
+static int32_t plant_read(Plant *plant)
+{
+    plant->noise = plant->noise * 1664525u + 1013904223u;
+    int32_t lsb = (int32_t)(plant->noise >> 30) - 1;    // -1, 0, 1 or 2
+    if (lsb > 1) {
+        lsb = 0;
+    }
+    return (int32_t)lround(plant->average * 128) + lsb;
+}
+
+static int32_t to_q16(double gain)
+{
+    return (int32_t)lround(gain * PID_ONE);
+}
+
+int main(int argc, char **argv)
+{
+    bool csv = false;
+    if (argc > 1 && strcmp(argv[1], "--csv") == 0) {
+        csv = true;
+        argc--;
+        argv++;
+    }
+    double setpoint = argc > 1 ? atof(argv[1]) : 45.0;
+    uint32_t period_ms = argc > 2 ? (uint32_t)atoi(argv[2]) : 100;
+    double kp = argc > 3 ? atof(argv[3]) : 2.0;
+    double ki = argc > 4 ? atof(argv[4]) : 1.0 / 16;
+    double kd = argc > 5 ? atof(argv[5]) : 0;
+    double seconds = argc > 6 ? atof(argv[6]) : 1200;
+
+    if (period_ms == 0) {
+        fprintf(stderr, "period must be at least 1 ms\n");
+        return 1;
+    }
+
+    PID_Gains gains = {.kp = to_q16(kp), .ki = to_q16(ki), .kd = to_q16(kd),
+                       .outMin = 0, .outMax = OUTPUT_MAX, .reverse = false};
+    PID_State pid;
+    PID_reset(&pid);
+    int32_t target = (int32_t)lround(setpoint * 128);
+
+    Plant plant = {PLANT_AMBIENT, PLANT_AMBIENT, PLANT_AMBIENT, 1};
+    double start = PLANT_AMBIENT;
+    double step = setpoint - start;
+    double rise10 = -1, rise90 = -1, settled = -1, peak = start;
+    double sumError = 0, sumOutput = 0;
+    uint32_t tailSamples = 0, saturated = 0;
+    uint32_t periods = (uint32_t)(seconds * 1000 / period_ms);
+    uint32_t ticks = (uint32_t)lround(period_ms / 1000.0 / SIM_DT_S);
+    int32_t output = 0;
+
+    if (csv) {
+        printf("time_s,mass_degC,measured_degC,output\n");
+    }
+    for (uint32_t n = 0; n < periods; n++) {
+        double time = n * period_ms / 1000.0;
+
+        // Output of the previous period, then sample and step
+        double duty = (double)output / OUTPUT_MAX;
+        int32_t raw = plant_read(&plant);
+        output = PID_step(&pid, &gains, target, raw);
+        if (output == OUTPUT_MAX || output == 0) {
+            saturated++;
+        }
+        for (uint32_t t = 0; t < ticks; t++) {
+            plant_step(&plant, duty, SIM_DT_S);
+        }
+
+        double measured = raw / 128.0;
+        if (rise10 < 0 && measured - start >= 0.1 * step) {
+            rise10 = time;
+        }
+        if (rise90 < 0 && measured - start >= 0.9 * step) {
+            rise90 = time;
+        }
+        if (measured > peak) {
+            peak = measured;
+        }
+        if (fabs(measured - setpoint) > SETTLE_BAND) {
+            settled = -1;
+        }
+        else if (settled < 0) {
+            settled = time;
+        }
+        // Last quarter of the run is the steady state
+        if (n >= periods - periods / 4) {
+            sumError += measured - setpoint;
+            sumOutput += output;
+            tailSamples++;
+        }
+        if (csv) {
+            printf("%.3f,%.4f,%.4f,%d\n", time, plant.mass, measured, output);
+        }
+    }
+
+    FILE *out = csv ? stderr : stdout;
+    fprintf(out, "setpoint %.2f degC from %.2f, period %u ms, kp %g ki %g kd %g, %u periods\n",
+            setpoint, start, period_ms, kp, ki, kd, periods);
+    if (rise10 >= 0 && rise90 >= 0) {
+        fprintf(out, "rise 10-90%%    %.1f s\n", rise90 - rise10);
+    }
+    else {
+        fprintf(out, "rise 10-90%%    not reached\n");
+    }
+    fprintf(out, "overshoot      %.3f degC\n", peak > setpoint ? peak - setpoint : 0);
+    if (settled >= 0) {
+        fprintf(out, "settled +-%.2f %.1f s\n", SETTLE_BAND, settled);
+    }
+    else {
+        fprintf(out, "settled +-%.2f never\n", SETTLE_BAND);
+    }
+    if (tailSamples) {
+        fprintf(out, "steady error   %.4f degC, output %.0f of %d\n",
+                sumError / tailSamples, sumOutput / tailSamples, OUTPUT_MAX);
+    }
+    fprintf(out, "saturated      %u of %u periods\n", saturated, periods);
+    return 0;
+}
@@ -0,0 +1,54 @@
+/*
+ * tlm_dump.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Reads a raw UART capture (file or stdin) and prints samples as CSV
+ * Log records are formatted with the firmware's message table to stderr
+ *      tlm_dump < /dev/ttyACM0
+ */
+
+#include <stdio.h>
+
+#include "frame_decoder.h"
+
+static void print_sample(const Decoder_Sample *sample, void *arg)
+{
+    (void)arg;
+    printf("%u,%u,%d,%.4f\n", sample->sensorId, sample->timestamp_us, sample->raw, sample->temp);
+}
+
+static void print_log(const Log_Record *record, uint8_t thread, void *arg)
+{
+    (void)thread;
+    (void)arg;
+    char line[128];
+    Log_format(line, sizeof(line), record);
+    fputs(line, stderr);
+}
+
+int main(int argc, char **argv)
+{
+    static Frame_Decoder decoder;
+    uint8_t buffer[4096];
+    size_t length;
+    FILE *input = stdin;
+
+    if (argc > 1 && (input = fopen(argv[1], "rb")) == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    Decoder_init(&decoder, print_sample, print_log, NULL, NULL);
+    printf("sensor,timestamp_us,raw,degC\n");
+    while ((length = fread(buffer, 1, sizeof(buffer), input)) > 0) {
+        Decoder_feed(&decoder, buffer, length);
+        fflush(stdout);
+    }
+    fprintf(stderr, "frames %u, samples %u, crc errors %u, framing errors %u, lost frames %u\n",
+            decoder.stats.frames, decoder.stats.samples, decoder.stats.crcErrors,
+            decoder.stats.framingErrors, decoder.stats.lostFrames);
+    fprintf(stderr, "log records %u, dropped by firmware %u\n",
+            decoder.stats.logRecords, decoder.stats.logDropped);
+    return 0;
+}
@@ -0,0 +1,237 @@
+/*
+ * tx_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Compares the UART transmit path against one blocking UART2_write per
+ * character, the way uart_print_string wrote before the ring
+ *      tx_bench [producers] [messages each] [interval us] [baud]
+ *
+ * Producer threads print a 24 byte line every interval, like sensor
+ * threads printing samples. UART2_write is a model of a blocking driver:
+ * one write at a time, a fixed cost per call, then 10 bits per byte at the
+ * baud rate. Reports line throughput, driver calls and the time the
+ * producers spent inside the print calls. Both runs are checked for lost,
+ * reordered or interleaved lines, exits 1 if the ring run has any.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/prctl.h>
+
+#include "sim.h"
+#include "uart_tx.h"
+#include "utilities.h"
+
+#define PRODUCERS_MAX           16
+/* Driver call and interrupt setup per UART2_write */
+#define WRITE_CALL_US           10
+
+typedef struct Producer {
+    pthread_t thread;
+    uint32_t id;
+    uint64_t inside_us;         // Time spent in the print calls
+    uint32_t max_us;            // Longest single message
+} Producer;
+
+static uint32_t messages = 500;
+static uint32_t interval_us = 10000;
+static uint32_t baud = 115200;
+static bool direct;
+
+static pthread_mutex_t line_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t line_free_us;   // Time the line finishes the last write
+static uint64_t line_bytes;
+static uint32_t line_writes;
+static uint64_t line_first_us, line_last_us;
+
+static void sleep_until(uint64_t time_us)
+{
+    struct timespec deadline;
+    deadline.tv_sec = (time_t)(time_us / 1000000);
+    deadline.tv_nsec = (long)(time_us % 1000000) * 1000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL)) {
+    }
+}
+
+/*
+ * Blocking driver model, returns once the bytes are on the line
+ */
+int_fast16_t UART2_write(UART2_Handle handle, const void *buffer, size_t size, size_t *written)
+{
+    (void)handle;
+    pthread_mutex_lock(&line_lock);
+    uint64_t now = clock_us();
+    uint64_t start = now > line_free_us ? now : line_free_us;
+    uint64_t end = start + WRITE_CALL_US + (uint64_t)size * 10 * 1000000 / baud;
+    if (!line_writes) {
+        line_first_us = start;
+    }
+    line_free_us = end;
+    line_writes++;
+    line_bytes += size;
+    size_t room = SIM_UART_OUT_SIZE - sim_uart_length;
+    size_t kept = size < room ? size : room;
+    memcpy(&sim_uart_out[sim_uart_length], buffer, kept);
+    sim_uart_length += kept;
+    sleep_until(end);
+    line_last_us = clock_us();
+    pthread_mutex_unlock(&line_lock);
+    if (written != NULL) {
+        *written = size;
+    }
+    return UART2_STATUS_SUCCESS;
+}
+
+/* uart_print_string before the ring */
+static void direct_print(const char *string)
+{
+    size_t bytesWritten = 0;
+    while (*string != '\0') {
+        if (UART2_write(uart, string, 1, &bytesWritten) != UART2_STATUS_SUCCESS) {
+            return;
+        }
+        string++;
+    }
+}
+
+static void *producer_thread(void *arg)
+{
+    Producer *producer = (Producer *)arg;
+    uint64_t next = clock_us();
+    char line[32];
+
+    for (uint32_t n = 0; n < messages; n++) {
+        snprintf(line, sizeof(line), "P%02u %05u Value: 23.125\n", producer->id, n % 100000);
+        uint64_t start = clock_us();
+        if (direct) {
+            direct_print(line);
+        }
+        else {
+            uart_print_string(line);
+        }
+        uint32_t took = (uint32_t)(clock_us() - start);
+        producer->inside_us += took;
+        if (took > producer->max_us) {
+            producer->max_us = took;
+        }
+        next += interval_us;
+        sleep_until(next);
+    }
+    return NULL;
+}
+
+/* Every producer's messages whole and in order, returns the faults */
+static uint32_t check_output(uint32_t producers)
+{
+    uint32_t expect[PRODUCERS_MAX] = {0};
+    uint32_t faults = 0;
+    uint32_t id, seq;
+    const char *cursor = sim_uart_out;
+    const char *end = sim_uart_out + sim_uart_length;
+
+    while (cursor < end) {
+        const char *newline = memchr(cursor, '\n', (size_t)(end - cursor));
+        if (newline == NULL) {
+            faults++;
+            break;
+        }
+        if (sscanf(cursor, "P%2u %5u", &id, &seq) != 2 || id >= producers ||
+            newline - cursor != 23) {
+            faults++;
+            cursor = newline + 1;
+            continue;
+        }
+        if (seq != expect[id] % 100000) {
+            faults++;
+        }
+        expect[id] = seq + 1;
+        cursor = newline + 1;
+    }
+    if (faults) {
+        return faults;
+    }
+    for (id = 0; id < producers; id++) {
+        if (expect[id] != messages) {
+            faults++;
+        }
+    }
+    return faults;
+}
+
+static uint32_t run(uint32_t producers, const char *name)
+{
+    Producer producer[PRODUCERS_MAX];
+    uint64_t inside = 0;
+    uint32_t worst = 0;
+
+    memset(producer, 0, sizeof(producer));
+    line_bytes = 0;
+    line_writes = 0;
+    line_free_us = 0;
+    sim_uart_clear();
+
+    uint64_t start = clock_us();
+    for (uint32_t n = 0; n < producers; n++) {
+        producer[n].id = n;
+        pthread_create(&producer[n].thread, NULL, producer_thread, &producer[n]);
+    }
+    for (uint32_t n = 0; n < producers; n++) {
+        pthread_join(producer[n].thread, NULL);
+        inside += producer[n].inside_us;
+        if (producer[n].max_us > worst) {
+            worst = producer[n].max_us;
+        }
+    }
+    uint64_t expected = (uint64_t)producers * messages * 24;
+    while ((line_bytes < expected || (!direct && uart_tx_stats.bytesWritten < expected)) &&
+           clock_us() - start < 60000000) {
+        sleep_until(clock_us() + 10000);
+    }
+    double busy = (line_last_us - line_first_us) / 1e6;    // First to last byte on the line
+    double data = line_bytes * 10.0 / baud;                 // Time the bytes alone take
+    if (busy <= 0) {
+        busy = 1;
+    }
+
+    printf("%-7s %6.0f bytes/s, data %3.0f %% of the line time, %6u writes, "
+           "in print %7.1f us avg %6u us max, %5.1f %% of the interval\n",
+           name, line_bytes / busy, data * 100 / busy, line_writes,
+           (double)inside / (producers * messages), worst,
+           inside * 100.0 / ((double)producers * messages * interval_us));
+    return check_output(producers);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t producers = argc > 1 ? (uint32_t)atoi(argv[1]) : 4;
+    messages = argc > 2 ? (uint32_t)atoi(argv[2]) : 500;
+    interval_us = argc > 3 ? (uint32_t)atoi(argv[3]) : 10000;
+    baud = argc > 4 ? (uint32_t)atoi(argv[4]) : 115200;
+    if (producers == 0 || producers > PRODUCERS_MAX || baud == 0) {
+        fprintf(stderr, "1 to %u producers\n", PRODUCERS_MAX);
+        return 1;
+    }
+    prctl(PR_SET_TIMERSLACK, 1);
+
+    printf("%u producers, %u lines of 24 bytes each every %u us, %u baud, offered %.0f %% of the line\n",
+           producers, messages, interval_us, baud,
+           producers * 24.0 * 10 * 1e6 / interval_us / baud * 100);
+
+    direct = true;
+    uint32_t mixed = run(producers, "direct");
+    printf("direct  %u lines interleaved or out of order\n", mixed);
+
+    direct = false;
+    UART_TX_init(UART_TX_BLOCK);
+    uint32_t faults = run(producers, "ring");
+    printf("ring    queued %u, written %u, dropped %u, blocked %u us, max level %u of %u, %s\n",
+           uart_tx_stats.bytesQueued, uart_tx_stats.bytesWritten, uart_tx_stats.droppedBytes,
+           uart_tx_stats.blocked_us, uart_tx_stats.maxLevel, UART_TX_SIZE,
+           faults ? "LOST OR REORDERED" : "all in order");
+    return faults ? 1 : 0;
+}
@@ -6,160 +6,193 @@
  */
 
 #include "utilities.h"
+#include "log.h"
 #include "TMP117.h"
 
-void *TMP_thread(void *tmp_handle);
-void TMP_process_requests(TMP_Handle *handle);
+void TMP_start(void *tmp_handle);
+void TMP_dispatch(void *tmp_handle, const Active_Msg *msg);
+bool TMP_interleave(void *tmp_handle, const Active_Msg *suspended, const Active_Msg *msg);
 static void i2cErrorHandler(I2C_Transaction *transaction);
 
-void Detect_request(TMP_Handle *tmp_handle, bool *detect);
-void Detect_process(TMP_Handle *tmp_handle);
+void Detect_request(TMP_Handle *tmp_handle, Completion *done);
+bool Detect_process(TMP_Handle *tmp_handle, bool *detect);
 bool Detect_internal(TMP_Handle *tmp_handle);
-void ReadTemp_request(TMP_Handle *tmp_handle, float *avgTemp, uint8_t count);
-void ReadTemp_process(TMP_Handle *tmp_handle);
+void ReadTemp_request(TMP_Handle *tmp_handle, uint8_t count, Completion *done);
+bool ReadTemp_process(TMP_Handle *tmp_handle, float *avgTemp, uint8_t count);
+bool ReadTemp_step(TMP_Handle *tmp_handle, float *avgTemp, uint8_t count);
+bool ReadTemp_internal(TMP_Handle *tmp_handle, TMP_Sample *sample);
+void Publish_internal(TMP_Handle *tmp_handle, const TMP_Sample *sample);
+bool Unsubscribe_internal(TMP_Handle *tmp_handle, TMP_SampleFxn fxn, void *arg);
+bool ReadReg_internal(TMP_Handle *tmp_handle, uint8_t reg, uint16_t *value);
+bool WriteReg_internal(TMP_Handle *tmp_handle, uint8_t reg, uint16_t value);
+void Monitor_request(TMP_Handle *tmp_handle, uint16_t period_ms, Completion *done);
+void Monitor_process(TMP_Handle *tmp_handle, uint16_t period_ms);
+void Monitor_step(TMP_Handle *tmp_handle);
+void Adapt_request(TMP_Handle *tmp_handle, uint16_t min_ms, uint16_t max_ms, Completion *done);
+void Adapt_process(TMP_Handle *tmp_handle, uint16_t min_ms, uint16_t max_ms);
+void Adapt_step(TMP_Handle *tmp_handle);
 uint8_t UnlockMemory_internal(TMP_Handle *tmp_handle);
 uint8_t LockMemory_internal(TMP_Handle *tmp_handle);
-void ReadSN_request(TMP_Handle *tmp_handle, uint32_t *detect);
-void ReadSN_process(TMP_Handle *tmp_handle);
+uint8_t Eeprom_poll_internal(TMP_Handle *tmp_handle, bool unlock);
+bool Eeprom_retry_internal(TMP_Handle *tmp_handle, const Active_Msg *next);
+void ReadSN_request(TMP_Handle *tmp_handle, Completion *done);
+bool ReadSN_process(TMP_Handle *tmp_handle, uint32_t *serialNo);
 uint32_t ReadSN_internal(TMP_Handle *tmp_handle);
-void WriteSN_request(TMP_Handle *tmp_handle, uint32_t serialNo);
-void WriteSN_process(TMP_Handle *tmp_handle);
-void ReadID_request(TMP_Handle *tmp_handle, uint16_t *id);
-void ReadID_process(TMP_Handle *tmp_handle);
-void ReadCal_request(TMP_Handle *tmp_handle, float *offset);
-void ReadCal_process(TMP_Handle *tmp_handle);
+void WriteSN_request(TMP_Handle *tmp_handle, uint32_t serialNo, Completion *done);
+bool WriteSN_process(TMP_Handle *tmp_handle, uint32_t serialNo);
+bool WriteSN_step(TMP_Handle *tmp_handle, uint32_t serialNo, uint8_t stage, uint32_t *readSerialNo);
+bool WriteSN_verify(TMP_Handle *tmp_handle, uint32_t serialNo, uint32_t *readSerialNo);
+void ReadID_request(TMP_Handle *tmp_handle, Completion *done);
+bool ReadID_process(TMP_Handle *tmp_handle, uint16_t *id);
+void ReadCal_request(TMP_Handle *tmp_handle, Completion *done);
+bool ReadCal_process(TMP_Handle *tmp_handle, float *offset);
 float ReadCal_internal(TMP_Handle *tmp_handle);
-void WriteCal_request(TMP_Handle *tmp_handle, float offset);
-void WriteCal_process(TMP_Handle *tmp_handle);
+void WriteCal_request(TMP_Handle *tmp_handle, float offset, Completion *done);
+bool WriteCal_process(TMP_Handle *tmp_handle, float offset);
+bool WriteCal_step(TMP_Handle *tmp_handle, float offset, uint8_t stage, float *readOffset);
+bool WriteCal_verify(TMP_Handle *tmp_handle, float offset, float *readOffset);
 void TMP_Stop_request(TMP_Handle *tmp_handle);
 
+/* Shared by every sensor */
+static const Active_Config TMP_config = {
+    .priority = TMP_PRIORITY,
+    .stackSize = TMP_STACK_SIZE,
+    .start = TMP_start,
+    .dispatch = TMP_dispatch,
+    .interleave = TMP_interleave
+};
+
 /*
  * Initializes TMP thread which runs in parallel
  * to perform all operations on the TMP117
  *
+ * Input handle storage owned by the caller (static or global), the
+ * thread keeps using it so it must outlive the sensor
  * Input SysConfig I2C Name Reference (i.e. CONFIG_I2C_0)
  * Input TMP Name (i.e. Probe Temp) up to 10 characters
  *
+ * Returns false if the thread could not be started
  */
-TMP_Handle Open_TMP(I2C_Handle i2c_handle, uint8_t address, const char TMP_Name[10])
+bool Open_TMP(TMP_Handle *tmp_handle, I2C_Handle i2c_handle, uint8_t address, const char TMP_Name[10])
 {
-    TMP_Handle Tmp_handle;
-    Tmp_handle.tmp_status = TMP_Busy;
-    Tmp_handle.tmp_request = TMP_Initializing;
-
-    strcpy(Tmp_handle.tmp_name,TMP_Name);
-    Tmp_handle.i2c_handle = i2c_handle;
-    Tmp_handle.address = address;
-
-    Tmp_handle.Detect = Detect_request;
-    Tmp_handle.ReadTemp = ReadTemp_request;
-    Tmp_handle.ReadSN = ReadSN_request;
-    Tmp_handle.WriteSN = WriteSN_request;
-    Tmp_handle.ReadID = ReadID_request;
-    Tmp_handle.ReadCal = ReadCal_request;
-    Tmp_handle.WriteCal = WriteCal_request;
-    Tmp_handle.Stop = TMP_Stop_request;
-
-    Tmp_handle.fxn_details.count = 0;
-    Tmp_handle.fxn_details.writeSerialNo = 0;
-    Tmp_handle.fxn_details.readSerialNo = NULL;
-    Tmp_handle.fxn_details.writeOffset = 0;
-    Tmp_handle.fxn_details.readOffset = NULL;
-    Tmp_handle.fxn_details.detect = NULL;
-
-    pthread_attr_t attrs;
-    struct sched_param priParam;
-    int retc;
-
-    /* Initialize the attributes structure with default values */
-    pthread_attr_init(&attrs);
-
-    /* Set priority, detach state, and stack size attributes */
-    priParam.sched_priority = 2;
-    retc                    = pthread_attr_setschedparam(&attrs, &priParam);
-    retc |= pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
-    retc |= pthread_attr_setstacksize(&attrs, 2048);
-    if (retc != 0){
-        /* failed to set attributes */
-        while (1){}
-    }
-
-    retc = pthread_create(&(Tmp_handle.pth_handle), &attrs, TMP_thread, (void *)&(Tmp_handle));
-    if (retc != 0){
-        uart_print_string("!Error: ");
-        uart_print_string(Tmp_handle.tmp_name);
-        uart_print_string(" Thread creation error!\n");
-    }
-
-    return Tmp_handle;
+    strcpy(tmp_handle->tmp_name,TMP_Name);
+    tmp_handle->i2c_handle = i2c_handle;
+    tmp_handle->address = address;
+
+    tmp_handle->Detect = Detect_request;
+    tmp_handle->ReadTemp = ReadTemp_request;
+    tmp_handle->ReadSN = ReadSN_request;
+    tmp_handle->WriteSN = WriteSN_request;
+    tmp_handle->ReadID = ReadID_request;
+    tmp_handle->ReadCal = ReadCal_request;
+    tmp_handle->WriteCal = WriteCal_request;
+    tmp_handle->Monitor = Monitor_request;
+    tmp_handle->Adapt = Adapt_request;
+    tmp_handle->Stop = TMP_Stop_request;
+
+    tmp_handle->subscriber_count = 0;
+    tmp_handle->fxn_details.conversion = TMP117_CONV_DEFAULT;
+    tmp_handle->adapt.config.maxStep = TMP_ADAPT_MAX_STEP;
+    tmp_handle->adapt.config.transient = TMP_ADAPT_TRANSIENT;
+    Periodic_register(&tmp_handle->timer, tmp_handle->tmp_name);
+
+    return Active_start(&tmp_handle->active, &TMP_config, tmp_handle, tmp_handle->tmp_name);
 }
 
 
 /*
- * TMP Thread
+ * Runs once in the sensor thread before the first request
  */
-void *TMP_thread(void *tmp_handle)
+void TMP_start(void *tmp_handle)
 {
     TMP_Handle *Tmp_handle = (TMP_Handle*)tmp_handle;
-
-    Semaphore_Params sem_params;
-    Semaphore_Params_init(&sem_params);
-    sem_params.mode = Semaphore_Mode_BINARY; // Not using events
-    Tmp_handle->sem_handle = Semaphore_create(0, &sem_params, NULL);
-
-
     Tmp_handle->i2c_trans.writeBuf = Tmp_handle->fxn_details.txBuffer;
     Tmp_handle->i2c_trans.readBuf = Tmp_handle->fxn_details.rxBuffer;
-
-    while(1){
-        Tmp_handle->tmp_status = TMP_Ready;
-        Semaphore_pend(Tmp_handle->sem_handle, BIOS_WAIT_FOREVER);
-        Tmp_handle->tmp_status = TMP_Busy;
-        //uart_print_string("Running ");
-        //uart_print_string(Tmp_handle->tmp_name);
-        //uart_print_string(" Thread\n");
-        TMP_process_requests(Tmp_handle);
-    }
 }
 
 /*
- * Processes any TMP requests and return once complete
+ * Runs one TMP request step in the sensor thread
+ * Results go to the request's Completion, a failed step fails it
  */
-void TMP_process_requests(TMP_Handle *handle)
+void TMP_dispatch(void *tmp_handle, const Active_Msg *msg)
 {
-    switch(handle->tmp_request) {
+    TMP_Handle *handle = (TMP_Handle*)tmp_handle;
+    Completion unused;      // Result storage for requests posted without a token
+    Completion *done = (msg->done != NULL) ? msg->done : &unused;
+    bool ok = true;
+    LOG2(LOG_TMP_REQUEST, handle->address, msg->sig);
+
+    switch(msg->sig) {
         case TMP_Detect:
-            Detect_process(handle);
-            handle->tmp_request = TMP_None;
+            ok = Detect_process(handle, &done->result.b);
             break;
         case TMP_ReadTemp:
-            ReadTemp_process(handle);
-            handle->tmp_request = TMP_None;
+            ok = ReadTemp_process(handle, &done->result.f32, (uint8_t)msg->arg);
             break;
         case TMP_ReadSN:
-            ReadSN_process(handle);
-            handle->tmp_request = TMP_None;
+            ok = ReadSN_process(handle, &done->result.u32);
             break;
         case TMP_WriteSN:
-            WriteSN_process(handle);
-            handle->tmp_request = TMP_None;
+            ok = WriteSN_process(handle, msg->value.u32);
             break;
         case TMP_ReadID:
-            ReadID_process(handle);
-            handle->tmp_request = TMP_None;
+            ok = ReadID_process(handle, &done->result.u16);
             break;
         case TMP_ReadCal:
-            ReadCal_process(handle);
-            handle->tmp_request = TMP_None;
+            ok = ReadCal_process(handle, &done->result.f32);
             break;
         case TMP_WriteCal:
-            WriteCal_process(handle);
-            handle->tmp_request = TMP_None;
+            ok = WriteCal_process(handle, msg->value.f32);
+            break;
+        case TMP_Monitor:
+            Monitor_process(handle, msg->arg);
+            break;
+        case TMP_Adapt:
+            Adapt_process(handle, msg->arg, (uint16_t)msg->value.u32);
+            break;
+        case TMP_ReadTempNext:
+            Periodic_record(&handle->timer);
+            ok = ReadTemp_step(handle, &done->result.f32, (uint8_t)msg->arg);
+            break;
+        case TMP_MonitorNext:
+            Periodic_record(&handle->timer);
+            Monitor_step(handle);
+            break;
+        case TMP_WriteSNNext:
+            ok = WriteSN_step(handle, msg->value.u32, (uint8_t)msg->arg, &done->result.u32);
+            break;
+        case TMP_WriteCalNext:
+            ok = WriteCal_step(handle, msg->value.f32, (uint8_t)msg->arg, &done->result.f32);
+            break;
+        case TMP_AdaptNext:
+            Periodic_record(&handle->timer);
+            Adapt_step(handle);
             break;
         default:
-            handle->tmp_request = TMP_None;
             break;
     }
+    if(!ok){
+        Completion_finish(msg->done, COMPLETION_Failed);
+    }
+}
+
+/*
+ * True if msg may run between the steps of the suspended request
+ * Only single step reads, a ReadTemp would reset the average of a
+ * suspended ReadTemp
+ */
+bool TMP_interleave(void *tmp_handle, const Active_Msg *suspended, const Active_Msg *msg)
+{
+    (void)tmp_handle;
+    switch(msg->sig) {
+        case TMP_Detect:
+        case TMP_ReadID:
+            return true;
+        case TMP_ReadTemp:
+            return msg->arg <= 1 && suspended->sig != TMP_ReadTempNext;
+        default:
+            return false;
+    }
 }
 
 /*
@@ -167,40 +200,41 @@ void TMP_process_requests(TMP_Handle *handle)
  */
 static void i2cErrorHandler(I2C_Transaction *transaction)
 {
+    uint8_t slave = transaction->slaveAddress;
     switch (transaction->status)
     {
         case I2C_STATUS_TIMEOUT:
-            uart_print_string("I2C transaction timed out!\n");
+            LOG1(LOG_I2C_TIMEOUT, slave);
             break;
         case I2C_STATUS_CLOCK_TIMEOUT:
-            uart_print_string("I2C serial clock line timed out!\n");
+            LOG1(LOG_I2C_CLOCK_TIMEOUT, slave);
             break;
         case I2C_STATUS_ADDR_NACK:
-            uart_print_string("I2C slave address not acknowledged!\n");
+            LOG1(LOG_I2C_ADDR_NACK, slave);
             break;
         case I2C_STATUS_DATA_NACK:
-            uart_print_string("I2C data byte not acknowledged!\n");
+            LOG1(LOG_I2C_DATA_NACK, slave);
             break;
         case I2C_STATUS_ARB_LOST:
-            uart_print_string("I2C arbitration to another master!\n");
+            LOG1(LOG_I2C_ARB_LOST, slave);
             break;
         case I2C_STATUS_INCOMPLETE:
-            uart_print_string("I2C transaction returned before completion!\n");
+            LOG1(LOG_I2C_INCOMPLETE, slave);
             break;
         case I2C_STATUS_BUS_BUSY:
-            uart_print_string("I2C bus is already in use!\n");
+            LOG1(LOG_I2C_BUS_BUSY, slave);
             break;
         case I2C_STATUS_CANCEL:
-            uart_print_string("I2C transaction cancelled!\n");
+            LOG1(LOG_I2C_CANCEL, slave);
             break;
         case I2C_STATUS_INVALID_TRANS:
-            uart_print_string("I2C transaction invalid!\n");
+            LOG1(LOG_I2C_INVALID, slave);
             break;
         case I2C_STATUS_ERROR:
-            uart_print_string("I2C generic error!\n");
+            LOG1(LOG_I2C_ERROR, slave);
             break;
         default:
-            uart_print_string("I2C undefined error case!\n");
+            LOG2(LOG_I2C_UNDEFINED, transaction->status, slave);
             break;
     }
 }
@@ -209,37 +243,33 @@ static void i2cErrorHandler(I2C_Transaction *transaction)
 /*
  * Detect TMP117 request
  */
-void Detect_request(TMP_Handle *tmp_handle, bool *detect)
+void Detect_request(TMP_Handle *tmp_handle, Completion *done)
 {
-    uint8_t n = 0;
-    while(tmp_handle->tmp_status == TMP_Busy && n<10){
-        usleep(1000); // Wait 1ms
-    } // Wait up to 10ms
-    if(tmp_handle->tmp_status == TMP_Ready){
-        tmp_handle->tmp_request = TMP_Detect;
-        tmp_handle->fxn_details.detect = detect;
-        Semaphore_post(tmp_handle->sem_handle);
-    }
+    Active_Msg msg = {.sig = TMP_Detect, .priority = ACTIVE_PRIORITY_HIGH,
+                      .deadline_us = TMP_READ_DEADLINE_US, .done = done};
+    Active_post(&tmp_handle->active, &msg);
 }
 
 
 /*
  * Detect TMP117 process
+ * Not finding the sensor is a result, not a failure
  */
-void Detect_process(TMP_Handle *tmp_handle)
+bool Detect_process(TMP_Handle *tmp_handle, bool *detect)
 {
     tmp_handle->i2c_trans.slaveAddress = tmp_handle->address;
     tmp_handle->i2c_trans.readCount = 0;
     tmp_handle->i2c_trans.writeCount = 1;
     tmp_handle->fxn_details.txBuffer[0] = sensor.resultReg;
     if(I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
-        uart_print_string("Detected TMP sensor with slave\n");
-        *(tmp_handle->fxn_details.detect) = true;
+        LOG1(LOG_TMP_DETECTED, tmp_handle->address);
+        *detect = true;
     }
     else{
         i2cErrorHandler(&tmp_handle->i2c_trans);
-        *(tmp_handle->fxn_details.detect) = false;
+        *detect = false;
     }
+    return true;
 }
 
 /*
@@ -253,7 +283,7 @@ bool Detect_internal(TMP_Handle *tmp_handle)
     tmp_handle->fxn_details.txBuffer[0] = sensor.resultReg;
 
     if(I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
-        uart_print_string("Detected TMP sensor with slave\n");
+        LOG1(LOG_TMP_DETECTED, tmp_handle->address);
         return true;
     }
     else{
@@ -266,93 +296,364 @@ bool Detect_internal(TMP_Handle *tmp_handle)
 /*
  * Read temperature request
  */
-void ReadTemp_request(TMP_Handle *tmp_handle, float *avgTemp, uint8_t count)
+void ReadTemp_request(TMP_Handle *tmp_handle, uint8_t count, Completion *done)
 {
-    uint8_t n = 0;
-    while(tmp_handle->tmp_status == TMP_Busy && n<10){
-        usleep(1000); // Wait 1ms
-    } // Wait up to 10ms
-    if(tmp_handle->tmp_status == TMP_Ready){
-        tmp_handle->tmp_request = TMP_ReadTemp;
-        tmp_handle->fxn_details.count = count;
-        tmp_handle->fxn_details.avgTemp = avgTemp;
-        Semaphore_post(tmp_handle->sem_handle);
-    }
+    uint32_t samples = count ? count - 1 : 0;
+    Active_Msg msg = {.sig = TMP_ReadTemp, .arg = count, .priority = ACTIVE_PRIORITY_HIGH,
+                      .deadline_us = samples*1000000 + TMP_READ_DEADLINE_US, .done = done}; // 1s apart
+    Active_post(&tmp_handle->active, &msg);
 }
 
 /*
  * Read temperature process
  */
-void ReadTemp_process(TMP_Handle *tmp_handle)
+bool ReadTemp_process(TMP_Handle *tmp_handle, float *avgTemp, uint8_t count)
 {
-    tmp_handle->i2c_trans.slaveAddress = tmp_handle->address;\
-    tmp_handle->i2c_trans.readCount = 2;
-    tmp_handle->i2c_trans.writeCount = 1;
-    tmp_handle->fxn_details.txBuffer[0] = sensor.resultReg;
-
-    int16_t temperature;
-    float temp;
-    float avg_temp;
-    int count_request = tmp_handle->fxn_details.count;
-    int sample = 0;
-    while(tmp_handle->fxn_details.count){
-        tmp_handle->fxn_details.count--;
-        if (I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
-            /*
-             * Extract degrees C from the received data;
-             * see TMP sensor datasheet
-             */
-            temperature = (tmp_handle->fxn_details.rxBuffer[0] << 8) | \
-                    (tmp_handle->fxn_details.rxBuffer[1]);
-            temp = temperature;
-            temp *= 0.0078125;
+    tmp_handle->fxn_details.samples = 0;
+    if(count > 1){ // A single read leaves the timer to a suspended Monitor or Adapt
+        Periodic_start(&tmp_handle->timer, 1000000, PERIODIC_SKIP); // 1s
+        Conversion_internal(tmp_handle, 1000000);
+    }
+    return ReadTemp_step(tmp_handle, avgTemp, count);
+}
 
+/*
+ * Takes one of the remaining samples and schedules the next one a period later
+ *      Returns false if the last sample failed
+ */
+bool ReadTemp_step(TMP_Handle *tmp_handle, float *avgTemp, uint8_t count)
+{
+    TMP_Sample sample;
+    TMP_Misc *details = &tmp_handle->fxn_details;
+    bool ok = true;
+    if(count && !Active_cancelled(&tmp_handle->active)){
+        count--;
+        ok = ReadTemp_internal(tmp_handle, &sample);
+        if (ok){
             uart_print_string("Value: ");
-            uart_print_float(temp);
+            uart_print_fixed(sample.raw, 7, 3);
             uart_print_string("\n");
-            if(sample == 0){avg_temp = temp;}
+            if(details->samples == 0){details->avgTemp = sample.temp;}
             else{
-                avg_temp = (avg_temp*sample + temp)/(sample+1);
+                details->avgTemp = (details->avgTemp*details->samples + sample.temp)/(details->samples+1);
             }
-            *(tmp_handle->fxn_details.avgTemp) = avg_temp;
+            *avgTemp = details->avgTemp;
         }
         else{
-            i2cErrorHandler(&tmp_handle->i2c_trans);
-            *(tmp_handle->fxn_details.avgTemp) = -296;
-            //return 0;
+            *avgTemp = -296;
+        }
+        details->samples++;
+        if(count){
+            Active_Msg next = {.sig = TMP_ReadTempNext, .arg = count};
+            Periodic_next(&tmp_handle->timer);
+            Active_schedule(&tmp_handle->active, &next, tmp_handle->timer.deadline_us);
+            return true;
         }
-        sample++;
-        /* Sleep for 1s */
-        sleep(1);
     }
-    if(count_request > 1){
+    if(details->samples > 1){
         uart_print_string("Average Value: ");
-        uart_print_float(avg_temp);
+        uart_print_float(details->avgTemp);
         uart_print_string("\n");
     }
-    //return avg_temp;
+    return ok;
 }
 
 /*
- * Read ID request
+ * Read temperature for internal use
+ * Publishes the sample to every subscriber
+ *      Returns true on success
  */
-void ReadID_request(TMP_Handle *tmp_handle, uint16_t *id)
+bool ReadTemp_internal(TMP_Handle *tmp_handle, TMP_Sample *sample)
 {
+    tmp_handle->i2c_trans.slaveAddress = tmp_handle->address;
+    tmp_handle->i2c_trans.readCount = 2;
+    tmp_handle->i2c_trans.writeCount = 1;
+    tmp_handle->fxn_details.txBuffer[0] = sensor.resultReg;
+
+    uint64_t start = clock_us();
+    if (!I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
+        i2cErrorHandler(&tmp_handle->i2c_trans);
+        return false;
+    }
+    sample->timestamp_us = clock_us();
+    tmp_handle->fxn_details.read_us = (uint32_t)(sample->timestamp_us - start);
+    /*
+     * Extract degrees C from the received data;
+     * see TMP sensor datasheet
+     */
+    sample->raw = (int16_t)((tmp_handle->fxn_details.rxBuffer[0] << 8) | \
+            (tmp_handle->fxn_details.rxBuffer[1]));
+    sample->temp = sample->raw * 0.0078125f;
+    LOG2(LOG_TMP_SAMPLE, tmp_handle->address, sample->raw);
+
+    Publish_internal(tmp_handle, sample);
+    return true;
+}
+
+/*
+ * Passes a sample to every subscriber
+ * Each function is loaded with acquire, so its argument was written
+ * before TMP_Subscribe published it, freed slots are skipped
+ */
+void Publish_internal(TMP_Handle *tmp_handle, const TMP_Sample *sample)
+{
+    uint8_t count = __atomic_load_n(&tmp_handle->subscriber_count, __ATOMIC_ACQUIRE);
     uint8_t n = 0;
-    while(tmp_handle->tmp_status == TMP_Busy && n<10){
+    for(; n<count; n++){
+        TMP_SampleFxn fxn = __atomic_load_n(&tmp_handle->subscribers[n].fxn, __ATOMIC_ACQUIRE);
+        if(fxn != NULL){
+            fxn(tmp_handle, sample, tmp_handle->subscribers[n].arg);
+        }
+    }
+}
+
+/*
+ * Register access with a private transaction, the handle's own
+ * i2c_trans and buffers are left to its thread
+ *      Returns true on success
+ */
+bool ReadReg_internal(TMP_Handle *tmp_handle, uint8_t reg, uint16_t *value)
+{
+    I2C_Transaction transaction;
+    uint8_t rxBuffer[2];
+
+    memset(&transaction, 0, sizeof(I2C_Transaction));
+    transaction.slaveAddress = tmp_handle->address;
+    transaction.writeBuf = &reg;
+    transaction.writeCount = 1;
+    transaction.readBuf = rxBuffer;
+    transaction.readCount = 2;
+    if(!I2C_transfer(tmp_handle->i2c_handle, &transaction)){
+        return false;
+    }
+    *value = (uint16_t)((rxBuffer[0] << 8) | rxBuffer[1]);
+    return true;
+}
+
+bool WriteReg_internal(TMP_Handle *tmp_handle, uint8_t reg, uint16_t value)
+{
+    I2C_Transaction transaction;
+    uint8_t txBuffer[3] = {reg, (uint8_t)(value >> 8), (uint8_t)value};
+
+    memset(&transaction, 0, sizeof(I2C_Transaction));
+    transaction.slaveAddress = tmp_handle->address;
+    transaction.writeBuf = txBuffer;
+    transaction.writeCount = 3;
+    transaction.readBuf = NULL;
+    transaction.readCount = 0;
+    return I2C_transfer(tmp_handle->i2c_handle, &transaction);
+}
+
+/*
+ * Monitor request
+ * Samples every period_ms until Stop, results go to subscribers only
+ * The Completion finishes as cancelled by Stop
+ */
+void Monitor_request(TMP_Handle *tmp_handle, uint16_t period_ms, Completion *done)
+{
+    Active_Msg msg = {.sig = TMP_Monitor, .arg = period_ms, .done = done};
+    Active_post(&tmp_handle->active, &msg);
+}
+
+/*
+ * Monitor process
+ */
+void Monitor_process(TMP_Handle *tmp_handle, uint16_t period_ms)
+{
+    Periodic_start(&tmp_handle->timer, (uint32_t)period_ms*1000, PERIODIC_SKIP);
+    Conversion_internal(tmp_handle, (uint32_t)period_ms*1000);
+    Monitor_step(tmp_handle);
+}
+
+/*
+ * Takes one sample and schedules the next one until Stop
+ */
+void Monitor_step(TMP_Handle *tmp_handle)
+{
+    TMP_Sample sample;
+    if(Active_cancelled(&tmp_handle->active)){
+        return;
+    }
+    ReadTemp_internal(tmp_handle, &sample);
+
+    Active_Msg next = {.sig = TMP_MonitorNext};
+    Periodic_next(&tmp_handle->timer);
+    Active_schedule(&tmp_handle->active, &next, tmp_handle->timer.deadline_us);
+}
+
+/*
+ * Adapt request
+ * Samples like Monitor with a period between min_ms and max_ms that follows
+ * the temperature (see adaptive.h), the conversion cycle follows the period
+ * The Completion finishes as cancelled by Stop
+ */
+void Adapt_request(TMP_Handle *tmp_handle, uint16_t min_ms, uint16_t max_ms, Completion *done)
+{
+    Active_Msg msg = {.sig = TMP_Adapt, .arg = min_ms, .value.u32 = max_ms, .done = done};
+    Active_post(&tmp_handle->active, &msg);
+}
+
+/*
+ * Adapt process
+ */
+void Adapt_process(TMP_Handle *tmp_handle, uint16_t min_ms, uint16_t max_ms)
+{
+    Adaptive_Rate *rate = &tmp_handle->adapt;
+    if(min_ms < TMP_ADAPT_MIN_MS){
+        min_ms = TMP_ADAPT_MIN_MS;
+    }
+    if(max_ms < min_ms){
+        max_ms = min_ms;
+    }
+    rate->config.minPeriod_us = (uint32_t)min_ms*1000;
+    rate->config.maxPeriod_us = (uint32_t)max_ms*1000;
+    Adaptive_start(rate);
+
+    Periodic_start(&tmp_handle->timer, rate->period_us, PERIODIC_SKIP);
+    Conversion_internal(tmp_handle, rate->period_us);
+    Adapt_step(tmp_handle);
+}
+
+/*
+ * Takes one sample, sets the next period from it and schedules the next
+ * sample until Stop
+ */
+void Adapt_step(TMP_Handle *tmp_handle)
+{
+    TMP_Sample sample;
+    if(Active_cancelled(&tmp_handle->active)){
+        return;
+    }
+    if(ReadTemp_internal(tmp_handle, &sample)){
+        tmp_handle->adapt.stats.busTime_us += tmp_handle->fxn_details.read_us;
+        uint32_t period = Adaptive_update(&tmp_handle->adapt, sample.temp, sample.timestamp_us);
+        if(period != tmp_handle->timer.period_us){
+            tmp_handle->timer.period_us = period;
+            Conversion_internal(tmp_handle, period);
+        }
+    }
+
+    Active_Msg next = {.sig = TMP_AdaptNext};
+    Periodic_next(&tmp_handle->timer);
+    Active_schedule(&tmp_handle->active, &next, tmp_handle->timer.deadline_us);
+}
+
+/*
+ * Sets the longest conversion cycle that still gives a new result every
+ * period, so a slow period lets the sensor stand by between conversions
+ * Writes the configuration register only when the cycle changes
+ *      Returns false if the write failed
+ */
+bool Conversion_internal(TMP_Handle *tmp_handle, uint32_t period_us)
+{
+    uint8_t conversion = (period_us >= 16000000) ? 7 :  // 16s
+                         (period_us >= 8000000) ? 6 :   // 8s
+                         (period_us >= 4000000) ? 5 :   // 4s
+                         (period_us >= 1000000) ? 4 :   // 1s
+                         (period_us >= 500000) ? 3 :    // 500ms
+                         (period_us >= 250000) ? 2 : 0; // 250ms, 125ms
+    if(conversion == tmp_handle->fxn_details.conversion){
+        return true;
+    }
+    uint16_t config = (uint16_t)((conversion << TMP117_CONV_SHIFT) | TMP117_AVG_8);
+    tmp_handle->i2c_trans.slaveAddress = tmp_handle->address;
+    tmp_handle->i2c_trans.readCount = 0;
+    tmp_handle->i2c_trans.writeCount = 3;
+    tmp_handle->fxn_details.txBuffer[0] = TMP117_CONFIG_REG;
+    tmp_handle->fxn_details.txBuffer[1] = (uint8_t)(config >> 8);
+    tmp_handle->fxn_details.txBuffer[2] = (uint8_t)(config);
+    if(!I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
+        i2cErrorHandler(&tmp_handle->i2c_trans);
+        return false;
+    }
+    tmp_handle->fxn_details.conversion = conversion;
+    return true;
+}
+
+/*
+ * Registers a function called from the TMP thread on every new sample
+ * Subscribers must not block, they run in the sensor thread
+ * The entry is written before its function is published with release, so
+ * the sensor thread may be sampling meanwhile. A slot left by an earlier
+ * subscriber is reused. Thread context, one thread subscribing or
+ * unsubscribing at a time
+ *      Returns false if the subscriber table is full
+ */
+bool TMP_Subscribe(TMP_Handle *tmp_handle, TMP_SampleFxn fxn, void *arg)
+{
+    uint8_t count = tmp_handle->subscriber_count;
+    uint8_t n = 0;
+    for(; n<count; n++){
+        if(__atomic_load_n(&tmp_handle->subscribers[n].fxn, __ATOMIC_RELAXED) == NULL){
+            break;
+        }
+    }
+    if(n >= TMP_MAX_SUBSCRIBERS){
+        return false;
+    }
+    tmp_handle->subscribers[n].arg = arg;
+    __atomic_store_n(&tmp_handle->subscribers[n].fxn, fxn, __ATOMIC_RELEASE);
+    if(n == count){
+        __atomic_store_n(&tmp_handle->subscriber_count, count + 1, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+/*
+ * Removes a subscriber registered with the same function and argument
+ * The sensor is claimed while the table changes, so the function is not
+ * running in any thread when this returns. Thread context only, a
+ * subscriber removes itself with Unsubscribe_internal
+ *      Returns false if not found or the sensor stayed busy for TMP_UNSUBSCRIBE_MS
+ */
+bool TMP_Unsubscribe(TMP_Handle *tmp_handle, TMP_SampleFxn fxn, void *arg)
+{
+    bool found;
+    uint8_t n = 0;
+    while(!Active_claim(&tmp_handle->active)){
+        if(n++ >= TMP_UNSUBSCRIBE_MS){
+            return false;
+        }
         usleep(1000); // Wait 1ms
-    } // Wait up to 10ms
-    if(tmp_handle->tmp_status == TMP_Ready){
-        tmp_handle->tmp_request = TMP_ReadID;
-        tmp_handle->fxn_details.readID = id;
-        Semaphore_post(tmp_handle->sem_handle);
     }
+    found = Unsubscribe_internal(tmp_handle, fxn, arg);
+    Active_release(&tmp_handle->active);
+    return found;
+}
+
+/*
+ * Frees the slot of a subscriber, the sensor thread skips it from the
+ * next sample on. Called from inside a subscriber, or with the sensor held
+ *      Returns false if not found
+ */
+bool Unsubscribe_internal(TMP_Handle *tmp_handle, TMP_SampleFxn fxn, void *arg)
+{
+    uint8_t count = __atomic_load_n(&tmp_handle->subscriber_count, __ATOMIC_ACQUIRE);
+    uint8_t n = 0;
+    for(; n<count; n++){
+        if(__atomic_load_n(&tmp_handle->subscribers[n].fxn, __ATOMIC_RELAXED) == fxn &&
+           tmp_handle->subscribers[n].arg == arg){
+            __atomic_store_n(&tmp_handle->subscribers[n].fxn, NULL, __ATOMIC_RELEASE);
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Read ID request
+ */
+void ReadID_request(TMP_Handle *tmp_handle, Completion *done)
+{
+    Active_Msg msg = {.sig = TMP_ReadID, .priority = ACTIVE_PRIORITY_HIGH,
+                      .deadline_us = TMP_READ_DEADLINE_US, .done = done};
+    Active_post(&tmp_handle->active, &msg);
 }
 
 /*
  * Read EUI
  */
-void ReadID_process(TMP_Handle *tmp_handle)
+bool ReadID_process(TMP_Handle *tmp_handle, uint16_t *readID)
 {
     tmp_handle->i2c_trans.slaveAddress = tmp_handle->address;
     tmp_handle->i2c_trans.readCount = 2;
@@ -363,42 +664,37 @@ void ReadID_process(TMP_Handle *tmp_handle)
     if (I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
         id = ((tmp_handle->fxn_details.rxBuffer[0] & 0x0F) << 8) | \
                 (tmp_handle->fxn_details.rxBuffer[1]);
-        *(tmp_handle->fxn_details.readID) = id;
+        *readID = id;
     }
     else{
         i2cErrorHandler(&tmp_handle->i2c_trans);
-        return;
+        return false;
     }
     uart_print_uint32((uint32_t)id);
     uart_print_string("\n");
+    return true;
 }
 
 
 /*
  * Read Calibration Request
  */
-void ReadCal_request(TMP_Handle *tmp_handle, float *offset)
+void ReadCal_request(TMP_Handle *tmp_handle, Completion *done)
 {
-    uint8_t n = 0;
-    while(tmp_handle->tmp_status == TMP_Busy && n<10){
-        usleep(1000); // Wait 1ms
-    } // Wait up to 10ms
-    if(tmp_handle->tmp_status == TMP_Ready){
-        tmp_handle->tmp_request = TMP_ReadCal;
-        tmp_handle->fxn_details.readOffset = offset;
-        Semaphore_post(tmp_handle->sem_handle);
-    }
+    Active_Msg msg = {.sig = TMP_ReadCal, .done = done};
+    Active_post(&tmp_handle->active, &msg);
 }
 
 
 /*
  * Read Calibration Offset
  */
-void ReadCal_process(TMP_Handle *tmp_handle)
+bool ReadCal_process(TMP_Handle *tmp_handle, float *readOffset)
 {
-    if(LockMemory_internal(tmp_handle)){
-        uart_print_string("!Error: Cannot lock EEPROM!\n");
-        return; //error
+    uint8_t lock = LockMemory_internal(tmp_handle);
+    if(lock){
+        LOG2(LOG_TMP_LOCK_FAILED, tmp_handle->address, lock);
+        return false; //error
     }
 
     int16_t tempOffset = 0;
@@ -413,15 +709,17 @@ void ReadCal_process(TMP_Handle *tmp_handle)
                 (tmp_handle->fxn_details.rxBuffer[1]);
         offset = (float)tempOffset;
         offset /= 128;
-        *(tmp_handle->fxn_details.readOffset) = offset;
+        *readOffset = offset;
     }
     else{
         i2cErrorHandler(&tmp_handle->i2c_trans);
+        return false;
     }
 
     uart_print_string("Stored Offset: ");
-    uart_print_float(offset);
+    uart_print_fixed(tempOffset, 7, 3);
     uart_print_string("\n");
+    return true;
 }
 
 
@@ -430,8 +728,9 @@ void ReadCal_process(TMP_Handle *tmp_handle)
  */
 float ReadCal_internal(TMP_Handle *tmp_handle)
 {
-    if(LockMemory_internal(tmp_handle)){
-        uart_print_string("!Error: Cannot lock EEPROM!\n");
+    uint8_t lock = LockMemory_internal(tmp_handle);
+    if(lock){
+        LOG2(LOG_TMP_LOCK_FAILED, tmp_handle->address, lock);
         return -296; //error
     }
 
@@ -454,7 +753,7 @@ float ReadCal_internal(TMP_Handle *tmp_handle)
     }
 
     uart_print_string("Stored Offset: ");
-    uart_print_float(offset);
+    uart_print_fixed(tempOffset, 7, 3);
     uart_print_string("\n");
     return offset;
 }
@@ -462,71 +761,96 @@ float ReadCal_internal(TMP_Handle *tmp_handle)
 /*
  * Write calibration offset request
  */
-void WriteCal_request(TMP_Handle *tmp_handle, float offset)
+void WriteCal_request(TMP_Handle *tmp_handle, float offset, Completion *done)
 {
-    uint8_t n = 0;
-    while(tmp_handle->tmp_status == TMP_Busy && n<10){
-        usleep(1000); // Wait 1ms
-    } // Wait up to 10ms
-    if(tmp_handle->tmp_status == TMP_Ready){
-        tmp_handle->tmp_request = TMP_WriteCal;
-        tmp_handle->fxn_details.writeOffset = offset;
-        Semaphore_post(tmp_handle->sem_handle);
-    }
+    Active_Msg msg = {.sig = TMP_WriteCal, .value.f32 = offset, .done = done};
+    Active_post(&tmp_handle->active, &msg);
 }
 
 
 /*
  * Write Calibration Offset process
  */
-void WriteCal_process(TMP_Handle *tmp_handle)
+bool WriteCal_process(TMP_Handle *tmp_handle, float writeOffset)
 {
-    if(LockMemory_internal(tmp_handle)){
-        uart_print_string("!Error: Cannot lock EEPROM!\n");
-        return; //error
+    tmp_handle->fxn_details.eeprom_us = clock_us() + TMP_EEPROM_TIMEOUT_US;
+    return WriteCal_step(tmp_handle, writeOffset, TMP_EEPROM_Write1, NULL);
+}
+
+/*
+ * One stage of the calibration offset write
+ *      Write1 waits for the EEPROM to lock, then writes the offset
+ *      Verify reads it back 10ms later
+ * Waiting stages poll again from a continuation so reads can interleave
+ *      Returns false if the stage failed or timed out
+ */
+bool WriteCal_step(TMP_Handle *tmp_handle, float writeOffset, uint8_t stage, float *readOffset)
+{
+    Active_Msg next = {.sig = TMP_WriteCalNext, .arg = stage, .value.f32 = writeOffset};
+    if(Active_cancelled(&tmp_handle->active)){
+        return true;
+    }
+    if(stage == TMP_EEPROM_Verify){
+        return WriteCal_verify(tmp_handle, writeOffset, readOffset);
+    }
+
+    uint8_t lock = Eeprom_poll_internal(tmp_handle, false);
+    if(lock & TMP_EEPROM_I2C){
+        LOG2(LOG_TMP_LOCK_FAILED, tmp_handle->address, lock);
+        return false; //error
+    }
+    if(lock){
+        if(Eeprom_retry_internal(tmp_handle, &next)){
+            return true;
+        }
+        LOG1(LOG_TMP_LOCK_TIMEOUT, tmp_handle->address);
+        return false;
     }
     tmp_handle->i2c_trans.slaveAddress = tmp_handle->address;
     tmp_handle->i2c_trans.readCount = 0;
     tmp_handle->i2c_trans.writeCount = 3;
     tmp_handle->fxn_details.txBuffer[0] = sensor.TempOffsetReg;
 
-    int16_t tempOffset = (int16_t)(128*(tmp_handle->fxn_details.writeOffset));
+    int16_t tempOffset = (int16_t)(128*writeOffset);
 
     tmp_handle->fxn_details.txBuffer[1] = (uint8_t)(tempOffset >> 8);
     tmp_handle->fxn_details.txBuffer[2] = (uint8_t)(tempOffset & 0xFF);
 
     if (I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
-        usleep(10000); //Wait 10ms
-        float read_offset = ReadCal_internal(tmp_handle);
-        if(read_offset == tmp_handle->fxn_details.writeOffset){
-            uart_print_string("...Successfully applied offset: ");
-            uart_print_float(read_offset);
-            uart_print_string("\n");
-        }
-        else{
-            uart_print_string("!Error: Calibration offset verification failed");
-        }
+        next.arg = TMP_EEPROM_Verify;
+        Active_schedule(&tmp_handle->active, &next, clock_us() + 10000); // Read back in 10ms
+        return true;
     }
-    else{
-        i2cErrorHandler(&tmp_handle->i2c_trans);
+    i2cErrorHandler(&tmp_handle->i2c_trans);
+    return false;
+}
+
+/*
+ * Reads back the calibration offset once the EEPROM write is done
+ *      Returns false if it does not match
+ */
+bool WriteCal_verify(TMP_Handle *tmp_handle, float writeOffset, float *readOffset)
+{
+    float read_offset = ReadCal_internal(tmp_handle);
+    *readOffset = read_offset;
+    if(read_offset == writeOffset){
+        uart_print_string("...Successfully applied offset: ");
+        uart_print_float(read_offset);
+        uart_print_string("\n");
+        return true;
     }
+    LOG1(LOG_TMP_CAL_VERIFY, tmp_handle->address);
+    return false;
 }
 
 
 /*
  * Read serial number request
  */
-void ReadSN_request(TMP_Handle *tmp_handle, uint32_t *serialNo)
+void ReadSN_request(TMP_Handle *tmp_handle, Completion *done)
 {
-    uint8_t n = 0;
-    while(tmp_handle->tmp_status == TMP_Busy && n<10){
-        usleep(1000); // Wait 1ms
-    } // Wait up to 10ms
-    if(tmp_handle->tmp_status == TMP_Ready){
-        tmp_handle->tmp_request = TMP_ReadSN;
-        tmp_handle->fxn_details.readSerialNo = serialNo;
-        Semaphore_post(tmp_handle->sem_handle);
-    }
+    Active_Msg msg = {.sig = TMP_ReadSN, .done = done};
+    Active_post(&tmp_handle->active, &msg);
 }
 
 /*
@@ -534,12 +858,13 @@ void ReadSN_request(TMP_Handle *tmp_handle, uint32_t *serialNo)
  *      Read Mem1 Greatest Byte and next byte
  *      Read Mem2 Lower byte
  */
-void ReadSN_process(TMP_Handle *tmp_handle)
+bool ReadSN_process(TMP_Handle *tmp_handle, uint32_t *readSerialNo)
 {
     uint32_t serialNo = 0;
-    if(LockMemory_internal(tmp_handle)){
-        uart_print_string("!Error: Cannot lock EEPROM!\n");
-        return; //error
+    uint8_t lock = LockMemory_internal(tmp_handle);
+    if(lock){
+        LOG2(LOG_TMP_LOCK_FAILED, tmp_handle->address, lock);
+        return false; //error
     }
 
     // Read MSB and MSB-1 from Memory 1 Register
@@ -554,12 +879,13 @@ void ReadSN_process(TMP_Handle *tmp_handle)
     }
     else{
         i2cErrorHandler(&tmp_handle->i2c_trans);
-        return;
+        return false;
     }
 
-    if(LockMemory_internal(tmp_handle)){
-        uart_print_string("!Error: Cannot lock EEPROM!\n");
-        return; //error
+    lock = LockMemory_internal(tmp_handle);
+    if(lock){
+        LOG2(LOG_TMP_LOCK_FAILED, tmp_handle->address, lock);
+        return false; //error
     }
 
     // Read MSB-2 and LSB from Memory 2 Register
@@ -570,16 +896,17 @@ void ReadSN_process(TMP_Handle *tmp_handle)
     if (I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
         serialNo |= (tmp_handle->fxn_details.rxBuffer[0] << 8) | \
                 (tmp_handle->fxn_details.rxBuffer[1] << 0);
-        *(tmp_handle->fxn_details.readSerialNo) = serialNo;
+        *readSerialNo = serialNo;
     }
     else{
         i2cErrorHandler(&tmp_handle->i2c_trans);
-        return;
+        return false;
     }
 
     uart_print_string("Serial Number: SDS7-");
     uart_print_uint32(serialNo);
     uart_print_string("\n");
+    return true;
 }
 
 
@@ -589,8 +916,9 @@ void ReadSN_process(TMP_Handle *tmp_handle)
 uint32_t ReadSN_internal(TMP_Handle *tmp_handle)
 {
     uint32_t serialNo = 0;
-    if(LockMemory_internal(tmp_handle)){
-        uart_print_string("!Error: Cannot lock EEPROM!\n");
+    uint8_t lock = LockMemory_internal(tmp_handle);
+    if(lock){
+        LOG2(LOG_TMP_LOCK_FAILED, tmp_handle->address, lock);
         return 0; //error
     }
 
@@ -609,8 +937,9 @@ uint32_t ReadSN_internal(TMP_Handle *tmp_handle)
         return 0;
     }
 
-    if(LockMemory_internal(tmp_handle)){
-        uart_print_string("!Error: Cannot lock EEPROM!\n");
+    lock = LockMemory_internal(tmp_handle);
+    if(lock){
+        LOG2(LOG_TMP_LOCK_FAILED, tmp_handle->address, lock);
         return 0; //error
     }
 
@@ -635,17 +964,10 @@ uint32_t ReadSN_internal(TMP_Handle *tmp_handle)
 /*
  * Write serial number request
  */
-void WriteSN_request(TMP_Handle *tmp_handle, uint32_t serialNo)
+void WriteSN_request(TMP_Handle *tmp_handle, uint32_t serialNo, Completion *done)
 {
-    uint8_t n = 0;
-    while(tmp_handle->tmp_status == TMP_Busy && n<10){
-        usleep(1000); // Wait 1ms
-    } // Wait up to 10ms
-    if(tmp_handle->tmp_status == TMP_Ready){
-        tmp_handle->tmp_request = TMP_WriteSN;
-        tmp_handle->fxn_details.writeSerialNo = serialNo;
-        Semaphore_post(tmp_handle->sem_handle);
-    }
+    Active_Msg msg = {.sig = TMP_WriteSN, .value.u32 = serialNo, .done = done};
+    Active_post(&tmp_handle->active, &msg);
 }
 
 
@@ -655,57 +977,88 @@ void WriteSN_request(TMP_Handle *tmp_handle, uint32_t serialNo)
  *      Read as SDS7-########
  *      Refer to latest Calibration Points Table for SDS7 details
  */
-void WriteSN_process(TMP_Handle *tmp_handle)
+bool WriteSN_process(TMP_Handle *tmp_handle, uint32_t serialNo)
 {
-    uint32_t serialNo = tmp_handle->fxn_details.writeSerialNo;
-    if(UnlockMemory_internal(tmp_handle)){
-        uart_print_string("!Error: Cannot unlock EEPROM!\n");
-        return; //error
-    }
-    tmp_handle->i2c_trans.slaveAddress = tmp_handle->address;
-    tmp_handle->i2c_trans.readCount = 0;
-    tmp_handle->i2c_trans.writeCount = 3;
-
-    tmp_handle->fxn_details.txBuffer[0] = sensor.Mem1Reg;
-    tmp_handle->fxn_details.txBuffer[1] = (uint8_t)(serialNo>>24);
-    tmp_handle->fxn_details.txBuffer[2] = (uint8_t)(serialNo>>16);
+    tmp_handle->fxn_details.eeprom_us = clock_us() + TMP_EEPROM_TIMEOUT_US;
+    return WriteSN_step(tmp_handle, serialNo, TMP_EEPROM_Write1, NULL);
+}
 
-    if(!I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
-        i2cErrorHandler(&tmp_handle->i2c_trans);
-        return;
+/*
+ * One stage of the serial number write
+ *      Write1 waits for the EEPROM to unlock, then writes Mem1
+ *      Write2 waits for that write to program, then writes Mem2
+ *      Verify waits for it, locks the EEPROM and reads back
+ * Waiting stages poll again from a continuation so reads can interleave
+ *      Returns false if the stage failed or timed out
+ */
+bool WriteSN_step(TMP_Handle *tmp_handle, uint32_t serialNo, uint8_t stage, uint32_t *readSerialNo)
+{
+    Active_Msg next = {.sig = TMP_WriteSNNext, .arg = stage, .value.u32 = serialNo};
+    if(Active_cancelled(&tmp_handle->active)){
+        LockMemory_internal(tmp_handle); // Do not leave the EEPROM unlocked
+        return true;
     }
 
-    if(UnlockMemory_internal(tmp_handle)){
-        uart_print_string("!Error: Cannot unlock EEPROM!\n");
-        return; //error
+    bool unlock = (stage != TMP_EEPROM_Verify);
+    uint8_t lock = Eeprom_poll_internal(tmp_handle, unlock);
+    if(lock & TMP_EEPROM_I2C){
+        if(unlock){LOG2(LOG_TMP_UNLOCK_FAILED, tmp_handle->address, lock);}
+        else{LOG2(LOG_TMP_LOCK_FAILED, tmp_handle->address, lock);}
+        return false; //error
+    }
+    if(lock){
+        if(Eeprom_retry_internal(tmp_handle, &next)){
+            return true;
+        }
+        if(unlock){LOG1(LOG_TMP_UNLOCK_TIMEOUT, tmp_handle->address);}
+        else{LOG1(LOG_TMP_LOCK_TIMEOUT, tmp_handle->address);}
+        return false;
+    }
+    if(stage == TMP_EEPROM_Verify){
+        return WriteSN_verify(tmp_handle, serialNo, readSerialNo);
     }
 
+    tmp_handle->i2c_trans.slaveAddress = tmp_handle->address;
     tmp_handle->i2c_trans.readCount = 0;
     tmp_handle->i2c_trans.writeCount = 3;
-    tmp_handle->fxn_details.txBuffer[0] = sensor.Mem2Reg;
-    tmp_handle->fxn_details.txBuffer[1] = (uint8_t)(serialNo>>8);
-    tmp_handle->fxn_details.txBuffer[2] = (uint8_t)(serialNo>>0);
-
-
+    if(stage == TMP_EEPROM_Write1){
+        tmp_handle->fxn_details.txBuffer[0] = sensor.Mem1Reg;
+        tmp_handle->fxn_details.txBuffer[1] = (uint8_t)(serialNo>>24);
+        tmp_handle->fxn_details.txBuffer[2] = (uint8_t)(serialNo>>16);
+    }
+    else{
+        tmp_handle->fxn_details.txBuffer[0] = sensor.Mem2Reg;
+        tmp_handle->fxn_details.txBuffer[1] = (uint8_t)(serialNo>>8);
+        tmp_handle->fxn_details.txBuffer[2] = (uint8_t)(serialNo>>0);
+    }
     if(!I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
         i2cErrorHandler(&tmp_handle->i2c_trans);
-        return;
+        return false;
     }
 
-    usleep(50000); //wait 50ms
+    // The EEPROM is busy programming, poll for the next stage
+    next.arg = stage + 1;
+    tmp_handle->fxn_details.eeprom_us = clock_us() + TMP_EEPROM_TIMEOUT_US;
+    Active_schedule(&tmp_handle->active, &next, clock_us() + TMP_EEPROM_POLL_US);
+    return true;
+}
 
+/*
+ * Reads back the serial number once the EEPROM writes are done
+ *      Returns false if it does not match
+ */
+bool WriteSN_verify(TMP_Handle *tmp_handle, uint32_t serialNo, uint32_t *readSerialNo)
+{
     uint32_t readSN = ReadSN_internal(tmp_handle);
+    *readSerialNo = readSN;
     if(readSN == serialNo){
         uart_print_string("...Successfully set the Serial Number: ");
         uart_print_uint32(readSN);
         uart_print_string("\n");
+        return true;
     }
-    else{
-        uart_print_string("!Error: Verification failed\n");
-        return;
-    }
-
-    return;
+    LOG2(LOG_TMP_SN_VERIFY, tmp_handle->address, readSN);
+    return false;
 }
 
 /*
@@ -713,114 +1066,111 @@ void WriteSN_process(TMP_Handle *tmp_handle)
  */
 void TMP_Stop_request(TMP_Handle *tmp_handle)
 {
-    uint8_t n = 0;
-    if(tmp_handle->tmp_status == TMP_Ready){
-        return;
-    }
-    else if(tmp_handle->tmp_status == TMP_Busy)
-    {
-        tmp_handle->fxn_details.count = 0;
-    }
+    Active_cancel(&tmp_handle->active);
 }
 
 
 /*
  * Unlocks EEPROM
- * Sets the EEPROM to unlock and checks the status
- *      Returns mask 0x01 if busy, 0x02 if locked, 0x04 if I2C error, 0x08 if timeout error
+ * Sets the EEPROM to unlock and waits for it, blocking
+ *      Returns mask TMP_EEPROM_BUSY, _STATE if locked, _I2C or _TIMEOUT
  *      Returns 0x00 if ready and unlocked (success)
  */
 uint8_t UnlockMemory_internal(TMP_Handle *tmp_handle)
 {
-    bool EEPROM_busy = false;
-    bool EEPROM_locked = true; //assume locked
+    uint8_t status;
     int time = 0;
-    do{
-        // Read from Unlock Memory Register
-        tmp_handle->i2c_trans.slaveAddress = tmp_handle->address;
-        tmp_handle->i2c_trans.readCount = 2;
-        tmp_handle->i2c_trans.writeCount = 1;
-        tmp_handle->fxn_details.txBuffer[0] = sensor.MemUnlockReg;
-
-        if(I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
-            EEPROM_busy = tmp_handle->fxn_details.rxBuffer[0]&(1<<6);       //6th bit 1 if busy, 0 if not busy
-            EEPROM_locked = !(tmp_handle->fxn_details.rxBuffer[0]&(1<<7));  //7th bit 1 if unlocked, 0 if locked
-        }
-        else{
-            i2cErrorHandler(&tmp_handle->i2c_trans);
-            return (EEPROM_busy)|(EEPROM_locked<<1)|(1<<3);
-        }
-        if(!EEPROM_busy && !EEPROM_locked){break;} //if already set, break
-        if(!EEPROM_busy){ //If not busy
-            // Write to Unlock Memory Register to unlock
-            tmp_handle->i2c_trans.slaveAddress = tmp_handle->address;
-            tmp_handle->i2c_trans.readCount = 0;
-            tmp_handle->i2c_trans.writeCount = 3;
-            tmp_handle->fxn_details.txBuffer[0] = sensor.MemUnlockReg;
-            tmp_handle->fxn_details.txBuffer[1] = 1<<7;
-            tmp_handle->fxn_details.txBuffer[2] = 0;
-            if(!I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
-                i2cErrorHandler(&tmp_handle->i2c_trans);
-                return (EEPROM_busy)|(EEPROM_locked<<1)|(1<<3); //I2C error
-            }
+    while((status = Eeprom_poll_internal(tmp_handle, true)) != 0){
+        if(status & TMP_EEPROM_I2C){
+            return status;
         }
         time++;
         if(time > 15){
-            uart_print_string("!Error: Timeout during attempt to unlock memory\n");
-            return (EEPROM_busy)|(EEPROM_locked<<1)|(1<<4); //timeout
+            LOG1(LOG_TMP_UNLOCK_TIMEOUT, tmp_handle->address);
+            return status|TMP_EEPROM_TIMEOUT;
         }
         usleep(10000); //10ms
-    }while(EEPROM_busy || EEPROM_locked);
-
-    return (EEPROM_busy)|(EEPROM_locked<<1);
+    }
+    return status;
 }
 
 /*
  * Locks EEPROM
- * Sets the EEPROM to lock and checks the status
- *      Returns mask 0x01 if busy, 0x02 if unlocked, 0x04 if I2C error, 0x08 if timeout error
+ * Sets the EEPROM to lock and waits for it, blocking
+ * Returns at once when already locked and idle, used by the reads
+ *      Returns mask TMP_EEPROM_BUSY, _STATE if unlocked, _I2C or _TIMEOUT
  *      Returns 0x00 if ready and locked (success)
  */
 uint8_t LockMemory_internal(TMP_Handle *tmp_handle)
 {
-    bool EEPROM_busy = false;
-    bool EEPROM_unlocked = true; //assume unlocked
+    uint8_t status;
     int time = 0;
-
-    do{
-        // Read from Unlock Memory Register
-        tmp_handle->i2c_trans.slaveAddress = tmp_handle->address;
-        tmp_handle->i2c_trans.readCount = 2;
-        tmp_handle->i2c_trans.writeCount = 1;
-        tmp_handle->fxn_details.txBuffer[0] = sensor.MemUnlockReg;
-        if(I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
-            EEPROM_busy = (tmp_handle->fxn_details.rxBuffer[0])&(1<<6);       //6th bit 1 if busy, 0 if not busy
-            EEPROM_unlocked = (tmp_handle->fxn_details.rxBuffer[0]&(1<<7)); //7th bit 1 if unlocked, 0 if locked
-        }
-        else{
-            i2cErrorHandler(&tmp_handle->i2c_trans);
-            return (EEPROM_busy)|(EEPROM_unlocked<<1)|(1<<3);
-        }
-        if(!EEPROM_busy && !EEPROM_unlocked){break;} //if already set, break
-        if(!EEPROM_busy){ //If not busy
-            // Write to Unlock Memory Register to unlock
-            tmp_handle->i2c_trans.slaveAddress = tmp_handle->address;
-            tmp_handle->i2c_trans.readCount = 0;
-            tmp_handle->i2c_trans.writeCount = 3;
-            tmp_handle->fxn_details.txBuffer[0] = sensor.MemUnlockReg;
-            tmp_handle->fxn_details.txBuffer[1] = 0;
-            tmp_handle->fxn_details.txBuffer[2] = 0;
-            if(!I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
-                i2cErrorHandler(&tmp_handle->i2c_trans);
-                return (EEPROM_busy)|(EEPROM_unlocked<<1)|(1<<3);
-            }
+    while((status = Eeprom_poll_internal(tmp_handle, false)) != 0){
+        if(status & TMP_EEPROM_I2C){
+            return status;
         }
         time++;
         if(time > 15){
-            uart_print_string("!Error: Timeout during attempt lock memory\n");
-            return (EEPROM_busy)|(EEPROM_unlocked<<1)|(0x08); //timeout
+            LOG1(LOG_TMP_LOCK_TIMEOUT, tmp_handle->address);
+            return status|TMP_EEPROM_TIMEOUT;
         }
         usleep(10000); //10ms
-    }while(EEPROM_busy || EEPROM_unlocked);
-    return (EEPROM_busy)|(EEPROM_unlocked<<1);
+    }
+    return status;
+}
+
+/*
+ * One pass of the EEPROM lock sequence, never waits
+ * Reads the lock register and, when the EEPROM is idle in the other
+ * state, writes the requested one
+ * Input true to unlock, false to lock
+ *      Returns mask TMP_EEPROM_BUSY, _STATE if not yet in the requested state, _I2C
+ *      Returns 0x00 if ready and in the requested state
+ */
+uint8_t Eeprom_poll_internal(TMP_Handle *tmp_handle, bool unlock)
+{
+    bool EEPROM_busy;
+    bool EEPROM_unlocked;
+
+    // Read from Unlock Memory Register
+    tmp_handle->i2c_trans.slaveAddress = tmp_handle->address;
+    tmp_handle->i2c_trans.readCount = 2;
+    tmp_handle->i2c_trans.writeCount = 1;
+    tmp_handle->fxn_details.txBuffer[0] = sensor.MemUnlockReg;
+    if(!I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
+        i2cErrorHandler(&tmp_handle->i2c_trans);
+        return TMP_EEPROM_I2C;
+    }
+    EEPROM_busy = tmp_handle->fxn_details.rxBuffer[0]&(1<<6);       //6th bit 1 if busy, 0 if not busy
+    EEPROM_unlocked = tmp_handle->fxn_details.rxBuffer[0]&(1<<7);   //7th bit 1 if unlocked, 0 if locked
+    if(!EEPROM_busy && EEPROM_unlocked == unlock){
+        return 0x00; //already set
+    }
+    if(!EEPROM_busy){
+        // Write to Unlock Memory Register, applied by the next pass
+        tmp_handle->i2c_trans.readCount = 0;
+        tmp_handle->i2c_trans.writeCount = 3;
+        tmp_handle->fxn_details.txBuffer[0] = sensor.MemUnlockReg;
+        tmp_handle->fxn_details.txBuffer[1] = unlock ? 1<<7 : 0;
+        tmp_handle->fxn_details.txBuffer[2] = 0;
+        if(!I2C_transfer(tmp_handle->i2c_handle, &tmp_handle->i2c_trans)){
+            i2cErrorHandler(&tmp_handle->i2c_trans);
+            return TMP_EEPROM_STATE|TMP_EEPROM_I2C;
+        }
+    }
+    return (EEPROM_busy ? TMP_EEPROM_BUSY : 0)|((EEPROM_unlocked != unlock) ? TMP_EEPROM_STATE : 0);
+}
+
+/*
+ * Polls the running EEPROM stage again later
+ *      Returns false once the stage timed out
+ */
+bool Eeprom_retry_internal(TMP_Handle *tmp_handle, const Active_Msg *next)
+{
+    uint64_t now = clock_us();
+    if(now >= tmp_handle->fxn_details.eeprom_us){
+        return false;
+    }
+    Active_schedule(&tmp_handle->active, next, now + TMP_EEPROM_POLL_US);
+    return true;
 }
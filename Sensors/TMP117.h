@@ -8,20 +8,18 @@
 #ifndef TMP117_H_
 #define TMP117_H_
 
-/* POSIX Header files */
-#include <pthread.h>
-
-/* RTOS header files */
-#include <ti/sysbios/BIOS.h>
-
 /* Drivers */
 #include <ti/drivers/I2C.h>
-#include <ti/sysbios/knl/Semaphore.h>
 #include <ti/drivers/Board.h> //Sleep header
 #include <string.h>
 
+#include "periodic.h"
+#include "active.h"
+#include "adaptive.h"
+
 /* Temperature result registers */
 #define TMP117_RESULT_REG       0x00
+#define TMP117_CONFIG_REG       0x01
 #define TMP117_EUI_REG          0x0F
 #define TMP117_TMPOFFSET_REG    0x07
 #define TMP117_MEMUNLOCK_RED    0x04
@@ -32,10 +30,41 @@
 /* I2C slave addresses */
 #define TMP117_ADDR             0x48
 
+/* Stack of each sensor thread, check the high-water mark with ThreadStats_print */
+#define TMP_STACK_SIZE          2048
+#define TMP_PRIORITY            2
+
+/* Maximum number of sample subscribers per sensor */
+#define TMP_MAX_SUBSCRIBERS     4
+/* Time TMP_Unsubscribe waits for the sensor to be idle */
+#define TMP_UNSUBSCRIBE_MS      100
+
+/* Default deadline of Detect, ReadID and each ReadTemp sample, from post */
+#define TMP_READ_DEADLINE_US    20000
+
+/* EEPROM writes are split into stages polled from continuations */
+#define TMP_EEPROM_POLL_US      2000
+#define TMP_EEPROM_TIMEOUT_US   150000  // Per stage, the blocking sequence allowed 15 x 10ms
+
+/* Conversion cycle, CONV bits of the configuration register with 8 averages (AVG 01) */
+#define TMP117_CONV_SHIFT       7
+#define TMP117_AVG_8            0x0020
+#define TMP117_CONV_DEFAULT     4       // 1s, the power on setting
+
+/* Adapt, shortest period (the 125ms cycle with 8 averages) and default thresholds */
+#define TMP_ADAPT_MIN_MS        125
+#define TMP_ADAPT_MAX_STEP      0.1f    // degC between samples
+#define TMP_ADAPT_TRANSIENT     0.25f   // degC off the prediction
+
+/* EEPROM lock status mask */
+#define TMP_EEPROM_BUSY         0x01
+#define TMP_EEPROM_STATE        0x02    // Not yet in the requested lock state
+#define TMP_EEPROM_I2C          0x04
+#define TMP_EEPROM_TIMEOUT      0x08
+
 
 typedef enum TMP_Request {
     TMP_None,
-    TMP_Initializing,
     TMP_Detect,
     TMP_ReadTemp,
     TMP_ReadSN,
@@ -43,45 +72,77 @@ typedef enum TMP_Request {
     TMP_ReadID,
     TMP_ReadCal,
     TMP_WriteCal,
-    TMP_Stop
+    TMP_Monitor,
+    TMP_Adapt,
+    TMP_ReadTempNext,       // Continuations, scheduled by the sensor itself
+    TMP_MonitorNext,
+    TMP_WriteSNNext,
+    TMP_WriteCalNext,
+    TMP_AdaptNext
 } TMP_Request;
 
-typedef enum TMP_Status {
-    TMP_Ready,
-    TMP_Busy
-} TMP_Status;
+/* Stages of WriteSN and WriteCal, the arg of their continuations */
+typedef enum TMP_EepromStage {
+    TMP_EEPROM_Write1,      // WriteSN: unlock, Mem1   WriteCal: lock, offset
+    TMP_EEPROM_Write2,      // WriteSN: unlock, Mem2
+    TMP_EEPROM_Verify       // Lock, read back
+} TMP_EepromStage;
+
+/*
+ * A single temperature sample published to subscribers
+ */
+typedef struct TMP_Sample {
+    int16_t raw;            // Raw result register, 1/128 degC per bit
+    float temp;             // Temperature in degC
+    uint64_t timestamp_us;  // clock_us() when the I2C read completed
+} TMP_Sample;
+
+struct TMP_Handle;
+typedef void (*TMP_SampleFxn)(struct TMP_Handle*, const TMP_Sample*, void*);
+
+typedef struct TMP_Subscriber {
+    TMP_SampleFxn fxn;      // Called from the TMP thread on every new sample, NULL for a free slot
+    void *arg;
+} TMP_Subscriber;
 
 typedef struct TMP_Misc {
-    uint8_t count;
-    float *avgTemp;
-    uint16_t *readID;
-    uint32_t writeSerialNo;
-    uint32_t *readSerialNo;
-    float writeOffset;
-    float *readOffset;
-    bool *detect;
-    char txBuffer[10];
-    char rxBuffer[10];
+    uint8_t samples;        // Samples taken by the running ReadTemp
+    float avgTemp;          // Running average of the running ReadTemp
+    uint64_t eeprom_us;     // clock_us() time the running EEPROM stage times out
+    uint32_t read_us;       // I2C time of the last result read
+    uint8_t conversion;     // Conversion cycle set, TMP117_CONV_DEFAULT after power on
+    char txBuffer[4];
+    char rxBuffer[4];
 } TMP_Misc;
 
+/*
+ * Methods only queue a request and return, they may be called from a Hwi
+ * or Swi (i.e. a GPIO callback)
+ * Detect, ReadID and ReadTemp are high priority with a deadline, a single
+ * ReadTemp, Detect or ReadID may run between the stages of an EEPROM write
+ * or the samples of Monitor. The Completion can override both.
+ */
 typedef struct TMP_Handle {
     const char          tmp_name[10];
-    pthread_t           pth_handle;     // Thread Handle Generated by Open_TMP
     I2C_Handle          i2c_handle;     // I2C Handle Generated by Open_TMP
     I2C_Transaction     i2c_trans;      // I2C Transaction
     uint8_t             address;        // Temperature Sensor I2C Address
-    Semaphore_Handle    sem_handle;     // Semaphore Handle Generated by Open_TMP
-    TMP_Status          tmp_status;     // Updated with current status by thread
-    TMP_Request         tmp_request;    // Updated with object methods
-    void (*Detect)(struct TMP_Handle*, bool*);    // Method to detect if the TMP117 is found
-    void (*ReadTemp)(struct TMP_Handle*,float*,uint8_t);  // Method to read temperature n times
-    void (*ReadSN)(struct TMP_Handle*,uint32_t*); // Method to read TMP serial number
-    void (*WriteSN)(struct TMP_Handle*,uint32_t); // Method to write TMP serial number
-    void (*ReadID)(struct TMP_Handle*,uint16_t*); // Method to read manufacturer TMP ID
-    void (*ReadCal)(struct TMP_Handle*,float*);   // Method to read calibration offset
-    void (*WriteCal)(struct TMP_Handle*,float);   // Method to write calibration offset
+    Active_Object       active;         // Thread and request queue started by Open_TMP
+    void (*Detect)(struct TMP_Handle*,Completion*);   // Method to detect if the TMP117 is found, result.b
+    void (*ReadTemp)(struct TMP_Handle*,uint8_t,Completion*);  // Method to read temperature n times, result.f32 average
+    void (*ReadSN)(struct TMP_Handle*,Completion*);   // Method to read TMP serial number, result.u32
+    void (*WriteSN)(struct TMP_Handle*,uint32_t,Completion*); // Method to write TMP serial number, result.u32 read back
+    void (*ReadID)(struct TMP_Handle*,Completion*);   // Method to read manufacturer TMP ID, result.u16
+    void (*ReadCal)(struct TMP_Handle*,Completion*);  // Method to read calibration offset, result.f32
+    void (*WriteCal)(struct TMP_Handle*,float,Completion*);   // Method to write calibration offset, result.f32 read back
+    void (*Monitor)(struct TMP_Handle*,uint16_t,Completion*); // Method to sample every n ms until Stop
+    void (*Adapt)(struct TMP_Handle*,uint16_t,uint16_t,Completion*); // Method to sample every min to max ms, faster while the temperature moves, until Stop
     void (*Stop)(struct TMP_Handle*);             // Method to stop all operations in progress
-    TMP_Misc            fxn_details;    // Internal register to manage tasks
+    TMP_Misc            fxn_details;    // I2C buffers
+    Periodic_Timer      timer;          // Sample period timer used by ReadTemp, Monitor and Adapt
+    Adaptive_Rate       adapt;          // Period of Adapt, set config.maxStep and config.transient before the call
+    TMP_Subscriber      subscribers[TMP_MAX_SUBSCRIBERS]; // Sample stream listeners
+    uint8_t             subscriber_count;   // Slots used so far, a removed subscriber leaves its slot free
 } TMP_Handle;
 
 
@@ -106,6 +167,23 @@ static const struct
             TMP117_MEM2_REG,
             TMP117_MEM3_REG};
 
-TMP_Handle Open_TMP(I2C_Handle i2c_handle, uint8_t address, const char TMP_Name[10]);
+bool Open_TMP(TMP_Handle *tmp_handle, I2C_Handle i2c_handle, uint8_t address, const char TMP_Name[10]);
+bool TMP_Subscribe(TMP_Handle *tmp_handle, TMP_SampleFxn fxn, void *arg);
+bool TMP_Unsubscribe(TMP_Handle *tmp_handle, TMP_SampleFxn fxn, void *arg);
+
+/* Reads one sample in the caller's thread, the caller must hold the sensor with Active_claim */
+bool ReadTemp_internal(TMP_Handle *tmp_handle, TMP_Sample *sample);
+
+/* Passes a sample to every subscriber, the caller must hold the sensor */
+void Publish_internal(TMP_Handle *tmp_handle, const TMP_Sample *sample);
+
+/* Removes a subscriber from inside a subscriber, or with the sensor held */
+bool Unsubscribe_internal(TMP_Handle *tmp_handle, TMP_SampleFxn fxn, void *arg);
+
+/* One 16 bit register with a private transaction, the caller must hold the sensor */
+bool ReadReg_internal(TMP_Handle *tmp_handle, uint8_t reg, uint16_t *value);
+bool WriteReg_internal(TMP_Handle *tmp_handle, uint8_t reg, uint16_t value);
+/* Sets the conversion cycle for a new sample every period_us, the caller must hold the sensor */
+bool Conversion_internal(TMP_Handle *tmp_handle, uint32_t period_us);
 
 #endif /* TMP117_H_ */
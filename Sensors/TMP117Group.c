@@ -0,0 +1,343 @@
+/*
+ * TMP117Group.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#include "utilities.h"
+#include "log.h"
+#include "TMP117Group.h"
+
+/* The 8 conversions of a one-shot, without the margin, its middle is the sample time */
+#define TMPG_WINDOW_US          124000
+
+void TMPGroup_dispatch(void *group_handle, const Active_Msg *msg);
+void TMPGroup_Sample_request(TMPGroup_Handle *handle, Completion *done);
+void TMPGroup_Monitor_request(TMPGroup_Handle *handle, uint16_t period_ms, Completion *done);
+void TMPGroup_Monitor_process(TMPGroup_Handle *handle, uint16_t period_ms);
+void TMPGroup_Monitor_step(TMPGroup_Handle *handle);
+bool TMPGroup_Read_step(TMPGroup_Handle *handle, bool monitor, uint32_t *valid);
+void TMPGroup_Stop_request(TMPGroup_Handle *handle);
+static bool TMPGroup_trigger_internal(TMPGroup_Handle *handle, bool monitor);
+static void TMPGroup_release_internal(TMPGroup_Handle *handle);
+static void TMPGroup_restore_internal(TMPGroup_Handle *handle);
+
+/* Shared by every group */
+static const Active_Config TMPGroup_config = {
+    .priority = TMP_GROUP_PRIORITY,
+    .stackSize = TMP_GROUP_STACK_SIZE,
+    .start = NULL,
+    .dispatch = TMPGroup_dispatch,
+    .interleave = NULL
+};
+
+/*
+ * Initializes a group thread which samples several
+ * TMP117 sensors at the same instant (i.e. the probes of a fixture)
+ *
+ * Input handle storage owned by the caller (static or global), the
+ * thread keeps using it so it must outlive the group
+ * Input array of TMP handles opened with Open_TMP
+ * Input number of handles up to TMP_GROUP_MAX
+ * Input Group Name (i.e. Fixture) up to 10 characters
+ *
+ * Returns false if the thread could not be started
+ */
+bool Open_TMPGroup(TMPGroup_Handle *group_handle, TMP_Handle *members[], uint8_t count, const char Group_Name[10])
+{
+    strncpy(group_handle->group_name, Group_Name, sizeof(group_handle->group_name) - 1);
+    group_handle->group_name[sizeof(group_handle->group_name) - 1] = '\0';
+    if(count > TMP_GROUP_MAX){
+        count = TMP_GROUP_MAX;
+    }
+    group_handle->count = count;
+
+    group_handle->Sample = TMPGroup_Sample_request;
+    group_handle->Monitor = TMPGroup_Monitor_request;
+    group_handle->Stop = TMPGroup_Stop_request;
+
+    uint8_t n = 0;
+    for(; n<TMP_GROUP_MAX; n++){
+        group_handle->members[n] = (n < count) ? members[n] : NULL;
+    }
+    memset(&group_handle->fxn_details, 0, sizeof(TMPGroup_Misc));
+    memset(&group_handle->set, 0, sizeof(TMPGroup_Set));
+    memset(&group_handle->stats, 0, sizeof(TMPGroup_Stats));
+    group_handle->subscriber_count = 0;
+    Periodic_register(&group_handle->timer, group_handle->group_name);
+
+    return Active_start(&group_handle->active, &TMPGroup_config, group_handle, group_handle->group_name);
+}
+
+/*
+ * Registers a function called from the group thread on every set
+ * Members' own subscribers get their sample of the set as well
+ *      Returns false if the subscriber table is full
+ */
+bool TMPGroup_Subscribe(TMPGroup_Handle *group_handle, TMPGroup_SetFxn fxn, void *arg)
+{
+    if(group_handle->subscriber_count >= TMP_GROUP_SUBSCRIBERS){
+        return false;
+    }
+    group_handle->subscribers[group_handle->subscriber_count].fxn = fxn;
+    group_handle->subscribers[group_handle->subscriber_count].arg = arg;
+    group_handle->subscriber_count++;
+    return true;
+}
+
+/*
+ * Runs one group request step in the group thread
+ */
+void TMPGroup_dispatch(void *group_handle, const Active_Msg *msg)
+{
+    TMPGroup_Handle *handle = (TMPGroup_Handle*)group_handle;
+    Completion unused;      // Result storage for requests posted without a token
+    Completion *done = (msg->done != NULL) ? msg->done : &unused;
+    bool ok = true;
+
+    switch(msg->sig) {
+        case TMPG_Sample:
+            ok = TMPGroup_trigger_internal(handle, false);
+            if(!ok){
+                TMPGroup_restore_internal(handle);
+            }
+            break;
+        case TMPG_Monitor:
+            TMPGroup_Monitor_process(handle, msg->arg);
+            break;
+        case TMPG_ReadNext:
+            ok = TMPGroup_Read_step(handle, msg->arg, &done->result.u32);
+            break;
+        case TMPG_MonitorNext:
+            Periodic_record(&handle->timer);
+            TMPGroup_Monitor_step(handle);
+            break;
+        default:
+            break;
+    }
+    if(!ok){
+        Completion_finish(msg->done, COMPLETION_Failed);
+    }
+}
+
+
+/*
+ * Sample request
+ * Takes one set, result.u32 is the mask of members sampled
+ */
+void TMPGroup_Sample_request(TMPGroup_Handle *handle, Completion *done)
+{
+    Active_Msg msg = {.sig = TMPG_Sample, .priority = ACTIVE_PRIORITY_HIGH,
+                      .deadline_us = TMP_GROUP_DEADLINE_US, .done = done};
+    Active_post(&handle->active, &msg);
+}
+
+/*
+ * Monitor request
+ * Takes a set every period_ms until Stop, at least the one-shot time,
+ * results go to subscribers only
+ * The Completion finishes as cancelled by Stop
+ */
+void TMPGroup_Monitor_request(TMPGroup_Handle *handle, uint16_t period_ms, Completion *done)
+{
+    Active_Msg msg = {.sig = TMPG_Monitor, .arg = period_ms, .done = done};
+    Active_post(&handle->active, &msg);
+}
+
+/*
+ * Monitor process
+ */
+void TMPGroup_Monitor_process(TMPGroup_Handle *handle, uint16_t period_ms)
+{
+    uint32_t period_us = (uint32_t)period_ms*1000;
+    if(period_us < TMP_ONESHOT_US){
+        period_us = TMP_ONESHOT_US;
+    }
+    Periodic_start(&handle->timer, period_us, PERIODIC_SKIP);
+    TMPGroup_Monitor_step(handle);
+}
+
+/*
+ * Starts the conversions of one set, the read follows as a continuation
+ */
+void TMPGroup_Monitor_step(TMPGroup_Handle *handle)
+{
+    if(Active_cancelled(&handle->active)){
+        TMPGroup_restore_internal(handle);
+        return;
+    }
+    if(!TMPGroup_trigger_internal(handle, true)){
+        // Nothing converting, try again next period
+        Active_Msg next = {.sig = TMPG_MonitorNext};
+        Periodic_next(&handle->timer);
+        Active_schedule(&handle->active, &next, handle->timer.deadline_us);
+    }
+}
+
+/*
+ * Reads every triggered member back to back and publishes the set
+ * Monitor schedules the next set, Sample puts the members back in
+ * continuous conversion
+ *      Returns false if no member was sampled
+ */
+bool TMPGroup_Read_step(TMPGroup_Handle *handle, bool monitor, uint32_t *valid)
+{
+    TMPGroup_Misc *details = &handle->fxn_details;
+    TMPGroup_Set *set = &handle->set;
+    uint64_t first = 0, last = 0;
+    uint64_t start, end;
+    uint8_t n;
+
+    if(Active_cancelled(&handle->active)){
+        TMPGroup_release_internal(handle);
+        TMPGroup_restore_internal(handle);
+        return true;
+    }
+
+    set->count = handle->count;
+    set->valid = 0;
+    start = clock_us();
+    end = start;
+    for(n=0; n<handle->count; n++){
+        uint16_t raw;
+        if(!(details->triggered & (1 << n))){
+            continue;
+        }
+        if(!ReadReg_internal(handle->members[n], sensor.resultReg, &raw)){
+            handle->stats.failures++;
+            continue;
+        }
+        end = clock_us();
+        set->valid |= 1 << n;
+        set->samples[n].raw = (int16_t)raw;
+        set->samples[n].temp = set->samples[n].raw * 0.0078125f;
+        if(!first || details->trigger_us[n] < first){
+            first = details->trigger_us[n];
+        }
+        if(details->trigger_us[n] > last){
+            last = details->trigger_us[n];
+        }
+    }
+    TMPGroup_release_internal(handle);
+
+    if(set->valid){
+        set->timestamp_us = (first + last)/2 + TMPG_WINDOW_US/2;
+        set->skew_us = (uint32_t)(last - first);
+        set->read_us = (uint32_t)(end - start);
+        handle->stats.sets++;
+        handle->stats.lastSkew_us = set->skew_us;
+        if(set->skew_us > handle->stats.maxSkew_us){
+            handle->stats.maxSkew_us = set->skew_us;
+        }
+        if(set->read_us > handle->stats.maxRead_us){
+            handle->stats.maxRead_us = set->read_us;
+        }
+        LOG2(LOG_TMP_GROUP_SET, set->valid, set->skew_us);
+
+        for(n=0; n<handle->count; n++){
+            if(!(set->valid & (1 << n))){
+                continue;
+            }
+            set->samples[n].timestamp_us = set->timestamp_us;
+            Publish_internal(handle->members[n], &set->samples[n]);
+        }
+        for(n=0; n<handle->subscriber_count; n++){
+            handle->subscribers[n].fxn(handle, set, handle->subscribers[n].arg);
+        }
+    }
+    *valid = set->valid;
+
+    if(monitor){
+        Active_Msg next = {.sig = TMPG_MonitorNext};
+        Periodic_next(&handle->timer);
+        Active_schedule(&handle->active, &next, handle->timer.deadline_us);
+        return true;
+    }
+    TMPGroup_restore_internal(handle);
+    return set->valid != 0;
+}
+
+/*
+ * Stop all processes request
+ * Members are released and put back in continuous conversion
+ */
+void TMPGroup_Stop_request(TMPGroup_Handle *handle)
+{
+    Active_cancel(&handle->active);
+}
+
+
+/*
+ * Claims every member and starts its one-shot conversion, back to back
+ * so the conversion windows line up, then schedules the read pass for
+ * when the last one is done
+ * Input true if Monitor takes the set
+ *      Returns false if no member is converting
+ */
+static bool TMPGroup_trigger_internal(TMPGroup_Handle *handle, bool monitor)
+{
+    TMPGroup_Misc *details = &handle->fxn_details;
+    Active_Msg next = {.sig = TMPG_ReadNext, .arg = monitor};
+    uint64_t last = 0;
+    uint8_t n;
+
+    details->triggered = 0;
+    for(n=0; n<handle->count; n++){
+        TMP_Handle *member = handle->members[n];
+        if(!Active_claim(&member->active)){
+            LOG1(LOG_TMP_GROUP_BUSY, member->address);
+            handle->stats.skipped++;
+            continue;
+        }
+        if(!WriteReg_internal(member, TMP117_CONFIG_REG, TMP117_MOD_ONESHOT | TMP117_AVG_8)){
+            Active_release(&member->active);
+            handle->stats.failures++;
+            continue;
+        }
+        last = clock_us();
+        details->trigger_us[n] = last;
+        details->triggered |= 1 << n;
+        details->restore |= 1 << n;
+    }
+    if(!details->triggered){
+        return false;
+    }
+    Active_schedule(&handle->active, &next, last + TMP_ONESHOT_US);
+    return true;
+}
+
+/*
+ * Gives the claimed members back to their own threads
+ */
+static void TMPGroup_release_internal(TMPGroup_Handle *handle)
+{
+    uint8_t n = 0;
+    for(; n<handle->count; n++){
+        if(handle->fxn_details.triggered & (1 << n)){
+            Active_release(&handle->members[n]->active);
+        }
+    }
+    handle->fxn_details.triggered = 0;
+}
+
+/*
+ * Puts members left in one-shot mode back in continuous conversion at
+ * their own cycle, a member busy with its own request is tried again
+ * when the next group request ends
+ */
+static void TMPGroup_restore_internal(TMPGroup_Handle *handle)
+{
+    uint8_t n = 0;
+    for(; n<handle->count; n++){
+        TMP_Handle *member = handle->members[n];
+        if(!(handle->fxn_details.restore & (1 << n)) || !Active_claim(&member->active)){
+            continue;
+        }
+        uint16_t config = (uint16_t)((member->fxn_details.conversion << TMP117_CONV_SHIFT) | TMP117_AVG_8);
+        if(WriteReg_internal(member, TMP117_CONFIG_REG, config)){
+            handle->fxn_details.restore &= ~(1 << n);
+        }
+        Active_release(&member->active);
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * TMP117Group.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Synchronized sampling of several TMP117 sensors
+ *      Each set triggers a one-shot conversion on every member back to
+ *      back, waits once for the conversion time and reads every result in
+ *      one pass. All samples of a set carry the same timestamp, the middle
+ *      of the conversion window, and the set reports the skew: the time
+ *      between the first and the last trigger, by which the windows of
+ *      the members are offset.
+ *
+ *      Members are claimed (Active_claim) from the trigger to the read, so
+ *      their own requests wait for the set. A member busy with a request
+ *      of its own is left out of the set. Stop Monitor or Adapt on the
+ *      members first, between sets a member left in one-shot mode stands
+ *      by. When the group request ends, members are put back in continuous
+ *      conversion at their own cycle.
+ */
+
+#ifndef TMP117GROUP_H_
+#define TMP117GROUP_H_
+
+#include "TMP117.h"
+
+/* Maximum number of sensors sampled by a single group */
+#define TMP_GROUP_MAX           8
+
+/* Stack of each group thread */
+#define TMP_GROUP_STACK_SIZE    2048
+#define TMP_GROUP_PRIORITY      2
+
+/* Maximum number of set subscribers per group */
+#define TMP_GROUP_SUBSCRIBERS   2
+
+/* Configuration register, one-shot conversion (MOD 11) with 8 averages */
+#define TMP117_MOD_ONESHOT      0x0C00
+/* 8 conversions of 15.5ms, plus margin for the internal oscillator */
+#define TMP_ONESHOT_US          140000
+/* Default deadline of Sample, from post */
+#define TMP_GROUP_DEADLINE_US   (TMP_ONESHOT_US + 20000)
+
+typedef enum TMPGroup_Request {
+    TMPG_None,
+    TMPG_Sample,
+    TMPG_Monitor,
+    TMPG_ReadNext,          // Continuations, scheduled by the group itself
+    TMPG_MonitorNext
+} TMPGroup_Request;
+
+/*
+ * One synchronized set, samples in member order
+ */
+typedef struct TMPGroup_Set {
+    uint64_t timestamp_us;  // Common to every sample, middle of the conversion window
+    uint32_t skew_us;       // First to last trigger
+    uint32_t read_us;       // Read pass, first to last result
+    uint8_t count;          // Members in the group
+    uint8_t valid;          // Mask of members sampled, bit n for member n
+    TMP_Sample samples[TMP_GROUP_MAX];
+} TMPGroup_Set;
+
+struct TMPGroup_Handle;
+typedef void (*TMPGroup_SetFxn)(struct TMPGroup_Handle*, const TMPGroup_Set*, void*);
+
+typedef struct TMPGroup_Subscriber {
+    TMPGroup_SetFxn fxn;    // Called from the group thread on every set
+    void *arg;
+} TMPGroup_Subscriber;
+
+typedef struct TMPGroup_Stats {
+    uint32_t sets;
+    uint32_t skipped;       // Members left out as busy
+    uint32_t failures;      // Members whose trigger or read failed
+    uint32_t lastSkew_us;
+    uint32_t maxSkew_us;
+    uint32_t maxRead_us;
+} TMPGroup_Stats;
+
+typedef struct TMPGroup_Misc {
+    uint8_t triggered;      // Mask of members claimed and converting
+    uint8_t restore;        // Mask of members left in one-shot mode
+    uint64_t trigger_us[TMP_GROUP_MAX];
+} TMPGroup_Misc;
+
+/*
+ * Methods only queue a request and return, like the TMP_Handle methods
+ */
+typedef struct TMPGroup_Handle {
+    char                group_name[10];
+    TMP_Handle          *members[TMP_GROUP_MAX]; // Sensors opened with Open_TMP
+    uint8_t             count;          // Number of members
+    Active_Object       active;         // Thread and request queue started by Open_TMPGroup
+    void (*Sample)(struct TMPGroup_Handle*,Completion*);           // Method to take one set, result.u32 mask of members sampled
+    void (*Monitor)(struct TMPGroup_Handle*,uint16_t,Completion*); // Method to take a set every n ms until Stop
+    void (*Stop)(struct TMPGroup_Handle*);                         // Method to stop all operations in progress
+    TMPGroup_Misc       fxn_details;    // Internal register to manage tasks
+    TMPGroup_Set        set;            // Last set taken
+    TMPGroup_Stats      stats;
+    Periodic_Timer      timer;          // Set period timer used by Monitor
+    TMPGroup_Subscriber subscribers[TMP_GROUP_SUBSCRIBERS]; // Set listeners
+    uint8_t             subscriber_count;
+} TMPGroup_Handle;
+
+bool Open_TMPGroup(TMPGroup_Handle *group_handle, TMP_Handle *members[], uint8_t count, const char Group_Name[10]);
+bool TMPGroup_Subscribe(TMPGroup_Handle *group_handle, TMPGroup_SetFxn fxn, void *arg);
+
+#endif /* TMP117GROUP_H_ */
@@ -0,0 +1,180 @@
+/*
+ * TMP117Scan.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#include <ti/sysbios/knl/Clock.h>
+
+#include "utilities.h"
+#include "log.h"
+#include "TMP117Scan.h"
+
+typedef enum Scan_State {
+    SCAN_None,
+    SCAN_Writing,                   // Claimed by the first valid sample
+    SCAN_Sampled                    // firstSample_us written
+} Scan_State;
+
+TMP_Boot tmp_boot;
+static uint8_t scan_sampled = SCAN_None;   // Scan_State
+
+static int_fast16_t Scan_probe_internal(I2C_Handle bus, uint8_t address, uint16_t *id);
+static void Scan_sample_internal(TMP_Handle *tmp_handle, const TMP_Sample *sample, void *arg);
+
+
+/*
+ * Finds the TMP117 sensors on every bus and opens a handle for each
+ * Call once at startup, before any other I2C traffic on the buses
+ *
+ * Input array of I2C handles opened by the application
+ * Input number of buses
+ * Input table of handles filled in bus then address order, named TMP0, TMP1...
+ * Input size of the table, sensors past it are counted but not opened
+ *      Returns the number of handles opened
+ */
+uint8_t TMP_Scan(I2C_Handle buses[], uint8_t busCount, TMP_Handle handles[], uint8_t max)
+{
+    I2C_Handle foundBus[TMP_SCAN_MAX];
+    uint8_t foundAddress[TMP_SCAN_MAX];
+    uint8_t count = 0;
+    uint8_t b, a, n;
+
+    memset(&tmp_boot, 0, sizeof(TMP_Boot));
+    __atomic_store_n(&scan_sampled, SCAN_None, __ATOMIC_RELAXED);
+    tmp_boot.scanStart_us = clock_us();
+
+    for(b=0; b<busCount; b++){
+        for(a=0; a<TMP117_ADDR_COUNT; a++){
+            uint8_t address = TMP117_ADDR + a;
+            uint16_t id = 0;
+            uint64_t start = clock_us();
+            int_fast16_t status = Scan_probe_internal(buses[b], address, &id);
+            uint32_t probe = (uint32_t)(clock_us() - start);
+            tmp_boot.probes++;
+            if(probe > tmp_boot.maxProbe_us){
+                tmp_boot.maxProbe_us = probe;
+            }
+
+            if(status == I2C_STATUS_SUCCESS){
+                if((id & TMP117_ID_MASK) != TMP117_DEVICE_ID){
+                    tmp_boot.foreign++;
+                    continue;
+                }
+                tmp_boot.found++;
+                LOG1(LOG_TMP_DETECTED, address);
+                if(count < max && count < TMP_SCAN_MAX){
+                    foundBus[count] = buses[b];
+                    foundAddress[count++] = address;
+                }
+            }
+            else if(status == I2C_STATUS_TIMEOUT || status == I2C_STATUS_CLOCK_TIMEOUT || status == I2C_STATUS_BUS_BUSY){
+                LOG2(LOG_TMP_SCAN_STUCK, b, status);
+                tmp_boot.stuck++;
+                break; // The other addresses would time out as well
+            }
+            else{
+                tmp_boot.absent++;
+            }
+        }
+    }
+    tmp_boot.scanEnd_us = clock_us();
+
+    for(n=0; n<count; n++){
+        char name[10] = "TMP";
+        if(n >= 10){
+            name[3] = '0' + n/10;
+            name[4] = '0' + n%10;
+        }
+        else{
+            name[3] = '0' + n;
+        }
+        Open_TMP(&handles[n], foundBus[n], foundAddress[n], name);
+        TMP_Subscribe(&handles[n], Scan_sample_internal, NULL);
+    }
+    tmp_boot.openEnd_us = clock_us();
+    return count;
+}
+
+/*
+ * Prints the boot phases in ms from kernel start and the probe counts
+ */
+void TMP_Boot_print(void)
+{
+    uint64_t first = (__atomic_load_n(&scan_sampled, __ATOMIC_ACQUIRE) == SCAN_Sampled) ? tmp_boot.firstSample_us : 0;
+
+    uart_print_string("boot scan_ms ");
+    uart_print_uint32((uint32_t)(tmp_boot.scanStart_us / 1000));
+    uart_print_string("-");
+    uart_print_uint32((uint32_t)(tmp_boot.scanEnd_us / 1000));
+    uart_print_string(" open_ms ");
+    uart_print_uint32((uint32_t)(tmp_boot.openEnd_us / 1000));
+    uart_print_string(" first_sample_ms ");
+    if(first){
+        uart_print_uint32((uint32_t)(first / 1000));
+        uart_print_string((first > TMP_BOOT_TARGET_US) ? " over" : " within");
+    }
+    else{
+        uart_print_string("none,");
+    }
+    uart_print_string(" target ");
+    uart_print_uint32(TMP_BOOT_TARGET_US / 1000);
+    uart_print_string("\nprobes ");
+    uart_print_uint32(tmp_boot.probes);
+    uart_print_string(" found ");
+    uart_print_uint32(tmp_boot.found);
+    uart_print_string(" foreign ");
+    uart_print_uint32(tmp_boot.foreign);
+    uart_print_string(" absent ");
+    uart_print_uint32(tmp_boot.absent);
+    uart_print_string(" stuck_buses ");
+    uart_print_uint32(tmp_boot.stuck);
+    uart_print_string(" max_probe_us ");
+    uart_print_uint32(tmp_boot.maxProbe_us);
+    uart_print_string("\n");
+}
+
+/*
+ * Reads the device ID register with a short timeout
+ *      Returns the I2C_STATUS of the transfer
+ */
+static int_fast16_t Scan_probe_internal(I2C_Handle bus, uint8_t address, uint16_t *id)
+{
+    I2C_Transaction transaction;
+    uint8_t reg = sensor.EuiReg;
+    uint8_t rxBuffer[2];
+    uint32_t ticks = (TMP_SCAN_TIMEOUT_US + Clock_tickPeriod - 1) / Clock_tickPeriod;
+
+    memset(&transaction, 0, sizeof(I2C_Transaction));
+    transaction.slaveAddress = address;
+    transaction.writeBuf = &reg;
+    transaction.writeCount = 1;
+    transaction.readBuf = rxBuffer;
+    transaction.readCount = 2;
+    int_fast16_t status = I2C_transferTimeout(bus, &transaction, ticks);
+    if(status == I2C_STATUS_SUCCESS){
+        *id = (uint16_t)((rxBuffer[0] << 8) | rxBuffer[1]);
+    }
+    return status;
+}
+
+/*
+ * Records the first valid sample of any scanned sensor, a result read
+ * before the first conversion finished is still TMP117_RESULT_RESET
+ * Runs in the sensor threads, the first one to get here writes the time
+ * and publishes it with release. Each sensor then gives its subscriber
+ * slot back on its next valid sample.
+ */
+static void Scan_sample_internal(TMP_Handle *tmp_handle, const TMP_Sample *sample, void *arg)
+{
+    uint8_t none = SCAN_None;
+    if(sample->raw == TMP117_RESULT_RESET){
+        return;
+    }
+    if(__atomic_compare_exchange_n(&scan_sampled, &none, SCAN_Writing, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)){
+        tmp_boot.firstSample_us = sample->timestamp_us;
+        __atomic_store_n(&scan_sampled, SCAN_Sampled, __ATOMIC_RELEASE);
+    }
+    Unsubscribe_internal(tmp_handle, Scan_sample_internal, arg);
+}
@@ -0,0 +1,63 @@
+/*
+ * TMP117Scan.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * TMP117 bus discovery and boot timing
+ *      TMP_Scan probes every TMP117 address on every bus given with a
+ *      short transfer timeout, reads the device ID register to confirm
+ *      the part and opens a TMP_Handle only for the sensors found. A bus
+ *      that times out instead of answering or NACKing is stuck (i.e. SDA
+ *      held low or no pull-ups), its remaining addresses are skipped.
+ *
+ *      The boot phases are kept in tmp_boot as clock_us() times, counted
+ *      from kernel start: scan start and end, handles opened and the first
+ *      valid sample of any scanned sensor. The shell command boot prints
+ *      them against TMP_BOOT_TARGET_US. The subscriber slot TMP_Scan takes
+ *      on each sensor is given back on its first valid sample after that.
+ */
+
+#ifndef TMP117SCAN_H_
+#define TMP117SCAN_H_
+
+#include "TMP117.h"
+
+/* ADD0 tied to GND, V+, SDA or SCL gives 0x48 to 0x4B */
+#define TMP117_ADDR_COUNT       4
+
+/* Device ID register, bits 11-0 */
+#define TMP117_DEVICE_ID        0x0117
+#define TMP117_ID_MASK          0x0FFF
+
+/* Result register after power on, before the first conversion is done */
+#define TMP117_RESULT_RESET     ((int16_t)0x8000)
+
+/* Sensors TMP_Scan can open, i.e. 4 buses of 4 */
+#define TMP_SCAN_MAX            16
+
+/* One probe, address and 2 byte read are about 0.5ms at 100 kHz */
+#define TMP_SCAN_TIMEOUT_US     2000
+
+/* Power on to first valid sample the application aims for */
+#define TMP_BOOT_TARGET_US      250000
+
+typedef struct TMP_Boot {
+    uint64_t scanStart_us;      // clock_us() times, from kernel start
+    uint64_t scanEnd_us;        // Every address probed
+    uint64_t openEnd_us;        // Handles opened
+    uint64_t firstSample_us;    // First result other than TMP117_RESULT_RESET, 0 until then
+    uint32_t maxProbe_us;       // Longest single probe
+    uint8_t probes;
+    uint8_t found;              // Answered with the TMP117 device ID
+    uint8_t foreign;            // Answered with another ID, not opened
+    uint8_t absent;             // Address NACK or other error
+    uint8_t stuck;              // Buses given up after a timeout
+} TMP_Boot;
+
+extern TMP_Boot tmp_boot;
+
+uint8_t TMP_Scan(I2C_Handle buses[], uint8_t busCount, TMP_Handle handles[], uint8_t max);
+void TMP_Boot_print(void);
+
+#endif /* TMP117SCAN_H_ */
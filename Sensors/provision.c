@@ -0,0 +1,503 @@
+/*
+ * provision.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#include <pthread.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Semaphore.h>
+
+#include "provision.h"
+#include "framing.h"
+#include "uart_tx.h"
+#include "utilities.h"
+#include "log.h"
+
+#define PROV_BATCH_MAX          (PROV_BATCH_HEADER_SIZE + PROV_MAX_OPS*PROV_OP_SIZE)
+#define PROV_RESULT_MAX         (PROV_RESULT_HEADER_SIZE + PROV_MAX_OPS*PROV_RESULT_SIZE + TLM_CRC_SIZE)
+
+/* Register writes queued per sensor and batch */
+#define PROV_TARGET_WRITES      8
+
+/* EEPROM unlock register bits */
+#define PROV_EEPROM_UNLOCKED    0x8000
+#define PROV_EEPROM_BUSY        0x4000
+
+typedef enum Prov_Stage {
+    PROV_Idle,
+    PROV_Unlock,
+    PROV_Write,
+    PROV_Lock,
+    PROV_Done
+} Prov_Stage;
+
+typedef struct Prov_Op {
+    uint8_t target;
+    uint8_t op;
+    uint32_t arg;
+    uint8_t status;
+    uint32_t value;
+} Prov_Op;
+
+/*
+ * Per sensor state of one batch
+ */
+typedef struct Prov_Target {
+    TMP_Handle *handle;
+    bool used;                  // Addressed by the batch
+    bool claimed;               // Sensor thread marked busy for the batch
+    uint8_t error;              // Status reported for every op of the sensor
+    Prov_Stage stage;
+    uint8_t writes;
+    uint8_t next;
+    uint8_t reg[PROV_TARGET_WRITES];
+    uint16_t value[PROV_TARGET_WRITES];
+    uint64_t deadline_us;
+} Prov_Target;
+
+Provision_Stats provision_stats;
+
+static Prov_Target prov_targets[PROV_MAX_TARGETS];
+static uint8_t prov_target_count = 0;
+static Prov_Op prov_ops[PROV_MAX_OPS];
+static uint8_t prov_batch[PROV_BATCH_MAX];
+static size_t prov_length = 0;
+static bool prov_busy = false;
+static Semaphore_Handle prov_sem = NULL;
+static Thread_Stats prov_thread_stats;
+
+void *Provision_thread(void *arg);
+void Provision_process(void);
+static uint8_t Provision_parse_internal(uint8_t *count);
+static void Provision_session_internal(I2C_Handle bus);
+static void Provision_read_internal(Prov_Op *op);
+static void Provision_result_internal(uint16_t batchId, uint8_t status, uint32_t elapsed_us, uint8_t count);
+static bool Prov_read16(Prov_Target *target, uint8_t reg, uint16_t *value);
+static bool Prov_write16(Prov_Target *target, uint8_t reg, uint16_t value);
+
+
+/*
+ * Starts the provisioning thread
+ * Register sensors with Provision_addTMP and route PROV_TYPE_BATCH frames
+ * to Provision_submit (i.e. Shell_addFrame(PROV_TYPE_BATCH, Provision_submit))
+ */
+void Provision_init(void)
+{
+    memset(&provision_stats, 0, sizeof(Provision_Stats));
+
+    Semaphore_Params sem_params;
+    Semaphore_Params_init(&sem_params);
+    sem_params.mode = Semaphore_Mode_BINARY;
+    prov_sem = Semaphore_create(0, &sem_params, NULL);
+
+    pthread_t pth_handle;
+    pthread_attr_t attrs;
+    struct sched_param priParam;
+    int retc;
+
+    /* Initialize the attributes structure with default values */
+    pthread_attr_init(&attrs);
+
+    /* Set priority, detach state, and stack size attributes */
+    priParam.sched_priority = 2;
+    retc                    = pthread_attr_setschedparam(&attrs, &priParam);
+    retc |= pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
+    retc |= pthread_attr_setstacksize(&attrs, PROV_STACK_SIZE);
+    if (retc != 0){
+        /* failed to set attributes */
+        while (1){}
+    }
+
+    retc = pthread_create(&pth_handle, &attrs, Provision_thread, NULL);
+    if (retc != 0){
+        uart_print_string("!Error: Provision thread creation error!\n");
+    }
+}
+
+/*
+ * Registers a sensor, its index in a batch is the registration order
+ *      Returns false if the target table is full
+ */
+bool Provision_addTMP(TMP_Handle *tmp_handle)
+{
+    if(prov_target_count >= PROV_MAX_TARGETS){
+        return false;
+    }
+    prov_targets[prov_target_count++].handle = tmp_handle;
+    return true;
+}
+
+/*
+ * Takes a PROV_TYPE_BATCH payload (CRC already checked and removed)
+ * The batch is copied and run by the provisioning thread, a batch that
+ * arrives while another one runs is answered with PROV_ERR_BUSY
+ */
+void Provision_submit(const uint8_t *payload, size_t length)
+{
+    uint16_t batchId = length >= 3 ? (uint16_t)(payload[1] | (payload[2] << 8)) : 0;
+    if(__atomic_load_n(&prov_busy, __ATOMIC_ACQUIRE)){
+        provision_stats.refused++;
+        Provision_result_internal(batchId, PROV_ERR_BUSY, 0, 0);
+        return;
+    }
+    if(length > PROV_BATCH_MAX){
+        provision_stats.refused++;
+        Provision_result_internal(batchId, PROV_ERR_INVALID, 0, 0);
+        return;
+    }
+    memcpy(prov_batch, payload, length);
+    prov_length = length;
+    __atomic_store_n(&prov_busy, true, __ATOMIC_RELEASE);
+    Semaphore_post(prov_sem);
+}
+
+/*
+ * Provisioning Thread
+ */
+void *Provision_thread(void *arg)
+{
+    (void)arg;
+    ThreadStats_register(&prov_thread_stats, "provision", PROV_STACK_SIZE);
+    while(1){
+        ThreadStats_block(&prov_thread_stats);
+        Semaphore_pend(prov_sem, BIOS_WAIT_FOREVER);
+        ThreadStats_wake(&prov_thread_stats);
+        Provision_process();
+        __atomic_store_n(&prov_busy, false, __ATOMIC_RELEASE);
+    }
+}
+
+/*
+ * Runs one batch
+ *      Sensors are claimed by marking them busy so their own requests are
+ *      refused, then every bus gets one EEPROM session for its writes,
+ *      then all reads and read backs run and the sensors are released
+ */
+void Provision_process(void)
+{
+    uint64_t start = clock_us();
+    uint16_t batchId = (uint16_t)(prov_batch[1] | (prov_batch[2] << 8));
+    uint8_t count = 0;
+    uint8_t n;
+
+    uint8_t status = Provision_parse_internal(&count);
+    if(status != PROV_OK){
+        provision_stats.refused++;
+        Provision_result_internal(batchId, status, 0, 0);
+        return;
+    }
+
+    for(n=0; n<prov_target_count; n++){
+        Prov_Target *target = &prov_targets[n];
+        if(!target->used){
+            continue;
+        }
+        if(!Active_claim(&target->handle->active)){
+            target->error = PROV_ERR_BUSY;
+            continue;
+        }
+        target->claimed = true;
+    }
+
+    // One session per bus, sensors on a bus are interleaved
+    for(n=0; n<prov_target_count; n++){
+        I2C_Handle bus = prov_targets[n].handle->i2c_handle;
+        uint8_t m = 0;
+        for(; m<n; m++){
+            if(prov_targets[m].handle->i2c_handle == bus){
+                break;
+            }
+        }
+        if(m == n){
+            Provision_session_internal(bus);
+        }
+    }
+
+    for(n=0; n<count; n++){
+        Prov_Op *op = &prov_ops[n];
+        if(op->status == PROV_OK){
+            if(prov_targets[op->target].error != PROV_OK){
+                op->status = prov_targets[op->target].error;
+            }
+            else{
+                Provision_read_internal(op);
+            }
+        }
+        provision_stats.operations++;
+        if(op->status != PROV_OK){
+            provision_stats.failures++;
+        }
+    }
+
+    for(n=0; n<prov_target_count; n++){
+        if(prov_targets[n].claimed){
+            Active_release(&prov_targets[n].handle->active);
+        }
+    }
+
+    provision_stats.batches++;
+    provision_stats.last_us = (uint32_t)(clock_us() - start);
+    Provision_result_internal(batchId, PROV_OK, provision_stats.last_us, count);
+}
+
+/*
+ * Decodes the batch into prov_ops and queues the register writes per sensor
+ *      Returns PROV_OK or PROV_ERR_INVALID for a malformed batch
+ */
+static uint8_t Provision_parse_internal(uint8_t *count)
+{
+    uint8_t n;
+    if(prov_length < PROV_BATCH_HEADER_SIZE){
+        return PROV_ERR_INVALID;
+    }
+    *count = prov_batch[3];
+    if(*count > PROV_MAX_OPS || prov_length != PROV_BATCH_HEADER_SIZE + (size_t)*count*PROV_OP_SIZE){
+        return PROV_ERR_INVALID;
+    }
+
+    for(n=0; n<prov_target_count; n++){
+        TMP_Handle *handle = prov_targets[n].handle;
+        memset(&prov_targets[n], 0, sizeof(Prov_Target));
+        prov_targets[n].handle = handle;
+    }
+
+    for(n=0; n<*count; n++){
+        const uint8_t *field = &prov_batch[PROV_BATCH_HEADER_SIZE + n*PROV_OP_SIZE];
+        Prov_Op *op = &prov_ops[n];
+        op->target = field[0];
+        op->op = field[1];
+        op->arg = (uint32_t)field[2] | ((uint32_t)field[3] << 8) | ((uint32_t)field[4] << 16) | ((uint32_t)field[5] << 24);
+        op->status = PROV_OK;
+        op->value = 0;
+
+        if(op->target >= prov_target_count){
+            op->status = PROV_ERR_TARGET;
+            continue;
+        }
+        Prov_Target *target = &prov_targets[op->target];
+        switch(op->op){
+            case PROV_OP_DETECT:
+            case PROV_OP_READ_ID:
+            case PROV_OP_READ_SN:
+            case PROV_OP_READ_CAL:
+                target->used = true;
+                break;
+            case PROV_OP_WRITE_SN:
+                if(target->writes + 2 > PROV_TARGET_WRITES){
+                    op->status = PROV_ERR_OP;
+                    break;
+                }
+                target->used = true;
+                target->reg[target->writes] = sensor.Mem1Reg;
+                target->value[target->writes++] = (uint16_t)(op->arg >> 16);
+                target->reg[target->writes] = sensor.Mem2Reg;
+                target->value[target->writes++] = (uint16_t)(op->arg);
+                break;
+            case PROV_OP_WRITE_CAL:
+                if(target->writes + 1 > PROV_TARGET_WRITES || (int32_t)op->arg < INT16_MIN || (int32_t)op->arg > INT16_MAX){
+                    op->status = PROV_ERR_OP;
+                    break;
+                }
+                target->used = true;
+                target->reg[target->writes] = sensor.TempOffsetReg;
+                target->value[target->writes++] = (uint16_t)op->arg;
+                break;
+            default:
+                op->status = PROV_ERR_OP;
+                break;
+        }
+    }
+    return PROV_OK;
+}
+
+/*
+ * EEPROM session for every claimed sensor with writes on one bus
+ *      Each sensor steps Unlock -> Write... -> Lock and only advances when
+ *      its EEPROM is not busy, so while one sensor programs a word the
+ *      thread writes the others instead of sleeping
+ */
+static void Provision_session_internal(I2C_Handle bus)
+{
+    uint8_t pending = 0;
+    uint8_t n;
+
+    for(n=0; n<prov_target_count; n++){
+        Prov_Target *target = &prov_targets[n];
+        if(target->claimed && target->handle->i2c_handle == bus && target->writes){
+            target->stage = PROV_Unlock;
+            target->deadline_us = clock_us() + PROV_EEPROM_TIMEOUT_MS*1000;
+            pending++;
+        }
+    }
+
+    while(pending){
+        bool progress = false;
+        for(n=0; n<prov_target_count; n++){
+            Prov_Target *target = &prov_targets[n];
+            if(target->handle->i2c_handle != bus || target->stage == PROV_Idle || target->stage == PROV_Done){
+                continue;
+            }
+
+            uint16_t eeprom;
+            if(!Prov_read16(target, sensor.MemUnlockReg, &eeprom)){
+                target->error = PROV_ERR_I2C;
+                target->stage = PROV_Done;
+                pending--;
+                continue;
+            }
+            // Still programming, or the unlock has not taken yet
+            bool waiting = (eeprom & PROV_EEPROM_BUSY) ||
+                           (target->stage == PROV_Write && !(eeprom & PROV_EEPROM_UNLOCKED));
+            if(waiting && clock_us() > target->deadline_us){
+                LOG1(LOG_TMP_UNLOCK_TIMEOUT, target->handle->address);
+                target->error = PROV_ERR_EEPROM;
+                Prov_write16(target, sensor.MemUnlockReg, 0); // Best effort lock
+                target->stage = PROV_Done;
+                pending--;
+                continue;
+            }
+            if(eeprom & PROV_EEPROM_BUSY){
+                continue;
+            }
+
+            bool ok = true;
+            bool advanced = true;
+            switch(target->stage){
+                case PROV_Unlock:
+                    ok = Prov_write16(target, sensor.MemUnlockReg, PROV_EEPROM_UNLOCKED);
+                    target->stage = PROV_Write;
+                    break;
+                case PROV_Write:
+                    if(!(eeprom & PROV_EEPROM_UNLOCKED)){
+                        // Retry within the stage deadline, not progress
+                        ok = Prov_write16(target, sensor.MemUnlockReg, PROV_EEPROM_UNLOCKED);
+                        advanced = false;
+                        break;
+                    }
+                    ok = Prov_write16(target, target->reg[target->next], target->value[target->next]);
+                    if(++target->next >= target->writes){
+                        target->stage = PROV_Lock;
+                    }
+                    break;
+                case PROV_Lock:
+                    ok = Prov_write16(target, sensor.MemUnlockReg, 0);
+                    target->stage = PROV_Done;
+                    pending--;
+                    break;
+                default:
+                    break;
+            }
+            if(!ok){
+                target->error = PROV_ERR_I2C;
+                if(target->stage != PROV_Done){
+                    target->stage = PROV_Done;
+                    pending--;
+                }
+            }
+            if(advanced){
+                // Deadline of the next stage or word
+                target->deadline_us = clock_us() + PROV_EEPROM_TIMEOUT_MS*1000;
+                progress = true;
+            }
+        }
+        if(!progress){
+            usleep(1000); // Every sensor is programming, wait 1ms
+        }
+    }
+}
+
+/*
+ * Reads the value of one operation, writes are verified against it
+ */
+static void Provision_read_internal(Prov_Op *op)
+{
+    Prov_Target *target = &prov_targets[op->target];
+    uint16_t high, low;
+    bool ok = true;
+
+    switch(op->op){
+        case PROV_OP_DETECT:
+            op->value = Prov_read16(target, sensor.resultReg, &low);
+            return;
+        case PROV_OP_READ_ID:
+            ok = Prov_read16(target, sensor.EuiReg, &low);
+            op->value = low & 0x0FFF;
+            break;
+        case PROV_OP_READ_SN:
+        case PROV_OP_WRITE_SN:
+            ok = Prov_read16(target, sensor.Mem1Reg, &high) && Prov_read16(target, sensor.Mem2Reg, &low);
+            op->value = ((uint32_t)high << 16) | low;
+            break;
+        case PROV_OP_READ_CAL:
+        case PROV_OP_WRITE_CAL:
+            ok = Prov_read16(target, sensor.TempOffsetReg, &low);
+            op->value = (uint32_t)(int32_t)(int16_t)low;
+            break;
+        default:
+            break;
+    }
+    if(!ok){
+        op->status = PROV_ERR_I2C;
+    }
+    else if((op->op == PROV_OP_WRITE_SN || op->op == PROV_OP_WRITE_CAL) && op->value != op->arg){
+        if(op->op == PROV_OP_WRITE_SN){
+            LOG2(LOG_TMP_SN_VERIFY, target->handle->address, op->value);
+        }
+        else{
+            LOG1(LOG_TMP_CAL_VERIFY, target->handle->address);
+        }
+        op->status = PROV_ERR_VERIFY;
+    }
+}
+
+/*
+ * Sends the PROV_TYPE_RESULT frame
+ */
+static void Provision_result_internal(uint16_t batchId, uint8_t status, uint32_t elapsed_us, uint8_t count)
+{
+    uint8_t payload[PROV_RESULT_MAX];
+    uint8_t frame[COBS_MAX_ENCODED(PROV_RESULT_MAX) + 1];
+    size_t length = 0;
+    uint8_t n = 0;
+
+    payload[length++] = PROV_TYPE_RESULT;
+    payload[length++] = (uint8_t)(batchId);
+    payload[length++] = (uint8_t)(batchId >> 8);
+    payload[length++] = status;
+    payload[length++] = (uint8_t)(elapsed_us);
+    payload[length++] = (uint8_t)(elapsed_us >> 8);
+    payload[length++] = (uint8_t)(elapsed_us >> 16);
+    payload[length++] = (uint8_t)(elapsed_us >> 24);
+    payload[length++] = count;
+    for(; n<count; n++){
+        payload[length++] = prov_ops[n].status;
+        payload[length++] = (uint8_t)(prov_ops[n].value);
+        payload[length++] = (uint8_t)(prov_ops[n].value >> 8);
+        payload[length++] = (uint8_t)(prov_ops[n].value >> 16);
+        payload[length++] = (uint8_t)(prov_ops[n].value >> 24);
+    }
+    uint16_t crc = crc16(payload, length, 0xFFFF);
+    payload[length++] = (uint8_t)(crc);
+    payload[length++] = (uint8_t)(crc >> 8);
+
+    size_t encoded = cobs_encode(payload, length, frame);
+    frame[encoded++] = FRAME_DELIMITER;
+    UART_TX_write((const char*)frame, encoded);
+}
+
+/*
+ * Register access through the shared TMP117 helpers, counted
+ */
+static bool Prov_read16(Prov_Target *target, uint8_t reg, uint16_t *value)
+{
+    provision_stats.transfers++;
+    return ReadReg_internal(target->handle, reg, value);
+}
+
+static bool Prov_write16(Prov_Target *target, uint8_t reg, uint16_t value)
+{
+    provision_stats.transfers++;
+    return WriteReg_internal(target->handle, reg, value);
+}
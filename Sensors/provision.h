@@ -0,0 +1,50 @@
+/*
+ * provision.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Batched TMP117 provisioning for end of line fixtures
+ *      One PROV_TYPE_BATCH frame (protocol.h) carries the serial number and
+ *      calibration operations for many sensors, one PROV_TYPE_RESULT frame
+ *      answers it. Sensors on the same bus share one EEPROM session: all
+ *      are unlocked, their writes are interleaved so each sensor programs
+ *      its EEPROM while the next one is written, then all are locked and
+ *      read back.
+ */
+
+#ifndef PROVISION_H_
+#define PROVISION_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "TMP117.h"
+#include "protocol.h"
+
+/* Stack of the provisioning thread */
+#define PROV_STACK_SIZE         2048
+
+/* Sensors that can be addressed by a batch */
+#define PROV_MAX_TARGETS        16
+
+/* Longest wait for one EEPROM write or unlock to finish */
+#define PROV_EEPROM_TIMEOUT_MS  50
+
+typedef struct Provision_Stats {
+    uint32_t batches;           // Batches executed
+    uint32_t refused;           // Batches refused as busy or malformed
+    uint32_t operations;
+    uint32_t failures;          // Operations with a status other than PROV_OK
+    uint32_t transfers;         // I2C transfers issued
+    uint32_t last_us;           // Duration of the last batch
+} Provision_Stats;
+
+extern Provision_Stats provision_stats;
+
+void Provision_init(void);
+bool Provision_addTMP(TMP_Handle *tmp_handle);
+void Provision_submit(const uint8_t *payload, size_t length);
+
+#endif /* PROVISION_H_ */
@@ -6,93 +6,81 @@
  */
 #include "myPWM.h"
 #include "utilities.h"
+#include "log.h"
 
-void *PWM_thread(void *myPWM_handle);
-void PWM_process_requests(myPWM_Handle *handle);
+void myPWM_start(void *myPWM_handle);
+void myPWM_dispatch(void *myPWM_handle, const Active_Msg *msg);
 void Set_request(myPWM_Handle *handle, uint8_t brightness);
-void Set_process(myPWM_Handle *handle);
-void Set_internal(myPWM_Handle *handle, uint8_t brightness);
+void Set_process(myPWM_Handle *handle, uint8_t brightness);
+void Set_internal(myPWM_Handle *handle, uint16_t level);
 void Blink_request(myPWM_Handle *handle, uint8_t count);
-void Blink_process(myPWM_Handle *handle);
+void Blink_process(myPWM_Handle *handle, uint8_t count);
+void Blink_step(myPWM_Handle *handle, uint16_t remaining);
 void Pulse_request(myPWM_Handle *handle, uint8_t count);
-void Pulse_process(myPWM_Handle *handle);
+void Pulse_process(myPWM_Handle *handle, uint8_t count);
+void Pulse_step(myPWM_Handle *handle, uint16_t remaining);
 void PWM_Stop_request(myPWM_Handle *handle);
 
+static pthread_once_t PWM_init_once = PTHREAD_ONCE_INIT;
+
+/* Shared by every LED */
+static const Active_Config myPWM_config = {
+    .priority = MYPWM_PRIORITY,
+    .stackSize = MYPWM_STACK_SIZE,
+    .start = myPWM_start,
+    .dispatch = myPWM_dispatch
+};
 
 /*
  * Initializes PWM thread which runs in parallel
  * to perform different operations such as blinking,
  * fading, etc..
  *
+ * Input handle storage owned by the caller (static or global), the
+ * thread keeps using it so it must outlive the LED
  * Input SysConfig PWM Name Reference (i.e. CONFIG_PWM_0)
  * Input LED Name (i.e. GREEN LED) up to 10 characters
+ * Input PWM frequency in Hz (i.e. MYPWM_DEFAULT_PERIOD_HZ)
+ * Input duty resolution, number of steps from 0% to 100% (i.e. MYPWM_DEFAULT_RESOLUTION)
  *
- * Returns NULL on error else return handle
- * Used the pointer to the handle to control the LED
+ * Returns false if the thread could not be started
+ * Use the pointer to the handle to control the LED
  */
-myPWM_Handle Open_myPWM(uint_least8_t PWM, const char LED_Name[10])
+bool Open_myPWM(myPWM_Handle *myPwm_handle, uint_least8_t PWM, const char LED_Name[10], uint32_t period_hz, uint16_t resolution)
 {
-    myPWM_Handle myPwm_handle;
-    myPwm_handle.pwm_status = PWM_Busy;
-    myPwm_handle.pwm_request = PWM_Initializing;
-
-    strcpy(myPwm_handle.LED_Name,LED_Name);
-    myPwm_handle.pwm_sysconfig = PWM;
-
-    myPwm_handle.Set = Set_request;
-    myPwm_handle.Blink = Blink_request;
-    myPwm_handle.Pulse = Pulse_request;
-    myPwm_handle.Stop = PWM_Stop_request;
-
-    myPwm_handle.fxn_details.brightness = 0;
-    myPwm_handle.fxn_details.count = 0;
+    strcpy(myPwm_handle->LED_Name,LED_Name);
+    myPwm_handle->pwm_sysconfig = PWM;
+    myPwm_handle->period_hz = period_hz ? period_hz : MYPWM_DEFAULT_PERIOD_HZ;
+    myPwm_handle->resolution = resolution ? resolution : MYPWM_DEFAULT_RESOLUTION;
+    myPwm_handle->running = false;
+    myPwm_handle->duty = 0;
+    memset(&myPwm_handle->stats, 0, sizeof(myPWM_Stats));
+    Periodic_register(&myPwm_handle->timer, myPwm_handle->LED_Name);
 
+    myPwm_handle->Set = Set_request;
+    myPwm_handle->Blink = Blink_request;
+    myPwm_handle->Pulse = Pulse_request;
+    myPwm_handle->Stop = PWM_Stop_request;
 
+    // PWM driver is shared by every LED, initialize it only once
+    pthread_once(&PWM_init_once, PWM_init);
 
-    pthread_attr_t attrs;
-    struct sched_param priParam;
-    int retc;
-
-    /* Initialize the attributes structure with default values */
-    pthread_attr_init(&attrs);
-
-    /* Set priority, detach state, and stack size attributes */
-    priParam.sched_priority = 1;
-    retc                    = pthread_attr_setschedparam(&attrs, &priParam);
-    retc |= pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
-    retc |= pthread_attr_setstacksize(&attrs, 2048);
-    if (retc != 0){
-        /* failed to set attributes */
-        while (1){}
-    }
-
-    retc = pthread_create(&(myPwm_handle.pth_handle), &attrs, PWM_thread, (void *)&(myPwm_handle));
-    if (retc != 0){
-        uart_print_string("!Error: Thread creation error!\n");
-    }
-
-    return myPwm_handle;
+    return Active_start(&myPwm_handle->active, &myPWM_config, myPwm_handle, myPwm_handle->LED_Name);
 }
 
 
 /*
- * PWM Thread
+ * Opens the PWM instance in the LED thread before the first request
  */
-void *PWM_thread(void *myPwm_handle)
+void myPWM_start(void *myPwm_handle)
 {
     myPWM_Handle *myPWM_handle = (myPWM_Handle*)myPwm_handle;
 
-    Semaphore_Params sem_params;
-    Semaphore_Params_init(&sem_params);
-    sem_params.mode = Semaphore_Mode_BINARY; // Not using events
-    myPWM_handle->sem_handle = Semaphore_create(0, &sem_params, NULL);
-
-    PWM_init();
     PWM_Params pwmParams;
     PWM_Params_init(&pwmParams);
     pwmParams.idleLevel = PWM_IDLE_LOW;      // Output low when PWM is not running
     pwmParams.periodUnits = PWM_PERIOD_HZ;   // Period is in Hz
-    pwmParams.periodValue = 1e6;             // 1MHz
+    pwmParams.periodValue = myPWM_handle->period_hz;
     pwmParams.dutyUnits = PWM_DUTY_FRACTION; // Duty is in fractional percentage
     pwmParams.dutyValue = 0;                 // 0% initial duty cycle
 
@@ -100,41 +88,38 @@ void *PWM_thread(void *myPwm_handle)
     myPWM_handle->pwm_handle = PWM_open(myPWM_handle->pwm_sysconfig, &pwmParams);
 
     if (myPWM_handle->pwm_handle == NULL) {
-        uart_print_string("!Error: PWM_open failed\n");
+        LOG1(LOG_PWM_OPEN_FAILED, myPWM_handle->pwm_sysconfig);
         while(1);
     }
-    while(1){
-        myPWM_handle->pwm_status = PWM_Ready;
-        Semaphore_pend(myPWM_handle->sem_handle, BIOS_WAIT_FOREVER);
-        myPWM_handle->pwm_status = PWM_Busy;
-        //uart_print_string("Running ");
-        //uart_print_string(myPWM_handle->LED_Name);
-        //uart_print_string(" Thread\n");
-        PWM_process_requests(myPWM_handle);
-    }
 }
 
 /*
- * Processes any PWM requests and return once complete
+ * Runs one PWM request to completion in the LED thread
  */
-void PWM_process_requests(myPWM_Handle *handle)
+void myPWM_dispatch(void *myPwm_handle, const Active_Msg *msg)
 {
-    switch(handle->pwm_request) {
+    myPWM_Handle *handle = (myPWM_Handle*)myPwm_handle;
+    LOG2(LOG_PWM_REQUEST, handle->pwm_sysconfig, msg->sig);
+
+    switch(msg->sig) {
         case PWM_Set:
-            Set_process(handle);
-            handle->pwm_request = PWM_None;
+            Set_process(handle, (uint8_t)msg->arg);
             break;
         case PWM_Blink:
-            //uart_print_string("Processing Blink...\n");
-            Blink_process(handle);
-            handle->pwm_request = PWM_None;
+            Blink_process(handle, (uint8_t)msg->arg);
             break;
         case PWM_Pulse:
-            Pulse_process(handle);
-            handle->pwm_request = PWM_None;
+            Pulse_process(handle, (uint8_t)msg->arg);
+            break;
+        case PWM_BlinkNext:
+            Periodic_record(&handle->timer);
+            Blink_step(handle, msg->arg);
+            break;
+        case PWM_PulseNext:
+            Periodic_record(&handle->timer);
+            Pulse_step(handle, msg->arg);
             break;
         default:
-            handle->pwm_request = PWM_None;
             break;
     }
 }
@@ -146,15 +131,8 @@ void PWM_process_requests(myPWM_Handle *handle)
  */
 void Set_request(myPWM_Handle *handle, uint8_t brightness)
 {
-    uint8_t n = 0;
-    while(handle->pwm_status == PWM_Busy && n<10){
-        usleep(1000); // Wait 1ms
-    } // Wait up to 10ms
-    if(handle->pwm_status == PWM_Ready){
-        handle->pwm_request = PWM_Set;
-        handle->fxn_details.brightness = brightness;
-        Semaphore_post(handle->sem_handle);
-    }
+    Active_Msg msg = {.sig = PWM_Set, .arg = brightness};
+    Active_post(&handle->active, &msg);
 }
 
 /*
@@ -162,39 +140,46 @@ void Set_request(myPWM_Handle *handle, uint8_t brightness)
  * Input 0 to 100 for 0% to 100% duty cycle
  * Updates the PWM duty cycle of the green LED
  */
-void Set_process(myPWM_Handle *handle)
+void Set_process(myPWM_Handle *handle, uint8_t brightness)
 {
-    if(!handle->fxn_details.brightness){ // if percent is zero
-        PWM_stop(handle->pwm_handle);
-        return;
-    }
-    if(handle->fxn_details.brightness > 100){
-        handle->fxn_details.brightness = 100;
+    if(brightness > 100){
+        brightness = 100;
     }
-    PWM_start(handle->pwm_handle);
-    uint32_t dutyCycle;
-    dutyCycle = (uint32_t) (((uint64_t) PWM_DUTY_FRACTION_MAX * handle->fxn_details.brightness) / 100);
-    PWM_setDuty(handle->pwm_handle, dutyCycle);
+    LOG2(LOG_PWM_LEVEL, handle->pwm_sysconfig, brightness);
+    Set_internal(handle, (uint16_t)(((uint32_t)handle->resolution * brightness) / 100));
 }
 
 /*
- * Set green LED Level
- * Input 0 to 100 for 0% to 100% duty cycle
- * Updates the PWM duty cycle of the green LED
+ * Set LED Level
+ * Input 0 to resolution for 0% to 100% duty cycle
+ * Only starts/stops the PWM on a real on/off transition
+ * and only writes the duty when it changes
  */
-void Set_internal(myPWM_Handle *handle, uint8_t brightness)
+void Set_internal(myPWM_Handle *handle, uint16_t level)
 {
-    if(!brightness){ // if percent is zero
-        PWM_stop(handle->pwm_handle);
+    if(!level){ // if level is zero
+        if(handle->running){
+            PWM_stop(handle->pwm_handle);
+            handle->stats.stops++;
+            handle->running = false;
+        }
         return;
     }
-    if(brightness > 100){
-        brightness = 100;
+    if(level > handle->resolution){
+        level = handle->resolution;
     }
-    PWM_start(handle->pwm_handle);
     uint32_t dutyCycle;
-    dutyCycle = (uint32_t) (((uint64_t) PWM_DUTY_FRACTION_MAX * brightness) / 100);
-    PWM_setDuty(handle->pwm_handle, dutyCycle);
+    dutyCycle = (uint32_t) (((uint64_t) PWM_DUTY_FRACTION_MAX * level) / handle->resolution);
+    if(dutyCycle != handle->duty){
+        PWM_setDuty(handle->pwm_handle, dutyCycle);
+        handle->stats.dutyWrites++;
+        handle->duty = dutyCycle;
+    }
+    if(!handle->running){
+        PWM_start(handle->pwm_handle);
+        handle->stats.starts++;
+        handle->running = true;
+    }
 }
 
 /*
@@ -202,30 +187,34 @@ void Set_internal(myPWM_Handle *handle, uint8_t brightness)
  */
 void Blink_request(myPWM_Handle *handle, uint8_t count)
 {
-    uint8_t n = 0;
-    while(handle->pwm_status == PWM_Busy && n<10){
-        usleep(1000); // Wait 1ms
-    } // Wait up to 10ms
-    if(handle->pwm_status == PWM_Ready){
-        handle->pwm_request = PWM_Blink;
-        handle->fxn_details.count = count;
-        Semaphore_post(handle->sem_handle);
-    }
+    Active_Msg msg = {.sig = PWM_Blink, .arg = count};
+    Active_post(&handle->active, &msg);
 }
 
 /*
  * Blink Green LED - process called inside thread
  */
-void Blink_process(myPWM_Handle *handle)
+void Blink_process(myPWM_Handle *handle, uint8_t count)
+{
+    Periodic_start(&handle->timer, 500000, PERIODIC_CATCH_UP); // 500ms
+    Blink_step(handle, (uint16_t)count * 2);
+}
+
+/*
+ * Applies one on or off half period and schedules the next one
+ * Input remaining half periods, odd is off and even is on
+ */
+void Blink_step(myPWM_Handle *handle, uint16_t remaining)
 {
-    uint8_t t = 0;
-    while(handle->fxn_details.count){
-        handle->fxn_details.count--;
-        Set_internal(handle, 100);
-        usleep(500000); // 500ms
+    if(!remaining || Active_cancelled(&handle->active)){
         Set_internal(handle, 0);
-        usleep(500000); // 500ms
+        return;
     }
+    Set_internal(handle, (remaining & 1) ? 0 : handle->resolution);
+
+    Active_Msg next = {.sig = PWM_BlinkNext, .arg = remaining - 1};
+    Periodic_next(&handle->timer);
+    Active_schedule(&handle->active, &next, handle->timer.deadline_us);
 }
 
 
@@ -234,48 +223,44 @@ void Blink_process(myPWM_Handle *handle)
  */
 void Pulse_request(myPWM_Handle *handle, uint8_t count)
 {
-    uint8_t n = 0;
-    while(handle->pwm_status == PWM_Busy && n<10){
-        usleep(1000); // Wait 1ms
-    } // Wait up to 10ms
-    if(handle->pwm_status == PWM_Ready){
-        handle->pwm_request = PWM_Pulse;
-        handle->fxn_details.count = count;
-        Semaphore_post(handle->sem_handle);
-    }
+    Active_Msg msg = {.sig = PWM_Pulse, .arg = count};
+    Active_post(&handle->active, &msg);
 }
 
 /*
  * Pulse Green LED - process called inside thread
  */
-void Pulse_process(myPWM_Handle *handle)
+void Pulse_process(myPWM_Handle *handle, uint8_t count)
 {
-    int t = 0;
-    while(handle->fxn_details.count){
-        handle->fxn_details.count--;
-        int n = 0;
-        for(n;n<=100;n++){
-            Set_internal(handle, n);
-            usleep(5000); // 5ms
-        } // 500ms rise
-        for(n = 100;n >= 0; n--){
-            Set_internal(handle, n);
-            usleep(5000); // 5ms
-        } // 500ms fall
-    }
+    Periodic_start(&handle->timer, 5000, PERIODIC_CATCH_UP); // 5ms
+    Pulse_step(handle, (uint16_t)count * 200);
 }
 
 /*
- * Stop all processes request
+ * Applies one 5ms brightness step and schedules the next one
+ * Input remaining steps, each pulse is a 100 step rise and a 100 step fall
  */
-void PWM_Stop_request(myPWM_Handle *handle)
+void Pulse_step(myPWM_Handle *handle, uint16_t remaining)
 {
-    uint8_t n = 0;
-    if(handle->pwm_status == PWM_Ready){
+    if(!remaining || Active_cancelled(&handle->active)){
+        Set_internal(handle, 0);
         return;
     }
-    else if(handle->pwm_status == PWM_Busy)
-    {
-        handle->fxn_details.count = 0;
+    uint16_t n = (200 - remaining % 200) % 200; // Step within the pulse
+    if(n > 100){
+        n = 200 - n; // Fall
     }
+    Set_internal(handle, (uint16_t)(((uint32_t)handle->resolution * n) / 100));
+
+    Active_Msg next = {.sig = PWM_PulseNext, .arg = remaining - 1};
+    Periodic_next(&handle->timer);
+    Active_schedule(&handle->active, &next, handle->timer.deadline_us);
+}
+
+/*
+ * Stop all processes request
+ */
+void PWM_Stop_request(myPWM_Handle *handle)
+{
+    Active_cancel(&handle->active);
 }
@@ -8,52 +8,62 @@
 #ifndef MYPWM_H_
 #define MYPWM_H_
 
-/* POSIX Header files */
-#include <pthread.h>
-
-/* RTOS header files */
-#include <ti/sysbios/BIOS.h>
-
 /* Drivers */
 #include <ti/drivers/PWM.h>
-#include <ti/sysbios/knl/Semaphore.h>
 #include <ti/drivers/Board.h> //Sleep header
 #include <string.h>
 
+#include "periodic.h"
+#include "active.h"
+
 typedef enum myPWM_Request {
     PWM_None,
-    PWM_Initializing,
     PWM_Set,
     PWM_Blink,
     PWM_Pulse,
-    PWM_Stop
+    PWM_BlinkNext,      // Continuations, scheduled by the LED object itself
+    PWM_PulseNext
 } myPWM_Request;
 
-typedef enum myPWM_Status {
-    PWM_Ready,
-    PWM_Busy
-} myPWM_Status;
+/* Stack of each LED thread, check the high-water mark with ThreadStats_print */
+#define MYPWM_STACK_SIZE            2048
+#define MYPWM_PRIORITY              1
+
+/* Defaults for Open_myPWM period and duty resolution */
+#define MYPWM_DEFAULT_PERIOD_HZ     1000000 // 1MHz
+#define MYPWM_DEFAULT_RESOLUTION    100     // 1% steps
 
-typedef struct myPWM_Misc {
-    uint8_t count;
-    uint8_t brightness;
-} myPWM_Misc;
+/* Driver call counters to verify the peripheral is only touched on transitions */
+typedef struct myPWM_Stats {
+    uint32_t starts;        // PWM_start calls
+    uint32_t stops;         // PWM_stop calls
+    uint32_t dutyWrites;    // PWM_setDuty calls
+} myPWM_Stats;
 
+/*
+ * Methods only queue a request and return, they may be called from a Hwi
+ * or Swi (i.e. a button callback)
+ */
 typedef struct myPWM_Handle {
     const char          LED_Name[10];
-    pthread_t           pth_handle;     // Thread Handle Generated by Open_myPWM
     uint_least8_t       pwm_sysconfig;  // PWM Name in SysConfig i.e. CONFIG_PWM_0
     PWM_Handle          pwm_handle;     // PWM Handle Generated by Open_myPWM
-    Semaphore_Handle    sem_handle;     // Semaphore Handle Generated by Open_myPWM
-    myPWM_Status        pwm_status;     // Updated with current status by thread
-    myPWM_Request       pwm_request;    // Updated with object methods
+    uint32_t            period_hz;      // PWM frequency set by Open_myPWM
+    uint16_t            resolution;     // Number of duty steps from 0% to 100%
+    bool                running;        // True while the PWM peripheral is started
+    uint32_t            duty;           // Last duty written to the peripheral
+    Active_Object       active;         // Thread and request queue started by Open_myPWM
     void (*Set)(struct myPWM_Handle*,uint8_t);   // Method to set LED brightness level 0-100%
     void (*Blink)(struct myPWM_Handle*,uint8_t); // Method to blink LED n number of times
     void (*Pulse)(struct myPWM_Handle*,uint8_t); // Method to Pulse LED n number of times
     void (*Stop)(struct myPWM_Handle*);          // Method to stop all current processes
-    myPWM_Misc          fxn_details;    // Internal register to manage tasks
+    myPWM_Stats         stats;          // Driver call counters
+    Periodic_Timer      timer;          // Step timer used by Blink and Pulse
 } myPWM_Handle;
 
-myPWM_Handle Open_myPWM(uint_least8_t PWM, const char LED_Name[10]);
+bool Open_myPWM(myPWM_Handle *myPwm_handle, uint_least8_t PWM, const char LED_Name[10], uint32_t period_hz, uint16_t resolution);
+
+/* Applies a level 0 to resolution directly, the caller must hold the LED with Active_claim */
+void Set_internal(myPWM_Handle *handle, uint16_t level);
 
 #endif /* MYPWM_H_ */
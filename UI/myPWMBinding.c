@@ -0,0 +1,234 @@
+/*
+ * myPWMBinding.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+#include "myPWMBinding.h"
+#include "utilities.h"
+
+void Binding_sample(TMP_Handle *tmp_handle, const TMP_Sample *sample, void *arg);
+void Binding_map_internal(myPWMBinding_Handle *binding, float temp, uint8_t *level);
+static bool Bind_group_internal(myPWMBinding_Handle *binding);
+static void Bind_release_internal(myPWMBinding_Handle *binding);
+static bool Bind_list_internal(myPWMBinding_Handle *binding);
+static void Bind_unlist_internal(myPWMBinding_Handle *binding);
+
+static myPWMBinding_Handle *bind_list[BIND_MAX_BINDINGS];
+
+
+/*
+ * Binds a TMP sensor to an LED or an LED group
+ * Every new sample from the sensor (ReadTemp or Monitor) updates the LED
+ *
+ * Input binding with mode and mapping filled in, must stay valid while bound
+ * Input TMP handle opened with Open_TMP
+ * Input single LED or LED group (the other one NULL)
+ *
+ * The binding claims the LED (Active_take) or the group members until
+ * Unbind_myPWM, effects running on them are stopped first. Thread context
+ *      Returns false if there is no single target, BIND_MAX_BINDINGS are
+ *      bound, the target is busy or the sensor cannot take another subscriber
+ */
+bool Bind_myPWM(myPWMBinding_Handle *binding, TMP_Handle *tmp_handle, myPWM_Handle *led, myPWMGroup_Handle *group)
+{
+    if((led == NULL) == (group == NULL)){
+        return false;
+    }
+    binding->led = led;
+    binding->group = group;
+    binding->tmp_handle = tmp_handle;
+    binding->claimed = 0;
+    memset(&binding->stats, 0, sizeof(myPWMBinding_Stats));
+    if(binding->entries > BIND_MAX_THRESHOLDS){
+        binding->entries = BIND_MAX_THRESHOLDS;
+    }
+    if(!Bind_list_internal(binding)){
+        return false;
+    }
+
+    if(led != NULL && !Active_take(&led->active, BIND_CLAIM_MS)){
+        Bind_unlist_internal(binding);
+        return false;
+    }
+    if(group != NULL && !Bind_group_internal(binding)){
+        Bind_unlist_internal(binding);
+        return false;
+    }
+    if(!TMP_Subscribe(tmp_handle, Binding_sample, binding)){
+        Bind_unlist_internal(binding);
+        Bind_release_internal(binding);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Ends a binding, the LED or group members go back to their own requests
+ * and keep their last level. Thread context
+ *      Returns false if the sensor stayed busy, the binding is still bound
+ */
+bool Unbind_myPWM(myPWMBinding_Handle *binding)
+{
+    // Binding_sample is not running anywhere once this returns
+    if(!TMP_Unsubscribe(binding->tmp_handle, Binding_sample, binding)){
+        return false;
+    }
+    Bind_unlist_internal(binding);
+    Bind_release_internal(binding);
+    return true;
+}
+
+/*
+ * Prints one line per binding, sample read to LED updated
+ *      target  samples  last us  avg us  max us
+ */
+void Binding_print(void)
+{
+    uint8_t n = 0;
+    uart_print_string("binding samples latency_us last/avg/max\n");
+    for(; n<BIND_MAX_BINDINGS; n++){
+        myPWMBinding_Handle *binding = __atomic_load_n(&bind_list[n], __ATOMIC_ACQUIRE);
+        if(binding == NULL){
+            continue;
+        }
+        myPWMBinding_Stats stats = binding->stats;
+        if(binding->group != NULL){
+            uart_print_string(binding->group->group_name);
+        }
+        else if(binding->led != NULL){
+            uart_print_string(binding->led->LED_Name);
+        }
+        uart_print_string(" ");
+        uart_print_uint32(stats.samples);
+        uart_print_string(" ");
+        uart_print_uint32(stats.lastLatency_us);
+        uart_print_string("/");
+        uart_print_uint32(stats.samples ? (uint32_t)(stats.sumLatency_us / stats.samples) : 0);
+        uart_print_string("/");
+        uart_print_uint32(stats.maxLatency_us);
+        uart_print_string("\n");
+    }
+}
+
+/*
+ * Takes the group from its thread, new group requests are refused while
+ * bound and the one running is stopped
+ *      Returns false if the group did not finish its request in BIND_CLAIM_MS
+ */
+static bool Bind_group_internal(myPWMBinding_Handle *binding)
+{
+    myPWMGroup_Handle *group = binding->group;
+
+    __atomic_store_n(&group->bound, true, __ATOMIC_RELEASE);
+    // Stops the running request, its last step gives the members back
+    if(!Active_take(&group->active, BIND_CLAIM_MS)){
+        __atomic_store_n(&group->bound, false, __ATOMIC_RELEASE);
+        return false;
+    }
+    Active_release(&group->active);
+    binding->claimed = Group_claim_internal(group);
+    return true;
+}
+
+/*
+ * Gives the LED or the group members back
+ */
+static void Bind_release_internal(myPWMBinding_Handle *binding)
+{
+    if(binding->led != NULL){
+        Active_release(&binding->led->active);
+    }
+    if(binding->group != NULL){
+        Group_release_internal(binding->group, binding->claimed);
+        binding->claimed = 0;
+        __atomic_store_n(&binding->group->bound, false, __ATOMIC_RELEASE);
+    }
+}
+
+/*
+ * Sample subscriber - called inside the TMP thread
+ * The target is claimed by the binding, no other thread writes it
+ */
+void Binding_sample(TMP_Handle *tmp_handle, const TMP_Sample *sample, void *arg)
+{
+    myPWMBinding_Handle *binding = (myPWMBinding_Handle*)arg;
+    uint8_t level[MYPWM_GROUP_MAX];
+
+    Binding_map_internal(binding, sample->temp, level);
+
+    if(binding->group != NULL){
+        memcpy(binding->group->fxn_details.level, level, binding->group->count);
+        Group_apply_internal(binding->group);
+    }
+    else if(binding->led != NULL){
+        Set_internal(binding->led, (uint16_t)(((uint32_t)binding->led->resolution * level[0]) / 100));
+    }
+
+    uint32_t latency = (uint32_t)(clock_us() - sample->timestamp_us);
+    binding->stats.samples++;
+    binding->stats.lastLatency_us = latency;
+    binding->stats.sumLatency_us += latency;
+    if(latency > binding->stats.maxLatency_us){
+        binding->stats.maxLatency_us = latency;
+    }
+}
+
+/*
+ * Maps a temperature to channel levels 0-100%
+ */
+void Binding_map_internal(myPWMBinding_Handle *binding, float temp, uint8_t *level)
+{
+    uint8_t n = 0;
+    if(binding->mode == BIND_Ramp){
+        myPWMBinding_Ramp *ramp = &binding->ramp;
+        float span = ramp->tempHigh - ramp->tempLow;
+        float t = (span > 0) ? (temp - ramp->tempLow)/span : 1;
+        if(t < 0){t = 0;}
+        if(t > 1){t = 1;}
+        for(; n<MYPWM_GROUP_MAX; n++){
+            float delta = (float)ramp->levelHigh[n] - ramp->levelLow[n];
+            level[n] = (uint8_t)(ramp->levelLow[n] + delta*t + 0.5f);
+        }
+        return;
+    }
+
+    // Threshold table, below the first entry everything is off
+    memset(level, 0, MYPWM_GROUP_MAX);
+    for(; n<binding->entries; n++){
+        if(temp < binding->table[n].temp){
+            break;
+        }
+        memcpy(level, binding->table[n].level, MYPWM_GROUP_MAX);
+    }
+}
+
+/*
+ * Adds the binding to the Binding_print list
+ *      Returns false if BIND_MAX_BINDINGS are listed
+ */
+static bool Bind_list_internal(myPWMBinding_Handle *binding)
+{
+    uint8_t n = 0;
+    for(; n<BIND_MAX_BINDINGS; n++){
+        myPWMBinding_Handle *none = NULL;
+        if(__atomic_compare_exchange_n(&bind_list[n], &none, binding, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)){
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Removes the binding from the Binding_print list
+ */
+static void Bind_unlist_internal(myPWMBinding_Handle *binding)
+{
+    uint8_t n = 0;
+    for(; n<BIND_MAX_BINDINGS; n++){
+        myPWMBinding_Handle *self = binding;
+        __atomic_compare_exchange_n(&bind_list[n], &self, NULL, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+    }
+}
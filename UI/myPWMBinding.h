@@ -0,0 +1,75 @@
+/*
+ * myPWMBinding.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#ifndef MYPWMBINDING_H_
+#define MYPWMBINDING_H_
+
+#include "myPWM.h"
+#include "myPWMGroup.h"
+#include "TMP117.h"
+
+/* Maximum number of entries in a threshold table */
+#define BIND_MAX_THRESHOLDS     8
+
+/* Bindings at once, all listed by Binding_print */
+#define BIND_MAX_BINDINGS       4
+
+/* Time given to the target to finish a stopped effect on Bind_myPWM */
+#define BIND_CLAIM_MS           20
+
+typedef enum myPWMBinding_Mode {
+    BIND_Threshold,     // Level from the highest threshold at or below the temperature
+    BIND_Ramp           // Level linearly interpolated between two temperatures
+} myPWMBinding_Mode;
+
+/*
+ * Threshold table entry
+ * Entries must be sorted by ascending temperature
+ */
+typedef struct myPWMBinding_Threshold {
+    float temp;                         // Applies at and above this temperature
+    uint8_t level[MYPWM_GROUP_MAX];     // 0-100% per channel (index 0 for a single LED)
+} myPWMBinding_Threshold;
+
+typedef struct myPWMBinding_Ramp {
+    float tempLow;                      // At and below this temperature use levelLow
+    float tempHigh;                     // At and above this temperature use levelHigh
+    uint8_t levelLow[MYPWM_GROUP_MAX];
+    uint8_t levelHigh[MYPWM_GROUP_MAX];
+} myPWMBinding_Ramp;
+
+typedef struct myPWMBinding_Stats {
+    uint32_t samples;           // Samples received from the sensor
+    uint32_t lastLatency_us;    // Sample read to LED updated
+    uint32_t maxLatency_us;
+    uint64_t sumLatency_us;     // Divide by samples for the average
+} myPWMBinding_Stats;
+
+/*
+ * Declarative binding of a TMP sample stream to an LED or LED group
+ * Fill in mode and the mapping, then call Bind_myPWM
+ * The binding is evaluated inside the TMP thread, the application
+ * does not take part once it is bound. The target is claimed until
+ * Unbind_myPWM, its own requests wait (LED) or are refused (group)
+ */
+typedef struct myPWMBinding_Handle {
+    myPWMBinding_Mode       mode;
+    myPWMBinding_Threshold  table[BIND_MAX_THRESHOLDS];
+    uint8_t                 entries;    // Number of valid threshold entries
+    myPWMBinding_Ramp       ramp;
+    myPWM_Handle            *led;       // Single LED target or NULL
+    myPWMGroup_Handle       *group;     // Group target or NULL
+    TMP_Handle              *tmp_handle; // Sensor bound by Bind_myPWM
+    uint8_t                 claimed;    // Mask of group members claimed by the binding
+    myPWMBinding_Stats      stats;
+} myPWMBinding_Handle;
+
+bool Bind_myPWM(myPWMBinding_Handle *binding, TMP_Handle *tmp_handle, myPWM_Handle *led, myPWMGroup_Handle *group);
+bool Unbind_myPWM(myPWMBinding_Handle *binding);
+void Binding_print(void);
+
+#endif /* MYPWMBINDING_H_ */
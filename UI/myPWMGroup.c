@@ -0,0 +1,456 @@
+/*
+ * myPWMGroup.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+#include "myPWMGroup.h"
+#include "utilities.h"
+#include "log.h"
+
+void Group_dispatch(void *group_handle, const Active_Msg *msg);
+void Group_apply_internal(myPWMGroup_Handle *handle);
+void Group_Set_request(myPWMGroup_Handle *handle, const uint8_t *levels);
+void Group_Set_process(myPWMGroup_Handle *handle, const uint8_t *levels);
+void Group_Fade_request(myPWMGroup_Handle *handle, const uint8_t *levels, uint16_t time_ms);
+void Group_Fade_process(myPWMGroup_Handle *handle, const uint8_t *levels, uint16_t time_ms);
+void Group_FadeHSV_request(myPWMGroup_Handle *handle, myPWM_HSV hsv, uint16_t time_ms);
+void Group_FadeHSV_process(myPWMGroup_Handle *handle, myPWM_HSV hsv, uint16_t time_ms);
+void Group_Claim_step(myPWMGroup_Handle *handle, uint8_t request);
+void Group_Fade_step(myPWMGroup_Handle *handle, bool hsv);
+void Group_Stop_request(myPWMGroup_Handle *handle);
+static void Group_start_internal(myPWMGroup_Handle *handle, uint8_t request);
+static void Group_take_internal(myPWMGroup_Handle *handle, bool cancel);
+static void Group_steps_internal(myPWMGroup_Handle *handle, uint16_t time_ms);
+
+/* Shared by every group */
+static const Active_Config Group_config = {
+    .priority = MYPWM_GROUP_PRIORITY,
+    .stackSize = MYPWM_GROUP_STACK_SIZE,
+    .start = NULL,
+    .dispatch = Group_dispatch,
+    .interleave = NULL
+};
+
+
+/*
+ * Initializes a group thread which drives several
+ * PWM channels together (i.e. the three channels of an RGB LED)
+ * so that every duty update lands in the same pass
+ *
+ * Input handle storage owned by the caller (static or global), the
+ * thread keeps using it so it must outlive the group
+ * Input array of myPWM handles opened with Open_myPWM (R, G, B order for HSV)
+ * Input number of handles up to MYPWM_GROUP_MAX
+ * Input Group Name (i.e. RGB LED) up to 10 characters
+ *
+ * Members are claimed (Active_claim) for each group request, their own
+ * requests wait until the group is done with them
+ *      Returns false if the thread could not be started
+ */
+bool Open_myPWMGroup(myPWMGroup_Handle *group_handle, myPWM_Handle *members[], uint8_t count, const char Group_Name[10])
+{
+    group_handle->bound = false;
+
+    strcpy(group_handle->group_name,Group_Name);
+    if(count > MYPWM_GROUP_MAX){
+        count = MYPWM_GROUP_MAX;
+    }
+    group_handle->count = count;
+
+    group_handle->Set = Group_Set_request;
+    group_handle->Fade = Group_Fade_request;
+    group_handle->FadeHSV = Group_FadeHSV_request;
+    group_handle->Stop = Group_Stop_request;
+
+    uint8_t n = 0;
+    for(; n<MYPWM_GROUP_MAX; n++){
+        group_handle->members[n] = (n < count) ? members[n] : NULL;
+    }
+    memset(&group_handle->fxn_details, 0, sizeof(myPWMGroup_Misc));
+    Periodic_register(&group_handle->timer, group_handle->group_name);
+
+    return Active_start(&group_handle->active, &Group_config, group_handle, group_handle->group_name);
+}
+
+
+/*
+ * Runs one group request step in the group thread
+ * While a binding owns the members new requests are refused
+ */
+void Group_dispatch(void *group_handle, const Active_Msg *msg)
+{
+    myPWMGroup_Handle *handle = (myPWMGroup_Handle*)group_handle;
+    myPWM_HSV hsv;
+
+    switch(msg->sig) {
+        case GRP_Set:
+        case GRP_Fade:
+        case GRP_FadeHSV:
+            if(__atomic_load_n(&handle->bound, __ATOMIC_ACQUIRE)){
+                return;
+            }
+            if(msg->sig == GRP_Set){
+                Group_Set_process(handle, msg->value.u8);
+            }
+            else if(msg->sig == GRP_Fade){
+                Group_Fade_process(handle, msg->value.u8, msg->arg);
+            }
+            else{
+                hsv.hue = (uint16_t)msg->value.u32;
+                hsv.saturation = (uint8_t)(msg->value.u32 >> 16);
+                hsv.value = (uint8_t)(msg->value.u32 >> 24);
+                Group_FadeHSV_process(handle, hsv, msg->arg);
+            }
+            break;
+        case GRP_ClaimNext:
+            Group_Claim_step(handle, (uint8_t)msg->arg);
+            break;
+        case GRP_FadeNext:
+            Periodic_record(&handle->timer);
+            Group_Fade_step(handle, msg->arg);
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * Claims every member not claimed yet, a Blink or Pulse running on one is
+ * stopped and its last step (LED off) runs before the claim. A member that
+ * cannot be taken keeps running its own requests and is left out
+ * Thread context, used by bindings outside the group thread
+ *      Returns the mask of members claimed by this call
+ */
+uint8_t Group_claim_internal(myPWMGroup_Handle *handle)
+{
+    uint8_t taken = 0;
+    uint8_t n = 0;
+    for(; n<handle->count; n++){
+        if(handle->fxn_details.claimed & (1 << n)){
+            continue;
+        }
+        if(Active_take(&handle->members[n]->active, MYPWM_GROUP_CLAIM_MS)){
+            taken |= 1 << n;
+        }
+        else{
+            LOG1(LOG_PWM_GROUP_BUSY, handle->members[n]->pwm_sysconfig);
+        }
+    }
+    handle->fxn_details.claimed |= taken;
+    return taken;
+}
+
+/*
+ * Gives members back to their own threads, queued requests run then
+ * Input mask of members returned by Group_claim_internal
+ */
+void Group_release_internal(myPWMGroup_Handle *handle, uint8_t members)
+{
+    uint8_t n = 0;
+    members &= handle->fxn_details.claimed;
+    handle->fxn_details.claimed &= ~members;
+    for(; n<handle->count; n++){
+        if(members & (1 << n)){
+            Active_release(&handle->members[n]->active);
+        }
+    }
+}
+
+/*
+ * Writes the current level of every claimed member back to back
+ * One pass per tick keeps the channels phase aligned
+ */
+void Group_apply_internal(myPWMGroup_Handle *handle)
+{
+    uint8_t n = 0;
+    for(; n<handle->count; n++){
+        myPWM_Handle *member = handle->members[n];
+        if(!(handle->fxn_details.claimed & (1 << n))){
+            continue;
+        }
+        Set_internal(member, (uint16_t)(((uint32_t)member->resolution * handle->fxn_details.level[n]) / 100));
+    }
+}
+
+/*
+ * Set all member levels at once
+ * Input one 0 to 100 level per member
+ */
+void Group_Set_request(myPWMGroup_Handle *handle, const uint8_t *levels)
+{
+    Active_Msg msg = {.sig = GRP_Set};
+    memcpy(msg.value.u8, levels, handle->count);
+    Active_post(&handle->active, &msg);
+}
+
+/*
+ * Set all member levels - process called inside thread
+ */
+void Group_Set_process(myPWMGroup_Handle *handle, const uint8_t *levels)
+{
+    memcpy(handle->fxn_details.target, levels, handle->count);
+    Group_start_internal(handle, GRP_Set);
+}
+
+/*
+ * Fade all member levels linearly to new levels
+ * Input one 0 to 100 level per member
+ * Input fade time in ms
+ */
+void Group_Fade_request(myPWMGroup_Handle *handle, const uint8_t *levels, uint16_t time_ms)
+{
+    Active_Msg msg = {.sig = GRP_Fade, .arg = time_ms};
+    memcpy(msg.value.u8, levels, handle->count);
+    Active_post(&handle->active, &msg);
+}
+
+/*
+ * Fade all member levels - process called inside thread
+ */
+void Group_Fade_process(myPWMGroup_Handle *handle, const uint8_t *levels, uint16_t time_ms)
+{
+    memcpy(handle->fxn_details.target, levels, handle->count);
+    Group_steps_internal(handle, time_ms);
+    Group_start_internal(handle, GRP_Fade);
+}
+
+/*
+ * Fade an RGB group to a new color through HSV space
+ * Hue takes the shortest way around the color wheel
+ * Input HSV color
+ * Input fade time in ms
+ */
+void Group_FadeHSV_request(myPWMGroup_Handle *handle, myPWM_HSV hsv, uint16_t time_ms)
+{
+    if(handle->count < 3){
+        return; // HSV needs R, G and B members
+    }
+    Active_Msg msg = {.sig = GRP_FadeHSV, .arg = time_ms,
+                      .value.u32 = hsv.hue | ((uint32_t)hsv.saturation << 16) | ((uint32_t)hsv.value << 24)};
+    Active_post(&handle->active, &msg);
+}
+
+/*
+ * Fade an RGB group through HSV - process called inside thread
+ */
+void Group_FadeHSV_process(myPWMGroup_Handle *handle, myPWM_HSV hsv, uint16_t time_ms)
+{
+    handle->fxn_details.targetHSV = hsv;
+    if(handle->fxn_details.targetHSV.hue >= 360){
+        handle->fxn_details.targetHSV.hue %= 360;
+    }
+    Group_steps_internal(handle, time_ms);
+    Group_start_internal(handle, GRP_FadeHSV);
+}
+
+/*
+ * Claims the members still missing, the request starts once all are
+ * held or MYPWM_GROUP_CLAIM_MS has passed, members still busy are left out
+ * Input request to start
+ */
+void Group_Claim_step(myPWMGroup_Handle *handle, uint8_t request)
+{
+    myPWMGroup_Misc *details = &handle->fxn_details;
+    uint8_t all = (uint8_t)((1 << handle->count) - 1);
+    uint8_t n = 0;
+
+    if(Active_cancelled(&handle->active)){
+        Group_release_internal(handle, details->claimed);
+        return;
+    }
+    Group_take_internal(handle, false);
+    if(details->claimed != all && clock_us() < details->claimDeadline_us){
+        Active_Msg next = {.sig = GRP_ClaimNext, .arg = request};
+        Active_schedule(&handle->active, &next, clock_us() + 1000); // Retry in 1ms
+        return;
+    }
+    for(; n<handle->count; n++){
+        if(!(details->claimed & (1 << n))){
+            LOG1(LOG_PWM_GROUP_BUSY, handle->members[n]->pwm_sysconfig);
+        }
+    }
+
+    switch(request) {
+        case GRP_Set:
+            memcpy(details->level, details->target, handle->count);
+            Group_apply_internal(handle);
+            Group_release_internal(handle, details->claimed);
+            break;
+        case GRP_Fade:
+            memcpy(details->start, details->level, handle->count);
+            Periodic_start(&handle->timer, MYPWM_GROUP_TICK_US, PERIODIC_CATCH_UP);
+            Group_Fade_step(handle, false);
+            break;
+        case GRP_FadeHSV:
+            details->startHSV = levels_to_HSV(details->level);
+            Periodic_start(&handle->timer, MYPWM_GROUP_TICK_US, PERIODIC_CATCH_UP);
+            Group_Fade_step(handle, true);
+            break;
+        default:
+            Group_release_internal(handle, details->claimed);
+            break;
+    }
+}
+
+/*
+ * One fade tick, schedules the next one until the fade is done or Stop
+ * The HSV color is computed once per tick and shared by all members
+ * Input true for FadeHSV
+ */
+void Group_Fade_step(myPWMGroup_Handle *handle, bool hsv)
+{
+    myPWMGroup_Misc *details = &handle->fxn_details;
+    if(Active_cancelled(&handle->active) || !details->steps){
+        Group_release_internal(handle, details->claimed); // Members keep their last level
+        return;
+    }
+    details->steps--;
+    int32_t done = details->totalSteps - details->steps;
+
+    if(hsv){
+        int32_t dHue = (int32_t)details->targetHSV.hue - details->startHSV.hue;
+        if(dHue > 180){dHue -= 360;}
+        else if(dHue < -180){dHue += 360;}
+        int32_t dSat = (int32_t)details->targetHSV.saturation - details->startHSV.saturation;
+        int32_t dVal = (int32_t)details->targetHSV.value - details->startHSV.value;
+
+        myPWM_HSV color;
+        int32_t hue = details->startHSV.hue + (dHue*done)/details->totalSteps;
+        if(hue < 0){hue += 360;}
+        else if(hue >= 360){hue -= 360;}
+        color.hue = (uint16_t)hue;
+        color.saturation = (uint8_t)(details->startHSV.saturation + (dSat*done)/details->totalSteps);
+        color.value = (uint8_t)(details->startHSV.value + (dVal*done)/details->totalSteps);
+        HSV_to_levels(color, details->level);
+    }
+    else{
+        uint8_t n = 0;
+        for(; n<handle->count; n++){
+            int32_t delta = (int32_t)details->target[n] - details->start[n];
+            details->level[n] = (uint8_t)(details->start[n] + (delta*done)/details->totalSteps);
+        }
+    }
+    Group_apply_internal(handle);
+
+    if(!details->steps){
+        Group_release_internal(handle, details->claimed);
+        return;
+    }
+    Active_Msg next = {.sig = GRP_FadeNext, .arg = hsv};
+    Periodic_next(&handle->timer);
+    Active_schedule(&handle->active, &next, handle->timer.deadline_us);
+}
+
+/*
+ * Stop the current fade, members keep their last level
+ * Requests still queued are discarded as well
+ */
+void Group_Stop_request(myPWMGroup_Handle *handle)
+{
+    Active_cancel(&handle->active);
+}
+
+
+/*
+ * Starts a request: claims the free members now, busy ones have their
+ * effect stopped and are claimed by Group_Claim_step as they finish, so
+ * on the FW_COOPERATIVE event loop the stopped effects can run their
+ * last step
+ */
+static void Group_start_internal(myPWMGroup_Handle *handle, uint8_t request)
+{
+    handle->fxn_details.claimDeadline_us = clock_us() + MYPWM_GROUP_CLAIM_MS*1000;
+    Group_take_internal(handle, true);
+    Group_Claim_step(handle, request);
+}
+
+/*
+ * One claim attempt per member not claimed yet, does not wait
+ * Input true to cancel the request of a member that is not free
+ */
+static void Group_take_internal(myPWMGroup_Handle *handle, bool cancel)
+{
+    uint8_t n = 0;
+    for(; n<handle->count; n++){
+        Active_Object *member = &handle->members[n]->active;
+        if(handle->fxn_details.claimed & (1 << n)){
+            continue;
+        }
+        if(Active_try_take(member)){
+            handle->fxn_details.claimed |= 1 << n;
+        }
+        else if(cancel){
+            Active_cancel(member);
+        }
+    }
+}
+
+/*
+ * Fade length in ticks, at least one
+ */
+static void Group_steps_internal(myPWMGroup_Handle *handle, uint16_t time_ms)
+{
+    handle->fxn_details.totalSteps = (uint16_t)(((uint32_t)time_ms*1000)/MYPWM_GROUP_TICK_US);
+    if(!handle->fxn_details.totalSteps){
+        handle->fxn_details.totalSteps = 1;
+    }
+    handle->fxn_details.steps = handle->fxn_details.totalSteps;
+}
+
+/*
+ * Converts HSV (0-359, 0-100, 0-100) to R, G, B levels 0-100%
+ * Integer only so it can run every tick
+ */
+void HSV_to_levels(myPWM_HSV hsv, uint8_t rgb[3])
+{
+    uint32_t v = hsv.value > 100 ? 100 : hsv.value;
+    uint32_t s = hsv.saturation > 100 ? 100 : hsv.saturation;
+    uint32_t region = (hsv.hue % 360) / 60;
+    uint32_t rem = (hsv.hue % 360) % 60;
+
+    uint8_t p = (uint8_t)((v * (100 - s)) / 100);
+    uint8_t q = (uint8_t)((v * (6000 - s*rem)) / 6000);
+    uint8_t t = (uint8_t)((v * (6000 - s*(60 - rem))) / 6000);
+
+    switch(region) {
+        case 0:  rgb[0] = v; rgb[1] = t; rgb[2] = p; break;
+        case 1:  rgb[0] = q; rgb[1] = v; rgb[2] = p; break;
+        case 2:  rgb[0] = p; rgb[1] = v; rgb[2] = t; break;
+        case 3:  rgb[0] = p; rgb[1] = q; rgb[2] = v; break;
+        case 4:  rgb[0] = t; rgb[1] = p; rgb[2] = v; break;
+        default: rgb[0] = v; rgb[1] = p; rgb[2] = q; break;
+    }
+}
+
+/*
+ * Converts R, G, B levels 0-100% to HSV (0-359, 0-100, 0-100)
+ */
+myPWM_HSV levels_to_HSV(const uint8_t rgb[3])
+{
+    myPWM_HSV hsv = {0, 0, 0};
+    int32_t r = rgb[0], g = rgb[1], b = rgb[2];
+    int32_t max = r > g ? (r > b ? r : b) : (g > b ? g : b);
+    int32_t min = r < g ? (r < b ? r : b) : (g < b ? g : b);
+    int32_t delta = max - min;
+    int32_t hue;
+
+    hsv.value = (uint8_t)max;
+    if(max == 0 || delta == 0){
+        return hsv; // Black or grey, hue undefined
+    }
+    hsv.saturation = (uint8_t)((delta * 100) / max);
+
+    if(max == r){
+        hue = (60 * (g - b)) / delta;
+    }
+    else if(max == g){
+        hue = 120 + (60 * (b - r)) / delta;
+    }
+    else{
+        hue = 240 + (60 * (r - g)) / delta;
+    }
+    if(hue < 0){hue += 360;}
+    hsv.hue = (uint16_t)hue;
+    return hsv;
+}
@@ -0,0 +1,88 @@
+/*
+ * myPWMGroup.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#ifndef MYPWMGROUP_H_
+#define MYPWMGROUP_H_
+
+#include <string.h>
+
+#include "myPWM.h"
+#include "periodic.h"
+
+/* Maximum number of PWM channels bound to a single group */
+#define MYPWM_GROUP_MAX         4
+
+/* Stack of each group thread */
+#define MYPWM_GROUP_STACK_SIZE  2048
+#define MYPWM_GROUP_PRIORITY    1
+
+/* Update tick of the group thread during fades */
+#define MYPWM_GROUP_TICK_US     5000
+
+/* Time given to a member to finish a stopped effect before it is left out */
+#define MYPWM_GROUP_CLAIM_MS    20
+
+typedef enum myPWMGroup_Request {
+    GRP_None,
+    GRP_Set,
+    GRP_Fade,
+    GRP_FadeHSV,
+    GRP_ClaimNext,          // Continuations, scheduled by the group itself
+    GRP_FadeNext
+} myPWMGroup_Request;
+
+/*
+ * HSV color for 3 channel groups (members ordered R, G, B)
+ *      hue 0-359 degrees, saturation and value 0-100%
+ */
+typedef struct myPWM_HSV {
+    uint16_t hue;
+    uint8_t saturation;
+    uint8_t value;
+} myPWM_HSV;
+
+typedef struct myPWMGroup_Misc {
+    uint16_t steps;                             // Remaining fade ticks
+    uint16_t totalSteps;                        // Fade length in ticks
+    uint8_t level[MYPWM_GROUP_MAX];             // Current level of each member 0-100%
+    uint8_t start[MYPWM_GROUP_MAX];             // Levels at the start of a fade
+    uint8_t target[MYPWM_GROUP_MAX];            // Requested levels
+    uint8_t claimed;                            // Mask of members taken from their threads, bit n for member n
+    uint64_t claimDeadline_us;                  // Members not claimed by then are left out of the request
+    myPWM_HSV startHSV;                         // HSV at the start of a fade
+    myPWM_HSV targetHSV;                        // Requested HSV
+} myPWMGroup_Misc;
+
+/*
+ * Methods only queue a request and return, like the myPWM_Handle methods,
+ * they may be called from a Hwi or Swi
+ */
+typedef struct myPWMGroup_Handle {
+    const char          group_name[10];
+    myPWM_Handle        *members[MYPWM_GROUP_MAX]; // Bound channels, R G B order for HSV
+    uint8_t             count;          // Number of bound channels
+    Active_Object       active;         // Thread and request queue started by Open_myPWMGroup
+    bool                bound;          // Driven by a binding, requests are refused until Unbind_myPWM
+    void (*Set)(struct myPWMGroup_Handle*,const uint8_t*);              // Method to set all member levels 0-100% at once
+    void (*Fade)(struct myPWMGroup_Handle*,const uint8_t*,uint16_t);    // Method to fade member levels over n ms
+    void (*FadeHSV)(struct myPWMGroup_Handle*,myPWM_HSV,uint16_t);      // Method to fade an RGB group through HSV over n ms
+    void (*Stop)(struct myPWMGroup_Handle*);                            // Method to stop the current fade
+    myPWMGroup_Misc     fxn_details;    // Internal register to manage tasks
+    Periodic_Timer      timer;          // Fade tick timer
+} myPWMGroup_Handle;
+
+bool Open_myPWMGroup(myPWMGroup_Handle *group_handle, myPWM_Handle *members[], uint8_t count, const char Group_Name[10]);
+
+/* Claim and write the members outside the group thread, used by bindings */
+uint8_t Group_claim_internal(myPWMGroup_Handle *handle);
+void Group_release_internal(myPWMGroup_Handle *handle, uint8_t members);
+void Group_apply_internal(myPWMGroup_Handle *handle);
+
+void HSV_to_levels(myPWM_HSV hsv, uint8_t rgb[3]);
+myPWM_HSV levels_to_HSV(const uint8_t rgb[3]);
+
+#endif /* MYPWMGROUP_H_ */
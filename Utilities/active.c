@@ -0,0 +1,654 @@
+/*
+ * active.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Queue positions run freely and wrap, a slot is indexed by position
+ * modulo ACTIVE_QUEUE_SIZE. Each slot holds the position it is waiting
+ * for: a producer may write it when seq equals the position, the object
+ * thread may read it when seq is one past. Producers reserve a position
+ * with a compare and swap on head, so several threads can post at once.
+ *
+ * The object thread, or the event loop with FW_COOPERATIVE, waits on the
+ * semaphore with a timeout set by the pending continuation.
+ */
+
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include "active.h"
+#include "utilities.h"
+#include "log.h"
+
+#define ACTIVE_MASK             (ACTIVE_QUEUE_SIZE - 1)
+#define ACTIVE_NEVER            UINT64_MAX
+
+static Active_Object *active_list[ACTIVE_MAX];
+static uint32_t active_count = 0;
+
+#ifdef FW_COOPERATIVE
+static Semaphore_Handle loop_sem = NULL;
+static Thread_Stats loop_thread_stats;
+static pthread_once_t loop_once = PTHREAD_ONCE_INIT;
+static void Active_loop_init(void);
+void *Active_loop(void *arg);
+#else
+void *Active_thread(void *active);
+#endif
+static bool Active_take_internal(Active_Object *ao, Active_Msg *msg);
+static bool Active_step_internal(Active_Object *ao);
+static void Active_fill_internal(Active_Object *ao);
+static bool Active_before_internal(const Active_Slot *a, const Active_Slot *b);
+static bool Active_pick_internal(Active_Object *ao, const Active_Msg *suspended, Active_Slot *next);
+static void Active_finish_internal(Active_Object *ao, const Active_Msg *msg);
+static uint64_t Active_due_internal(Active_Object *ao);
+static uint32_t Active_timeout_internal(uint64_t due_us);
+static void Active_report_internal(Active_Object *ao);
+
+
+/*
+ * Starts the object thread, or adds the object to the event loop
+ * Call from Open_*, messages posted before the thread runs are kept
+ *
+ * Input object storage, usually inside the handle
+ * Input driver configuration, shared by every object of the driver
+ * Input handle passed to the configuration functions
+ * Input name shown by Active_print and ThreadStats_print
+ *
+ * Returns false if the thread could not be created
+ */
+bool Active_start(Active_Object *ao, const Active_Config *config, void *owner, const char *name)
+{
+    uint32_t n = 0;
+    memset(ao, 0, sizeof(Active_Object));
+    ao->config = config;
+    ao->owner = owner;
+    ao->name = name;
+    ao->state = ACTIVE_Starting;
+    for(; n<ACTIVE_QUEUE_SIZE; n++){
+        ao->slots[n].seq = n;
+    }
+
+#ifdef FW_COOPERATIVE
+    pthread_once(&loop_once, Active_loop_init);
+    ao->sem_handle = loop_sem;
+#else
+    Semaphore_Params sem_params;
+    Semaphore_Params_init(&sem_params);
+    sem_params.mode = Semaphore_Mode_BINARY; // The thread drains the whole queue per wake
+    ao->sem_handle = Semaphore_create(0, &sem_params, NULL);
+#endif
+
+    uint32_t slot = __atomic_fetch_add(&active_count, 1, __ATOMIC_RELAXED);
+    ao->id = (uint8_t)slot;
+    if(slot < ACTIVE_MAX){
+        __atomic_store_n(&active_list[slot], ao, __ATOMIC_RELEASE);
+    }
+#ifdef FW_COOPERATIVE
+    else{
+        // The loop only runs listed objects
+        uart_print_string("!Error: ");
+        uart_print_string(name);
+        uart_print_string(" does not fit the event loop!\n");
+        return false;
+    }
+    Semaphore_post(loop_sem); // The loop runs the start function
+    return true;
+#else
+    pthread_t pth_handle;
+    pthread_attr_t attrs;
+    struct sched_param priParam;
+    int retc;
+
+    /* Initialize the attributes structure with default values */
+    pthread_attr_init(&attrs);
+
+    /* Set priority, detach state, and stack size attributes */
+    priParam.sched_priority = config->priority;
+    retc                    = pthread_attr_setschedparam(&attrs, &priParam);
+    retc |= pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
+    retc |= pthread_attr_setstacksize(&attrs, config->stackSize);
+    if (retc != 0){
+        /* failed to set attributes */
+        while (1){}
+    }
+
+    retc = pthread_create(&pth_handle, &attrs, Active_thread, (void *)ao);
+    if (retc != 0){
+        uart_print_string("!Error: ");
+        uart_print_string(name);
+        uart_print_string(" Thread creation error!\n");
+        return false;
+    }
+    return true;
+#endif
+}
+
+
+#ifdef FW_COOPERATIVE
+/*
+ * Creates the event loop thread, once for every object
+ */
+static void Active_loop_init(void)
+{
+    Semaphore_Params sem_params;
+    Semaphore_Params_init(&sem_params);
+    sem_params.mode = Semaphore_Mode_BINARY; // Every pass visits every object
+    loop_sem = Semaphore_create(0, &sem_params, NULL);
+
+    pthread_t pth_handle;
+    pthread_attr_t attrs;
+    struct sched_param priParam;
+    int retc;
+
+    /* Initialize the attributes structure with default values */
+    pthread_attr_init(&attrs);
+
+    /* Set priority, detach state, and stack size attributes */
+    priParam.sched_priority = ACTIVE_LOOP_PRIORITY;
+    retc                    = pthread_attr_setschedparam(&attrs, &priParam);
+    retc |= pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
+    retc |= pthread_attr_setstacksize(&attrs, ACTIVE_LOOP_STACK_SIZE);
+    if (retc != 0){
+        /* failed to set attributes */
+        while (1){}
+    }
+
+    retc = pthread_create(&pth_handle, &attrs, Active_loop, NULL);
+    if (retc != 0){
+        uart_print_string("!Error: Event loop thread creation error!\n");
+    }
+}
+
+/*
+ * Event Loop Thread
+ * Each pass gives every object one step, then sleeps until the next
+ * post or the earliest continuation
+ */
+void *Active_loop(void *arg)
+{
+    ThreadStats_register(&loop_thread_stats, "loop", ACTIVE_LOOP_STACK_SIZE);
+
+    while(1){
+        uint32_t count = __atomic_load_n(&active_count, __ATOMIC_RELAXED);
+        uint64_t next = ACTIVE_NEVER;
+        bool ran = false;
+        uint32_t n = 0;
+
+        if(count > ACTIVE_MAX){
+            count = ACTIVE_MAX;
+        }
+        for(; n<count; n++){
+            Active_Object *ao = __atomic_load_n(&active_list[n], __ATOMIC_ACQUIRE);
+            if(ao == NULL){
+                continue;
+            }
+            if(__atomic_load_n(&ao->state, __ATOMIC_ACQUIRE) == ACTIVE_Starting){
+                if(ao->config->start != NULL){
+                    ao->config->start(ao->owner);
+                }
+                __atomic_store_n(&ao->state, ACTIVE_Idle, __ATOMIC_RELEASE);
+            }
+            uint8_t idle = ACTIVE_Idle;
+            if(!__atomic_compare_exchange_n(&ao->state, &idle, ACTIVE_Busy, false,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)){
+                continue; // Claimed, Active_release posts the loop
+            }
+            Active_report_internal(ao);
+            ran |= Active_step_internal(ao);
+            uint64_t due = Active_due_internal(ao);
+            if(due < next){
+                next = due;
+            }
+            __atomic_store_n(&ao->state, ACTIVE_Idle, __ATOMIC_RELEASE);
+        }
+        if(ran){
+            continue;
+        }
+        ThreadStats_block(&loop_thread_stats);
+        Semaphore_pend(loop_sem, Active_timeout_internal(next));
+        ThreadStats_wake(&loop_thread_stats);
+    }
+}
+
+#else
+/*
+ * Active Object Thread
+ */
+void *Active_thread(void *active)
+{
+    Active_Object *ao = (Active_Object*)active;
+    ThreadStats_register(&ao->thread_stats, ao->name, ao->config->stackSize);
+
+    if(ao->config->start != NULL){
+        ao->config->start(ao->owner);
+    }
+    __atomic_store_n(&ao->state, ACTIVE_Idle, __ATOMIC_RELEASE);
+
+    while(1){
+        uint64_t due = ACTIVE_NEVER;
+        uint8_t idle = ACTIVE_Idle;
+        if(__atomic_compare_exchange_n(&ao->state, &idle, ACTIVE_Busy, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)){
+            Active_report_internal(ao);
+            while(Active_step_internal(ao)){}
+            due = Active_due_internal(ao);
+            __atomic_store_n(&ao->state, ACTIVE_Idle, __ATOMIC_RELEASE);
+        }
+        // Claimed objects wait for Active_release to post
+        ThreadStats_block(&ao->thread_stats);
+        Semaphore_pend(ao->sem_handle, Active_timeout_internal(due));
+        ThreadStats_wake(&ao->thread_stats);
+    }
+}
+#endif
+
+/*
+ * Dispatches the due continuation or the most urgent ready message
+ * While a continuation waits, a more urgent message may interleave
+ *      Returns false if there was nothing to run
+ */
+static bool Active_step_internal(Active_Object *ao)
+{
+    Active_Slot next;
+    bool interleave = false;
+
+    Active_fill_internal(ao);
+    if(ao->armed){
+        ao->current = ao->timerPos;
+        if(Active_cancelled(ao) || clock_us() >= ao->due_us){
+            ao->armed = false;
+            next.seq = ao->timerPos;
+            next.msg = ao->timerMsg;
+        }
+        else if(Active_pick_internal(ao, &ao->timerMsg, &next)){
+            interleave = true;
+            ao->stats.interleaved++;
+        }
+        else{
+            return false;
+        }
+    }
+    else if(!Active_pick_internal(ao, NULL, &next)){
+        return false;
+    }
+
+    uint64_t start = clock_us();
+    ao->current = next.seq;
+    ao->dispatching = &next.msg;
+    ao->scheduled = false;
+    Completion_begin(next.msg.done);
+    ao->config->dispatch(ao->owner, &next.msg);
+    ao->dispatching = NULL;
+    uint32_t elapsed = (uint32_t)(clock_us() - start);
+    if(elapsed > ao->stats.maxDispatch_us){
+        ao->stats.maxDispatch_us = elapsed;
+    }
+    ao->stats.dispatched++;
+
+    // Finished unless the handler scheduled another step
+    if(!ao->scheduled){
+        Active_finish_internal(ao, &next.msg);
+    }
+    if(interleave){
+        ao->current = ao->timerPos;
+    }
+    return true;
+}
+
+/*
+ * Moves posted messages into the ready set while it has room
+ */
+static void Active_fill_internal(Active_Object *ao)
+{
+    while(ao->readyCount < ACTIVE_READY_SIZE){
+        Active_Slot *slot = &ao->ready[ao->readyCount];
+        if(!Active_take_internal(ao, &slot->msg)){
+            return;
+        }
+        slot->seq = ao->tail - 1;
+        ao->readyCount++;
+    }
+}
+
+/*
+ * True if ready message a runs before b: higher priority, then earlier
+ * deadline, a deadline before none, then posted first
+ */
+static bool Active_before_internal(const Active_Slot *a, const Active_Slot *b)
+{
+    if(a->msg.priority != b->msg.priority){
+        return a->msg.priority > b->msg.priority;
+    }
+    if(a->msg.deadline_us != b->msg.deadline_us){
+        if(!a->msg.deadline_us || !b->msg.deadline_us){
+            return a->msg.deadline_us != 0;
+        }
+        return (int32_t)(a->msg.deadline_us - b->msg.deadline_us) < 0;
+    }
+    return (int32_t)(a->seq - b->seq) < 0;
+}
+
+/*
+ * Takes the most urgent ready message, discarding cancelled ones
+ * Input suspended continuation, only more urgent messages the driver lets
+ * interleave qualify, NULL if no request is suspended
+ *      Returns false if none qualifies
+ */
+static bool Active_pick_internal(Active_Object *ao, const Active_Msg *suspended, Active_Slot *next)
+{
+    uint32_t cancel = __atomic_load_n(&ao->cancel, __ATOMIC_ACQUIRE);
+    int best = -1;
+    uint8_t n = 0;
+
+    while(n < ao->readyCount){
+        Active_Slot *slot = &ao->ready[n];
+        if((int32_t)(slot->seq - cancel) < 0){
+            ao->stats.cancelled++;
+            Completion_finish(slot->msg.done, COMPLETION_Cancelled);
+            *slot = ao->ready[--ao->readyCount];
+            continue;
+        }
+        if(suspended == NULL ||
+           (slot->msg.priority > suspended->priority && ao->config->interleave != NULL &&
+            ao->config->interleave(ao->owner, suspended, &slot->msg))){
+            if(best < 0 || Active_before_internal(slot, &ao->ready[best])){
+                best = n;
+            }
+        }
+        n++;
+    }
+    if(best < 0){
+        return false;
+    }
+    *next = ao->ready[best];
+    ao->ready[best] = ao->ready[--ao->readyCount];
+    return true;
+}
+
+/*
+ * Closes a request: deadline statistics and its Completion
+ */
+static void Active_finish_internal(Active_Object *ao, const Active_Msg *msg)
+{
+    bool cancelled = Active_cancelled(ao);
+    if(msg->deadline_us && !cancelled){
+        int32_t late = (int32_t)((uint32_t)clock_us() - msg->deadline_us);
+        ao->stats.deadlines++;
+        if(late > 0){
+            ao->stats.missed++;
+            if((uint32_t)late > ao->stats.maxLate_us){
+                ao->stats.maxLate_us = (uint32_t)late;
+            }
+        }
+    }
+    Completion_finish(msg->done, cancelled ? COMPLETION_Cancelled : COMPLETION_Done);
+}
+
+/*
+ * Logs posts dropped since the last call, object thread only
+ * Active_post may run in an interrupt and cannot log itself
+ */
+static void Active_report_internal(Active_Object *ao)
+{
+    uint32_t dropped = __atomic_load_n(&ao->stats.dropped, __ATOMIC_RELAXED);
+    if(dropped != ao->stats.reported){
+        LOG2(LOG_ACTIVE_FULL, ao->id, dropped - ao->stats.reported);
+        ao->stats.reported = dropped;
+    }
+}
+
+/*
+ * Time the object needs to run again, ACTIVE_NEVER without a continuation
+ */
+static uint64_t Active_due_internal(Active_Object *ao)
+{
+    if(!ao->armed){
+        return ACTIVE_NEVER;
+    }
+    return Active_cancelled(ao) ? 0 : ao->due_us;
+}
+
+/*
+ * Semaphore_pend timeout in Clock ticks until due_us, rounded up
+ */
+static uint32_t Active_timeout_internal(uint64_t due_us)
+{
+    if(due_us == ACTIVE_NEVER){
+        return BIOS_WAIT_FOREVER;
+    }
+    uint64_t now = clock_us();
+    if(due_us <= now){
+        return BIOS_NO_WAIT;
+    }
+    return (uint32_t)((due_us - now + Clock_tickPeriod - 1) / Clock_tickPeriod);
+}
+
+/*
+ * Takes the next posted message, object thread only
+ *      Returns false if the queue is empty
+ */
+static bool Active_take_internal(Active_Object *ao, Active_Msg *msg)
+{
+    Active_Slot *slot = &ao->slots[ao->tail & ACTIVE_MASK];
+    if(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != ao->tail + 1){
+        return false;
+    }
+    *msg = slot->msg;
+    __atomic_store_n(&slot->seq, ao->tail + ACTIVE_QUEUE_SIZE, __ATOMIC_RELEASE);
+    __atomic_store_n(&ao->tail, ao->tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/*
+ * Queues a message for the object thread, never waits
+ * Callable from a Hwi or Swi
+ *      Returns false if the queue was full and the message dropped
+ */
+bool Active_post(Active_Object *ao, const Active_Msg *msg)
+{
+    uint32_t pos = __atomic_load_n(&ao->head, __ATOMIC_RELAXED);
+    Active_Slot *slot;
+    Completion_post(msg->done);
+    while(1){
+        slot = &ao->slots[pos & ACTIVE_MASK];
+        int32_t diff = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+        if(diff == 0){
+            if(__atomic_compare_exchange_n(&ao->head, &pos, pos + 1, true,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+                break;
+            }
+            // pos reloaded by the failed exchange
+        }
+        else if(diff < 0){
+            __atomic_fetch_add(&ao->stats.dropped, 1, __ATOMIC_RELAXED);
+            Completion_finish(msg->done, COMPLETION_Dropped);
+            Semaphore_post(ao->sem_handle); // The object thread logs the drop
+            return false;
+        }
+        else{
+            pos = __atomic_load_n(&ao->head, __ATOMIC_RELAXED);
+        }
+    }
+    slot->msg = *msg;
+    if(msg->done != NULL){
+        if(msg->done->priority > slot->msg.priority){
+            slot->msg.priority = msg->done->priority;
+        }
+        if(msg->done->deadline_us){
+            slot->msg.deadline_us = msg->done->deadline_us;
+        }
+    }
+    if(slot->msg.deadline_us){
+        slot->msg.deadline_us += (uint32_t)clock_us();
+        if(!slot->msg.deadline_us){
+            slot->msg.deadline_us = 1; // 0 means none
+        }
+    }
+    // Before publishing, the object thread cannot pass an unpublished position
+    uint32_t depth = pos + 1 - __atomic_load_n(&ao->tail, __ATOMIC_ACQUIRE);
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+
+    __atomic_fetch_add(&ao->stats.posted, 1, __ATOMIC_RELAXED);
+    uint32_t deepest = __atomic_load_n(&ao->stats.maxDepth, __ATOMIC_RELAXED);
+    while(depth > deepest && !__atomic_compare_exchange_n(&ao->stats.maxDepth, &deepest, depth, true,
+                                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED)){}
+    Semaphore_post(ao->sem_handle);
+    return true;
+}
+
+/*
+ * Schedules the next step of the request being dispatched, replaces any
+ * earlier one. The step keeps the request's Completion, priority and deadline
+ * Call from the dispatch function only
+ *
+ * Input message dispatched at the due time
+ * Input clock_us() time, i.e. Periodic_Timer deadline_us
+ */
+void Active_schedule(Active_Object *ao, const Active_Msg *msg, uint64_t due_us)
+{
+    const Active_Msg *request = ao->dispatching;
+    ao->timerMsg = *msg;
+    ao->timerMsg.done = request->done;
+    ao->timerMsg.priority = request->priority;
+    ao->timerMsg.deadline_us = request->deadline_us;
+    ao->timerPos = ao->current;
+    ao->due_us = due_us;
+    ao->armed = true;
+    ao->scheduled = true;
+}
+
+/*
+ * Discards every message posted so far, the one being dispatched included
+ * A pending continuation runs at once so the handler can finish
+ * Callable from a Hwi or Swi
+ */
+void Active_cancel(Active_Object *ao)
+{
+    __atomic_store_n(&ao->cancel, __atomic_load_n(&ao->head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    Semaphore_post(ao->sem_handle);
+}
+
+/*
+ * True once the message being dispatched was cancelled
+ * Long running handlers poll this between steps, object thread only
+ */
+bool Active_cancelled(Active_Object *ao)
+{
+    return (int32_t)(ao->current - __atomic_load_n(&ao->cancel, __ATOMIC_ACQUIRE)) < 0;
+}
+
+/*
+ * True once the object thread has run its start function
+ */
+bool Active_ready(Active_Object *ao)
+{
+    return __atomic_load_n(&ao->state, __ATOMIC_ACQUIRE) != ACTIVE_Starting;
+}
+
+/*
+ * Takes the object from another thread while it is idle
+ * Messages stay queued until Active_release
+ *      Returns false if the object is starting, busy or already claimed
+ */
+bool Active_claim(Active_Object *ao)
+{
+    uint8_t idle = ACTIVE_Idle;
+    return __atomic_compare_exchange_n(&ao->state, &idle, ACTIVE_Claimed, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+/*
+ * Claims the object for another thread that drives it for a while (i.e.
+ * a controller or a group), the request running on it is cancelled and
+ * its last step runs in the object thread before the claim
+ * Thread context only, polls every 1ms
+ *      Returns false if the object was not free within timeout_ms
+ */
+bool Active_take(Active_Object *ao, uint32_t timeout_ms)
+{
+    bool cancelled = false;
+    uint32_t n = 0;
+    for(; n<=timeout_ms; n++){
+        if(Active_try_take(ao)){
+            return true;
+        }
+        if(!cancelled){
+            Active_cancel(ao);
+            cancelled = true;
+        }
+        usleep(1000); // Wait 1ms
+    }
+    return false;
+}
+
+/*
+ * One attempt of Active_take that does not wait, for an object thread
+ * that takes another object between its own steps (i.e. a controller on
+ * the FW_COOPERATIVE event loop), the caller cancels the running request
+ *      Returns false if the object is busy, claimed or between two steps
+ */
+bool Active_try_take(Active_Object *ao)
+{
+    if(Active_claim(ao)){
+        if(!__atomic_load_n(&ao->armed, __ATOMIC_ACQUIRE)){
+            return true;
+        }
+        Active_release(ao); // Between two steps of a request
+    }
+    return false;
+}
+
+/*
+ * Gives a claimed object back and runs any messages queued meanwhile
+ */
+void Active_release(Active_Object *ao)
+{
+    __atomic_store_n(&ao->state, ACTIVE_Idle, __ATOMIC_RELEASE);
+    Semaphore_post(ao->sem_handle);
+}
+
+/*
+ * Prints one line per active object
+ *      name  posted  dispatched  dropped  cancelled  max depth  max dispatch us
+ *      interleaved  missed/deadlines  max late us
+ */
+void Active_print(void)
+{
+    uint32_t count = __atomic_load_n(&active_count, __ATOMIC_RELAXED);
+    uint32_t n = 0;
+
+    if(count > ACTIVE_MAX){
+        count = ACTIVE_MAX;
+    }
+    uart_print_string("object posted dispatched dropped cancelled maxdepth maxdispatch_us interleaved missed/deadlines maxlate_us\n");
+    for(; n<count; n++){
+        Active_Object *ao = __atomic_load_n(&active_list[n], __ATOMIC_ACQUIRE);
+        if(ao == NULL){
+            continue;
+        }
+        uart_print_string(ao->name);
+        uart_print_string(" ");
+        uart_print_uint32(ao->stats.posted);
+        uart_print_string(" ");
+        uart_print_uint32(ao->stats.dispatched);
+        uart_print_string(" ");
+        uart_print_uint32(ao->stats.dropped);
+        uart_print_string(" ");
+        uart_print_uint32(ao->stats.cancelled);
+        uart_print_string(" ");
+        uart_print_uint32(ao->stats.maxDepth);
+        uart_print_string(" ");
+        uart_print_uint32(ao->stats.maxDispatch_us);
+        uart_print_string(" ");
+        uart_print_uint32(ao->stats.interleaved);
+        uart_print_string(" ");
+        uart_print_uint32(ao->stats.missed);
+        uart_print_string("/");
+        uart_print_uint32(ao->stats.deadlines);
+        uart_print_string(" ");
+        uart_print_uint32(ao->stats.maxLate_us);
+        uart_print_string("\n");
+    }
+}
@@ -0,0 +1,182 @@
+/*
+ * active.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Active objects
+ *      The thread, queue and dispatch loop shared by every driver object.
+ *      Methods post an Active_Msg and return at once, the object thread
+ *      takes messages in order and runs the driver dispatch function to
+ *      completion for each one.
+ *
+ *      The queue is a bounded lock-free ring, posting never waits: a full
+ *      queue drops the message and counts it. Active_post, Active_cancel
+ *      and so every driver method may be called from a Hwi or Swi (i.e. a
+ *      GPIO callback). A post only retries its reservation when another
+ *      post took the same position in between, on a single core that is
+ *      an interrupt nested inside it, so the retries are bounded by the
+ *      interrupt nesting depth. Drops are logged later by the object
+ *      thread, the log is thread context only. Stop uses Active_cancel,
+ *      which discards every message posted so far including the one being
+ *      dispatched, long running handlers poll Active_cancelled.
+ *
+ *      Handlers do not sleep between steps. A handler that needs to wait
+ *      schedules a continuation with Active_schedule and returns, the next
+ *      step is dispatched at the due time. Queued messages wait until the
+ *      request has no continuation left, so requests still run one at a
+ *      time. On Active_cancel a pending continuation is dispatched at once
+ *      so the handler can finish (i.e. turn an LED off).
+ *
+ *      A message with a Completion is marked pending when posted and
+ *      finished when dispatch returns without a continuation: cancelled if
+ *      Stop caught it, else done unless the handler already failed it.
+ *      Continuations carry the token of the request that scheduled them.
+ *
+ *      Each message has a priority and optionally a deadline. The object
+ *      thread moves posted messages into a small ready set and dispatches
+ *      the most urgent: higher priority first, then the earliest deadline
+ *      (EDF), then the order of posting. Between the steps of a request
+ *      a more urgent message may run if the driver's interleave function
+ *      allows it, such messages must finish in one step. A request that
+ *      finishes after its deadline is counted as missed.
+ *
+ *      Another thread can drive an idle object directly after Active_claim
+ *      (i.e. a group writing its members), messages posted meanwhile wait
+ *      for Active_release. Active_take also stops the running request
+ *      first, for holds that outlast it (i.e. a controller).
+ *
+ *      With FW_COOPERATIVE defined every object runs on one event loop
+ *      thread instead of a thread each, the driver code is the same.
+ *
+ *      RAM: an object is 344 bytes on the target, 280 with FW_COOPERATIVE.
+ *      160 of them are the queue and the ready set, ACTIVE_QUEUE_SIZE plus
+ *      ACTIVE_READY_SIZE messages of 20 bytes with their positions. The
+ *      ready set holds copies because the ring frees its slots in order,
+ *      a smaller one narrows the window the most urgent message is picked
+ *      from. The threaded build adds the 64 byte Thread_Stats of the object
+ *      thread, small next to its stack.
+ */
+
+#ifndef ACTIVE_H_
+#define ACTIVE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <ti/sysbios/knl/Semaphore.h>
+
+#include "threadstats.h"
+#include "completion.h"
+
+/* Messages waiting per object, power of 2 */
+#define ACTIVE_QUEUE_SIZE       4
+
+/* Messages taken from the queue and waiting to be picked, per object */
+#define ACTIVE_READY_SIZE       4
+
+#define ACTIVE_PRIORITY_NORMAL  0
+#define ACTIVE_PRIORITY_HIGH    1
+#define ACTIVE_PRIORITY_URGENT  2
+
+/* Objects that can be listed by Active_print */
+#define ACTIVE_MAX              16
+
+/* Event loop thread of the FW_COOPERATIVE build, shared by every object */
+#define ACTIVE_LOOP_STACK_SIZE  2048
+#define ACTIVE_LOOP_PRIORITY    2
+
+typedef enum Active_State {
+    ACTIVE_Starting,            // Thread not running or start function not done
+    ACTIVE_Idle,
+    ACTIVE_Busy,                // Dispatching
+    ACTIVE_Claimed              // Taken by Active_claim, messages wait for Active_release
+} Active_State;
+
+/*
+ * One request, sig is the request enum of the owning driver
+ */
+typedef struct Active_Msg {
+    uint8_t sig;
+    uint8_t priority;           // ACTIVE_PRIORITY_*
+    uint16_t arg;               // Count, period or time argument
+    union {
+        uint32_t u32;
+        float f32;
+        uint8_t u8[4];
+    } value;                    // Value argument
+    uint32_t deadline_us;       // Time allowed from post to finish, 0 for none
+                                // Active_post turns it into a clock_us() deadline (low 32 bits)
+    Completion *done;           // Caller token for status and result, NULL if unused
+} Active_Msg;
+
+/*
+ * Shared by every object of one driver
+ */
+typedef struct Active_Config {
+    int priority;               // Object thread, unused with FW_COOPERATIVE
+    uint32_t stackSize;
+    void (*start)(void *owner);                         // Runs once in the object thread, may be NULL
+    void (*dispatch)(void *owner, const Active_Msg *msg);
+    bool (*interleave)(void *owner, const Active_Msg *suspended, const Active_Msg *msg); // May msg run between steps of suspended, NULL never
+} Active_Config;
+
+typedef struct Active_Slot {
+    uint32_t seq;               // Position this slot can be written or read at, in the ready set the message position
+    Active_Msg msg;
+} Active_Slot;
+
+typedef struct Active_Stats {
+    uint32_t posted;
+    uint32_t dispatched;
+    uint32_t dropped;           // Posts refused by a full queue
+    uint32_t reported;          // Drops already logged by the object thread
+    uint32_t cancelled;         // Messages discarded by Active_cancel
+    uint32_t maxDepth;          // Most messages waiting at once
+    uint32_t maxDispatch_us;    // Longest single dispatch
+    uint32_t interleaved;       // Messages run between the steps of another request
+    uint32_t deadlines;         // Requests finished with a deadline
+    uint32_t missed;            // Of those, finished after it
+    uint32_t maxLate_us;        // Latest finish past a deadline
+} Active_Stats;
+
+typedef struct Active_Object {
+    const Active_Config *config;
+    void *owner;                // Handle passed to the config functions
+    const char *name;
+    Semaphore_Handle sem_handle;
+    uint32_t head;              // Next position to post, advanced by producers
+    uint32_t tail;              // Next position to take, advanced by the object thread
+    uint32_t current;           // Position of the message being dispatched
+    uint32_t cancel;            // Messages before this position are discarded
+    uint8_t state;              // Active_State
+    uint8_t id;                 // Slot in the Active_print list
+    bool armed;                 // A continuation is scheduled
+    bool scheduled;             // The running dispatch scheduled it
+    uint32_t timerPos;          // Position of the request that scheduled it
+    uint64_t due_us;            // clock_us() time of the continuation
+    Active_Msg timerMsg;
+    const Active_Msg *dispatching;  // Message being dispatched, for the token, priority and deadline
+    Active_Slot slots[ACTIVE_QUEUE_SIZE];
+    Active_Slot ready[ACTIVE_READY_SIZE];   // Object thread only
+    uint8_t readyCount;
+    Active_Stats stats;
+#ifndef FW_COOPERATIVE
+    Thread_Stats thread_stats;
+#endif
+} Active_Object;
+
+bool Active_start(Active_Object *ao, const Active_Config *config, void *owner, const char *name);
+bool Active_post(Active_Object *ao, const Active_Msg *msg);
+void Active_schedule(Active_Object *ao, const Active_Msg *msg, uint64_t due_us);
+void Active_cancel(Active_Object *ao);
+bool Active_cancelled(Active_Object *ao);
+bool Active_ready(Active_Object *ao);
+bool Active_claim(Active_Object *ao);
+bool Active_take(Active_Object *ao, uint32_t timeout_ms);
+bool Active_try_take(Active_Object *ao);
+void Active_release(Active_Object *ao);
+void Active_print(void);
+
+#endif /* ACTIVE_H_ */
@@ -0,0 +1,98 @@
+/*
+ * adaptive.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#include <math.h>
+
+#include "adaptive.h"
+
+/* Weight of the newest prediction error in the smoothed one */
+#define ADAPTIVE_ERROR_GAIN     0.25f
+
+/*
+ * Starts over with rate->config, the first period is minPeriod so the
+ * slope is learnt at the fastest rate
+ */
+void Adaptive_start(Adaptive_Rate *rate)
+{
+    rate->period_us = rate->config.minPeriod_us;
+    rate->last = 0;
+    rate->slope = 0;
+    rate->error = 0;
+    rate->last_us = 0;
+    rate->started = false;
+    rate->stats.samples = 0;
+    rate->stats.transients = 0;
+    rate->stats.changes = 0;
+    rate->stats.elapsed_us = 0;
+    rate->stats.busTime_us = 0;
+}
+
+/*
+ * Takes a sample and chooses the period until the next one
+ *
+ * Input temperature in degC
+ * Input time the sample was taken
+ *      Returns the next period in us, between minPeriod and maxPeriod
+ */
+uint32_t Adaptive_update(Adaptive_Rate *rate, float temp, uint64_t time_us)
+{
+    const Adaptive_Config *config = &rate->config;
+    uint32_t period = rate->period_us;
+
+    rate->stats.samples++;
+    if(!rate->started || time_us <= rate->last_us){
+        rate->started = true;
+        rate->last = temp;
+        rate->last_us = time_us;
+        return period;
+    }
+
+    float dt = (float)(time_us - rate->last_us) * 1e-6f;
+    float error = fabsf(temp - (rate->last + rate->slope*dt));
+    rate->slope = (temp - rate->last) / dt;
+    rate->error += (error - rate->error) * ADAPTIVE_ERROR_GAIN;
+    rate->stats.elapsed_us += time_us - rate->last_us;
+    rate->last = temp;
+    rate->last_us = time_us;
+
+    if(error > config->transient){
+        period = config->minPeriod_us;
+        rate->stats.transients++;
+    }
+    else{
+        // Movement expected over one more period like the last
+        float expected = fabsf(rate->slope) * (float)period * 1e-6f + rate->error;
+        if(expected > config->maxStep){
+            period = (uint32_t)((float)period * (config->maxStep / expected));
+        }
+        else if(expected < config->maxStep / 2){
+            period += period / 2;
+        }
+    }
+    if(period < config->minPeriod_us){
+        period = config->minPeriod_us;
+    }
+    if(period > config->maxPeriod_us){
+        period = config->maxPeriod_us;
+    }
+    if(period != rate->period_us){
+        rate->stats.changes++;
+    }
+    rate->period_us = period;
+    return period;
+}
+
+/*
+ * Samples a fixed minPeriod would have taken over the same time
+ */
+uint32_t Adaptive_fixedSamples(const Adaptive_Rate *rate)
+{
+    if(!rate->config.minPeriod_us){
+        return rate->stats.samples;
+    }
+    return (uint32_t)(rate->stats.elapsed_us / rate->config.minPeriod_us) + 1;
+}
@@ -0,0 +1,54 @@
+/*
+ * adaptive.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Sampling period that follows the temperature
+ * No driver dependency, the host replays recorded traces with the same code
+ *
+ * After each sample the period is chosen so the temperature moves about
+ * maxStep until the next one, at the slope of the last interval plus the
+ * smoothed error of the previous predictions (noise or oscillation the
+ * slope does not explain). A sample further than transient off its
+ * prediction goes straight to minPeriod. A flat signal backs off by half
+ * a period per sample, up to maxPeriod.
+ */
+
+#ifndef ADAPTIVE_H_
+#define ADAPTIVE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct Adaptive_Config {
+    uint32_t minPeriod_us;      // Fastest, while the temperature moves
+    uint32_t maxPeriod_us;      // Slowest, while it is flat
+    float maxStep;              // degC the temperature should move between samples
+    float transient;            // degC off the prediction that jumps to minPeriod
+} Adaptive_Config;
+
+typedef struct Adaptive_Stats {
+    uint32_t samples;
+    uint32_t transients;        // Jumps to minPeriod
+    uint32_t changes;           // Samples after which the period changed
+    uint64_t elapsed_us;        // From the first sample to the last
+    uint64_t busTime_us;        // Bus time of the samples, added by the driver
+} Adaptive_Stats;
+
+typedef struct Adaptive_Rate {
+    Adaptive_Config config;
+    uint32_t period_us;         // Until the next sample
+    float last;                 // Last sample, degC
+    float slope;                // Over the last interval, degC/s
+    float error;                // Smoothed prediction error, degC
+    uint64_t last_us;
+    bool started;
+    Adaptive_Stats stats;
+} Adaptive_Rate;
+
+void Adaptive_start(Adaptive_Rate *rate);
+uint32_t Adaptive_update(Adaptive_Rate *rate, float temp, uint64_t time_us);
+uint32_t Adaptive_fixedSamples(const Adaptive_Rate *rate);
+
+#endif /* ADAPTIVE_H_ */
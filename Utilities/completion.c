@@ -0,0 +1,116 @@
+/*
+ * completion.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * The status is the only field shared without a lock: the object thread
+ * writes the result and timestamps, then stores the final status with
+ * release order, so a caller that sees it finished also sees the result.
+ */
+
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include "completion.h"
+#include "threadstats.h"
+#include "utilities.h"
+
+/*
+ * Prepares a token, call once before its first request
+ *
+ * Input callback run in the object thread when a request finishes, may be NULL
+ * Input argument passed to the callback
+ */
+void Completion_init(Completion *done, Completion_Fxn fxn, void *arg)
+{
+    memset(done, 0, sizeof(Completion));
+    done->fxn = fxn;
+    done->arg = arg;
+
+    Semaphore_Params sem_params;
+    Semaphore_Params_init(&sem_params);
+    sem_params.mode = Semaphore_Mode_BINARY;
+    done->sem_handle = Semaphore_create(0, &sem_params, NULL);
+}
+
+/*
+ * Marks the token pending, called by Active_post before queuing
+ */
+void Completion_post(Completion *done)
+{
+    if(done == NULL){
+        return;
+    }
+    while(Semaphore_pend(done->sem_handle, BIOS_NO_WAIT)){} // Post left by the last request
+    done->started_us = 0;
+    done->done_us = 0;
+    done->posted_us = clock_us();
+    __atomic_store_n(&done->status, COMPLETION_Pending, __ATOMIC_RELEASE);
+}
+
+/*
+ * Stamps the first dispatch of the request, object thread only
+ */
+void Completion_begin(Completion *done)
+{
+    if(done == NULL || done->started_us){
+        return;
+    }
+    done->started_us = clock_us();
+}
+
+/*
+ * Finishes a pending token, wakes the waiter and runs the callback
+ * Set the result first
+ *      Returns false if the token was not pending (already finished)
+ */
+bool Completion_finish(Completion *done, Completion_Status status)
+{
+    if(done == NULL || __atomic_load_n(&done->status, __ATOMIC_ACQUIRE) != COMPLETION_Pending){
+        return false;
+    }
+    done->done_us = clock_us();
+    __atomic_store_n(&done->status, status, __ATOMIC_RELEASE);
+    Semaphore_post(done->sem_handle);
+    if(done->fxn != NULL){
+        done->fxn(done, done->arg);
+    }
+    return true;
+}
+
+/*
+ * Current status, never waits
+ */
+Completion_Status Completion_poll(Completion *done)
+{
+    return (Completion_Status)__atomic_load_n(&done->status, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Blocks until the request finishes or the timeout expires
+ * Input timeout in us, 0 polls, COMPLETION_WAIT_FOREVER never expires
+ *      Returns the status, COMPLETION_Pending on timeout
+ */
+Completion_Status Completion_wait(Completion *done, uint32_t timeout_us)
+{
+    uint64_t deadline = clock_us() + timeout_us;
+    Completion_Status status = Completion_poll(done);
+    Thread_Stats *self = ThreadStats_self();
+
+    while(status == COMPLETION_Pending){
+        uint32_t timeout = BIOS_WAIT_FOREVER;
+        if(timeout_us != COMPLETION_WAIT_FOREVER){
+            uint64_t now = clock_us();
+            if(now >= deadline){
+                break;
+            }
+            timeout = (uint32_t)((deadline - now + Clock_tickPeriod - 1) / Clock_tickPeriod);
+        }
+        ThreadStats_block(self);
+        Semaphore_pend(done->sem_handle, timeout);
+        ThreadStats_wake(self);
+        status = Completion_poll(done);
+    }
+    return status;
+}
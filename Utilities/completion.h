@@ -0,0 +1,67 @@
+/*
+ * completion.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Request completion tokens
+ *      The caller owns a Completion and passes it with a request. The
+ *      object marks it pending when posted, stamps it when the request
+ *      starts and finishes it with a status and the result. The caller
+ *      can poll it, block on it with a timeout, or give it a callback
+ *      which runs when the request finishes: in the object thread, or in
+ *      the posting thread if a full queue dropped the request.
+ *
+ *      A token carries one request at a time, do not post it again while
+ *      it is pending. Tokens may be posted from a Hwi or Swi, the callback
+ *      of a dropped request then runs in that interrupt.
+ */
+
+#ifndef COMPLETION_H_
+#define COMPLETION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ti/sysbios/knl/Semaphore.h>
+
+/* Completion_wait timeout that never expires */
+#define COMPLETION_WAIT_FOREVER     UINT32_MAX
+
+typedef enum Completion_Status {
+    COMPLETION_Idle,            // Never posted
+    COMPLETION_Pending,         // Queued or running
+    COMPLETION_Done,            // Finished, result is valid
+    COMPLETION_Failed,          // Finished with a bus or verify error
+    COMPLETION_Dropped,         // Refused by a full queue, never ran
+    COMPLETION_Cancelled        // Discarded or ended by Stop
+} Completion_Status;
+
+struct Completion;
+typedef void (*Completion_Fxn)(struct Completion*, void*);
+
+typedef struct Completion {
+    uint8_t status;             // Completion_Status
+    union {
+        uint32_t u32;
+        float f32;
+        uint16_t u16;
+        bool b;
+    } result;                   // Written by the request before it finishes
+    uint64_t posted_us;         // clock_us() times
+    uint64_t started_us;        // 0 if it never ran
+    uint64_t done_us;
+    uint8_t priority;           // Request options read when posted: raises the driver's priority
+    uint32_t deadline_us;       // and replaces its deadline, 0 keeps the default
+    Completion_Fxn fxn;         // Called from the object thread when finished, may be NULL
+    void *arg;
+    Semaphore_Handle sem_handle;
+} Completion;
+
+void Completion_init(Completion *done, Completion_Fxn fxn, void *arg);
+void Completion_post(Completion *done);
+void Completion_begin(Completion *done);
+bool Completion_finish(Completion *done, Completion_Status status);
+Completion_Status Completion_poll(Completion *done);
+Completion_Status Completion_wait(Completion *done, uint32_t timeout_us);
+
+#endif /* COMPLETION_H_ */
@@ -0,0 +1,27 @@
+/*
+ * framing.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * COBS framing and CRC-16 shared by the firmware and the host tools
+ * No driver dependency
+ */
+
+#ifndef FRAMING_H_
+#define FRAMING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Frame delimiter on the wire, COBS removes it from the payload */
+#define FRAME_DELIMITER         0x00
+
+/* Worst case COBS output for n payload bytes, delimiter not included */
+#define COBS_MAX_ENCODED(n)     ((n) + ((n) / 254) + 1)
+
+uint16_t crc16(const uint8_t *data, size_t length, uint16_t crc);
+size_t cobs_encode(const uint8_t *input, size_t length, uint8_t *output);
+size_t cobs_decode(const uint8_t *input, size_t length, uint8_t *output);
+
+#endif /* FRAMING_H_ */
@@ -0,0 +1,288 @@
+/*
+ * histcodec.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#include <string.h>
+
+#include "histcodec.h"
+#include "framing.h"
+#include "protocol.h"
+
+#define HIST_TAG_SENSOR_MASK    0x3F
+#define HIST_TAG_SENSOR_ESCAPE  0x3F    // Sensor ID as a varint after the tag
+#define HIST_TAG_GAP            0x40
+#define HIST_TAG_BOOT           0x80
+
+static int HistCodec_walk_internal(const uint8_t *payload, size_t length, HistCodec_Fxn fxn, void *arg);
+static uint32_t HistCodec_predict_internal(const HistCodec *codec, const HistCodec_Slot *slot);
+static void HistCodec_update_internal(HistCodec *codec, const SampleLog_Record *record, bool first);
+static size_t HistCodec_put_internal(uint8_t *out, uint32_t value);
+static bool HistCodec_get_internal(const uint8_t *in, size_t length, size_t *offset, uint32_t *value);
+
+static uint32_t zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/*
+ * Starts a HIST_TYPE_BLOCK payload
+ *
+ * Input payload buffer, HIST_BLOCK_MAX bytes fill a block
+ * Input capacity of the buffer, the CRC included
+ * Input request ID echoed to the host
+ */
+void HistCodec_begin(HistCodec *codec, uint8_t *payload, size_t capacity, uint16_t requestId)
+{
+    memset(codec, 0, sizeof(HistCodec));
+    codec->payload = payload;
+    codec->capacity = capacity - TLM_CRC_SIZE;
+    payload[0] = HIST_TYPE_BLOCK;
+    payload[1] = (uint8_t)(requestId);
+    payload[2] = (uint8_t)(requestId >> 8);
+    payload[3] = 0;
+    codec->length = 4;
+}
+
+/*
+ * Appends a record to the block
+ *      Returns false if the block is full, the record is left for the next one
+ */
+bool HistCodec_add(HistCodec *codec, const SampleLog_Record *record)
+{
+    uint8_t *out = &codec->payload[codec->length];
+
+    if(codec->count == 255){
+        return false;
+    }
+    if(codec->count == 0){
+        if(codec->length + HIST_BLOCK_HEADER_SIZE - 4 > codec->capacity){
+            return false;
+        }
+        out[0] = (uint8_t)(record->index);
+        out[1] = (uint8_t)(record->index >> 8);
+        out[2] = (uint8_t)(record->index >> 16);
+        out[3] = (uint8_t)(record->index >> 24);
+        out[4] = (uint8_t)(record->boot);
+        out[5] = (uint8_t)(record->boot >> 8);
+        out[6] = (uint8_t)(record->time_ms);
+        out[7] = (uint8_t)(record->time_ms >> 8);
+        out[8] = (uint8_t)(record->time_ms >> 16);
+        out[9] = (uint8_t)(record->time_ms >> 24);
+        out[10] = record->sensorId;
+        out[11] = (uint8_t)(record->raw);
+        out[12] = (uint8_t)((uint16_t)record->raw >> 8);
+        codec->length += HIST_BLOCK_HEADER_SIZE - 4;
+        HistCodec_update_internal(codec, record, true);
+    }
+    else{
+        uint8_t encoded[HIST_RECORD_MAX];
+        size_t length = 1;
+        HistCodec_Slot *slot = &codec->slots[record->sensorId % HIST_SLOTS];
+        uint8_t tag = (record->sensorId < HIST_TAG_SENSOR_ESCAPE) ? record->sensorId : HIST_TAG_SENSOR_ESCAPE;
+        if(tag == HIST_TAG_SENSOR_ESCAPE){
+            length += HistCodec_put_internal(&encoded[length], record->sensorId);
+        }
+        if(record->index != codec->last.index + 1){
+            tag |= HIST_TAG_GAP;
+            length += HistCodec_put_internal(&encoded[length], record->index - codec->last.index - 2);
+        }
+        if(record->boot != codec->last.boot){
+            // Clock restarted, time is absolute
+            tag |= HIST_TAG_BOOT;
+            length += HistCodec_put_internal(&encoded[length], record->boot);
+            length += HistCodec_put_internal(&encoded[length], record->time_ms);
+        }
+        else{
+            uint32_t predicted = HistCodec_predict_internal(codec, slot);
+            length += HistCodec_put_internal(&encoded[length], zigzag((int32_t)(record->time_ms - predicted)));
+        }
+        length += HistCodec_put_internal(&encoded[length], zigzag((int32_t)record->raw - slot->raw));
+        encoded[0] = tag;
+
+        if(codec->length + length > codec->capacity){
+            return false;
+        }
+        memcpy(out, encoded, length);
+        codec->length += length;
+        HistCodec_update_internal(codec, record, false);
+    }
+    codec->count++;
+    codec->payload[3] = codec->count;
+    return true;
+}
+
+/*
+ * Closes the block with its CRC
+ *      Returns the payload length, ready for cobs_encode
+ */
+size_t HistCodec_finish(HistCodec *codec)
+{
+    uint16_t crc = crc16(codec->payload, codec->length, 0xFFFF);
+    codec->payload[codec->length++] = (uint8_t)(crc);
+    codec->payload[codec->length++] = (uint8_t)(crc >> 8);
+    return codec->length;
+}
+
+/*
+ * Expands a HIST_TYPE_BLOCK payload (CRC already checked and removed)
+ * The block is checked whole before the first callback
+ *
+ * Input callback for every record in order, index, time, boot, raw and sensorId set
+ *      Returns the number of records, -1 if the block is malformed
+ */
+int HistCodec_decode(const uint8_t *payload, size_t length, HistCodec_Fxn fxn, void *arg)
+{
+    if(HistCodec_walk_internal(payload, length, NULL, NULL) < 0){
+        return -1;
+    }
+    return HistCodec_walk_internal(payload, length, fxn, arg);
+}
+
+/*
+ * Decodes a block, fxn may be NULL to only check it
+ */
+static int HistCodec_walk_internal(const uint8_t *payload, size_t length, HistCodec_Fxn fxn, void *arg)
+{
+    HistCodec codec;
+    SampleLog_Record record;
+    size_t offset = HIST_BLOCK_HEADER_SIZE;
+    uint32_t value;
+    uint8_t n = 1;
+
+    if(length < HIST_BLOCK_HEADER_SIZE || payload[0] != HIST_TYPE_BLOCK || payload[3] == 0){
+        return -1;
+    }
+    uint8_t count = payload[3];
+    memset(&codec, 0, sizeof(HistCodec));
+    memset(&record, 0, sizeof(SampleLog_Record));
+    record.index = (uint32_t)payload[4] | ((uint32_t)payload[5] << 8) |
+                   ((uint32_t)payload[6] << 16) | ((uint32_t)payload[7] << 24);
+    record.boot = (uint16_t)(payload[8] | (payload[9] << 8));
+    record.time_ms = (uint32_t)payload[10] | ((uint32_t)payload[11] << 8) |
+                     ((uint32_t)payload[12] << 16) | ((uint32_t)payload[13] << 24);
+    record.sensorId = payload[14];
+    record.raw = (int16_t)(payload[15] | (payload[16] << 8));
+    HistCodec_update_internal(&codec, &record, true);
+    if(fxn != NULL){
+        fxn(&record, arg);
+    }
+
+    for(; n<count; n++){
+        if(offset >= length){
+            return -1;
+        }
+        uint8_t tag = payload[offset++];
+
+        record.sensorId = tag & HIST_TAG_SENSOR_MASK;
+        if(record.sensorId == HIST_TAG_SENSOR_ESCAPE){
+            if(!HistCodec_get_internal(payload, length, &offset, &value)){
+                return -1;
+            }
+            record.sensorId = (uint8_t)value;
+        }
+        HistCodec_Slot *slot = &codec.slots[record.sensorId % HIST_SLOTS];
+        value = 0;
+        if((tag & HIST_TAG_GAP) && !HistCodec_get_internal(payload, length, &offset, &value)){
+            return -1;
+        }
+        record.index += (tag & HIST_TAG_GAP) ? value + 2 : 1;
+        if(tag & HIST_TAG_BOOT){
+            if(!HistCodec_get_internal(payload, length, &offset, &value)){
+                return -1;
+            }
+            record.boot = (uint16_t)value;
+            if(!HistCodec_get_internal(payload, length, &offset, &record.time_ms)){
+                return -1;
+            }
+        }
+        else{
+            if(!HistCodec_get_internal(payload, length, &offset, &value)){
+                return -1;
+            }
+            record.time_ms = HistCodec_predict_internal(&codec, slot) + (uint32_t)unzigzag(value);
+        }
+        if(!HistCodec_get_internal(payload, length, &offset, &value)){
+            return -1;
+        }
+        record.raw = (int16_t)(slot->raw + unzigzag(value));
+        HistCodec_update_internal(&codec, &record, false);
+        if(fxn != NULL){
+            fxn(&record, arg);
+        }
+    }
+    return (offset == length) ? count : -1;
+}
+
+/*
+ * Time of the next record of a sensor, one interval after its last record,
+ * or the time of the record before when its interval is not known yet
+ */
+static uint32_t HistCodec_predict_internal(const HistCodec *codec, const HistCodec_Slot *slot)
+{
+    return slot->seen ? slot->time_ms + (uint32_t)slot->step : codec->last.time_ms;
+}
+
+/*
+ * Takes a record as the base of the next predictions, encoder and decoder alike
+ */
+static void HistCodec_update_internal(HistCodec *codec, const SampleLog_Record *record, bool first)
+{
+    HistCodec_Slot *slot = &codec->slots[record->sensorId % HIST_SLOTS];
+    uint8_t n = 0;
+
+    if(first){
+        // Every sensor starts from the raw value of the block's first record
+        for(; n<HIST_SLOTS; n++){
+            codec->slots[n].raw = record->raw;
+        }
+    }
+    else if(record->boot != codec->last.boot){
+        for(; n<HIST_SLOTS; n++){
+            codec->slots[n].seen = false;   // Clock restarted
+        }
+    }
+    slot->step = slot->seen ? (int32_t)(record->time_ms - slot->time_ms) : 0;
+    slot->time_ms = record->time_ms;
+    slot->raw = record->raw;
+    slot->seen = true;
+    codec->last = *record;
+}
+
+/*
+ * Unsigned LEB128, 7 bits per byte with the top bit set on all but the last
+ *      Returns the bytes written, 5 at most
+ */
+static size_t HistCodec_put_internal(uint8_t *out, uint32_t value)
+{
+    size_t length = 0;
+    while(value >= 0x80){
+        out[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (uint8_t)value;
+    return length;
+}
+
+static bool HistCodec_get_internal(const uint8_t *in, size_t length, size_t *offset, uint32_t *value)
+{
+    uint32_t result = 0;
+    uint8_t shift = 0;
+    while(*offset < length && shift < 35){
+        uint8_t byte = in[(*offset)++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80)){
+            *value = result;
+            return true;
+        }
+        shift += 7;
+    }
+    return false;
+}
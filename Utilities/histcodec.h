@@ -0,0 +1,57 @@
+/*
+ * histcodec.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Compact blocks of sample log records for the history download
+ * No driver dependency, the host tools use the same code
+ *
+ * A block carries its first record in full and every following record as
+ * differences: index and boot only when they do not simply continue, time
+ * as the change of the sensor's own sampling interval and the raw value as
+ * the change since the last sample of the same sensor. Small
+ * differences become one byte each as zig-zag varints, so a steadily
+ * sampled probe costs about 3 bytes per record. Blocks never depend on
+ * each other, a download can resume at any block. The layout is in
+ * protocol.h (HIST_TYPE_BLOCK).
+ */
+
+#ifndef HISTCODEC_H_
+#define HISTCODEC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "samplelog.h"
+
+/* Sensors predicted separately, by sensor ID modulo */
+#define HIST_SLOTS              8
+
+/* What the next record of a sensor is predicted from */
+typedef struct HistCodec_Slot {
+    uint32_t time_ms;           // Its last record
+    int32_t step;               // Interval before that, ms
+    int16_t raw;
+    bool seen;                  // Time and step valid in this block and boot
+} HistCodec_Slot;
+
+typedef struct HistCodec {
+    uint8_t *payload;
+    size_t length;              // Bytes encoded so far
+    size_t capacity;            // Room for the payload without the CRC
+    uint8_t count;
+    SampleLog_Record last;      // Record encoded last
+    HistCodec_Slot slots[HIST_SLOTS];
+} HistCodec;
+
+/* Called for every record of a decoded block */
+typedef void (*HistCodec_Fxn)(const SampleLog_Record *record, void *arg);
+
+void HistCodec_begin(HistCodec *codec, uint8_t *payload, size_t capacity, uint16_t requestId);
+bool HistCodec_add(HistCodec *codec, const SampleLog_Record *record);
+size_t HistCodec_finish(HistCodec *codec);
+int HistCodec_decode(const uint8_t *payload, size_t length, HistCodec_Fxn fxn, void *arg);
+
+#endif /* HISTCODEC_H_ */
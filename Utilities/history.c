@@ -0,0 +1,402 @@
+/*
+ * history.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Each source ring has a single producer, the thread of its sensor, and a
+ * single consumer, the history thread, so staging a sample takes no lock.
+ * The history thread owns history_log, nothing else touches the flash.
+ * Downloads are read by the same thread between appends, so a cursor
+ * always sees a consistent log.
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+#include <ti/drivers/NVS.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Semaphore.h>
+
+#include "history.h"
+#include "histcodec.h"
+#include "framing.h"
+#include "protocol.h"
+#include "threadstats.h"
+#include "uart_tx.h"
+#include "utilities.h"
+
+#define HISTORY_RING_MASK       (HISTORY_RING_SIZE - 1)
+
+/* Download in progress, history thread only */
+typedef struct History_Export {
+    SampleLog_Cursor cursor;    // Next record to send
+    bool active;
+    uint16_t requestId;
+    uint32_t remaining;         // Records left to send
+    uint32_t next;              // Index after the last record sent
+    uint32_t sent;
+    uint32_t errors;            // Log read errors when the download started
+} History_Export;
+
+SampleLog history_log;
+History_Stats history_stats;
+
+static NVS_Handle history_nvs;
+static History_Source *history_sources[HISTORY_MAX_SOURCES];
+static uint32_t history_count = 0;
+static Semaphore_Handle history_sem;
+static Thread_Stats history_thread_stats;
+static uint8_t history_request[HIST_REQUEST_SIZE];
+static bool history_requested = false;
+static History_Export history_export;
+static uint8_t history_block[HIST_BLOCK_MAX];
+static uint8_t history_frame[COBS_MAX_ENCODED(HIST_BLOCK_MAX) + 1];
+
+void *History_thread(void *arg);
+void History_sample(TMP_Handle *tmp_handle, const TMP_Sample *sample, void *arg);
+static uint32_t History_drain_internal(History_Source *source);
+static void History_start_internal(void);
+static void History_export_internal(void);
+static bool History_end_internal(uint16_t requestId, uint8_t status, uint32_t next, uint32_t sent);
+static bool History_read_internal(void *device, uint32_t offset, void *buffer, size_t length);
+static bool History_write_internal(void *device, uint32_t offset, const void *buffer, size_t length);
+static bool History_erase_internal(void *device, uint32_t offset, size_t length);
+
+
+/*
+ * Opens the NVS region, recovers the log and starts the history thread
+ * Recovery reads every sector header plus a binary search of the newest
+ * sector, it runs in the caller's thread
+ *
+ * Input SysConfig NVS index (i.e. CONFIG_NVS_HISTORY), a region of whole sectors
+ *      Returns false if the region cannot be opened or holds fewer than two sectors
+ */
+bool History_init(uint_least8_t nvsIndex)
+{
+    NVS_Params nvs_params;
+    NVS_Attrs attrs;
+    SampleLog_Flash flash;
+
+    memset(&history_stats, 0, sizeof(History_Stats));
+    NVS_init();
+    NVS_Params_init(&nvs_params);
+    history_nvs = NVS_open(nvsIndex, &nvs_params);
+    if(history_nvs == NULL){
+        uart_print_string("!Error: History NVS region not opened!\n");
+        return false;
+    }
+    NVS_getAttrs(history_nvs, &attrs);
+
+    flash.read = History_read_internal;
+    flash.write = History_write_internal;
+    flash.erase = History_erase_internal;
+    flash.device = history_nvs;
+    flash.sectorSize = attrs.sectorSize;
+    flash.sectors = attrs.regionSize / attrs.sectorSize;
+    if(!SampleLog_open(&history_log, &flash)){
+        uart_print_string("!Error: History log not opened!\n");
+        return false;
+    }
+
+    Semaphore_Params sem_params;
+    Semaphore_Params_init(&sem_params);
+    sem_params.mode = Semaphore_Mode_BINARY;
+    history_sem = Semaphore_create(0, &sem_params, NULL);
+
+    pthread_t pth_handle;
+    pthread_attr_t attrs_thread;
+    struct sched_param priParam;
+    int retc;
+
+    /* Initialize the attributes structure with default values */
+    pthread_attr_init(&attrs_thread);
+
+    /* Set priority, detach state, and stack size attributes */
+    priParam.sched_priority = 1;
+    retc                    = pthread_attr_setschedparam(&attrs_thread, &priParam);
+    retc |= pthread_attr_setdetachstate(&attrs_thread, PTHREAD_CREATE_DETACHED);
+    retc |= pthread_attr_setstacksize(&attrs_thread, HISTORY_STACK_SIZE);
+    if (retc != 0){
+        /* failed to set attributes */
+        while (1){}
+    }
+
+    retc = pthread_create(&pth_handle, &attrs_thread, History_thread, NULL);
+    if (retc != 0){
+        uart_print_string("!Error: History thread creation error!\n");
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Logs every sample of a TMP sensor
+ * Samples come from ReadTemp, Monitor or a controller reading the sensor
+ *
+ * Input source storage, must stay valid while logging
+ * Input TMP handle opened with Open_TMP
+ * Input sensor ID stored with every sample
+ *      Returns false if the source table is full or the sensor cannot take another subscriber
+ */
+bool History_addTMP(History_Source *source, TMP_Handle *tmp_handle, uint8_t sensorId)
+{
+    if(history_count >= HISTORY_MAX_SOURCES){
+        return false;
+    }
+    memset(source, 0, sizeof(History_Source));
+    source->sensorId = sensorId;
+    source->enabled = true;
+    if(!TMP_Subscribe(tmp_handle, History_sample, source)){
+        return false;
+    }
+    __atomic_store_n(&history_sources[history_count], source, __ATOMIC_RELEASE);
+    __atomic_store_n(&history_count, history_count + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/*
+ * Sample subscriber - called inside the TMP thread, never waits
+ */
+void History_sample(TMP_Handle *tmp_handle, const TMP_Sample *sample, void *arg)
+{
+    (void)tmp_handle;
+    History_Source *source = (History_Source*)arg;
+    if(!source->enabled){
+        return;
+    }
+    uint32_t head = source->head;
+    uint32_t level = head - __atomic_load_n(&source->tail, __ATOMIC_ACQUIRE);
+    if(level >= HISTORY_RING_SIZE){
+        __atomic_fetch_add(&history_stats.dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    SampleLog_Record *record = &source->records[head & HISTORY_RING_MASK];
+    record->time_ms = (uint32_t)(sample->timestamp_us / 1000);
+    record->raw = sample->raw;
+    record->sensorId = source->sensorId;
+    __atomic_store_n(&source->head, head + 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&history_stats.staged, 1, __ATOMIC_RELAXED);
+    if(level + 1 > history_stats.maxLevel){
+        history_stats.maxLevel = level + 1;
+    }
+    Semaphore_post(history_sem);
+}
+
+/*
+ * Takes a HIST_TYPE_REQUEST payload (CRC already checked and removed)
+ * The download is started by the history thread, a request that arrives
+ * before the previous one was taken is answered with HIST_ERR_BUSY
+ * (i.e. Shell_addFrame(HIST_TYPE_REQUEST, History_submit))
+ */
+void History_submit(const uint8_t *payload, size_t length)
+{
+    uint16_t requestId = length >= 3 ? (uint16_t)(payload[1] | (payload[2] << 8)) : 0;
+    if(length != HIST_REQUEST_SIZE - TLM_CRC_SIZE){
+        history_stats.refused++;
+        History_end_internal(requestId, HIST_ERR_INVALID, 0, 0);
+        return;
+    }
+    if(__atomic_load_n(&history_requested, __ATOMIC_ACQUIRE)){
+        history_stats.refused++;
+        History_end_internal(requestId, HIST_ERR_BUSY, 0, 0);
+        return;
+    }
+    memcpy(history_request, payload, length);
+    __atomic_store_n(&history_requested, true, __ATOMIC_RELEASE);
+    Semaphore_post(history_sem);
+}
+
+/*
+ * History Thread
+ *      Lowest priority, writes staged samples while the sensors are idle
+ *      and sends one block of a download after each round of appends
+ */
+void *History_thread(void *arg)
+{
+    (void)arg;
+    ThreadStats_register(&history_thread_stats, "history", HISTORY_STACK_SIZE);
+    while(1){
+        uint32_t written = 0;
+        uint32_t count = __atomic_load_n(&history_count, __ATOMIC_ACQUIRE);
+        uint32_t n = 0;
+        for(; n<count; n++){
+            written += History_drain_internal(history_sources[n]);
+        }
+        if(__atomic_load_n(&history_requested, __ATOMIC_ACQUIRE)){
+            History_start_internal();
+        }
+        if(history_export.active){
+            History_export_internal();
+        }
+        else if(!written){
+            ThreadStats_block(&history_thread_stats);
+            Semaphore_pend(history_sem, BIOS_WAIT_FOREVER);
+            ThreadStats_wake(&history_thread_stats);
+        }
+    }
+}
+
+/*
+ * Appends up to HISTORY_BATCH staged samples of a source with one flash write
+ *      Returns the samples taken from the ring
+ */
+static uint32_t History_drain_internal(History_Source *source)
+{
+    SampleLog_Record batch[HISTORY_BATCH];
+    uint32_t tail = source->tail;
+    uint32_t count = __atomic_load_n(&source->head, __ATOMIC_ACQUIRE) - tail;
+    uint32_t n = 0;
+
+    if(count > HISTORY_BATCH){
+        count = HISTORY_BATCH;
+    }
+    for(; n<count; n++){
+        batch[n] = source->records[(tail + n) & HISTORY_RING_MASK];
+    }
+    __atomic_store_n(&source->tail, tail + count, __ATOMIC_RELEASE);
+    if(!count){
+        return 0;
+    }
+
+    uint64_t start = clock_us();
+    if(SampleLog_append(&history_log, batch, count)){
+        history_stats.written += count;
+    }
+    else{
+        history_stats.failed += count;
+    }
+    uint32_t elapsed = (uint32_t)(clock_us() - start);
+    if(elapsed > history_stats.maxWrite_us){
+        history_stats.maxWrite_us = elapsed;
+    }
+    return count;
+}
+
+/*
+ * Starts the download requested, replacing one in progress
+ */
+static void History_start_internal(void)
+{
+    uint16_t requestId = (uint16_t)(history_request[1] | (history_request[2] << 8));
+    uint32_t first = (uint32_t)history_request[3] | ((uint32_t)history_request[4] << 8) |
+                     ((uint32_t)history_request[5] << 16) | ((uint32_t)history_request[6] << 24);
+    uint32_t count = (uint32_t)history_request[7] | ((uint32_t)history_request[8] << 8) |
+                     ((uint32_t)history_request[9] << 16) | ((uint32_t)history_request[10] << 24);
+    __atomic_store_n(&history_requested, false, __ATOMIC_RELEASE);
+
+    memset(&history_export, 0, sizeof(History_Export));
+    history_export.active = true;
+    history_export.requestId = requestId;
+    history_export.remaining = count ? count : UINT32_MAX;
+    history_export.next = (first > history_log.first) ? first : history_log.first;
+    history_export.errors = history_log.stats.errors;
+    SampleLog_seek(&history_log, &history_export.cursor, first);
+    history_stats.requests++;
+}
+
+/*
+ * Sends the next block of the download, or its end frame after the last one
+ * Nothing moves forward if the frame does not fit the UART ring, the same
+ * records are read and sent again on the next call
+ */
+static void History_export_internal(void)
+{
+    HistCodec codec;
+    SampleLog_Cursor cursor = history_export.cursor;
+    SampleLog_Record record;
+    uint32_t remaining = history_export.remaining;
+
+    HistCodec_begin(&codec, history_block, sizeof(history_block), history_export.requestId);
+    while(remaining){
+        SampleLog_Cursor at = cursor;
+        if(!SampleLog_next(&history_log, &cursor, &record)){
+            break;
+        }
+        if(!HistCodec_add(&codec, &record)){
+            cursor = at;    // Starts the next block
+            break;
+        }
+        remaining--;
+    }
+
+    if(!codec.count){
+        uint8_t status = (history_log.stats.errors != history_export.errors) ? HIST_ERR_FLASH : HIST_OK;
+        if(History_end_internal(history_export.requestId, status, history_export.next, history_export.sent)){
+            history_export.active = false;
+        }
+        else{
+            history_stats.retries++;
+            usleep(HISTORY_EXPORT_RETRY_US);
+        }
+        return;
+    }
+
+    size_t length = HistCodec_finish(&codec);
+    size_t encoded = cobs_encode(history_block, length, history_frame);
+    history_frame[encoded++] = FRAME_DELIMITER;
+    if(!UART_TX_write((const char*)history_frame, encoded)){
+        history_stats.retries++;
+        usleep(HISTORY_EXPORT_RETRY_US);
+        return;
+    }
+    history_export.cursor = cursor;
+    history_export.remaining = remaining;
+    history_export.next = codec.last.index + 1;
+    history_export.sent += codec.count;
+    history_stats.exported += codec.count;
+    history_stats.blocks++;
+}
+
+/*
+ * Sends the HIST_TYPE_END frame
+ *      Returns false if it did not fit the UART ring
+ */
+static bool History_end_internal(uint16_t requestId, uint8_t status, uint32_t next, uint32_t sent)
+{
+    uint8_t payload[HIST_END_SIZE];
+    uint8_t frame[COBS_MAX_ENCODED(HIST_END_SIZE) + 1];
+    uint32_t oldest = history_log.first;
+    size_t length = 0;
+
+    payload[length++] = HIST_TYPE_END;
+    payload[length++] = (uint8_t)(requestId);
+    payload[length++] = (uint8_t)(requestId >> 8);
+    payload[length++] = status;
+    payload[length++] = (uint8_t)(next);
+    payload[length++] = (uint8_t)(next >> 8);
+    payload[length++] = (uint8_t)(next >> 16);
+    payload[length++] = (uint8_t)(next >> 24);
+    payload[length++] = (uint8_t)(oldest);
+    payload[length++] = (uint8_t)(oldest >> 8);
+    payload[length++] = (uint8_t)(oldest >> 16);
+    payload[length++] = (uint8_t)(oldest >> 24);
+    payload[length++] = (uint8_t)(sent);
+    payload[length++] = (uint8_t)(sent >> 8);
+    payload[length++] = (uint8_t)(sent >> 16);
+    payload[length++] = (uint8_t)(sent >> 24);
+    uint16_t crc = crc16(payload, length, 0xFFFF);
+    payload[length++] = (uint8_t)(crc);
+    payload[length++] = (uint8_t)(crc >> 8);
+
+    size_t encoded = cobs_encode(payload, length, frame);
+    frame[encoded++] = FRAME_DELIMITER;
+    return UART_TX_write((const char*)frame, encoded);
+}
+
+/*
+ * SampleLog flash access through the NVS driver
+ */
+static bool History_read_internal(void *device, uint32_t offset, void *buffer, size_t length)
+{
+    return NVS_read((NVS_Handle)device, offset, buffer, length) == NVS_STATUS_SUCCESS;
+}
+
+static bool History_write_internal(void *device, uint32_t offset, const void *buffer, size_t length)
+{
+    return NVS_write((NVS_Handle)device, offset, (void*)buffer, length, NVS_WRITE_POST_VERIFY) == NVS_STATUS_SUCCESS;
+}
+
+static bool History_erase_internal(void *device, uint32_t offset, size_t length)
+{
+    return NVS_erase((NVS_Handle)device, offset, length) == NVS_STATUS_SUCCESS;
+}
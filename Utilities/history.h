@@ -0,0 +1,84 @@
+/*
+ * history.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Sample history in flash
+ *      Every sample of a registered TMP sensor is stored with its time in a
+ *      wear leveled ring of NVS sectors (samplelog.h) that survives resets
+ *      and host link outages. The sensor thread only copies the sample into
+ *      a ring of its source and posts the history thread, which writes to
+ *      the flash at the lowest priority, so logging never waits on a flash
+ *      program or erase. Samples that do not fit a full ring are counted.
+ *
+ * History download
+ *      Route HIST_TYPE_REQUEST frames to History_submit and the history
+ *      thread streams the records asked for as HIST_TYPE_BLOCK frames
+ *      (histcodec.h), between its flash writes, then a HIST_TYPE_END frame.
+ *      A block that does not fit the UART ring is retried, it is never
+ *      skipped, so the records of a download arrive complete and in order
+ *      unless the link corrupts them. If a stalled download falls behind
+ *      the sector being erased it continues from the oldest record, the
+ *      host sees the records lost as a gap in the indexes. The host resumes
+ *      from the last index it received.
+ */
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "TMP117.h"
+#include "samplelog.h"
+
+/* Stack of the history thread */
+#define HISTORY_STACK_SIZE      1024
+
+/* Samples staged per source, power of 2 */
+#define HISTORY_RING_SIZE       16
+
+/* Sources that can be registered */
+#define HISTORY_MAX_SOURCES     8
+
+/* Records written by one flash write at most */
+#define HISTORY_BATCH           8
+
+/* Wait before sending a block again that did not fit the UART ring */
+#define HISTORY_EXPORT_RETRY_US 10000
+
+typedef struct History_Stats {
+    uint32_t staged;            // Samples copied by the sensor threads
+    uint32_t dropped;           // Samples lost to a full ring
+    uint32_t written;           // Records written to flash
+    uint32_t failed;            // Records lost to a flash error
+    uint32_t maxLevel;          // Most samples staged in one ring
+    uint32_t maxWrite_us;       // Longest append, a sector erase included
+    uint32_t requests;          // Downloads started
+    uint32_t refused;           // Requests malformed or arriving before the last one was taken
+    uint32_t exported;          // Records sent
+    uint32_t blocks;            // HIST_TYPE_BLOCK frames sent
+    uint32_t retries;           // Blocks sent again after a full UART ring
+} History_Stats;
+
+/*
+ * One sensor logging to the history
+ * Caller owned, must stay valid while logging
+ */
+typedef struct History_Source {
+    SampleLog_Record records[HISTORY_RING_SIZE];    // time_ms, raw and sensorId only
+    uint32_t head;              // Written by the sensor thread only
+    uint32_t tail;              // Written by the history thread only
+    uint8_t sensorId;
+    bool enabled;               // Clear to pause logging
+} History_Source;
+
+extern SampleLog history_log;
+extern History_Stats history_stats;
+
+bool History_init(uint_least8_t nvsIndex);
+bool History_addTMP(History_Source *source, TMP_Handle *tmp_handle, uint8_t sensorId);
+void History_submit(const uint8_t *payload, size_t length);
+
+#endif /* HISTORY_H_ */
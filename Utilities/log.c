@@ -0,0 +1,255 @@
+/*
+ * log.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Each thread gets its own single producer ring the first time it logs,
+ * found again through a pthread key, so recording a message takes no lock
+ * and never waits. The writer thread is the only consumer of every ring.
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "protocol.h"
+#include "framing.h"
+#include "uart_tx.h"
+#include "threadstats.h"
+#include "utilities.h"
+
+#define LOG_RING_MASK           (LOG_RING_SIZE - 1)
+#define LOG_TEXT_MAX            96
+#define LOG_PAYLOAD_MAX         (LOG_HEADER_SIZE + LOG_RING_SIZE*LOG_RECORD_MAX + TLM_CRC_SIZE)
+
+Log_Stats log_stats;
+
+static Log_Ring log_rings[LOG_MAX_THREADS];
+static uint32_t log_threads = 0;        // Rings handed out
+static pthread_key_t log_key;
+static bool log_started = false;
+static Thread_Stats log_thread_stats;
+
+void *Log_thread(void *arg);
+static Log_Ring *Log_register(void);
+static bool Log_take(Log_Ring *ring, Log_Record *record);
+#ifdef LOG_OUTPUT_BINARY
+static void Log_send_frame(Log_Ring *ring);
+#else
+static void Log_send_text(const Log_Record *record);
+#endif
+
+
+/*
+ * Starts the log writer thread
+ * Call once after UART_TX_init, messages logged before this are lost
+ */
+void Log_init(void)
+{
+    memset(&log_stats, 0, sizeof(Log_Stats));
+    if(pthread_key_create(&log_key, NULL) != 0){
+        return;
+    }
+
+    pthread_t pth_handle;
+    pthread_attr_t attrs;
+    struct sched_param priParam;
+    int retc;
+
+    /* Initialize the attributes structure with default values */
+    pthread_attr_init(&attrs);
+
+    /* Set priority, detach state, and stack size attributes */
+    priParam.sched_priority = 1;
+    retc                    = pthread_attr_setschedparam(&attrs, &priParam);
+    retc |= pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
+    retc |= pthread_attr_setstacksize(&attrs, LOG_STACK_SIZE);
+    if (retc != 0){
+        /* failed to set attributes */
+        while (1){}
+    }
+
+    retc = pthread_create(&pth_handle, &attrs, Log_thread, NULL);
+    if (retc == 0){
+        __atomic_store_n(&log_started, true, __ATOMIC_RELEASE);
+    }
+}
+
+/*
+ * Records one message, use the LOG0/LOG1/LOG2 macros instead
+ */
+void Log_write(uint16_t id, uint8_t nargs, uint32_t a, uint32_t b)
+{
+    if(!__atomic_load_n(&log_started, __ATOMIC_ACQUIRE)){
+        return;
+    }
+    Log_Ring *ring = (Log_Ring*)pthread_getspecific(log_key);
+    if(ring == NULL){
+        ring = Log_register();
+        if(ring == NULL){
+            __atomic_fetch_add(&log_stats.unregistered, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+
+    uint32_t head = ring->head;
+    if(head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= LOG_RING_SIZE){
+        ring->dropped++;
+        return;
+    }
+    Log_Record *record = &ring->records[head & LOG_RING_MASK];
+    record->timestamp_us = (uint32_t)clock_us();
+    record->id = id;
+    record->nargs = nargs;
+    record->arg[0] = a;
+    record->arg[1] = b;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * Hands the calling thread the next free ring
+ */
+static Log_Ring *Log_register(void)
+{
+    uint32_t slot = __atomic_fetch_add(&log_threads, 1, __ATOMIC_RELAXED);
+    if(slot >= LOG_MAX_THREADS){
+        return NULL;
+    }
+    Log_Ring *ring = &log_rings[slot];
+    ring->slot = (uint8_t)slot;
+    pthread_setspecific(log_key, ring);
+    return ring;
+}
+
+/*
+ * Copies out the oldest record of a ring
+ */
+static bool Log_take(Log_Ring *ring, Log_Record *record)
+{
+    uint32_t tail = ring->tail;
+    if(tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)){
+        return false;
+    }
+    *record = ring->records[tail & LOG_RING_MASK];
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/*
+ * Log writer thread
+ *      Lowest priority, only runs when every other thread is idle
+ */
+void *Log_thread(void *arg)
+{
+    (void)arg;
+    ThreadStats_register(&log_thread_stats, "log", LOG_STACK_SIZE);
+    while(1){
+        bool busy = false;
+        uint32_t threads = __atomic_load_n(&log_threads, __ATOMIC_RELAXED);
+        if(threads > LOG_MAX_THREADS){
+            threads = LOG_MAX_THREADS;
+        }
+
+        uint32_t n = 0;
+        for(; n<threads; n++){
+            Log_Ring *ring = &log_rings[n];
+            uint32_t level = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - ring->tail;
+            if(!level && ring->dropped == ring->reported){
+                continue;
+            }
+            busy = true;
+            if(level > log_stats.maxLevel){
+                log_stats.maxLevel = level;
+            }
+#ifdef LOG_OUTPUT_BINARY
+            Log_send_frame(ring);
+#else
+            Log_Record record;
+            while(Log_take(ring, &record)){
+                log_stats.records++;
+                Log_send_text(&record);
+            }
+            uint32_t dropped = ring->dropped;
+            if(dropped != ring->reported){
+                log_stats.dropped += dropped - ring->reported;
+                record.timestamp_us = (uint32_t)clock_us();
+                record.id = LOG_DROPPED;
+                record.nargs = 2;
+                record.arg[0] = dropped - ring->reported;
+                record.arg[1] = ring->slot;
+                ring->reported = dropped;
+                Log_send_text(&record);
+            }
+#endif
+        }
+        if(!busy){
+            ThreadStats_block(&log_thread_stats);
+            usleep(LOG_FLUSH_US);
+            ThreadStats_wake(&log_thread_stats);
+        }
+    }
+}
+
+#ifndef LOG_OUTPUT_BINARY
+/*
+ * Formats one record and queues it as a text line
+ */
+static void Log_send_text(const Log_Record *record)
+{
+    char line[LOG_TEXT_MAX];
+    size_t length = Log_format(line, sizeof(line), record);
+    if(UART_TX_write(line, length)){
+        log_stats.frames++;
+    }
+}
+#else
+/*
+ * Sends every record of a ring as one LOG_TYPE_RECORDS frame
+ */
+static void Log_send_frame(Log_Ring *ring)
+{
+    uint8_t payload[LOG_PAYLOAD_MAX];
+    uint8_t frame[COBS_MAX_ENCODED(LOG_PAYLOAD_MAX) + 1];
+    size_t length = LOG_HEADER_SIZE;
+    uint8_t count = 0;
+    Log_Record record;
+
+    uint32_t dropped = ring->dropped;
+    while(count < LOG_RING_SIZE && Log_take(ring, &record)){
+        payload[length++] = (uint8_t)(record.timestamp_us);
+        payload[length++] = (uint8_t)(record.timestamp_us >> 8);
+        payload[length++] = (uint8_t)(record.timestamp_us >> 16);
+        payload[length++] = (uint8_t)(record.timestamp_us >> 24);
+        payload[length++] = (uint8_t)(record.id);
+        payload[length++] = (uint8_t)(record.id >> 8);
+        payload[length++] = record.nargs;
+        uint8_t n = 0;
+        for(; n<record.nargs && n<LOG_MAX_ARGS; n++){
+            payload[length++] = (uint8_t)(record.arg[n]);
+            payload[length++] = (uint8_t)(record.arg[n] >> 8);
+            payload[length++] = (uint8_t)(record.arg[n] >> 16);
+            payload[length++] = (uint8_t)(record.arg[n] >> 24);
+        }
+        count++;
+    }
+    log_stats.records += count;
+    log_stats.dropped += dropped - ring->reported;
+    ring->reported = dropped;
+
+    payload[0] = LOG_TYPE_RECORDS;
+    payload[1] = ring->slot;
+    payload[2] = count;
+    payload[3] = (uint8_t)(dropped);
+    payload[4] = (uint8_t)(dropped >> 8);
+    uint16_t crc = crc16(payload, length, 0xFFFF);
+    payload[length++] = (uint8_t)(crc);
+    payload[length++] = (uint8_t)(crc >> 8);
+
+    size_t encoded = cobs_encode(payload, length, frame);
+    frame[encoded++] = FRAME_DELIMITER;
+    if(UART_TX_write((const char*)frame, encoded)){
+        log_stats.frames++;
+    }
+}
+#endif
@@ -0,0 +1,103 @@
+/*
+ * log.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Deferred logging
+ *      LOG0/LOG1/LOG2 store a message ID, a timestamp and up to two
+ *      32 bit arguments into a ring owned by the calling thread. Nothing
+ *      is formatted or sent on the caller's time, the log writer thread
+ *      drains the rings at the lowest priority and prints text, or with
+ *      LOG_OUTPUT_BINARY sends LOG_TYPE_RECORDS frames for the host tools.
+ *
+ *      Messages are listed in log_messages.h. A message below LOG_LEVEL or
+ *      outside LOG_MODULES compiles to nothing.
+ *
+ *      Thread context only, not callable from a Hwi or Swi.
+ */
+
+#ifndef LOG_H_
+#define LOG_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "log_messages.h"
+
+/* Compile-time filters, override from the build */
+#ifndef LOG_LEVEL
+#define LOG_LEVEL               LOG_LEVEL_TRACE
+#endif
+#ifndef LOG_MODULES
+#define LOG_MODULES             ((1u << LOG_MOD_COUNT) - 1)
+#endif
+
+/* Records per thread ring, power of 2 */
+#define LOG_RING_SIZE           16
+
+/* Threads that can own a ring, later threads log nothing */
+#define LOG_MAX_THREADS         8
+
+#define LOG_MAX_ARGS            2
+
+/* Stack of the writer thread */
+#define LOG_STACK_SIZE          1024
+
+/* Writer poll period when every ring is empty */
+#define LOG_FLUSH_US            10000
+
+#define LOG_ID_ENTRY(id, module, level, format)     id,
+typedef enum Log_Id {
+    LOG_MESSAGES(LOG_ID_ENTRY)
+    LOG_COUNT
+} Log_Id;
+
+#define LOG_FILTER_ENTRY(id, module, level, format) \
+    id##_ENABLED = ((level) <= LOG_LEVEL && ((LOG_MODULES >> (module)) & 1u)),
+enum {
+    LOG_MESSAGES(LOG_FILTER_ENTRY)
+};
+
+typedef struct Log_Record {
+    uint32_t timestamp_us;      // Low 32 bits of clock_us
+    uint16_t id;                // Log_Id
+    uint8_t nargs;
+    uint8_t reserved;
+    uint32_t arg[LOG_MAX_ARGS];
+} Log_Record;
+
+typedef struct Log_Ring {
+    Log_Record records[LOG_RING_SIZE];
+    uint32_t head;              // Written by the owning thread only
+    uint32_t tail;              // Written by the log writer only
+    uint32_t dropped;           // Records lost to a full ring
+    uint32_t reported;          // Drops already reported by the writer
+    uint8_t slot;
+} Log_Ring;
+
+typedef struct Log_Stats {
+    uint32_t records;           // Records taken from the rings
+    uint32_t dropped;           // Records lost to full rings
+    uint32_t unregistered;      // Records lost because every ring was taken
+    uint32_t frames;            // Binary frames or text lines sent
+    uint32_t maxLevel;          // Fullest ring seen by the writer
+} Log_Stats;
+
+extern Log_Stats log_stats;
+
+#define LOG0(id) \
+    do { if (id##_ENABLED) { Log_write((id), 0, 0, 0); } } while (0)
+#define LOG1(id, a) \
+    do { if (id##_ENABLED) { Log_write((id), 1, (uint32_t)(a), 0); } } while (0)
+#define LOG2(id, a, b) \
+    do { if (id##_ENABLED) { Log_write((id), 2, (uint32_t)(a), (uint32_t)(b)); } } while (0)
+
+void Log_init(void);
+void Log_write(uint16_t id, uint8_t nargs, uint32_t a, uint32_t b);
+
+/* Formats one record as text, driver free, also used by the host tools */
+size_t Log_format(char *str, size_t size, const Log_Record *record);
+
+#endif /* LOG_H_ */
@@ -0,0 +1,153 @@
+/*
+ * log_format.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Text formatting of log records
+ * No driver dependency, the host tools build this file as is.
+ * Firmware built with LOG_OUTPUT_BINARY does not need it, which keeps
+ * the message strings out of flash.
+ */
+
+#include "log.h"
+
+typedef struct Log_Message {
+    uint8_t module;
+    uint8_t level;
+    const char *format;
+} Log_Message;
+
+#define LOG_TABLE_ENTRY(id, module, level, format)  { (module), (level), (format) },
+static const Log_Message log_messages[LOG_COUNT] = {
+    LOG_MESSAGES(LOG_TABLE_ENTRY)
+};
+
+static const char *const log_modules[LOG_MOD_COUNT] = { "SYS", "I2C", "TMP", "PWM", "CTRL" };
+static const char log_levels[] = "EWIT";
+
+typedef struct Log_Output {
+    char *str;
+    size_t size;
+    size_t length;
+} Log_Output;
+
+static void put_char(Log_Output *out, char c)
+{
+    if(out->length + 1 < out->size){
+        out->str[out->length++] = c;
+    }
+}
+
+static void put_string(Log_Output *out, const char *s)
+{
+    while(*s){
+        put_char(out, *s++);
+    }
+}
+
+static void put_uint(Log_Output *out, uint32_t value, uint32_t base, uint8_t minDigits)
+{
+    char digits[10];
+    uint8_t n = 0;
+    do{
+        uint32_t digit = value % base;
+        digits[n++] = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        value /= base;
+    }while(value);
+    while(n < minDigits && n < sizeof(digits)){
+        digits[n++] = '0';
+    }
+    while(n){
+        put_char(out, digits[--n]);
+    }
+}
+
+/*
+ * Signed Q7 (TMP117 counts) to 3 decimals, rounded
+ */
+static void put_q7(Log_Output *out, int32_t value)
+{
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    uint32_t whole = magnitude >> 7;
+    uint32_t frac = ((magnitude & 0x7F) * 1000 + 64) >> 7;
+    if(frac >= 1000){
+        whole++;
+        frac -= 1000;
+    }
+    if(value < 0){
+        put_char(out, '-');
+    }
+    put_uint(out, whole, 10, 1);
+    put_char(out, '.');
+    put_uint(out, frac, 10, 3);
+}
+
+/*
+ * Formats a record as "[seconds.micro] L MOD: text\n"
+ *      Returns the length written, always null terminated
+ */
+size_t Log_format(char *str, size_t size, const Log_Record *record)
+{
+    Log_Output out = { str, size, 0 };
+    uint8_t arg = 0;
+
+    if(size == 0){
+        return 0;
+    }
+    put_char(&out, '[');
+    put_uint(&out, record->timestamp_us / 1000000, 10, 1);
+    put_char(&out, '.');
+    put_uint(&out, record->timestamp_us % 1000000, 10, 6);
+    put_string(&out, "] ");
+
+    if(record->id >= LOG_COUNT){
+        put_string(&out, "? unknown message ");
+        put_uint(&out, record->id, 10, 1);
+        put_char(&out, '\n');
+        out.str[out.length] = '\0';
+        return out.length;
+    }
+
+    const Log_Message *message = &log_messages[record->id];
+    put_char(&out, log_levels[message->level & 3]);
+    put_char(&out, ' ');
+    put_string(&out, message->module < LOG_MOD_COUNT ? log_modules[message->module] : "?");
+    put_string(&out, ": ");
+
+    const char *f = message->format;
+    for(; *f; f++){
+        if(*f != '%' || f[1] == '\0'){
+            put_char(&out, *f);
+            continue;
+        }
+        f++;
+        if(*f == '%'){
+            put_char(&out, '%');
+            continue;
+        }
+        uint32_t value = (arg < record->nargs && arg < LOG_MAX_ARGS) ? record->arg[arg] : 0;
+        arg++;
+        switch(*f){
+            case 'd':
+                if((int32_t)value < 0){
+                    put_char(&out, '-');
+                    value = 0u - value;
+                }
+                put_uint(&out, value, 10, 1);
+                break;
+            case 'x':
+                put_uint(&out, value, 16, 1);
+                break;
+            case 'q':
+                put_q7(&out, (int32_t)value);
+                break;
+            default:
+                put_uint(&out, value, 10, 1);
+                break;
+        }
+    }
+    put_char(&out, '\n');
+    out.str[out.length] = '\0';
+    return out.length;
+}
@@ -0,0 +1,68 @@
+/*
+ * log_messages.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Table of every log message, shared by the firmware and the host tools
+ * No driver dependency
+ *
+ *      X(id, module, level, format)
+ *
+ * Only the ID and up to LOG_MAX_ARGS 32 bit arguments are recorded, the
+ * format is applied later by the log writer or by the host decoder.
+ * Formats take %u, %d, %x and %q (signed Q7 fixed point, TMP117 counts).
+ * Append new messages at the end, the ID is the position in the table.
+ */
+
+#ifndef LOG_MESSAGES_H_
+#define LOG_MESSAGES_H_
+
+/* Modules, one bit each in LOG_MODULES */
+#define LOG_MOD_SYS             0
+#define LOG_MOD_I2C             1
+#define LOG_MOD_TMP             2
+#define LOG_MOD_PWM             3
+#define LOG_MOD_CTRL            4
+#define LOG_MOD_COUNT           5
+
+/* Levels, lower is more severe */
+#define LOG_LEVEL_ERROR         0
+#define LOG_LEVEL_WARN          1
+#define LOG_LEVEL_INFO          2
+#define LOG_LEVEL_TRACE         3
+
+#define LOG_MESSAGES(X) \
+    X(LOG_DROPPED,              LOG_MOD_SYS,  LOG_LEVEL_WARN,  "%u log records dropped by thread %u") \
+    X(LOG_I2C_TIMEOUT,          LOG_MOD_I2C,  LOG_LEVEL_ERROR, "I2C transaction timed out! slave 0x%x") \
+    X(LOG_I2C_CLOCK_TIMEOUT,    LOG_MOD_I2C,  LOG_LEVEL_ERROR, "I2C serial clock line timed out! slave 0x%x") \
+    X(LOG_I2C_ADDR_NACK,        LOG_MOD_I2C,  LOG_LEVEL_ERROR, "I2C slave address not acknowledged! slave 0x%x") \
+    X(LOG_I2C_DATA_NACK,        LOG_MOD_I2C,  LOG_LEVEL_ERROR, "I2C data byte not acknowledged! slave 0x%x") \
+    X(LOG_I2C_ARB_LOST,         LOG_MOD_I2C,  LOG_LEVEL_ERROR, "I2C arbitration to another master! slave 0x%x") \
+    X(LOG_I2C_INCOMPLETE,       LOG_MOD_I2C,  LOG_LEVEL_ERROR, "I2C transaction returned before completion! slave 0x%x") \
+    X(LOG_I2C_BUS_BUSY,         LOG_MOD_I2C,  LOG_LEVEL_ERROR, "I2C bus is already in use! slave 0x%x") \
+    X(LOG_I2C_CANCEL,           LOG_MOD_I2C,  LOG_LEVEL_ERROR, "I2C transaction cancelled! slave 0x%x") \
+    X(LOG_I2C_INVALID,          LOG_MOD_I2C,  LOG_LEVEL_ERROR, "I2C transaction invalid! slave 0x%x") \
+    X(LOG_I2C_ERROR,            LOG_MOD_I2C,  LOG_LEVEL_ERROR, "I2C generic error! slave 0x%x") \
+    X(LOG_I2C_UNDEFINED,        LOG_MOD_I2C,  LOG_LEVEL_ERROR, "I2C undefined error case %d! slave 0x%x") \
+    X(LOG_TMP_DETECTED,         LOG_MOD_TMP,  LOG_LEVEL_INFO,  "Detected TMP sensor with slave 0x%x") \
+    X(LOG_TMP_REQUEST,          LOG_MOD_TMP,  LOG_LEVEL_TRACE, "TMP 0x%x running request %u") \
+    X(LOG_TMP_SAMPLE,           LOG_MOD_TMP,  LOG_LEVEL_TRACE, "TMP 0x%x sample %q") \
+    X(LOG_TMP_LOCK_FAILED,      LOG_MOD_TMP,  LOG_LEVEL_ERROR, "Cannot lock EEPROM! slave 0x%x status 0x%x") \
+    X(LOG_TMP_UNLOCK_FAILED,    LOG_MOD_TMP,  LOG_LEVEL_ERROR, "Cannot unlock EEPROM! slave 0x%x status 0x%x") \
+    X(LOG_TMP_LOCK_TIMEOUT,     LOG_MOD_TMP,  LOG_LEVEL_ERROR, "Timeout during attempt lock memory, slave 0x%x") \
+    X(LOG_TMP_UNLOCK_TIMEOUT,   LOG_MOD_TMP,  LOG_LEVEL_ERROR, "Timeout during attempt to unlock memory, slave 0x%x") \
+    X(LOG_TMP_CAL_VERIFY,       LOG_MOD_TMP,  LOG_LEVEL_ERROR, "Calibration offset verification failed, slave 0x%x") \
+    X(LOG_TMP_SN_VERIFY,        LOG_MOD_TMP,  LOG_LEVEL_ERROR, "Serial number verification failed, slave 0x%x read %u") \
+    X(LOG_PWM_OPEN_FAILED,      LOG_MOD_PWM,  LOG_LEVEL_ERROR, "PWM_open failed for PWM %u") \
+    X(LOG_PWM_REQUEST,          LOG_MOD_PWM,  LOG_LEVEL_TRACE, "PWM %u running request %u") \
+    X(LOG_PWM_LEVEL,            LOG_MOD_PWM,  LOG_LEVEL_TRACE, "PWM %u level %u") \
+    X(LOG_CTRL_OUTPUT,          LOG_MOD_CTRL, LOG_LEVEL_TRACE, "Thermal sample %q output %u") \
+    X(LOG_ACTIVE_FULL,          LOG_MOD_SYS,  LOG_LEVEL_WARN,  "Active object %u queue full, %u requests dropped") \
+    X(LOG_TMP_GROUP_SET,        LOG_MOD_TMP,  LOG_LEVEL_TRACE, "TMP group set of mask 0x%x skew %u us") \
+    X(LOG_TMP_GROUP_BUSY,       LOG_MOD_TMP,  LOG_LEVEL_WARN,  "TMP group left out busy slave 0x%x") \
+    X(LOG_TMP_SCAN_STUCK,       LOG_MOD_TMP,  LOG_LEVEL_ERROR, "TMP scan gave up bus %u, I2C status %d") \
+    X(LOG_PWM_GROUP_BUSY,       LOG_MOD_PWM,  LOG_LEVEL_WARN,  "PWM group left out busy PWM %u") \
+    X(LOG_CTRL_BUSY,            LOG_MOD_CTRL, LOG_LEVEL_WARN,  "Thermal run refused, 0x%x not free")
+
+#endif /* LOG_MESSAGES_H_ */
@@ -0,0 +1,166 @@
+/*
+ * periodic.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Periodic loops scheduled against absolute deadlines so
+ * execution time does not add to the period
+ */
+
+#include <errno.h>
+
+#include "periodic.h"
+#include "threadstats.h"
+#include "utilities.h"
+
+static Periodic_Timer *periodic_list[PERIODIC_MAX];
+static uint32_t periodic_count = 0;
+
+/*
+ * Lists a timer for Periodic_print and clears its statistics
+ * Call once when the owner is opened
+ * Input name shown by Periodic_print, usually the owner's name
+ */
+void Periodic_register(Periodic_Timer *timer, const char *name)
+{
+    timer->name = name;
+    Periodic_reset_stats(timer);
+
+    uint32_t slot = __atomic_fetch_add(&periodic_count, 1, __ATOMIC_RELAXED);
+    if(slot < PERIODIC_MAX){
+        __atomic_store_n(&periodic_list[slot], timer, __ATOMIC_RELEASE);
+    }
+}
+
+/*
+ * Starts a periodic timer, the first period begins now
+ * Input period in us
+ * Input overrun policy
+ */
+void Periodic_start(Periodic_Timer *timer, uint32_t period_us, Periodic_Policy policy)
+{
+    timer->deadline_us = clock_us();
+    timer->period_us = period_us;
+    timer->policy = policy;
+}
+
+/*
+ * Clears the jitter statistics
+ */
+void Periodic_reset_stats(Periodic_Timer *timer)
+{
+    memset(&timer->stats, 0, sizeof(Periodic_Stats));
+}
+
+/*
+ * Sleeps until the end of the current period
+ *      Returns the number of deadlines that had already passed (0 when on time)
+ */
+uint32_t Periodic_wait(Periodic_Timer *timer)
+{
+    uint32_t missed = Periodic_next(timer);
+
+    if(clock_us() < timer->deadline_us){
+        struct timespec deadline;
+        deadline.tv_sec = (time_t)(timer->deadline_us / 1000000);
+        deadline.tv_nsec = (long)(timer->deadline_us % 1000000) * 1000;
+        Thread_Stats *self = ThreadStats_self();
+        ThreadStats_block(self);
+        int status;
+        while((status = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL)) == EINTR){}
+        if(status){
+            timer->stats.sleepErrors++; // Runs early rather than spinning
+        }
+        ThreadStats_wake(self);
+    }
+
+    Periodic_record(timer);
+    return missed;
+}
+
+/*
+ * Moves deadline_us to the end of the current period without sleeping,
+ * for handlers that schedule a continuation instead of waiting
+ * Call Periodic_record when the continuation runs
+ *      Returns the number of deadlines that had already passed (0 when on time)
+ */
+uint32_t Periodic_next(Periodic_Timer *timer)
+{
+    uint32_t missed = 0;
+    uint64_t now = clock_us();
+    timer->deadline_us += timer->period_us;
+
+    if(now >= timer->deadline_us){
+        if(timer->policy == PERIODIC_SKIP){
+            missed = (uint32_t)((now - timer->deadline_us) / timer->period_us) + 1;
+            timer->deadline_us += (uint64_t)missed * timer->period_us;
+        }
+        else{
+            missed = 1;
+        }
+        timer->stats.overruns += missed;
+    }
+    return missed;
+}
+
+/*
+ * Records the wake up jitter against deadline_us
+ */
+void Periodic_record(Periodic_Timer *timer)
+{
+    uint64_t now = clock_us();
+    uint32_t jitter = (now > timer->deadline_us) ? (uint32_t)(now - timer->deadline_us) : 0;
+    uint8_t bin = 0;
+    uint32_t limit = 16;
+    while(bin < PERIODIC_HIST_BINS-1 && jitter >= limit){
+        bin++;
+        limit <<= 2;
+    }
+    timer->stats.histogram[bin]++;
+    timer->stats.periods++;
+    timer->stats.lastJitter_us = jitter;
+    timer->stats.sumJitter_us += jitter;
+    if(jitter > timer->stats.maxJitter_us){
+        timer->stats.maxJitter_us = jitter;
+    }
+}
+
+/*
+ * Prints one line per registered timer
+ *      name  periods  overruns  avg/max jitter us  histogram  sleep errors
+ */
+void Periodic_print(void)
+{
+    uint32_t count = __atomic_load_n(&periodic_count, __ATOMIC_RELAXED);
+    uint32_t n = 0;
+    uint8_t bin;
+
+    if(count > PERIODIC_MAX){
+        count = PERIODIC_MAX;
+    }
+    uart_print_string("timer periods overruns avg_us max_us <16/64/256us/1/4/16/65ms/more errors\n");
+    for(; n<count; n++){
+        Periodic_Timer *timer = __atomic_load_n(&periodic_list[n], __ATOMIC_ACQUIRE);
+        if(timer == NULL){
+            continue;
+        }
+        Periodic_Stats stats = timer->stats;
+        uart_print_string(timer->name);
+        uart_print_string(" ");
+        uart_print_uint32(stats.periods);
+        uart_print_string(" ");
+        uart_print_uint32(stats.overruns);
+        uart_print_string(" ");
+        uart_print_uint32(stats.periods ? (uint32_t)(stats.sumJitter_us / stats.periods) : 0);
+        uart_print_string(" ");
+        uart_print_uint32(stats.maxJitter_us);
+        for(bin=0; bin<PERIODIC_HIST_BINS; bin++){
+            uart_print_string(bin ? "/" : " ");
+            uart_print_uint32(stats.histogram[bin]);
+        }
+        uart_print_string(" ");
+        uart_print_uint32(stats.sleepErrors);
+        uart_print_string("\n");
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ * periodic.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#ifndef PERIODIC_H_
+#define PERIODIC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+/*
+ * Jitter histogram bins, bin n counts wake ups later than the
+ * deadline by less than 16us << 2n (16us, 64us, 256us, 1ms, 4ms,
+ * 16ms, 65ms), the last bin counts everything later
+ */
+#define PERIODIC_HIST_BINS      8
+
+/* Timers listed by Periodic_print */
+#define PERIODIC_MAX            16
+
+typedef enum Periodic_Policy {
+    PERIODIC_CATCH_UP,  // Missed deadlines run back to back, keeps effect durations exact
+    PERIODIC_SKIP       // Missed deadlines are dropped, keeps the phase of a control loop
+} Periodic_Policy;
+
+typedef struct Periodic_Stats {
+    uint32_t periods;           // Completed waits
+    uint32_t overruns;          // Deadlines already passed when the wait started
+    uint32_t lastJitter_us;     // Wake up time minus deadline
+    uint32_t maxJitter_us;
+    uint64_t sumJitter_us;      // Divide by periods for the average
+    uint32_t histogram[PERIODIC_HIST_BINS];
+    uint32_t sleepErrors;       // clock_nanosleep failures other than EINTR
+} Periodic_Stats;
+
+typedef struct Periodic_Timer {
+    const char *name;           // Set by Periodic_register
+    uint64_t deadline_us;       // Absolute CLOCK_MONOTONIC time of the next period
+    uint32_t period_us;
+    Periodic_Policy policy;
+    Periodic_Stats stats;
+} Periodic_Timer;
+
+void Periodic_register(Periodic_Timer *timer, const char *name);
+void Periodic_start(Periodic_Timer *timer, uint32_t period_us, Periodic_Policy policy);
+uint32_t Periodic_wait(Periodic_Timer *timer);
+uint32_t Periodic_next(Periodic_Timer *timer);
+void Periodic_record(Periodic_Timer *timer);
+void Periodic_reset_stats(Periodic_Timer *timer);
+void Periodic_print(void);
+
+#endif /* PERIODIC_H_ */
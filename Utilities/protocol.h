@@ -0,0 +1,157 @@
+/*
+ * protocol.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Binary frame formats shared by the firmware and the host tools
+ * No driver dependency
+ *
+ * Every frame on the wire is COBS encoded and ends with 0x00 (see framing.h).
+ * Decoded payloads are little endian, start with a u8 type and
+ * end with a u16 CRC-16/CCITT-FALSE over all bytes before it.
+ *
+ * TLM_TYPE_SAMPLES
+ *      u8  type
+ *      u8  sensor id
+ *      u16 sequence            per sensor, gaps mean lost frames
+ *      u32 first timestamp us  low 32 bits of clock_us
+ *      u32 last timestamp us
+ *      u8  count
+ *      i16 raw[count]          TMP117 result register, 1/128 degC
+ *      u16 crc16
+ *      Samples are evenly spaced between the first and last timestamp
+ *
+ * LOG_TYPE_RECORDS
+ *      u8  type
+ *      u8  thread slot         ring the records came from
+ *      u8  count
+ *      u16 dropped             records lost by this ring so far, wraps
+ *      count records of
+ *          u32 timestamp us
+ *          u16 message id      position in log_messages.h
+ *          u8  nargs
+ *          u32 arg[nargs]
+ *      u16 crc16
+ *
+ * PROV_TYPE_BATCH          host to device, provisioning operations
+ *      u8  type
+ *      u16 batch id            echoed in the result
+ *      u8  count               up to PROV_MAX_OPS
+ *      count operations of
+ *          u8  target          sensor index in registration order
+ *          u8  op              PROV_OP_*
+ *          u32 arg             serial number, or offset in 1/128 degC
+ *      u16 crc16
+ *      Writes are applied before reads, so reads return the final values.
+ *
+ * PROV_TYPE_RESULT         device to host, one per batch
+ *      u8  type
+ *      u16 batch id
+ *      u8  batch status        PROV_OK, PROV_ERR_BUSY or PROV_ERR_INVALID
+ *      u32 elapsed us          device time spent on the batch
+ *      u8  count
+ *      count results in operation order of
+ *          u8  status          PROV_OK or PROV_ERR_*
+ *          u32 value           value read, or read back after a write
+ *      u16 crc16
+ *
+ * HIST_TYPE_REQUEST        host to device, history download
+ *      u8  type
+ *      u16 request id          echoed in every block and the end frame
+ *      u32 first index         record to start at, the oldest kept if older
+ *      u32 count               records wanted, 0 for all up to the newest
+ *      u16 crc16
+ *      A request replaces a download in progress. To resume after a lost
+ *      block, request again from the last index received + 1.
+ *
+ * HIST_TYPE_BLOCK          device to host, records in index order (see histcodec.h)
+ *      u8  type
+ *      u16 request id
+ *      u8  count               records in the block, 1 or more
+ *      u32 index               first record in full
+ *      u16 boot
+ *      u32 time ms
+ *      u8  sensor id
+ *      i16 raw
+ *      count-1 records of
+ *          u8  tag             bits 0-5 sensor id, 63: varint sensor id follows
+ *                              bit 6 index gap, bit 7 new boot
+ *          [varint index - previous index - 2]     if gap, otherwise previous + 1
+ *          [varint boot, varint time ms]           if new boot
+ *          [zig-zag varint time step change]       otherwise, ms against the previous step
+ *          zig-zag varint raw change since the previous record of sensor id % 8
+ *      u16 crc16
+ *      Varints are unsigned LEB128, zig-zag maps 0,-1,1,-2.. to 0,1,2,3..
+ *
+ * HIST_TYPE_END            device to host, after the last block
+ *      u8  type
+ *      u16 request id
+ *      u8  status              HIST_OK or HIST_ERR_*
+ *      u32 next index          first record not sent
+ *      u32 oldest index        oldest record kept, older ones were overwritten
+ *      u32 records sent
+ *      u16 crc16
+ */
+
+#ifndef PROTOCOL_H_
+#define PROTOCOL_H_
+
+#define TLM_TYPE_SAMPLES        0x01
+
+/* Most samples carried by one frame */
+#define TLM_MAX_SAMPLES         32
+
+/* Payload bytes before the samples and after them */
+#define TLM_HEADER_SIZE         13
+#define TLM_CRC_SIZE            2
+
+#define LOG_TYPE_RECORDS        0x02
+
+#define LOG_HEADER_SIZE         5
+#define LOG_RECORD_MIN          7
+#define LOG_RECORD_MAX          15      // With two arguments
+
+#define PROV_TYPE_BATCH         0x10
+#define PROV_TYPE_RESULT        0x11
+
+#define PROV_MAX_OPS            40
+#define PROV_BATCH_HEADER_SIZE  4
+#define PROV_OP_SIZE            6
+#define PROV_RESULT_HEADER_SIZE 9
+#define PROV_RESULT_SIZE        5
+
+/* Operations */
+#define PROV_OP_DETECT          0x01
+#define PROV_OP_READ_ID         0x02
+#define PROV_OP_READ_SN         0x03
+#define PROV_OP_WRITE_SN        0x04
+#define PROV_OP_READ_CAL        0x05
+#define PROV_OP_WRITE_CAL       0x06
+
+/* Status codes */
+#define PROV_OK                 0x00
+#define PROV_ERR_TARGET         0x01    // No sensor registered at this index
+#define PROV_ERR_OP             0x02    // Unknown operation or argument out of range
+#define PROV_ERR_BUSY           0x03    // Sensor thread or provisioning already busy
+#define PROV_ERR_I2C            0x04
+#define PROV_ERR_EEPROM         0x05    // EEPROM did not unlock, lock or finish programming
+#define PROV_ERR_VERIFY         0x06    // Read back differs from the value written
+#define PROV_ERR_INVALID        0x07    // Malformed batch
+
+#define HIST_TYPE_REQUEST       0x20
+#define HIST_TYPE_BLOCK         0x21
+#define HIST_TYPE_END           0x22
+
+#define HIST_REQUEST_SIZE       13      // CRC included
+#define HIST_BLOCK_HEADER_SIZE  17
+#define HIST_RECORD_MAX         19      // One encoded record, every field at its longest
+#define HIST_BLOCK_MAX          254     // Payload and CRC, COBS adds a single byte
+#define HIST_END_SIZE           18
+
+#define HIST_OK                 0x00
+#define HIST_ERR_INVALID        0x01    // Malformed request
+#define HIST_ERR_FLASH          0x02    // Log could not be read
+#define HIST_ERR_BUSY           0x03    // Previous request not taken yet, send it again
+
+#endif /* PROTOCOL_H_ */
@@ -0,0 +1,359 @@
+/*
+ * samplelog.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#include <string.h>
+
+#include "samplelog.h"
+#include "framing.h"
+
+typedef enum SampleLog_Slot {
+    SLOG_Blank,                 // Never written since the erase
+    SLOG_Valid,
+    SLOG_Torn                   // Written but the CRC fails
+} SampleLog_Slot;
+
+static bool SampleLog_header_internal(SampleLog *log, uint32_t sector, SampleLog_Header *header);
+static uint8_t SampleLog_record_internal(SampleLog *log, uint32_t sector, uint32_t slot, SampleLog_Record *record);
+static bool SampleLog_start_internal(SampleLog *log, uint32_t sector);
+static uint32_t SampleLog_sequence_internal(SampleLog *log, uint32_t sector);
+
+
+/*
+ * Recovers the log from the flash, or formats it if no sector is valid
+ * Reads every sector header, then binary searches the newest sector
+ *
+ * Input log storage
+ * Input flash access and geometry, copied
+ *      Returns false if the geometry is unusable or the flash fails
+ */
+bool SampleLog_open(SampleLog *log, const SampleLog_Flash *flash)
+{
+    SampleLog_Header header;
+    SampleLog_Record record;
+    uint32_t newest = 0;
+    uint32_t oldest = 0;
+    uint16_t boot = 0;
+    bool found = false;
+    uint32_t sector = 0;
+
+    memset(log, 0, sizeof(SampleLog));
+    log->flash = *flash;
+    if(flash->sectors < SLOG_MIN_SECTORS || flash->sectorSize < SLOG_HEADER_SIZE + SLOG_RECORD_SIZE){
+        return false;
+    }
+    log->slots = (flash->sectorSize - SLOG_HEADER_SIZE) / SLOG_RECORD_SIZE;
+    log->stats.minErases = UINT32_MAX;
+
+    for(; sector<flash->sectors; sector++){
+        if(!SampleLog_header_internal(log, sector, &header)){
+            continue;
+        }
+        if(header.erases < log->stats.minErases){
+            log->stats.minErases = header.erases;
+        }
+        if(header.erases > log->stats.maxErases){
+            log->stats.maxErases = header.erases;
+        }
+        if(!found || header.sequence > newest){
+            newest = header.sequence;
+            log->sector = sector;
+            log->sequence = header.sequence;
+            log->next = header.firstIndex;
+            boot = header.boot;
+        }
+        if(!found || header.sequence < oldest){
+            oldest = header.sequence;
+            log->oldest = sector;
+            log->first = header.firstIndex;
+        }
+        found = true;
+    }
+
+    if(!found){
+        log->stats.minErases = 0;
+        log->boot = 1;
+        bool ok = SampleLog_start_internal(log, 0);
+        log->stats.recoveryReads = log->stats.reads;
+        return ok;
+    }
+
+    // Slots before the first blank one are written
+    uint32_t low = 0;
+    uint32_t high = log->slots;
+    while(low < high){
+        uint32_t middle = (low + high) / 2;
+        if(SampleLog_record_internal(log, log->sector, middle, &record) == SLOG_Blank){
+            high = middle;
+        }
+        else{
+            low = middle + 1;
+        }
+    }
+    log->slot = low;
+
+    // The last valid record gives the next index and the last boot
+    uint32_t slot = low;
+    while(slot--){
+        if(SampleLog_record_internal(log, log->sector, slot, &record) == SLOG_Valid){
+            log->next = record.index + 1;
+            if(record.boot > boot){
+                boot = record.boot;
+            }
+            break;
+        }
+        log->stats.torn++;
+    }
+    log->boot = boot + 1;
+    if(!log->boot){
+        log->boot = 1;
+    }
+    log->stats.recoveryReads = log->stats.reads;
+    return true;
+}
+
+/*
+ * Appends records, starting the next sector when one is full
+ * Sets the index, boot and crc of every record, the caller fills the rest
+ *      Returns false on a flash error, the records are then lost
+ */
+bool SampleLog_append(SampleLog *log, SampleLog_Record *records, uint32_t count)
+{
+    while(count){
+        if(log->slot >= log->slots){
+            if(!SampleLog_start_internal(log, (log->sector + 1) % log->flash.sectors)){
+                return false;
+            }
+        }
+        uint32_t n = log->slots - log->slot;
+        if(n > count){
+            n = count;
+        }
+        uint32_t i = 0;
+        for(; i<n; i++){
+            records[i].index = log->next + i;
+            records[i].boot = log->boot;
+            records[i].reserved = 0;
+            records[i].crc = crc16((const uint8_t*)&records[i], offsetof(SampleLog_Record, crc), 0xFFFF);
+        }
+
+        // One write per run of slots, a failed write may leave them half
+        // programmed so they are never used again
+        uint32_t offset = log->sector*log->flash.sectorSize + SLOG_HEADER_SIZE + log->slot*SLOG_RECORD_SIZE;
+        bool ok = log->flash.write(log->flash.device, offset, records, n*SLOG_RECORD_SIZE);
+        log->slot += n;
+        log->next += n;
+        if(!ok){
+            log->stats.errors++;
+            return false;
+        }
+        log->stats.records += n;
+        log->stats.bytes += n*SLOG_RECORD_SIZE;
+        records += n;
+        count -= n;
+    }
+    return true;
+}
+
+/*
+ * Places the cursor before the oldest record
+ */
+void SampleLog_rewind(SampleLog *log, SampleLog_Cursor *cursor)
+{
+    cursor->sector = log->oldest;
+    cursor->slot = 0;
+    cursor->sequence = SampleLog_sequence_internal(log, cursor->sector);
+}
+
+/*
+ * Places the cursor before the first record with an index of at least index
+ * Records older than the log start at the oldest one
+ *      Returns false if no such record is stored yet, the cursor is then at the end
+ */
+bool SampleLog_seek(SampleLog *log, SampleLog_Cursor *cursor, uint32_t index)
+{
+    SampleLog_Header header;
+    SampleLog_Record record;
+    uint32_t first = log->first;
+    uint32_t sector = log->oldest;
+
+    SampleLog_rewind(log, cursor);
+    if(index >= log->next){
+        cursor->sector = log->sector;
+        cursor->slot = log->slot;
+        cursor->sequence = log->sequence;
+        return false;
+    }
+    if(index <= log->first){
+        return true;
+    }
+
+    // Last sector starting at or before index
+    while(sector != log->sector){
+        sector = (sector + 1) % log->flash.sectors;
+        if(!SampleLog_header_internal(log, sector, &header)){
+            continue;
+        }
+        if(header.firstIndex > index){
+            break;
+        }
+        cursor->sector = sector;
+        first = header.firstIndex;
+    }
+
+    cursor->sequence = SampleLog_sequence_internal(log, cursor->sector);
+
+    // Records are numbered by slot unless one was torn before
+    uint32_t slot = index - first;
+    if(slot < log->slots && SampleLog_record_internal(log, cursor->sector, slot, &record) == SLOG_Valid &&
+       record.index == index){
+        cursor->slot = slot;
+        return true;
+    }
+
+    SampleLog_Cursor at = *cursor;
+    while(SampleLog_next(log, &at, &record)){
+        if(record.index >= index){
+            cursor->sector = at.sector;
+            cursor->slot = at.slot - 1;
+            return true;
+        }
+    }
+    *cursor = at;
+    return false;
+}
+
+/*
+ * Reads the record after the cursor and moves past it, skipping torn ones
+ * A cursor whose sector was reused since restarts at the oldest record
+ *      Returns false at the end of the log
+ */
+bool SampleLog_next(SampleLog *log, SampleLog_Cursor *cursor, SampleLog_Record *record)
+{
+    if(cursor->sequence != SampleLog_sequence_internal(log, cursor->sector)){
+        SampleLog_rewind(log, cursor);
+    }
+    while(cursor->sector != log->sector || cursor->slot < log->slot){
+        if(cursor->slot >= log->slots){
+            cursor->sector = (cursor->sector + 1) % log->flash.sectors;
+            cursor->slot = 0;
+            cursor->sequence++;
+            continue;
+        }
+        uint8_t state = SampleLog_record_internal(log, cursor->sector, cursor->slot++, record);
+        if(state == SLOG_Valid){
+            return true;
+        }
+        if(state == SLOG_Blank && cursor->sector != log->sector){
+            cursor->slot = log->slots;  // Rest of the sector never written
+        }
+    }
+    return false;
+}
+
+/*
+ * Reads a sector header
+ *      Returns false if it is not a valid header
+ */
+static bool SampleLog_header_internal(SampleLog *log, uint32_t sector, SampleLog_Header *header)
+{
+    log->stats.reads++;
+    if(!log->flash.read(log->flash.device, sector*log->flash.sectorSize, header, sizeof(SampleLog_Header))){
+        log->stats.errors++;
+        return false;
+    }
+    return header->magic == SLOG_MAGIC &&
+           header->crc == crc16((const uint8_t*)header, offsetof(SampleLog_Header, crc), 0xFFFF);
+}
+
+/*
+ * Reads the record in a slot
+ *      Returns SampleLog_Slot
+ */
+static uint8_t SampleLog_record_internal(SampleLog *log, uint32_t sector, uint32_t slot, SampleLog_Record *record)
+{
+    uint32_t offset = sector*log->flash.sectorSize + SLOG_HEADER_SIZE + slot*SLOG_RECORD_SIZE;
+    const uint8_t *bytes = (const uint8_t*)record;
+    size_t n = 0;
+
+    log->stats.reads++;
+    if(!log->flash.read(log->flash.device, offset, record, SLOG_RECORD_SIZE)){
+        log->stats.errors++;
+        return SLOG_Torn;
+    }
+    for(; n<SLOG_RECORD_SIZE; n++){
+        if(bytes[n] != 0xFF){
+            break;
+        }
+    }
+    if(n == SLOG_RECORD_SIZE){
+        return SLOG_Blank;
+    }
+    if(record->crc != crc16(bytes, offsetof(SampleLog_Record, crc), 0xFFFF)){
+        return SLOG_Torn;
+    }
+    return SLOG_Valid;
+}
+
+/*
+ * Erases a sector and writes its header, it becomes the newest
+ * Reusing the oldest sector drops its records
+ *      Returns false on a flash error
+ */
+static bool SampleLog_start_internal(SampleLog *log, uint32_t sector)
+{
+    SampleLog_Header header;
+    uint32_t erases = 0;
+    bool used = SampleLog_header_internal(log, sector, &header);
+    if(used){
+        erases = header.erases;
+    }
+
+    if(!log->flash.erase(log->flash.device, sector*log->flash.sectorSize, log->flash.sectorSize)){
+        log->stats.errors++;
+        return false;
+    }
+    log->stats.erases++;
+
+    memset(&header, 0xFF, sizeof(SampleLog_Header));
+    header.magic = SLOG_MAGIC;
+    header.sequence = log->sequence + 1;
+    header.firstIndex = log->next;
+    header.erases = erases + 1;
+    header.boot = log->boot;
+    header.crc = crc16((const uint8_t*)&header, offsetof(SampleLog_Header, crc), 0xFFFF);
+    if(!log->flash.write(log->flash.device, sector*log->flash.sectorSize, &header, offsetof(SampleLog_Header, reserved))){
+        log->stats.errors++;
+        return false;
+    }
+    log->stats.bytes += offsetof(SampleLog_Header, reserved);
+    if(header.erases > log->stats.maxErases){
+        log->stats.maxErases = header.erases;
+    }
+
+    log->sector = sector;
+    log->slot = 0;
+    log->sequence = header.sequence;
+    if(used && sector == log->oldest){
+        // The next sector now holds the oldest records, this one if it is the only one
+        uint32_t next = (sector + 1) % log->flash.sectors;
+        while(next != sector && !SampleLog_header_internal(log, next, &header)){
+            next = (next + 1) % log->flash.sectors;
+        }
+        log->oldest = next;
+        log->first = (next == sector) ? log->next : header.firstIndex;
+    }
+    return true;
+}
+
+/*
+ * Sequence number of a sector, the sectors are started in ring order so
+ * it counts back from the one being appended
+ */
+static uint32_t SampleLog_sequence_internal(SampleLog *log, uint32_t sector)
+{
+    return log->sequence - (log->sector + log->flash.sectors - sector) % log->flash.sectors;
+}
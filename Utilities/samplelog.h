@@ -0,0 +1,111 @@
+/*
+ * samplelog.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Append only sample log in a ring of flash sectors
+ *      Every sector starts with a header holding its sequence number, the
+ *      index of its first record and its erase count, followed by fixed
+ *      size records. Records are only ever appended. When the last sector
+ *      is full the oldest one is erased and reused, so the sectors are
+ *      erased in turn and wear evenly.
+ *
+ *      Erased flash reads 0xFF. At open the newest sector is found from the
+ *      headers and its first blank slot by a binary search, a few dozen
+ *      reads instead of a scan. A record torn by a reset fails its CRC and
+ *      is skipped, appending continues after it.
+ *
+ *      No driver dependency, the flash is reached through SampleLog_Flash:
+ *      NVS on the target (history.c), a memory mapped file on the host.
+ *      Not thread safe, one thread owns a log. Little endian.
+ */
+
+#ifndef SAMPLELOG_H_
+#define SAMPLELOG_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define SLOG_MAGIC              0x534C4F47  // "SLOG"
+#define SLOG_HEADER_SIZE        32
+#define SLOG_RECORD_SIZE        16
+#define SLOG_MIN_SECTORS        2
+
+typedef struct SampleLog_Header {
+    uint32_t magic;
+    uint32_t sequence;          // One more than the previous sector started
+    uint32_t firstIndex;        // Index of the sector's first record
+    uint32_t erases;            // Times this sector was erased
+    uint16_t boot;              // Boot that started the sector
+    uint16_t crc;               // crc16 of the bytes above
+    uint8_t reserved[12];       // Left erased
+} SampleLog_Header;
+
+typedef struct SampleLog_Record {
+    uint32_t index;             // Record number, continues across resets
+    uint32_t time_ms;           // clock_us()/1000 of the boot below
+    uint16_t boot;              // Boot count, the first boot is 1
+    int16_t raw;                // TMP117 result register, 1/128 degC
+    uint8_t sensorId;
+    uint8_t reserved;
+    uint16_t crc;               // crc16 of the bytes above
+} SampleLog_Record;
+
+/*
+ * Flash access, offsets from the start of the log region
+ * Writes only clear bits, erase sets a whole sector to 0xFF
+ */
+typedef struct SampleLog_Flash {
+    bool (*read)(void *device, uint32_t offset, void *buffer, size_t length);
+    bool (*write)(void *device, uint32_t offset, const void *buffer, size_t length);
+    bool (*erase)(void *device, uint32_t offset, size_t length);
+    void *device;
+    uint32_t sectorSize;
+    uint32_t sectors;
+} SampleLog_Flash;
+
+typedef struct SampleLog_Stats {
+    uint32_t records;           // Appended since open
+    uint32_t bytes;             // Programmed since open, records and headers
+    uint32_t erases;            // Sector erases since open
+    uint32_t reads;             // Flash reads since open
+    uint32_t recoveryReads;     // Of those, used by open
+    uint32_t torn;              // Records found torn by open
+    uint32_t errors;            // Failed flash operations
+    uint32_t minErases;         // Erase counts of the sectors seen
+    uint32_t maxErases;
+} SampleLog_Stats;
+
+typedef struct SampleLog {
+    SampleLog_Flash flash;
+    uint32_t slots;             // Records per sector
+    uint32_t sector;            // Sector being appended
+    uint32_t slot;              // Its next free slot
+    uint32_t sequence;          // Its sequence number
+    uint32_t oldest;            // Sector holding the oldest records
+    uint32_t first;             // Index of the oldest record
+    uint32_t next;              // Index of the next record
+    uint16_t boot;
+    SampleLog_Stats stats;
+} SampleLog;
+
+/*
+ * Read position, SampleLog_next moves it forward
+ * If appends reuse its sector it restarts at the oldest record, the jump
+ * in record indexes shows the records lost
+ */
+typedef struct SampleLog_Cursor {
+    uint32_t sector;
+    uint32_t slot;
+    uint32_t sequence;          // Of its sector when placed there
+} SampleLog_Cursor;
+
+bool SampleLog_open(SampleLog *log, const SampleLog_Flash *flash);
+bool SampleLog_append(SampleLog *log, SampleLog_Record *records, uint32_t count);
+void SampleLog_rewind(SampleLog *log, SampleLog_Cursor *cursor);
+bool SampleLog_seek(SampleLog *log, SampleLog_Cursor *cursor, uint32_t index);
+bool SampleLog_next(SampleLog *log, SampleLog_Cursor *cursor, SampleLog_Record *record);
+
+#endif /* SAMPLELOG_H_ */
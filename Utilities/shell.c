@@ -0,0 +1,579 @@
+/*
+ * shell.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * UART command shell
+ *      Input arrives through the interrupt driven receive ring (uart_rx.h),
+ *      nothing blocks in UART2_read. The shell thread edits one bounded
+ *      line at a time and dispatches "<object> <verb> [args]" through a
+ *      constant command table onto the object methods, i.e.
+ *          tmp0 readtemp 8
+ *          led1 pulse 3
+ */
+
+#include <pthread.h>
+#include <ti/sysbios/BIOS.h>
+
+#include "shell.h"
+#include "TMP117Scan.h"
+#include "myPWMBinding.h"
+#include "uart_tx.h"
+#include "uart_rx.h"
+#include "periodic.h"
+#include "threadstats.h"
+#include "utilities.h"
+
+typedef enum Shell_Type {
+    SHELL_TMP,
+    SHELL_PWM
+} Shell_Type;
+
+/*
+ * Registered object
+ * TMP requests report failures through the object's Completion
+ */
+typedef struct Shell_Object {
+    const char *name;
+    Shell_Type type;
+    void *handle;
+    Completion done;
+} Shell_Object;
+
+typedef bool (*Shell_Fxn)(Shell_Object *object, const char *args);
+
+typedef struct Shell_Frame {
+    uint8_t type;
+    Shell_FrameFxn fxn;
+} Shell_Frame;
+
+typedef struct Shell_Command {
+    Shell_Type type;
+    const char *verb;
+    Shell_Fxn fxn;
+    const char *help;
+} Shell_Command;
+
+Shell_Stats shell_stats;
+
+static Shell_Object shell_objects[SHELL_MAX_OBJECTS];
+static uint8_t shell_object_count = 0;
+static Shell_Frame shell_frames[SHELL_MAX_FRAMES];
+static uint8_t shell_frame_count = 0;
+
+static UART_RX_Reader shell_reader;
+static Thread_Stats shell_thread_stats;
+
+void *Shell_thread(void *arg);
+void Shell_execute_internal(char *line);
+void Shell_frame_internal(const uint8_t *payload, size_t length);
+static Completion *Shell_completion_internal(Shell_Object *object);
+static void Shell_done_internal(Completion *done, void *arg);
+
+static bool Cmd_help(Shell_Object *object, const char *args);
+static bool Cmd_tmp_detect(Shell_Object *object, const char *args);
+static bool Cmd_tmp_readtemp(Shell_Object *object, const char *args);
+static bool Cmd_tmp_monitor(Shell_Object *object, const char *args);
+static bool Cmd_tmp_adapt(Shell_Object *object, const char *args);
+static bool Cmd_tmp_readsn(Shell_Object *object, const char *args);
+static bool Cmd_tmp_writesn(Shell_Object *object, const char *args);
+static bool Cmd_tmp_readid(Shell_Object *object, const char *args);
+static bool Cmd_tmp_readcal(Shell_Object *object, const char *args);
+static bool Cmd_tmp_writecal(Shell_Object *object, const char *args);
+static bool Cmd_tmp_stop(Shell_Object *object, const char *args);
+static bool Cmd_pwm_set(Shell_Object *object, const char *args);
+static bool Cmd_pwm_blink(Shell_Object *object, const char *args);
+static bool Cmd_pwm_pulse(Shell_Object *object, const char *args);
+static bool Cmd_pwm_stop(Shell_Object *object, const char *args);
+
+/*
+ * Command table, verbs per object type
+ */
+static const Shell_Command shell_commands[] = {
+    {SHELL_TMP, "detect",   Cmd_tmp_detect,     ""},
+    {SHELL_TMP, "readtemp", Cmd_tmp_readtemp,   "<count>"},
+    {SHELL_TMP, "monitor",  Cmd_tmp_monitor,    "<period ms>"},
+    {SHELL_TMP, "adapt",    Cmd_tmp_adapt,      "[<min ms> <max ms>]"},
+    {SHELL_TMP, "readsn",   Cmd_tmp_readsn,     ""},
+    {SHELL_TMP, "writesn",  Cmd_tmp_writesn,    "<serial>"},
+    {SHELL_TMP, "readid",   Cmd_tmp_readid,     ""},
+    {SHELL_TMP, "readcal",  Cmd_tmp_readcal,    ""},
+    {SHELL_TMP, "writecal", Cmd_tmp_writecal,   "<offset degC>"},
+    {SHELL_TMP, "stop",     Cmd_tmp_stop,       ""},
+    {SHELL_PWM, "set",      Cmd_pwm_set,        "<0-100>"},
+    {SHELL_PWM, "blink",    Cmd_pwm_blink,      "<count>"},
+    {SHELL_PWM, "pulse",    Cmd_pwm_pulse,      "<count>"},
+    {SHELL_PWM, "stop",     Cmd_pwm_stop,       ""},
+};
+
+#define SHELL_COMMAND_COUNT     (sizeof(shell_commands)/sizeof(shell_commands[0]))
+
+
+/*
+ * Starts the shell thread
+ * Call once after UART_RX_init, the shell is the only consumer of the RX ring
+ */
+void Shell_init(void)
+{
+    memset(&shell_stats, 0, sizeof(Shell_Stats));
+    UART_RX_readerInit(&shell_reader, true);
+
+    pthread_t pth_handle;
+    pthread_attr_t attrs;
+    struct sched_param priParam;
+    int retc;
+
+    /* Initialize the attributes structure with default values */
+    pthread_attr_init(&attrs);
+
+    /* Set priority, detach state, and stack size attributes */
+    priParam.sched_priority = 1;
+    retc                    = pthread_attr_setschedparam(&attrs, &priParam);
+    retc |= pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
+    retc |= pthread_attr_setstacksize(&attrs, SHELL_STACK_SIZE);
+    if (retc != 0){
+        /* failed to set attributes */
+        while (1){}
+    }
+
+    retc = pthread_create(&pth_handle, &attrs, Shell_thread, NULL);
+    if (retc != 0){
+        uart_print_string("!Error: Shell thread creation error!\n");
+    }
+}
+
+/*
+ * Registers a TMP sensor under a name (i.e. "tmp0")
+ *      Returns false if the object table is full
+ */
+bool Shell_addTMP(TMP_Handle *tmp_handle, const char *name)
+{
+    if(shell_object_count >= SHELL_MAX_OBJECTS){
+        return false;
+    }
+    Shell_Object *object = &shell_objects[shell_object_count];
+    memset(object, 0, sizeof(Shell_Object));
+    object->name = name;
+    object->type = SHELL_TMP;
+    object->handle = tmp_handle;
+    Completion_init(&object->done, Shell_done_internal, object);
+    shell_object_count++;
+    return true;
+}
+
+/*
+ * Registers an LED under a name (i.e. "led1")
+ *      Returns false if the object table is full
+ */
+bool Shell_addPWM(myPWM_Handle *pwm_handle, const char *name)
+{
+    if(shell_object_count >= SHELL_MAX_OBJECTS){
+        return false;
+    }
+    Shell_Object *object = &shell_objects[shell_object_count];
+    memset(object, 0, sizeof(Shell_Object));
+    object->name = name;
+    object->type = SHELL_PWM;
+    object->handle = pwm_handle;
+    shell_object_count++;
+    return true;
+}
+
+/*
+ * Routes binary frames of one type (protocol.h) to a handler
+ * The handler runs in the shell thread and should hand long work off
+ *      Returns false if the frame table is full
+ */
+bool Shell_addFrame(uint8_t type, Shell_FrameFxn fxn)
+{
+    if(shell_frame_count >= SHELL_MAX_FRAMES){
+        return false;
+    }
+    shell_frames[shell_frame_count].type = type;
+    shell_frames[shell_frame_count].fxn = fxn;
+    shell_frame_count++;
+    return true;
+}
+
+/*
+ * Prints the lines and frames taken and those that matched nothing
+ */
+void Shell_print(void)
+{
+    uart_print_string("shell lines ");
+    uart_print_uint32(shell_stats.lines);
+    uart_print_string(" frames ");
+    uart_print_uint32(shell_stats.frames);
+    uart_print_string(" unknown ");
+    uart_print_uint32(shell_stats.unknown);
+    uart_print_string("\n");
+}
+
+/*
+ * Shell Thread
+ */
+void *Shell_thread(void *arg)
+{
+    (void)arg;
+    ThreadStats_register(&shell_thread_stats, "shell", SHELL_STACK_SIZE);
+    while(1){
+        ThreadStats_block(&shell_thread_stats);
+        if(!UART_RX_wait(UART_RX_timeout(&shell_reader))){
+            UART_RX_idle(&shell_reader);
+        }
+        ThreadStats_wake(&shell_thread_stats);
+        UART_RX_Item item;
+        while((item = UART_RX_next(&shell_reader)) != UART_RX_NONE){
+            if(item == UART_RX_LINE){
+                Shell_execute_internal(shell_reader.line);
+            }
+            else{
+                Shell_frame_internal(shell_reader.frame, shell_reader.frameLength);
+            }
+        }
+    }
+}
+
+/*
+ * Splits the next space separated word off the line
+ */
+static char *Shell_token_internal(char **cursor)
+{
+    char *start = *cursor;
+    while(*start == ' '){
+        start++;
+    }
+    if(*start == '\0'){
+        *cursor = start;
+        return NULL;
+    }
+    char *end = start;
+    while(*end != ' ' && *end != '\0'){
+        end++;
+    }
+    if(*end == ' '){
+        *end++ = '\0';
+    }
+    *cursor = end;
+    return start;
+}
+
+/*
+ * Looks up the object and verb and runs the command
+ */
+void Shell_execute_internal(char *line)
+{
+    char *cursor = line;
+    char *name = Shell_token_internal(&cursor);
+    char *verb = Shell_token_internal(&cursor);
+    while(*cursor == ' '){
+        cursor++;
+    }
+    shell_stats.lines++;
+
+    if(name == NULL){
+        return;
+    }
+    if(!strcmp(name, "help")){
+        Cmd_help(NULL, cursor);
+        return;
+    }
+    if(!strcmp(name, "stats")){
+        ThreadStats_print();
+        Active_print();
+        Periodic_print();
+        Binding_print();
+        UART_TX_print();
+        UART_RX_print(&shell_reader);
+        Shell_print();
+        return;
+    }
+    if(!strcmp(name, "boot")){
+        TMP_Boot_print();
+        return;
+    }
+
+    uint8_t n = 0;
+    for(; n<shell_object_count; n++){
+        if(!strcmp(name, shell_objects[n].name)){
+            break;
+        }
+    }
+    if(n == shell_object_count || verb == NULL){
+        shell_stats.unknown++;
+        uart_print_string("!Error: Unknown command, try help\n");
+        return;
+    }
+
+    Shell_Object *object = &shell_objects[n];
+    uint8_t c = 0;
+    for(; c<SHELL_COMMAND_COUNT; c++){
+        if(shell_commands[c].type == object->type && !strcmp(verb, shell_commands[c].verb)){
+            if(!shell_commands[c].fxn(object, cursor)){
+                uart_print_string("!Error: Usage: ");
+                uart_print_string(object->name);
+                uart_print_string(" ");
+                uart_print_string(shell_commands[c].verb);
+                uart_print_string(" ");
+                uart_print_string(shell_commands[c].help);
+                uart_print_string("\n");
+            }
+            return;
+        }
+    }
+    shell_stats.unknown++;
+    uart_print_string("!Error: Unknown command, try help\n");
+}
+
+/*
+ * Looks up the handler of a frame type
+ */
+void Shell_frame_internal(const uint8_t *payload, size_t length)
+{
+    uint8_t n = 0;
+    for(; n<shell_frame_count; n++){
+        if(shell_frames[n].type == payload[0]){
+            shell_stats.frames++;
+            shell_frames[n].fxn(payload, length);
+            return;
+        }
+    }
+    shell_stats.unknown++;
+}
+
+/*
+ * Lists the registered objects and their verbs
+ */
+static bool Cmd_help(Shell_Object *object, const char *args)
+{
+    (void)object;
+    (void)args;
+    uart_print_string("help\nstats\nboot\n");
+    uint8_t n = 0;
+    for(; n<shell_object_count; n++){
+        uint8_t c = 0;
+        for(; c<SHELL_COMMAND_COUNT; c++){
+            if(shell_commands[c].type == shell_objects[n].type){
+                uart_print_string(shell_objects[n].name);
+                uart_print_string(" ");
+                uart_print_string(shell_commands[c].verb);
+                uart_print_string(" ");
+                uart_print_string(shell_commands[c].help);
+                uart_print_string("\n");
+            }
+        }
+    }
+    return true;
+}
+
+/*
+ * Parses one optional unsigned argument with a default and a maximum
+ */
+static bool Shell_arg_internal(const char *args, uint32_t fallback, uint32_t max, uint32_t *value)
+{
+    if(*args == '\0'){
+        *value = fallback;
+        return true;
+    }
+    return parseUint32(args, value, NULL) == PARSE_OK && *value <= max;
+}
+
+/*
+ * Token for the next TMP request, NULL while the last one is still pending
+ */
+static Completion *Shell_completion_internal(Shell_Object *object)
+{
+    return (Completion_poll(&object->done) == COMPLETION_Pending) ? NULL : &object->done;
+}
+
+/*
+ * Reports a TMP request that did not complete, runs in the sensor thread
+ */
+static void Shell_done_internal(Completion *done, void *arg)
+{
+    Shell_Object *object = (Shell_Object*)arg;
+    switch(Completion_poll(done)){
+        case COMPLETION_Failed:
+            uart_print_string(object->name);
+            uart_print_string(" failed\n");
+            break;
+        case COMPLETION_Dropped:
+            uart_print_string(object->name);
+            uart_print_string(" busy\n");
+            break;
+        default:
+            break;
+    }
+}
+
+static bool Cmd_tmp_detect(Shell_Object *object, const char *args)
+{
+    (void)args;
+    TMP_Handle *handle = (TMP_Handle*)object->handle;
+    handle->Detect(handle, Shell_completion_internal(object));
+    return true;
+}
+
+static bool Cmd_tmp_readtemp(Shell_Object *object, const char *args)
+{
+    TMP_Handle *handle = (TMP_Handle*)object->handle;
+    uint32_t count;
+    if(!Shell_arg_internal(args, 1, 255, &count) || !count){
+        return false;
+    }
+    handle->ReadTemp(handle, (uint8_t)count, Shell_completion_internal(object));
+    return true;
+}
+
+static bool Cmd_tmp_monitor(Shell_Object *object, const char *args)
+{
+    TMP_Handle *handle = (TMP_Handle*)object->handle;
+    uint32_t period;
+    if(!Shell_arg_internal(args, 1000, 65535, &period) || !period){
+        return false;
+    }
+    handle->Monitor(handle, (uint16_t)period, Shell_completion_internal(object));
+    return true;
+}
+
+/*
+ * Starts Adapt, or without arguments reports the running one: samples,
+ * average rate, transients, bus time used and saved against a fixed
+ * minimum period
+ */
+static bool Cmd_tmp_adapt(Shell_Object *object, const char *args)
+{
+    TMP_Handle *handle = (TMP_Handle*)object->handle;
+    uint32_t min, max;
+    const char *end;
+
+    if(*args == '\0'){
+        const Adaptive_Stats *stats = &handle->adapt.stats;
+        uint32_t fixed = Adaptive_fixedSamples(&handle->adapt);
+        uint32_t perSample = stats->samples ? (uint32_t)(stats->busTime_us / stats->samples) : 0;
+        uart_print_string(object->name);
+        uart_print_string(" samples ");
+        uart_print_uint32(stats->samples);
+        uart_print_string(" of ");
+        uart_print_uint32(fixed);
+        uart_print_string(" fixed, mHz ");
+        uart_print_uint32(stats->elapsed_us ? (uint32_t)((uint64_t)stats->samples * 1000000000 / stats->elapsed_us) : 0);
+        uart_print_string(", period ms ");
+        uart_print_uint32(handle->adapt.period_us / 1000);
+        uart_print_string(", transients ");
+        uart_print_uint32(stats->transients);
+        uart_print_string(", bus us ");
+        uart_print_uint32((uint32_t)stats->busTime_us);
+        uart_print_string(" saved ");
+        uart_print_uint32((fixed > stats->samples) ? (fixed - stats->samples) * perSample : 0);
+        uart_print_string("\n");
+        return true;
+    }
+    if(parseUint32(args, &min, &end) != PARSE_OK || min > 65535){
+        return false;
+    }
+    while(*end == ' '){
+        end++;
+    }
+    if(parseUint32(end, &max, NULL) != PARSE_OK || max > 65535 || max < min){
+        return false;
+    }
+    handle->Adapt(handle, (uint16_t)min, (uint16_t)max, Shell_completion_internal(object));
+    return true;
+}
+
+static bool Cmd_tmp_readsn(Shell_Object *object, const char *args)
+{
+    (void)args;
+    TMP_Handle *handle = (TMP_Handle*)object->handle;
+    handle->ReadSN(handle, Shell_completion_internal(object));
+    return true;
+}
+
+static bool Cmd_tmp_writesn(Shell_Object *object, const char *args)
+{
+    TMP_Handle *handle = (TMP_Handle*)object->handle;
+    uint32_t serialNo;
+    if(parseUint32(args, &serialNo, NULL) != PARSE_OK){
+        return false;
+    }
+    handle->WriteSN(handle, serialNo, Shell_completion_internal(object));
+    return true;
+}
+
+static bool Cmd_tmp_readid(Shell_Object *object, const char *args)
+{
+    (void)args;
+    TMP_Handle *handle = (TMP_Handle*)object->handle;
+    handle->ReadID(handle, Shell_completion_internal(object));
+    return true;
+}
+
+static bool Cmd_tmp_readcal(Shell_Object *object, const char *args)
+{
+    (void)args;
+    TMP_Handle *handle = (TMP_Handle*)object->handle;
+    handle->ReadCal(handle, Shell_completion_internal(object));
+    return true;
+}
+
+static bool Cmd_tmp_writecal(Shell_Object *object, const char *args)
+{
+    TMP_Handle *handle = (TMP_Handle*)object->handle;
+    int32_t offset;
+    if(parseFixed(args, 7, &offset, NULL) != PARSE_OK || offset < INT16_MIN || offset > INT16_MAX){
+        return false;
+    }
+    handle->WriteCal(handle, offset / 128.0f, Shell_completion_internal(object)); // Exact, the register is Q7
+    return true;
+}
+
+static bool Cmd_tmp_stop(Shell_Object *object, const char *args)
+{
+    (void)args;
+    TMP_Handle *handle = (TMP_Handle*)object->handle;
+    handle->Stop(handle);
+    return true;
+}
+
+static bool Cmd_pwm_set(Shell_Object *object, const char *args)
+{
+    myPWM_Handle *handle = (myPWM_Handle*)object->handle;
+    uint32_t level;
+    if(parseUint32(args, &level, NULL) != PARSE_OK || level > 100){
+        return false;
+    }
+    handle->Set(handle, (uint8_t)level);
+    return true;
+}
+
+static bool Cmd_pwm_blink(Shell_Object *object, const char *args)
+{
+    myPWM_Handle *handle = (myPWM_Handle*)object->handle;
+    uint32_t count;
+    if(!Shell_arg_internal(args, 1, 255, &count)){
+        return false;
+    }
+    handle->Blink(handle, (uint8_t)count);
+    return true;
+}
+
+static bool Cmd_pwm_pulse(Shell_Object *object, const char *args)
+{
+    myPWM_Handle *handle = (myPWM_Handle*)object->handle;
+    uint32_t count;
+    if(!Shell_arg_internal(args, 1, 255, &count)){
+        return false;
+    }
+    handle->Pulse(handle, (uint8_t)count);
+    return true;
+}
+
+static bool Cmd_pwm_stop(Shell_Object *object, const char *args)
+{
+    (void)args;
+    myPWM_Handle *handle = (myPWM_Handle*)object->handle;
+    handle->Stop(handle);
+    return true;
+}
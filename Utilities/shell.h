@@ -0,0 +1,44 @@
+/*
+ * shell.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#ifndef SHELL_H_
+#define SHELL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "TMP117.h"
+#include "myPWM.h"
+
+/* Stack of the shell thread */
+#define SHELL_STACK_SIZE        2048
+
+/* Objects that can be registered with the shell */
+#define SHELL_MAX_OBJECTS       16
+
+/* Binary frame types that can be routed by the shell */
+#define SHELL_MAX_FRAMES        4
+
+/* Receives a frame payload from the shell thread, CRC checked and removed */
+typedef void (*Shell_FrameFxn)(const uint8_t *payload, size_t length);
+
+typedef struct Shell_Stats {
+    uint32_t lines;             // Lines executed
+    uint32_t unknown;           // Lines or frames that did not match a command
+    uint32_t frames;            // Frames routed to a handler
+} Shell_Stats;
+
+extern Shell_Stats shell_stats;
+
+void Shell_init(void);
+bool Shell_addTMP(TMP_Handle *tmp_handle, const char *name);
+bool Shell_addPWM(myPWM_Handle *pwm_handle, const char *name);
+bool Shell_addFrame(uint8_t type, Shell_FrameFxn fxn);
+void Shell_print(void);
+
+#endif /* SHELL_H_ */
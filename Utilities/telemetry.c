@@ -0,0 +1,110 @@
+/*
+ * telemetry.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#include "telemetry.h"
+#include "framing.h"
+#include "uart_tx.h"
+#include "utilities.h"
+
+#define TLM_PAYLOAD_MAX         (TLM_HEADER_SIZE + 2*TLM_MAX_SAMPLES + TLM_CRC_SIZE)
+
+void Telemetry_sample(TMP_Handle *tmp_handle, const TMP_Sample *sample, void *arg);
+
+
+/*
+ * Streams every sample of a TMP sensor as binary frames
+ * Samples come from ReadTemp, Monitor or a controller reading the sensor
+ *
+ * Input stream storage, must stay valid while streaming
+ * Input TMP handle opened with Open_TMP
+ * Input sensor ID written into every frame
+ * Input samples per frame, more samples per frame means less overhead per sample
+ *      Returns false if the sensor cannot take another subscriber
+ */
+bool Telemetry_addTMP(Telemetry_Stream *stream, TMP_Handle *tmp_handle, uint8_t sensorId, uint8_t perFrame)
+{
+    memset(stream, 0, sizeof(Telemetry_Stream));
+    stream->sensorId = sensorId;
+    if(perFrame < 1){
+        perFrame = 1;
+    }
+    if(perFrame > TLM_MAX_SAMPLES){
+        perFrame = TLM_MAX_SAMPLES;
+    }
+    stream->perFrame = perFrame;
+    stream->enabled = true;
+    return TMP_Subscribe(tmp_handle, Telemetry_sample, stream);
+}
+
+/*
+ * Sample subscriber - called inside the TMP thread
+ */
+void Telemetry_sample(TMP_Handle *tmp_handle, const TMP_Sample *sample, void *arg)
+{
+    Telemetry_Stream *stream = (Telemetry_Stream*)arg;
+    if(!stream->enabled){
+        return;
+    }
+    stream->stats.samples++;
+    if(!stream->count){
+        stream->firstTime_us = (uint32_t)sample->timestamp_us;
+    }
+    stream->lastTime_us = (uint32_t)sample->timestamp_us;
+    stream->samples[stream->count++] = sample->raw;
+    if(stream->count >= stream->perFrame){
+        Telemetry_flush(stream);
+    }
+}
+
+/*
+ * Sends the samples collected so far as one frame
+ */
+void Telemetry_flush(Telemetry_Stream *stream)
+{
+    uint8_t payload[TLM_PAYLOAD_MAX];
+    uint8_t frame[COBS_MAX_ENCODED(TLM_PAYLOAD_MAX) + 1];
+    size_t length = 0;
+
+    if(!stream->count){
+        return;
+    }
+
+    payload[length++] = TLM_TYPE_SAMPLES;
+    payload[length++] = stream->sensorId;
+    payload[length++] = (uint8_t)(stream->sequence);
+    payload[length++] = (uint8_t)(stream->sequence >> 8);
+    payload[length++] = (uint8_t)(stream->firstTime_us);
+    payload[length++] = (uint8_t)(stream->firstTime_us >> 8);
+    payload[length++] = (uint8_t)(stream->firstTime_us >> 16);
+    payload[length++] = (uint8_t)(stream->firstTime_us >> 24);
+    payload[length++] = (uint8_t)(stream->lastTime_us);
+    payload[length++] = (uint8_t)(stream->lastTime_us >> 8);
+    payload[length++] = (uint8_t)(stream->lastTime_us >> 16);
+    payload[length++] = (uint8_t)(stream->lastTime_us >> 24);
+    payload[length++] = stream->count;
+    uint8_t n = 0;
+    for(; n<stream->count; n++){
+        payload[length++] = (uint8_t)(stream->samples[n]);
+        payload[length++] = (uint8_t)((uint16_t)stream->samples[n] >> 8);
+    }
+    uint16_t crc = crc16(payload, length, 0xFFFF);
+    payload[length++] = (uint8_t)(crc);
+    payload[length++] = (uint8_t)(crc >> 8);
+
+    size_t encoded = cobs_encode(payload, length, frame);
+    frame[encoded++] = FRAME_DELIMITER;
+
+    if(UART_TX_write((const char*)frame, encoded)){
+        stream->stats.frames++;
+        stream->stats.bytes += encoded;
+    }
+    else{
+        stream->stats.dropped++;
+    }
+    stream->sequence++;
+    stream->count = 0;
+}
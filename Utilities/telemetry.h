@@ -0,0 +1,45 @@
+/*
+ * telemetry.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Binary sample streaming, frame format in protocol.h
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "TMP117.h"
+#include "protocol.h"
+
+typedef struct Telemetry_Stats {
+    uint32_t samples;           // Samples received from the sensor
+    uint32_t frames;            // Frames queued for transmission
+    uint32_t bytes;             // Bytes queued including framing
+    uint32_t dropped;           // Frames refused by the UART TX ring
+} Telemetry_Stats;
+
+/*
+ * One sensor streaming to the UART
+ * Caller owned, must stay valid while streaming
+ */
+typedef struct Telemetry_Stream {
+    uint8_t sensorId;
+    uint8_t perFrame;           // Samples per frame, 1 to TLM_MAX_SAMPLES
+    bool enabled;               // Clear to pause the stream
+    uint16_t sequence;
+    uint8_t count;
+    uint32_t firstTime_us;
+    uint32_t lastTime_us;
+    int16_t samples[TLM_MAX_SAMPLES];
+    Telemetry_Stats stats;
+} Telemetry_Stream;
+
+bool Telemetry_addTMP(Telemetry_Stream *stream, TMP_Handle *tmp_handle, uint8_t sensorId, uint8_t perFrame);
+void Telemetry_flush(Telemetry_Stream *stream);
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,193 @@
+/*
+ * threadstats.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#include <pthread.h>
+
+#include "threadstats.h"
+#include "utilities.h"
+
+static Thread_Stats *thread_list[THREAD_STATS_MAX];
+static uint32_t thread_count = 0;
+static pthread_key_t thread_key;
+static pthread_once_t thread_once = PTHREAD_ONCE_INIT;
+static int thread_hookId = -1;
+
+static void ThreadStats_init(void)
+{
+    pthread_key_create(&thread_key, NULL);
+}
+
+/*
+ * Registers the calling thread, call first thing in the thread function
+ * Input stats storage, usually inside the object handle
+ * Input name shown by ThreadStats_print
+ * Input stack size the thread was created with
+ */
+void ThreadStats_register(Thread_Stats *stats, const char *name, uint32_t stackSize)
+{
+    pthread_once(&thread_once, ThreadStats_init);
+
+    memset(stats, 0, sizeof(Thread_Stats));
+    stats->name = name;
+    stats->task = Task_self();
+    stats->stackSize = stackSize;
+    stats->since_us = clock_us();
+    stats->running = true;
+    pthread_setspecific(thread_key, stats);
+    if(thread_hookId >= 0 && stats->task != NULL){
+        stats->in_us = stats->since_us;  // Running now, the hook takes it from here
+        Task_setHookContext(stats->task, thread_hookId, stats);
+    }
+
+    uint32_t slot = __atomic_fetch_add(&thread_count, 1, __ATOMIC_RELAXED);
+    if(slot < THREAD_STATS_MAX){
+        __atomic_store_n(&thread_list[slot], stats, __ATOMIC_RELEASE);
+    }
+}
+
+/*
+ * Stats of the calling thread, NULL if it never registered
+ */
+Thread_Stats *ThreadStats_self(void)
+{
+    if(!__atomic_load_n(&thread_count, __ATOMIC_RELAXED)){
+        return NULL;
+    }
+    return (Thread_Stats*)pthread_getspecific(thread_key);
+}
+
+/*
+ * Call right before the thread waits
+ */
+void ThreadStats_block(Thread_Stats *stats)
+{
+    if(stats == NULL || !stats->running){
+        return;
+    }
+    uint64_t now = clock_us();
+    uint32_t run = (uint32_t)(now - stats->since_us);
+    stats->run_us += run;
+    if(run > stats->maxRun_us){
+        stats->maxRun_us = run;
+    }
+    stats->since_us = now;
+    stats->running = false;
+}
+
+/*
+ * Call right after the wait returns
+ */
+void ThreadStats_wake(Thread_Stats *stats)
+{
+    if(stats == NULL || stats->running){
+        return;
+    }
+    uint64_t now = clock_us();
+    stats->blocked_us += now - stats->since_us;
+    stats->since_us = now;
+    stats->wakes++;
+    stats->running = true;
+}
+
+/*
+ * Deepest stack use so far in bytes
+ */
+uint32_t ThreadStats_stackUsed(Thread_Stats *stats)
+{
+    Task_Stat stat;
+    if(stats->task == NULL){
+        return 0;
+    }
+    Task_stat(stats->task, &stat);
+    return (uint32_t)stat.used;
+}
+
+/*
+ * Task hook set register function, keeps the hook set id
+ */
+void ThreadStats_hookRegister(int id)
+{
+    thread_hookId = id;
+}
+
+/*
+ * Task switch hook, charges the time since prev was switched in to prev
+ * Runs in the scheduler with interrupts enabled, threads that never
+ * registered have no hook context and are skipped
+ */
+void ThreadStats_hookSwitch(Task_Handle prev, Task_Handle next)
+{
+    Thread_Stats *stats;
+    uint64_t now;
+    if(thread_hookId < 0){
+        return;
+    }
+    now = clock_us();
+    if(prev != NULL){
+        stats = (Thread_Stats*)Task_getHookContext(prev, thread_hookId);
+        if(stats != NULL){
+            stats->cpu_us += now - stats->in_us;
+        }
+    }
+    stats = (Thread_Stats*)Task_getHookContext(next, thread_hookId);
+    if(stats != NULL){
+        stats->in_us = now;
+    }
+}
+
+/*
+ * Prints one line per registered thread
+ *      name  stack used/size  wakes  cpu ms  wall ms  blocked ms  max wall us  load %
+ * Wall is the time between wake and block, preemption included
+ * Load is CPU time over the time since registration
+ */
+void ThreadStats_print(void)
+{
+    uint32_t count = __atomic_load_n(&thread_count, __ATOMIC_RELAXED);
+    uint32_t n = 0;
+
+    if(count > THREAD_STATS_MAX){
+        count = THREAD_STATS_MAX;
+    }
+    uart_print_string("thread stack/size wakes cpu_ms wall_ms blocked_ms maxwall_us load%\n");
+    for(; n<count; n++){
+        Thread_Stats *stats = __atomic_load_n(&thread_list[n], __ATOMIC_ACQUIRE);
+        if(stats == NULL){
+            continue;
+        }
+        uint64_t run = stats->run_us;
+        uint64_t blocked = stats->blocked_us;
+        uint64_t open = clock_us() - stats->since_us;   // Current activation or wait
+        if(stats->running){
+            run += open;
+        }
+        else{
+            blocked += open;
+        }
+        uint64_t cpu = stats->cpu_us;
+        uint32_t load = (run + blocked) ? (uint32_t)((cpu * 100) / (run + blocked)) : 0;
+
+        uart_print_string(stats->name);
+        uart_print_string(" ");
+        uart_print_uint32(ThreadStats_stackUsed(stats));
+        uart_print_string("/");
+        uart_print_uint32(stats->stackSize);
+        uart_print_string(" ");
+        uart_print_uint32(stats->wakes);
+        uart_print_string(" ");
+        uart_print_uint32((uint32_t)(cpu / 1000));
+        uart_print_string(" ");
+        uart_print_uint32((uint32_t)(run / 1000));
+        uart_print_string(" ");
+        uart_print_uint32((uint32_t)(blocked / 1000));
+        uart_print_string(" ");
+        uart_print_uint32(stats->maxRun_us);
+        uart_print_string(" ");
+        uart_print_uint32(load);
+        uart_print_string("\n");
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ * threadstats.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Per thread stack and load instrumentation
+ *      Each thread registers its Thread_Stats once and marks where it
+ *      blocks and wakes (the semaphore pend in its loop, Periodic_wait).
+ *      Wall time is the time between a wake and the next block, so it
+ *      includes time preempted by higher priority threads, it shows how
+ *      long an activation takes to finish.
+ *      CPU time is added up by a Task switch hook from the time the thread
+ *      is switched in to the time it is switched out, so preemption is not
+ *      charged. Interrupts taken meanwhile still are. The hook set is added
+ *      to the kernel configuration:
+ *          Task.addHookSet({registerFxn: '&ThreadStats_hookRegister',
+ *                           switchFxn: '&ThreadStats_hookSwitch'});
+ *      Without it CPU time and load read 0.
+ *      The stack high-water mark comes from Task_stat, which scans the
+ *      unused fill pattern of the stack.
+ */
+
+#ifndef THREADSTATS_H_
+#define THREADSTATS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ti/sysbios/knl/Task.h>
+
+/* Threads that can be listed by ThreadStats_print */
+#define THREAD_STATS_MAX        16
+
+typedef struct Thread_Stats {
+    const char *name;
+    Task_Handle task;           // Set by ThreadStats_register in the thread itself
+    uint32_t stackSize;         // Bytes given to pthread_attr_setstacksize
+    uint32_t wakes;
+    uint32_t maxRun_us;         // Longest single activation, wall time
+    bool running;
+    uint64_t run_us;            // Total wall time between wake and block
+    uint64_t blocked_us;        // Total time waiting
+    uint64_t since_us;          // Time of the last wake or block
+    uint64_t cpu_us;            // Total time switched in, from the switch hook
+    uint64_t in_us;             // Time it was last switched in
+} Thread_Stats;
+
+void ThreadStats_register(Thread_Stats *stats, const char *name, uint32_t stackSize);
+Thread_Stats *ThreadStats_self(void);
+void ThreadStats_block(Thread_Stats *stats);
+void ThreadStats_wake(Thread_Stats *stats);
+uint32_t ThreadStats_stackUsed(Thread_Stats *stats);
+void ThreadStats_print(void);
+void ThreadStats_hookRegister(int id);
+void ThreadStats_hookSwitch(Task_Handle prev, Task_Handle next);
+
+#endif /* THREADSTATS_H_ */
@@ -0,0 +1,363 @@
+/*
+ * uart_rx.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * The read callback is the only producer and advances rx_head, the
+ * consumer thread is the only reader and advances rx_tail. The driver
+ * keeps its own buffer while the callback runs, so bytes arriving between
+ * two reads are not lost as long as the consumer keeps the ring drained.
+ */
+
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include "uart_rx.h"
+#include "protocol.h"
+#include "utilities.h"
+
+#define UART_RX_MASK            (UART_RX_SIZE - 1)
+
+UART_RX_Stats uart_rx_stats;
+
+static uint8_t rx_ring[UART_RX_SIZE];
+static uint32_t rx_head = 0;            // Written by the read callback only
+static uint32_t rx_tail = 0;            // Written by the consumer only
+static uint8_t rx_chunk[UART_RX_CHUNK];
+static Semaphore_Handle rx_sem = NULL;
+
+void UART_RX_callback(UART2_Handle handle, void *buffer, size_t count, void *userArg, int_fast16_t status);
+static bool UART_RX_edit_internal(UART_RX_Reader *reader, char input);
+static bool UART_RX_frame_internal(UART_RX_Reader *reader);
+
+
+/*
+ * Sets the UART read side to callback mode
+ * Call on the parameters before UART2_open, the write side is unchanged
+ */
+void UART_RX_params(UART2_Params *params)
+{
+    params->readMode = UART2_Mode_CALLBACK;
+    params->readCallback = UART_RX_callback;
+    params->readReturnMode = UART2_ReadReturnMode_PARTIAL;
+}
+
+/*
+ * Starts receiving
+ * Call once after UART2_open with UART_RX_params
+ */
+void UART_RX_init(void)
+{
+    memset(&uart_rx_stats, 0, sizeof(UART_RX_Stats));
+
+    Semaphore_Params sem_params;
+    Semaphore_Params_init(&sem_params);
+    sem_params.mode = Semaphore_Mode_BINARY;
+    rx_sem = Semaphore_create(0, &sem_params, NULL);
+
+    UART2_read(uart, rx_chunk, UART_RX_CHUNK, NULL);
+}
+
+/*
+ * UART read callback - runs in interrupt context
+ * Copies the received bytes into the ring and restarts the read
+ */
+void UART_RX_callback(UART2_Handle handle, void *buffer, size_t count, void *userArg, int_fast16_t status)
+{
+    (void)userArg;
+    uint8_t *bytes = (uint8_t*)buffer;
+    uint32_t head = rx_head;
+    uint32_t tail = __atomic_load_n(&rx_tail, __ATOMIC_ACQUIRE);
+    size_t n = 0;
+
+    if(status == UART2_STATUS_EOVERRUN){
+        uart_rx_stats.uartOverruns++;
+    }
+    for(; n<count; n++){
+        if(head - tail >= UART_RX_SIZE){
+            uart_rx_stats.rxOverruns += count - n;
+            break;
+        }
+        rx_ring[head & UART_RX_MASK] = bytes[n];
+        head++;
+    }
+    uart_rx_stats.bytes += n;
+    if(head - tail > uart_rx_stats.maxLevel){
+        uart_rx_stats.maxLevel = head - tail;
+    }
+    __atomic_store_n(&rx_head, head, __ATOMIC_RELEASE);
+    if(n){
+        Semaphore_post(rx_sem);
+    }
+
+    UART2_read(handle, rx_chunk, UART_RX_CHUNK, NULL);
+}
+
+/*
+ * Waits for input
+ * Input timeout in system ticks, BIOS_WAIT_FOREVER to block
+ *      Returns true if bytes are waiting in the ring
+ */
+bool UART_RX_wait(uint32_t timeout)
+{
+    if(__atomic_load_n(&rx_head, __ATOMIC_ACQUIRE) != rx_tail){
+        return true;
+    }
+    Semaphore_pend(rx_sem, timeout);
+    return __atomic_load_n(&rx_head, __ATOMIC_ACQUIRE) != rx_tail;
+}
+
+/*
+ * Copies out up to size received bytes without waiting
+ *      Returns the number of bytes copied
+ */
+size_t UART_RX_read(uint8_t *data, size_t size)
+{
+    uint32_t tail = rx_tail;
+    uint32_t level = __atomic_load_n(&rx_head, __ATOMIC_ACQUIRE) - tail;
+    if(size > level){
+        size = level;
+    }
+    uint32_t offset = tail & UART_RX_MASK;
+    size_t first = UART_RX_SIZE - offset;
+    if(first > size){
+        first = size;
+    }
+    memcpy(data, &rx_ring[offset], first);
+    memcpy(data + first, &rx_ring[0], size - first);
+    __atomic_store_n(&rx_tail, tail + size, __ATOMIC_RELEASE);
+    return size;
+}
+
+/*
+ * Resets a reader
+ * Input echo, true for an interactive terminal
+ */
+void UART_RX_readerInit(UART_RX_Reader *reader, bool echo)
+{
+    memset(reader, 0, sizeof(UART_RX_Reader));
+    reader->echo = echo;
+}
+
+/*
+ * Takes bytes from the ring until a line or a frame is complete
+ *      Returns UART_RX_NONE once the ring is empty, partial input is kept
+ */
+UART_RX_Item UART_RX_next(UART_RX_Reader *reader)
+{
+    uint32_t tail = rx_tail;
+    uint32_t head = __atomic_load_n(&rx_head, __ATOMIC_ACQUIRE);
+    UART_RX_Item item = UART_RX_NONE;
+
+    // Text given back by UART_RX_idle comes before the ring
+    while(reader->replay < reader->replayLength){
+        if(UART_RX_edit_internal(reader, (char)reader->encoded[reader->replay++])){
+            return UART_RX_LINE;
+        }
+    }
+
+    while(tail != head && item == UART_RX_NONE){
+        uint8_t byte = rx_ring[tail & UART_RX_MASK];
+        tail++;
+
+        if(byte == FRAME_DELIMITER){
+            if(!reader->inFrame){
+                if(reader->lineLength || reader->lineBinary){
+                    reader->stats.discarded++;
+                    reader->lineLength = 0;
+                    reader->lineBinary = false;
+                }
+                reader->inFrame = true;
+            }
+            else if(UART_RX_frame_internal(reader)){
+                item = UART_RX_FRAME;
+                reader->inFrame = false;
+            }
+            // Otherwise a duplicate, or a bad frame whose closing delimiter opens the next one
+            reader->encodedLength = 0;
+            reader->framePrintable = true;
+            continue;
+        }
+        if(reader->inFrame){
+            if(byte != '\r' && byte != '\n' && (byte < ' ' || byte > '~')){
+                reader->framePrintable = false;
+            }
+            if(reader->encodedLength < sizeof(reader->encoded)){
+                reader->encoded[reader->encodedLength++] = byte;
+                continue;
+            }
+            // Longer than any frame, text after a lost closing delimiter
+            reader->stats.framingErrors++;
+            reader->inFrame = false;
+            reader->encodedLength = 0;
+        }
+        if(UART_RX_edit_internal(reader, (char)byte)){
+            item = UART_RX_LINE;
+        }
+    }
+    __atomic_store_n(&rx_tail, tail, __ATOMIC_RELEASE);
+    return item;
+}
+
+/*
+ * Timeout for UART_RX_wait
+ *      Returns UART_RX_IDLE_MS in ticks while a frame is open, else BIOS_WAIT_FOREVER
+ */
+uint32_t UART_RX_timeout(const UART_RX_Reader *reader)
+{
+    if(!reader->inFrame){
+        return BIOS_WAIT_FOREVER;
+    }
+    return (UART_RX_IDLE_MS * 1000 + Clock_tickPeriod - 1) / Clock_tickPeriod;
+}
+
+/*
+ * Ends an open frame after the line went quiet, call when UART_RX_wait
+ * with UART_RX_timeout returns false
+ * Bytes that were all printable are given back to UART_RX_next as text,
+ * i.e. typing after a duplicated delimiter
+ */
+void UART_RX_idle(UART_RX_Reader *reader)
+{
+    if(!reader->inFrame){
+        return;
+    }
+    reader->inFrame = false;
+    if(!reader->encodedLength){
+        return; // Lone delimiter
+    }
+    reader->stats.resyncs++;
+    if(reader->framePrintable){
+        reader->replay = 0;
+        reader->replayLength = reader->encodedLength;
+    }
+    else{
+        reader->stats.framingErrors++;
+    }
+    reader->encodedLength = 0;
+}
+
+/*
+ * Prints the ring statistics and those of one reader
+ * Input reader or NULL for the ring only
+ */
+void UART_RX_print(const UART_RX_Reader *reader)
+{
+    uart_print_string("uart_rx bytes ");
+    uart_print_uint32(uart_rx_stats.bytes);
+    uart_print_string(" overruns ring/uart ");
+    uart_print_uint32(uart_rx_stats.rxOverruns);
+    uart_print_string("/");
+    uart_print_uint32(uart_rx_stats.uartOverruns);
+    uart_print_string(" maxlevel ");
+    uart_print_uint32(uart_rx_stats.maxLevel);
+    uart_print_string("\n");
+    if(reader == NULL){
+        return;
+    }
+    uart_print_string("reader lines ");
+    uart_print_uint32(reader->stats.lines);
+    uart_print_string(" truncated ");
+    uart_print_uint32(reader->stats.truncated);
+    uart_print_string(" discarded ");
+    uart_print_uint32(reader->stats.discarded);
+    uart_print_string(" frames ");
+    uart_print_uint32(reader->stats.frames);
+    uart_print_string(" crc ");
+    uart_print_uint32(reader->stats.crcErrors);
+    uart_print_string(" framing ");
+    uart_print_uint32(reader->stats.framingErrors);
+    uart_print_string(" resyncs ");
+    uart_print_uint32(reader->stats.resyncs);
+    uart_print_string("\n");
+}
+
+/*
+ * Line editor
+ * Handles backspace, Ctrl-C/ESC to clear and refuses characters once
+ * the line is full, echoes when the reader is interactive. A line with
+ * other control characters is frame bytes and is dropped at its end
+ *      Returns true when a non-empty line is complete
+ */
+static bool UART_RX_edit_internal(UART_RX_Reader *reader, char input)
+{
+    if(input == '\r' || input == '\n'){
+        if(input == '\n' && reader->lineLength == 0){
+            return false; // Second half of "\r\n"
+        }
+        if(reader->echo){
+            uart_print_string("\r\n");
+        }
+        reader->line[reader->lineLength] = '\0';
+        if(reader->lineBinary){
+            reader->stats.discarded++;
+            reader->lineBinary = false;
+            reader->lineLength = 0;
+            return false;
+        }
+        if(!reader->lineLength){
+            return false;
+        }
+        reader->lineLength = 0;
+        reader->stats.lines++;
+        return true;
+    }
+    if(input == '\b' || input == 0x7F){
+        if(reader->lineLength){
+            reader->lineLength--;
+            if(reader->echo){
+                uart_print_string("\b \b");
+            }
+        }
+        return false;
+    }
+    if(input == 0x03 || input == 0x1B){ // Ctrl-C or ESC clears the line
+        reader->lineLength = 0;
+        reader->lineBinary = false;
+        if(reader->echo){
+            uart_print_string("\r\n");
+        }
+        return false;
+    }
+    if(input < ' ' || input > '~'){
+        reader->lineBinary = true; // Frame bytes read as text, the line is dropped
+        return false;
+    }
+    if(reader->lineLength >= UART_RX_LINE_MAX){
+        reader->stats.truncated++;
+        return false;
+    }
+    reader->line[reader->lineLength++] = input;
+    if(reader->echo){
+        char echo[2] = {input, '\0'};
+        uart_print_string(echo);
+    }
+    return false;
+}
+
+/*
+ * Decodes the collected frame and checks its CRC
+ *      Returns true if reader->frame holds a valid payload
+ */
+static bool UART_RX_frame_internal(UART_RX_Reader *reader)
+{
+    if(!reader->encodedLength){
+        return false; // Back to back delimiters
+    }
+    size_t length = cobs_decode(reader->encoded, reader->encodedLength, reader->frame);
+    if(length < 1 + TLM_CRC_SIZE || length > UART_RX_FRAME_MAX){
+        reader->stats.framingErrors++;
+        return false;
+    }
+    length -= TLM_CRC_SIZE;
+    uint16_t crc = (uint16_t)(reader->frame[length] | (reader->frame[length + 1] << 8));
+    if(crc16(reader->frame, length, 0xFFFF) != crc){
+        reader->stats.crcErrors++;
+        return false;
+    }
+    reader->frameLength = (uint16_t)length;
+    reader->stats.frames++;
+    return true;
+}
@@ -0,0 +1,114 @@
+/*
+ * uart_rx.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Interrupt driven UART receive
+ *      The UART2 read callback copies bytes into a lock-free ring and
+ *      wakes the consumer, no thread ever blocks inside UART2_read.
+ *      One consumer thread takes the bytes out as text lines or as
+ *      COBS frames (protocol.h) with a UART_RX_Reader.
+ *
+ *      Text and frames share the line: a 0x00 starts a frame and the next
+ *      0x00 ends it, so a host sends "00 <cobs> 00" per frame. Text never
+ *      contains 0x00. A lost or duplicated delimiter must not swap text
+ *      and frames for good, so the reader resynchronizes:
+ *          - back to back delimiters open a single frame
+ *          - after a valid frame the reader is back in text
+ *          - a frame that does not decode ends at a delimiter which also
+ *            opens the next frame (its opening delimiter was lost)
+ *          - a frame is sent in one go, when the line stays quiet for
+ *            UART_RX_IDLE_MS inside one it ends, and if its bytes were
+ *            all printable they are text after a duplicated delimiter
+ *          - more bytes than any frame holds are text after a lost
+ *            closing delimiter
+ *          - a text line holding control characters is frame bytes
+ *            after a lost opening delimiter and is dropped
+ *      A partial text line is dropped when a frame starts.
+ *
+ *      The consumer waits with UART_RX_timeout and calls UART_RX_idle
+ *      when the wait times out.
+ */
+
+#ifndef UART_RX_H_
+#define UART_RX_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <ti/drivers/UART2.h>
+
+#include "framing.h"
+
+/* Ring size in bytes, power of 2, 44ms of input at 115200 baud */
+#define UART_RX_SIZE            512
+
+/* Bytes requested from the driver per read callback */
+#define UART_RX_CHUNK           32
+
+/* Longest text line, longer input is refused */
+#define UART_RX_LINE_MAX        64
+
+/* Largest decoded frame including its CRC */
+#define UART_RX_FRAME_MAX       256
+
+/* Quiet time that ends an open frame, a byte is 87us at 115200 baud */
+#define UART_RX_IDLE_MS         20
+
+typedef struct UART_RX_Stats {
+    uint32_t bytes;             // Bytes placed in the ring
+    uint32_t rxOverruns;        // Bytes lost because the ring was full
+    uint32_t uartOverruns;      // Reads that reported a hardware overrun
+    uint32_t maxLevel;          // Fullest the ring has been in bytes
+} UART_RX_Stats;
+
+extern UART_RX_Stats uart_rx_stats;
+
+typedef enum UART_RX_Item {
+    UART_RX_NONE,               // Ring is empty, wait for more input
+    UART_RX_LINE,               // reader->line holds a complete line
+    UART_RX_FRAME               // reader->frame holds a frame with a valid CRC
+} UART_RX_Item;
+
+typedef struct UART_RX_ReaderStats {
+    uint32_t lines;
+    uint32_t truncated;         // Characters refused because the line was full
+    uint32_t frames;
+    uint32_t crcErrors;
+    uint32_t framingErrors;     // Bad COBS, oversize or too short frames
+    uint32_t resyncs;           // Open frames ended by a quiet line
+    uint32_t discarded;         // Partial or binary lines dropped
+} UART_RX_ReaderStats;
+
+/*
+ * Line and frame extraction state, caller owned
+ */
+typedef struct UART_RX_Reader {
+    bool echo;                  // Echo and edit text like a terminal
+    char line[UART_RX_LINE_MAX + 1];
+    uint8_t lineLength;
+    bool lineBinary;            // Line holds control characters
+    bool inFrame;
+    bool framePrintable;        // Frame bytes so far could be a text line
+    uint16_t encodedLength;
+    uint16_t replay;            // Frame bytes given back as text, next one
+    uint16_t replayLength;
+    uint8_t encoded[COBS_MAX_ENCODED(UART_RX_FRAME_MAX)];
+    uint8_t frame[COBS_MAX_ENCODED(UART_RX_FRAME_MAX)];
+    uint16_t frameLength;       // Payload length, CRC removed
+    UART_RX_ReaderStats stats;
+} UART_RX_Reader;
+
+void UART_RX_params(UART2_Params *params);
+void UART_RX_init(void);
+bool UART_RX_wait(uint32_t timeout);
+size_t UART_RX_read(uint8_t *data, size_t size);
+
+void UART_RX_readerInit(UART_RX_Reader *reader, bool echo);
+UART_RX_Item UART_RX_next(UART_RX_Reader *reader);
+uint32_t UART_RX_timeout(const UART_RX_Reader *reader);
+void UART_RX_idle(UART_RX_Reader *reader);
+void UART_RX_print(const UART_RX_Reader *reader);
+
+#endif /* UART_RX_H_ */
@@ -0,0 +1,252 @@
+/*
+ * uart_tx.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ *
+ * Buffered UART transmit path
+ *      Any thread queues whole messages into a lock-free ring and returns,
+ *      a single writer thread drains the ring in large UART2_write calls.
+ *
+ *      Each message is a 4 byte header word followed by the payload,
+ *      padded to 4 bytes. Producers reserve space with a compare and swap
+ *      on the reserve index, copy the payload, then publish the header.
+ *      Producers never wait for each other; the writer stops at the first
+ *      header that is not published yet.
+ */
+
+#include <pthread.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Semaphore.h>
+
+#include "uart_tx.h"
+#include "threadstats.h"
+#include "utilities.h"
+
+#define UART_TX_MASK            (UART_TX_SIZE - 1)
+#define UART_TX_READY           0x80000000u
+#define UART_TX_ALIGN(n)        (((n) + 3u) & ~3u)
+
+UART_TX_Stats uart_tx_stats;
+
+static uint32_t tx_ring[UART_TX_SIZE/4];
+static uint32_t tx_reserve = 0;         // Next free byte, advanced by producers
+static uint32_t tx_tail = 0;            // Next byte to send, advanced by the writer
+static char tx_chunk[UART_TX_CHUNK];    // Contiguous copy handed to UART2_write
+static UART_TX_Policy tx_policy;
+static Semaphore_Handle tx_sem = NULL;
+static bool tx_started = false;
+static Thread_Stats tx_thread_stats;
+
+void *UART_TX_thread(void *arg);
+
+
+/*
+ * Starts the writer thread
+ * Call once after UART2_open, prints before this go straight to UART2_write
+ *
+ * Input overflow policy
+ */
+void UART_TX_init(UART_TX_Policy policy)
+{
+    tx_policy = policy;
+    memset(&uart_tx_stats, 0, sizeof(UART_TX_Stats));
+
+    Semaphore_Params sem_params;
+    Semaphore_Params_init(&sem_params);
+    sem_params.mode = Semaphore_Mode_BINARY;
+    tx_sem = Semaphore_create(0, &sem_params, NULL);
+
+    pthread_t pth_handle;
+    pthread_attr_t attrs;
+    struct sched_param priParam;
+    int retc;
+
+    /* Initialize the attributes structure with default values */
+    pthread_attr_init(&attrs);
+
+    /* Set priority, detach state, and stack size attributes */
+    priParam.sched_priority = 1;
+    retc                    = pthread_attr_setschedparam(&attrs, &priParam);
+    retc |= pthread_attr_setdetachstate(&attrs, PTHREAD_CREATE_DETACHED);
+    retc |= pthread_attr_setstacksize(&attrs, UART_TX_STACK_SIZE);
+    if (retc != 0){
+        /* failed to set attributes */
+        while (1){}
+    }
+
+    retc = pthread_create(&pth_handle, &attrs, UART_TX_thread, NULL);
+    if (retc == 0){
+        __atomic_store_n(&tx_started, true, __ATOMIC_RELEASE);
+    }
+}
+
+/*
+ * Queues a message for transmission and returns without waiting for the UART
+ *      Returns false if the message was dropped
+ */
+bool UART_TX_write(const char *data, size_t length)
+{
+    if(!length){
+        return true;
+    }
+    if(!__atomic_load_n(&tx_started, __ATOMIC_ACQUIRE)){
+        size_t bytesWritten = 0;
+        return UART2_write(uart, data, length, &bytesWritten) == UART2_STATUS_SUCCESS;
+    }
+
+    uint32_t need = 4 + UART_TX_ALIGN(length);
+    if(need > UART_TX_SIZE){
+        __atomic_fetch_add(&uart_tx_stats.droppedBytes, length, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&uart_tx_stats.droppedMessages, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    // Reserve space
+    uint64_t blockedSince = 0;
+    uint32_t start = __atomic_load_n(&tx_reserve, __ATOMIC_RELAXED);
+    while(1){
+        uint32_t level = start - __atomic_load_n(&tx_tail, __ATOMIC_ACQUIRE);
+        if(level + need <= UART_TX_SIZE){
+            if(__atomic_compare_exchange_n(&tx_reserve, &start, start + need, true,
+                                           __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)){
+                // Raise the peak, other producers may be raising it too
+                uint32_t peak = __atomic_load_n(&uart_tx_stats.maxLevel, __ATOMIC_RELAXED);
+                while(level + need > peak &&
+                      !__atomic_compare_exchange_n(&uart_tx_stats.maxLevel, &peak, level + need, true,
+                                                   __ATOMIC_RELAXED, __ATOMIC_RELAXED)){}
+                break;
+            }
+            continue; // start reloaded by the failed exchange
+        }
+        if(tx_policy == UART_TX_DROP){
+            __atomic_fetch_add(&uart_tx_stats.droppedBytes, length, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&uart_tx_stats.droppedMessages, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+        if(!blockedSince){
+            blockedSince = clock_us();
+        }
+        Semaphore_post(tx_sem);
+        usleep(1000); // Wait 1ms for the writer
+        start = __atomic_load_n(&tx_reserve, __ATOMIC_RELAXED);
+    }
+    if(blockedSince){
+        __atomic_fetch_add(&uart_tx_stats.blocked_us, (uint32_t)(clock_us() - blockedSince), __ATOMIC_RELAXED);
+    }
+
+    // Copy payload, it may wrap around the end of the ring
+    uint8_t *bytes = (uint8_t*)tx_ring;
+    uint32_t offset = (start + 4) & UART_TX_MASK;
+    uint32_t first = UART_TX_SIZE - offset;
+    if(first > length){
+        first = length;
+    }
+    memcpy(&bytes[offset], data, first);
+    memcpy(&bytes[0], data + first, length - first);
+
+    // Publish
+    __atomic_fetch_add(&uart_tx_stats.bytesQueued, length, __ATOMIC_RELAXED);
+    __atomic_store_n(&tx_ring[(start & UART_TX_MASK)/4], UART_TX_READY | length, __ATOMIC_RELEASE);
+    Semaphore_post(tx_sem);
+    return true;
+}
+
+/*
+ * Prints the transmit counters
+ */
+void UART_TX_print(void)
+{
+    UART_TX_Stats stats = uart_tx_stats;
+    uart_print_string("uart_tx queued ");
+    uart_print_uint32(stats.bytesQueued);
+    uart_print_string(" written ");
+    uart_print_uint32(stats.bytesWritten);
+    uart_print_string(" writes ");
+    uart_print_uint32(stats.driverWrites);
+    uart_print_string(" dropped ");
+    uart_print_uint32(stats.droppedBytes);
+    uart_print_string("/");
+    uart_print_uint32(stats.droppedMessages);
+    uart_print_string(" blocked_us ");
+    uart_print_uint32(stats.blocked_us);
+    uart_print_string(" maxlevel ");
+    uart_print_uint32(stats.maxLevel);
+    uart_print_string("/");
+    uart_print_uint32(UART_TX_SIZE);
+    uart_print_string("\n");
+}
+
+/*
+ * Writer Thread
+ * Gathers published messages into one chunk per UART2_write
+ */
+void *UART_TX_thread(void *arg)
+{
+    (void)arg;
+    uint8_t *bytes = (uint8_t*)tx_ring;
+    ThreadStats_register(&tx_thread_stats, "uart tx", UART_TX_STACK_SIZE);
+    while(1){
+        ThreadStats_block(&tx_thread_stats);
+        Semaphore_pend(tx_sem, BIOS_WAIT_FOREVER);
+        ThreadStats_wake(&tx_thread_stats);
+        while(1){
+            size_t fill = 0;
+            uint32_t tail = tx_tail;
+            uint32_t released = tail;
+            uint32_t *header = &tx_ring[(tail & UART_TX_MASK)/4];
+            uint32_t word = __atomic_load_n(header, __ATOMIC_ACQUIRE);
+
+            // Copy whole messages while they fit in the chunk
+            while((word & UART_TX_READY) && tail != __atomic_load_n(&tx_reserve, __ATOMIC_ACQUIRE)){
+                uint32_t length = word & ~UART_TX_READY;
+                if(fill && fill + length > UART_TX_CHUNK){
+                    break;
+                }
+                uint32_t offset = (tail + 4) & UART_TX_MASK;
+                uint32_t done = 0;
+                while(done < length){
+                    uint32_t take = length - done;
+                    if(take > UART_TX_CHUNK - fill){
+                        take = UART_TX_CHUNK - fill;
+                    }
+                    if(take > UART_TX_SIZE - offset){
+                        take = UART_TX_SIZE - offset;
+                    }
+                    memcpy(&tx_chunk[fill], &bytes[offset], take);
+                    fill += take;
+                    done += take;
+                    offset = (offset + take) & UART_TX_MASK;
+                    if(fill == UART_TX_CHUNK && done < length){
+                        size_t bytesWritten = 0;
+                        UART2_write(uart, tx_chunk, fill, &bytesWritten);
+                        uart_tx_stats.driverWrites++;
+                        uart_tx_stats.bytesWritten += fill;
+                        fill = 0;
+                    }
+                }
+                // Clear the whole message so stale payload never reads as a header
+                uint32_t word_index = (tail & UART_TX_MASK)/4;
+                uint32_t words = (4 + UART_TX_ALIGN(length))/4;
+                while(words--){
+                    __atomic_store_n(&tx_ring[word_index], 0, __ATOMIC_RELAXED);
+                    word_index = (word_index + 1) & (UART_TX_MASK/4);
+                }
+                tail += 4 + UART_TX_ALIGN(length);
+                header = &tx_ring[(tail & UART_TX_MASK)/4];
+                word = __atomic_load_n(header, __ATOMIC_ACQUIRE);
+            }
+            if(tail == released){
+                break; // Nothing published
+            }
+            // Give the space back before the slow write so producers do not stall
+            __atomic_store_n(&tx_tail, tail, __ATOMIC_RELEASE);
+            if(fill){
+                size_t bytesWritten = 0;
+                UART2_write(uart, tx_chunk, fill, &bytesWritten);
+                uart_tx_stats.driverWrites++;
+                uart_tx_stats.bytesWritten += fill;
+            }
+        }
+    }
+}
@@ -0,0 +1,45 @@
+/*
+ * uart_tx.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: mblack
+ */
+
+#ifndef UART_TX_H_
+#define UART_TX_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Ring size in bytes, power of 2 */
+#define UART_TX_SIZE            1024
+
+/* Stack of the writer thread */
+#define UART_TX_STACK_SIZE      1024
+
+/* Largest single UART2_write issued by the writer thread */
+#define UART_TX_CHUNK           256
+
+typedef enum UART_TX_Policy {
+    UART_TX_DROP,       // A message that does not fit is dropped whole
+    UART_TX_BLOCK       // The caller sleeps until the message fits (thread context only)
+} UART_TX_Policy;
+
+typedef struct UART_TX_Stats {
+    uint32_t bytesQueued;       // Bytes accepted into the ring
+    uint32_t bytesWritten;      // Bytes handed to UART2_write
+    uint32_t driverWrites;      // UART2_write calls
+    uint32_t droppedBytes;      // Bytes lost to the drop policy
+    uint32_t droppedMessages;
+    uint32_t blocked_us;        // Total time callers waited for space
+    uint32_t maxLevel;          // Highest ring fill level seen in bytes
+} UART_TX_Stats;
+
+extern UART_TX_Stats uart_tx_stats;
+
+void UART_TX_init(UART_TX_Policy policy);
+bool UART_TX_write(const char *data, size_t length);
+void UART_TX_print(void);
+
+#endif /* UART_TX_H_ */
@@ -5,70 +5,58 @@
  *      Author: mblack
  */
 
+#include <ti/sysbios/BIOS.h>
+
 #include "utilities.h"
+#include "uart_tx.h"
+#include "uart_rx.h"
 
 
 
 /*
  * Blocks on UART response until pressing enter
- * Inputs the UART input string into the cmd pointer
+ * Inputs the UART input string into the cmd pointer (up to 9 characters)
+ * Takes the characters from the receive ring, call UART_RX_init first
  */
 void Read_UART(char *cmd)
 {
-    char input;
-    const char echoPrompt[] = "Echoing characters:\r\n";
-    size_t bytesRead;
-    size_t bytesWritten = 0;
-    uint32_t status     = UART2_STATUS_SUCCESS;
-
-    bool wait = true;
-    char command[10] = {'\0','\0','\0','\0','\0','\0','\0','\0','\0','\0'};
-    int index = 0;
-    /* Loop forever echoing */
-    while (wait)
-    {
-        bytesRead = 0;
-        while (bytesRead == 0)
-        {
-            status = UART2_read(uart, &input, 1, &bytesRead);
-            if (status != UART2_STATUS_SUCCESS)
-            {
-                /* UART2_read() failed */
-                return;
-            }
+    static UART_RX_Reader reader;
+    static bool ready = false;
+
+    if(!ready){
+        UART_RX_readerInit(&reader, true);
+        ready = true;
+    }
+    while(1){
+        if(!UART_RX_wait(UART_RX_timeout(&reader))){
+            UART_RX_idle(&reader);
         }
-        status = UART2_write(uart, &input, 1, &bytesWritten);
-        if(input == '\r') {
-            strcpy(cmd,command);
-            wait=false;
-            return;}
-        else {
-            command[index] = input;
-            index++;
+        if(UART_RX_next(&reader) == UART_RX_LINE){
+            strncpy(cmd, reader.line, 9); // Characters past the buffer are dropped, the shell has a longer line
+            cmd[9] = '\0';
+            return;
         }
     }
-
 }
 
 /*
  * Print string to UART
+ * Queued for the UART writer thread, does not wait for the line
  */
 void uart_print_string(const char *string)
 {
-    uint32_t status = UART2_STATUS_SUCCESS;
-    size_t bytesWritten = 0;
-    while (*string != '\0')
-    {
-        status = UART2_write(uart, string, 1, &bytesWritten);
-        if (status != UART2_STATUS_SUCCESS)
-        {
-            /* UART2_write() failed */
-            return;
-        }
-        string++;
-    }
+    UART_TX_write(string, strlen(string));
 }
 
+/*
+ * Monotonic time in microseconds
+ */
+uint64_t clock_us(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec*1000000 + now.tv_nsec/1000;
+}
 
 // Reverses a string 'str' of length 'len'
 void reverse(char* str, int len)
@@ -83,169 +71,385 @@ void reverse(char* str, int len)
     }
 }
 
-// Converts a given integer x to string str[].
+// Two ASCII digits for every value 0-99, lets the formatters
+// emit two digits per division
+static const char digitPairs[200] = {
+    '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+    '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+    '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+    '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+    '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+    '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+    '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+    '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+    '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+    '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+
+// Powers of ten for up to 9 decimals
+static const uint32_t pow10Table[10] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+// Converts a given unsigned integer x to string str[].
 // d is the number of digits required in the output.
 // If d is more than the number of digits in x,
 // then 0s are added at the beginning.
-int intToStr(int x, char str[], int d)
+// Zero is always at least one digit.
+// Returns the length, str needs room for 10 digits and '\0'
+int uint32ToStr(uint32_t x, char str[], int d)
 {
-    int i = 0;
-    while (x) {
-        str[i++] = (x % 10) + '0';
-        x = x / 10;
+    char digits[10];
+    int pos = 10;
+    while (x >= 100) {
+        uint32_t pair = x % 100;
+        x /= 100;
+        pos -= 2;
+        digits[pos] = digitPairs[pair*2];
+        digits[pos+1] = digitPairs[pair*2+1];
+    }
+    if (x >= 10) {
+        pos -= 2;
+        digits[pos] = digitPairs[x*2];
+        digits[pos+1] = digitPairs[x*2+1];
+    }
+    else {
+        digits[--pos] = '0' + x;
     }
 
     // If number of digits required is more, then
     // add 0s at the beginning
-    while (i < d) {
-        str[i] = '0';
-        i++;
+    int length = 10 - pos;
+    int pad = 0;
+    if (d > 10) {
+        d = 10;
     }
-    reverse(str, i);
-    str[i] = '\0';
-    return i;
+    if (d > length) {
+        pad = d - length;
+        memset(str, '0', pad);
+    }
+    memcpy(str + pad, &digits[pos], length);
+    str[pad + length] = '\0';
+    return pad + length;
 }
 
-// Converts a character to integer
-int ctoi(char character)
-{
-    switch(character)
-    {
-        case '1':
-            return 1;
-        case '2':
-            return 2;
-        case '3':
-            return 3;
-        case '4':
-            return 4;
-        case '5':
-            return 5;
-        case '6':
-            return 6;
-        case '7':
-            return 7;
-        case '8':
-            return 8;
-        case '9':
-            return 9;
-        default:
-            return 0;
+// Converts a given integer x to string str[].
+// d is the number of digits required in the output.
+// If d is more than the number of digits in x,
+// then 0s are added at the beginning.
+// Negative values get a leading '-' which is not counted in d
+// Returns the length, str needs room for sign, 10 digits and '\0'
+int intToStr(int x, char str[], int d)
+{
+    if (x < 0) {
+        str[0] = '-';
+        // Negate as unsigned so INT_MIN does not overflow
+        return uint32ToStr(0u - (uint32_t)x, str + 1, d) + 1;
     }
+    return uint32ToStr((uint32_t)x, str, d);
 }
-// Converts a string to integer
-int stoi(char* string)
+
+// True for characters allowed right after a number
+static bool isDelimiter(char character)
+{
+    return character == '\0' || character == ' ' || character == '\t' ||
+           character == '\r' || character == '\n' || character == ',';
+}
+
+// Accumulates decimal digits in one pass (Horner), stops at the first non-digit
+// Returns PARSE_INVALID without digits and PARSE_OVERFLOW above max
+static Parse_Status parseDigits(const char **cursor, uint32_t max, uint32_t *value)
+{
+    const char *string = *cursor;
+    uint32_t result = 0;
+    if (*string < '0' || *string > '9') {
+        return PARSE_INVALID;
+    }
+    while (*string >= '0' && *string <= '9') {
+        uint32_t digit = *string - '0';
+        if (result > (max - digit) / 10) {
+            *cursor = string;
+            return PARSE_OVERFLOW;
+        }
+        result = result*10 + digit;
+        string++;
+    }
+    *cursor = string;
+    *value = result;
+    return PARSE_OK;
+}
+
+// Reports the end position, a number must be followed by a delimiter
+static Parse_Status parseEnd(const char *string, const char **end, Parse_Status status)
+{
+    if (end != NULL) {
+        *end = string;
+    }
+    if (status == PARSE_OK && !isDelimiter(*string)) {
+        return PARSE_INVALID; // i.e. "1a3"
+    }
+    return status;
+}
+
+// Parses an unsigned decimal number, optional '+'
+// end (optional) is set to the first character after the number
+// value is only written on PARSE_OK
+Parse_Status parseUint32(const char *string, uint32_t *value, const char **end)
+{
+    uint32_t result = 0;
+    if (*string == '+') {
+        string++;
+    }
+    Parse_Status status = parseDigits(&string, UINT32_MAX, &result);
+    status = parseEnd(string, end, status);
+    if (status == PARSE_OK) {
+        *value = result;
+    }
+    return status;
+}
+
+// Parses a signed decimal number, optional '+' or '-'
+// end (optional) is set to the first character after the number
+// value is only written on PARSE_OK
+Parse_Status parseInt32(const char *string, int32_t *value, const char **end)
 {
-    int length = strlen(string);
-    int value = 0;
     bool negative = false;
+    uint32_t result = 0;
+    if (*string == '-' || *string == '+') {
+        negative = (*string == '-');
+        string++;
+    }
+    Parse_Status status = parseDigits(&string, negative ? 0x80000000u : 0x7FFFFFFFu, &result);
+    status = parseEnd(string, end, status);
+    if (status == PARSE_OK) {
+        *value = negative ? (int32_t)(0u - result) : (int32_t)result;
+    }
+    return status;
+}
 
-    int index = 1;
-    for(; index<length+1; index++){
-        value += ctoi(*string)*pow(10, length-index);
+// Parses a signed decimal number with optional fraction ("-12.5")
+// into Q format with fracBits fraction bits (i.e. 7 for TMP117 offsets)
+// Fraction digits beyond 9 are checked but do not change the result
+// end (optional) is set to the first character after the number
+// value is only written on PARSE_OK
+Parse_Status parseFixed(const char *string, uint8_t fracBits, int32_t *value, const char **end)
+{
+    bool negative = false;
+    uint32_t ipart = 0;
+    uint32_t fpart = 0;
+    uint8_t decimals = 0;
+    bool digits = false;
+    Parse_Status status = PARSE_OK;
+
+    if (*string == '-' || *string == '+') {
+        negative = (*string == '-');
         string++;
     }
+    if (*string >= '0' && *string <= '9') {
+        status = parseDigits(&string, UINT32_MAX, &ipart);
+        digits = true;
+    }
+    if (status == PARSE_OK && *string == '.') {
+        string++;
+        while (*string >= '0' && *string <= '9') {
+            if (decimals < 9) {
+                fpart = fpart*10 + (*string - '0');
+                decimals++;
+            }
+            digits = true;
+            string++;
+        }
+    }
+    if (status == PARSE_OK && !digits) {
+        status = PARSE_INVALID;
+    }
+
+    // Combine with rounding and range check against int32
+    uint64_t magnitude = 0;
+    if (status == PARSE_OK && fracBits < 32) {
+        uint32_t scale = pow10Table[decimals];
+        magnitude = ((uint64_t)ipart << fracBits) +
+                    ((((uint64_t)fpart << fracBits) + scale/2) / scale);
+        if (magnitude > (negative ? 0x80000000u : 0x7FFFFFFFu)) {
+            status = PARSE_OVERFLOW;
+        }
+    }
+    else if (status == PARSE_OK) {
+        status = PARSE_OVERFLOW;
+    }
+
+    status = parseEnd(string, end, status);
+    if (status == PARSE_OK) {
+        *value = negative ? (int32_t)(0u - (uint32_t)magnitude) : (int32_t)magnitude;
+    }
+    return status;
+}
+
+// Converts a string to integer
+// Returns 0 for invalid input, use parseInt32 to tell the difference
+int stoi(char* string)
+{
+    int32_t value = 0;
+    if (parseInt32(string, &value, NULL) != PARSE_OK) {
+        return 0;
+    }
     return value;
 }
 
+// Converts a string to float
+// Returns 0 for invalid input
 float stof(char* string)
 {
-    int length = strlen(string);
-    float value = 0;
-    int decposition = 0;
-    int index = 0;
-    for(; index<length; index++){
-        if(string[index]=='.'){
-            break;
-        }
-        else{
-            decposition++;
+    bool negative = false;
+    uint32_t ipart = 0;
+    uint32_t fpart = 0;
+    uint8_t decimals = 0;
+
+    if (*string == '-' || *string == '+') {
+        negative = (*string == '-');
+        string++;
+    }
+    if (*string != '.' && parseDigits((const char **)&string, UINT32_MAX, &ipart) != PARSE_OK) {
+        return 0;
+    }
+    if (*string == '.') {
+        string++;
+        while (*string >= '0' && *string <= '9') {
+            if (decimals < 9) {
+                fpart = fpart*10 + (*string - '0');
+                decimals++;
+            }
+            string++;
         }
     }
-    for(index = 0; index<length; index++)
-    {
-        if(index<decposition){
-            value += ctoi(string[index])*pow(10,decposition-(index+1));
+    if (!isDelimiter(*string)) {
+        return 0;
+    }
+    float value = (float)ipart + (float)fpart / (float)pow10Table[decimals];
+    return negative ? -value : value;
+}
+
+// Converts a signed fixed point value to a string.
+// fracBits is the Q format (i.e. 7 for TMP117 results, 1/128 per bit)
+// decimals is the number of digits after the point, rounded half up
+// Returns the length, str needs FMT_BUFFER_SIZE bytes
+int fixedToStr(int32_t value, uint8_t fracBits, uint8_t decimals, char str[])
+{
+    int i = 0;
+    uint32_t magnitude = (uint32_t)value;
+    if (value < 0) {
+        str[i++] = '-';
+        magnitude = 0u - (uint32_t)value;
+    }
+    if (decimals > 9) {
+        decimals = 9;
+    }
+
+    uint32_t ipart = fracBits < 32 ? magnitude >> fracBits : 0;
+    uint32_t fpart = magnitude - (fracBits < 32 ? ipart << fracBits : 0);
+    uint32_t scale = pow10Table[decimals];
+    uint32_t rounded;
+
+    // Scale the fraction to decimals digits with rounding,
+    // 32 bit math when the product fits (i.e. Q7 with 3 decimals)
+    if (fracBits <= 16 && decimals <= 4) {
+        rounded = fpart * scale;
+        if (fracBits) {
+            rounded = (rounded + (1u << (fracBits - 1))) >> fracBits;
         }
-        else if(index>decposition){
-            value += ctoi(string[index])*pow(10,decposition-(index));
+    }
+    else {
+        uint64_t wide = (uint64_t)fpart * scale;
+        if (fracBits) {
+            wide = (wide + ((uint64_t)1 << (fracBits - 1))) >> fracBits;
         }
+        rounded = (uint32_t)wide;
     }
-    return value;
+    if (rounded >= scale) {
+        ipart++;
+        rounded -= scale;
+    }
+
+    i += uint32ToStr(ipart, str + i, 1);
+    if (decimals) {
+        str[i++] = '.';
+        i += uint32ToStr(rounded, str + i, decimals);
+    }
+    return i;
 }
 
 // Converts a floating-point/double number to a string.
-void ftoa(float n, char* res, int afterpoint)
+// Integer only after the split, rounded half up
+// Returns the length, res needs FMT_BUFFER_SIZE bytes
+int ftoa(float n, char* res, int afterpoint)
 {
-    uint8_t d = 0;
+    int i = 0;
 
-    // Extract integer part
-    int ipart = (int)n;
+    // Sign is handled once so the integer and fraction parts
+    // are both formatted as magnitudes
+    if (n < 0) {
+        res[i++] = '-';
+        n = -n;
+    }
+    if (afterpoint > 9) {
+        afterpoint = 9;
+    }
 
-    if(ipart == 0){
-        d = 1;
+    // Extract integer part, saturate instead of overflowing the cast
+    if (n > 4294967040.0f) {
+        n = 4294967040.0f;
     }
+    uint32_t ipart = (uint32_t)n;
 
-    // Extract floating part
-    float fpart = n - (float)ipart;
+    // Get the value of fraction part upto given no.
+    // of points after dot, a carry goes to the integer part
+    uint32_t scale = pow10Table[afterpoint];
+    uint32_t fpart = (uint32_t)((n - (float)ipart) * scale + 0.5f);
+    if (fpart >= scale) {
+        ipart++;
+        fpart -= scale;
+    }
 
-    // convert integer part to string
-    int i = intToStr(ipart, res, d);
+    // convert integer part to string, at least one digit
+    i += uint32ToStr(ipart, res + i, 1);
 
     // check for display option after point
     if (afterpoint != 0) {
-        res[i] = '.'; // add dot
-
-        // Get the value of fraction part upto given no.
-        // of points after dot. The third parameter
-        // is needed to handle cases like 233.007
-        fpart = fpart * pow(10, afterpoint);
+        res[i++] = '.'; // add dot
 
-        intToStr((int)fpart, res + i + 1, afterpoint);
+        // Zero padding handles cases like 233.007
+        i += uint32ToStr(fpart, res + i, afterpoint);
     }
+    return i;
 }
 
 /*
  * Print float value to UART
+ * Formats on the stack, nothing is allocated
  */
 void uart_print_float(float value)
 {
-    uint32_t status = UART2_STATUS_SUCCESS;
-    size_t bytesWritten = 0;
-    char *string = malloc(15);
-    ftoa(value, string, 3);
-    while (*string != '\0')
-    {
-        status = UART2_write(uart, string, 1, &bytesWritten);
-        if (status != UART2_STATUS_SUCCESS)
-        {
-            /* UART2_write() failed */
-            return;
-        }
-        string++;
-    }
+    char string[FMT_BUFFER_SIZE];
+    UART_TX_write(string, ftoa(value, string, 3));
+}
+
+/*
+ * Print fixed point value to UART
+ * Input value in Q format with fracBits fraction bits
+ * Input number of decimals
+ */
+void uart_print_fixed(int32_t value, uint8_t fracBits, uint8_t decimals)
+{
+    char string[FMT_BUFFER_SIZE];
+    UART_TX_write(string, fixedToStr(value, fracBits, decimals, string));
 }
 
 /*
  * Print uint32 number to UART
+ * Formats on the stack, exact for the whole uint32 range
  */
 void uart_print_uint32(uint32_t value)
 {
-    int time = 0;
-    uint32_t status = UART2_STATUS_SUCCESS;
-    size_t bytesWritten = 0;
-    char *string = malloc(15);
-    ftoa((float)value, string, 0);
-    while (*string != '\0')
-    {
-        status = UART2_write(uart, string, 1, &bytesWritten);
-        if (status != UART2_STATUS_SUCCESS)
-        {
-            /* UART2_write() failed */
-            return;
-        }
-        string++;
-    }
+    char string[FMT_BUFFER_SIZE];
+    UART_TX_write(string, uint32ToStr(value, string, 1));
 }
-
-
@@ -13,11 +13,21 @@
 #include <stddef.h>
 #include <unistd.h>
 #include <stdbool.h>
-#include <math.h>
 #include <stdlib.h>
+#include <time.h>
 #include <ti/drivers/UART2.h>
 #include <ti/display/Display.h>
 
+/* Buffer size for any number formatted by intToStr, uint32ToStr, fixedToStr or ftoa */
+#define FMT_BUFFER_SIZE     24
+
+/* Result of the parse* functions */
+typedef enum Parse_Status {
+    PARSE_OK,
+    PARSE_INVALID,      // No digits or a character other than a delimiter after the number
+    PARSE_OVERFLOW      // Value does not fit the result type
+} Parse_Status;
+
 static Display_Handle display;
 
 UART2_Handle uart;
@@ -28,11 +38,19 @@ void Read_UART(char *cmd);
 void uart_print_string(const char *string);
 void uart_print_float(float value);
 void uart_print_uint32(uint32_t value);
+void uart_print_fixed(int32_t value, uint8_t fracBits, uint8_t decimals);
+
+uint64_t clock_us(void);
 
 void reverse(char* str, int len);
 int intToStr(int x, char str[], int d);
-void ftoa(float n, char* res, int afterpoint);
+int uint32ToStr(uint32_t x, char str[], int d);
+int fixedToStr(int32_t value, uint8_t fracBits, uint8_t decimals, char str[]);
+int ftoa(float n, char* res, int afterpoint);
 int stoi(char* string);
 float stof(char* string);
+Parse_Status parseUint32(const char *string, uint32_t *value, const char **end);
+Parse_Status parseInt32(const char *string, int32_t *value, const char **end);
+Parse_Status parseFixed(const char *string, uint8_t fracBits, int32_t *value, const char **end);
 
 #endif /* UTILITIES_H_ */